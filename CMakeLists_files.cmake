@@ -30,6 +30,8 @@
 # find opm -name '*.c*' -printf '\t%p\n' | sort
 list (APPEND MAIN_SOURCE_FILES
         opm/core/flowdiagnostics/AnisotropicEikonal.cpp
+        opm/core/flowdiagnostics/ColumnarFile.cpp
+        opm/core/flowdiagnostics/CompressedTracers.cpp
         opm/core/flowdiagnostics/DGBasis.cpp
         opm/core/flowdiagnostics/FlowDiagnostics.cpp
         opm/core/flowdiagnostics/TofDiscGalReorder.cpp
@@ -37,9 +39,11 @@ list (APPEND MAIN_SOURCE_FILES
         opm/core/linalg/LinearSolverFactory.cpp
         opm/core/linalg/LinearSolverInterface.cpp
         opm/core/linalg/LinearSolverIstl.cpp
+        opm/core/linalg/LinearSolverKrylov.cpp
         opm/core/linalg/LinearSolverPetsc.cpp
         opm/core/linalg/LinearSolverUmfpack.cpp
         opm/core/linalg/call_umfpack.c
+        opm/core/linalg/linsys_binary.c
         opm/core/linalg/sparse_sys.c
         opm/core/pressure/CompressibleTpfa.cpp
         opm/core/pressure/FlowBCManager.cpp
@@ -54,6 +58,7 @@ list (APPEND MAIN_SOURCE_FILES
         opm/core/pressure/tpfa/trans_tpfa.c
         opm/core/props/BlackoilPropertiesBasic.cpp
         opm/core/props/BlackoilPropertiesFromDeck.cpp
+        opm/core/props/BlackoilPropertiesInterface.cpp
         opm/core/props/IncompPropertiesBasic.cpp
         opm/core/props/IncompPropertiesFromDeck.cpp
         opm/core/props/IncompPropertiesSinglePhase.cpp
@@ -97,11 +102,14 @@ list (APPEND MAIN_SOURCE_FILES
 # originally generated with the command:
 # find tests -name '*.cpp' -a ! -wholename '*/not-unit/*' -printf '\t%p\n' | sort
 list (APPEND TEST_SOURCE_FILES
+	tests/test_bcsrmatrix.cpp
 	tests/test_compressedpropertyaccess.cpp
 	tests/test_dgbasis.cpp
 	tests/test_cubic.cpp
 	tests/test_event.cpp
 	tests/test_flowdiagnostics.cpp
+	tests/test_compressedtracers.cpp
+	tests/test_linsys_binary.cpp
 	tests/test_nonuniformtablelinear.cpp
 	tests/test_parallelistlinformation.cpp
 	tests/test_sparsevector.cpp
@@ -111,7 +119,9 @@ list (APPEND TEST_SOURCE_FILES
 	tests/test_wachspresscoord.cpp
 	tests/test_linearsolver.cpp
 	tests/test_parallel_linearsolver.cpp
+	tests/test_compressibletpfa.cpp
 	tests/test_satfunc.cpp
+	tests/test_blackoilpropertiesfromdeck.cpp
 	tests/test_shadow.cpp
 	tests/test_equil.cpp
 	tests/test_regionmapping.cpp
@@ -122,6 +132,11 @@ list (APPEND TEST_SOURCE_FILES
 	tests/test_wellcollection.cpp
 	tests/test_pinchprocessor.cpp
 	tests/test_anisotropiceikonal.cpp
+	tests/test_tofreorder.cpp
+	tests/test_tofdiscgalreorder.cpp
+	tests/test_trans_tpfa.cpp
+	tests/test_tabulatedrelperm.cpp
+	tests/test_transportsolvertwophasereorder.cpp
 	tests/test_stoppedwells.cpp
 	tests/test_relpermdiagnostics.cpp
         tests/test_norne_pvt.cpp
@@ -161,6 +176,10 @@ list (APPEND TEST_DATA_FILES
 # originally generated with the command:
 # find tutorials examples -name '*.c*' -printf '\t%p\n' | sort
 list (APPEND EXAMPLE_SOURCE_FILES
+	benchmarks/eikonal_benchmark.cpp
+	benchmarks/linsolver_benchmark.cpp
+	benchmarks/reorder_benchmark.cpp
+	benchmarks/satfunc_benchmark.cpp
 	examples/compute_eikonal_from_files.cpp
 	examples/compute_initial_state.cpp
 	examples/compute_tof.cpp
@@ -193,6 +212,8 @@ list (APPEND PROGRAM_SOURCE_FILES
 list (APPEND PUBLIC_HEADER_FILES
         opm/core/doxygen_main.hpp
         opm/core/flowdiagnostics/AnisotropicEikonal.hpp
+        opm/core/flowdiagnostics/ColumnarFile.hpp
+        opm/core/flowdiagnostics/CompressedTracers.hpp
         opm/core/flowdiagnostics/DGBasis.hpp
         opm/core/flowdiagnostics/FlowDiagnostics.hpp
         opm/core/flowdiagnostics/TofDiscGalReorder.hpp
@@ -200,11 +221,13 @@ list (APPEND PUBLIC_HEADER_FILES
         opm/core/linalg/LinearSolverFactory.hpp
         opm/core/linalg/LinearSolverInterface.hpp
         opm/core/linalg/LinearSolverIstl.hpp
+        opm/core/linalg/LinearSolverKrylov.hpp
         opm/core/linalg/LinearSolverPetsc.hpp
         opm/core/linalg/LinearSolverUmfpack.hpp
         opm/core/linalg/ParallelIstlInformation.hpp
         opm/core/linalg/blas_lapack.h
         opm/core/linalg/call_umfpack.h
+        opm/core/linalg/linsys_binary.h
         opm/core/linalg/sparse_sys.h
         opm/core/pressure/CompressibleTpfa.hpp
         opm/core/pressure/FlowBCManager.hpp
@@ -258,6 +281,7 @@ list (APPEND PUBLIC_HEADER_FILES
         opm/core/simulator/initStateEquil_impl.hpp
         opm/core/simulator/initState_impl.hpp
         opm/core/transport/TransportSolverTwophaseInterface.hpp
+        opm/core/transport/implicit/BCSRMatrixBlockAssembler.hpp
         opm/core/transport/implicit/CSRMatrixBlockAssembler.hpp
         opm/core/transport/implicit/CSRMatrixUmfpackSolver.hpp
         opm/core/transport/implicit/ImplicitAssembly.hpp
@@ -270,6 +294,7 @@ list (APPEND PUBLIC_HEADER_FILES
         opm/core/transport/implicit/TransportSolverTwophaseImplicit.hpp
         opm/core/transport/implicit/transport_source.h
         opm/core/transport/reorder/ReorderSolverInterface.hpp
+        opm/core/transport/reorder/TabulatedRelperm.hpp
         opm/core/transport/reorder/TransportSolverCompressibleTwophaseReorder.hpp
         opm/core/transport/reorder/TransportSolverTwophaseReorder.hpp
         opm/core/transport/reorder/reordersequence.h
@@ -0,0 +1,157 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Time AnisotropicEikonal2d or AnisotropicEikonal3d on a sequence of
+// refined Cartesian grids, and report the results as JSON.
+//
+// The metric is anisotropic with a principal direction that rotates
+// over the domain, and the solution is started from a corner cell.
+// The grid has n cells in each direction at the first level, and the
+// number of cells per direction is doubled for each further level.
+// The "scaled_time" reported for each level is time / (N log2 N) in
+// nanoseconds, for N cells, which should stay roughly constant.
+//
+// Parameters:
+//   dimensions   Grid dimension, 2 or 3 (default 2).
+//   n            Cells per direction on the coarsest level (default
+//                100 in 2d, 16 in 3d).
+//   levels       Number of refinement levels (default 4 in 2d, 3 in 3d).
+//   anisotropy   Ratio of the largest to the smallest eigenvalue of
+//                the metric (default 5).
+//   repeat       Number of timed solves per level (default 3).
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <opm/core/flowdiagnostics/AnisotropicEikonal.hpp>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/grid.h>
+#include <opm/core/utility/StopWatch.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // Metric with eigenvalues 1 and anisotropy, whose principal
+    // direction rotates with the first coordinate. In 3d the third
+    // direction has eigenvalue 1.
+    std::vector<double> rotatingMetric(const UnstructuredGrid& grid, const double anisotropy)
+    {
+        const int dim = grid.dimensions;
+        const int nc = grid.number_of_cells;
+        double xmax = 0.0;
+        for (int cell = 0; cell < nc; ++cell) {
+            xmax = std::max(xmax, grid.cell_centroids[dim*cell]);
+        }
+        std::vector<double> metric(dim*dim*nc, 0.0);
+        for (int cell = 0; cell < nc; ++cell) {
+            const double angle = 1.5 * grid.cell_centroids[dim*cell] / xmax;
+            const double c = std::cos(angle);
+            const double s = std::sin(angle);
+            double* m = &metric[dim*dim*cell];
+            m[0] = c*c + anisotropy*s*s;
+            m[1] = m[dim] = (1.0 - anisotropy)*c*s;
+            m[dim + 1] = s*s + anisotropy*c*c;
+            if (dim == 3) {
+                m[8] = 1.0;
+            }
+        }
+        return metric;
+    }
+
+    template <class Solver>
+    double timeSolve(const UnstructuredGrid& grid, const std::vector<double>& metric, const int repeat)
+    {
+        Solver solver(grid);
+        const std::vector<int> start = { 0 };
+        std::vector<double> solution;
+        Opm::time::StopWatch clock;
+        double best = std::numeric_limits<double>::max();
+        for (int r = 0; r < repeat; ++r) {
+            clock.start();
+            solver.solve(metric.data(), start, solution);
+            clock.stop();
+            best = std::min(best, clock.secsSinceStart());
+        }
+        return best;
+    }
+} // anon namespace
+
+
+
+// ----------------- Main program -----------------
+int
+main(int argc, char** argv)
+try
+{
+    using namespace Opm;
+
+    ParameterGroup param(argc, argv);
+
+    const int dim = param.getDefault("dimensions", 2);
+    if (dim != 2 && dim != 3) {
+        OPM_THROW(std::runtime_error, "dimensions must be 2 or 3, got " << dim);
+    }
+    const int n = param.getDefault("n", dim == 2 ? 100 : 16);
+    const int levels = param.getDefault("levels", dim == 2 ? 4 : 3);
+    const double anisotropy = param.getDefault("anisotropy", 5.0);
+    const int repeat = param.getDefault("repeat", 3);
+
+    std::cout << "{\n  \"dimensions\": " << dim
+              << ",\n  \"anisotropy\": " << anisotropy
+              << ",\n  \"levels\": [";
+    for (int level = 0; level < levels; ++level) {
+        const int nl = n << level;
+        std::unique_ptr<GridManager> gm;
+        if (dim == 2) {
+            gm.reset(new GridManager(nl, nl, 1.0/nl, 1.0/nl));
+        } else {
+            gm.reset(new GridManager(nl, nl, nl, 1.0/nl, 1.0/nl, 1.0/nl));
+        }
+        const UnstructuredGrid& grid = *gm->c_grid();
+        const std::vector<double> metric = rotatingMetric(grid, anisotropy);
+        const double time = (dim == 2)
+            ? timeSolve<AnisotropicEikonal2d>(grid, metric, repeat)
+            : timeSolve<AnisotropicEikonal3d>(grid, metric, repeat);
+        const double nc = grid.number_of_cells;
+        std::cout << (level == 0 ? "" : ",")
+                  << "\n    { \"cells\": " << grid.number_of_cells
+                  << ", \"time\": " << time
+                  << ", \"scaled_time\": " << 1e9*time/(nc*std::log2(nc)) << " }";
+        std::cerr << "Level " << level << ": " << grid.number_of_cells
+                  << " cells, " << time << " s" << std::endl;
+    }
+    std::cout << "\n  ]\n}\n";
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    throw;
+}
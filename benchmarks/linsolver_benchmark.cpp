@@ -0,0 +1,383 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Replay linear systems dumped with linsys_binary_write() (e.g., through
+// the linsolver_save_system and linsolver_save_binary parameters of
+// LinearSolverIstl) with every available LinearSolverFactory backend and
+// option combination, and report the results as JSON.
+//
+// Parameters:
+//   systems      Comma separated list of .linsys files (required).
+//   repeat       Number of timed solves per configuration (default 3).
+//   output       JSON output file (default: standard output).
+//   solvers      Comma separated subset of "umfpack", "istl", "petsc"
+//                and "krylov" (default: all available).
+//
+// For each system and configuration the report contains
+//   setup_time   Time of the first solve minus the fastest later solve,
+//                i.e., the part of the first solve that a solver session
+//                (LinearSolverInterface::makeSession()) can reuse.
+//   solve_time   Fastest solve with reused setup.
+//   iterations   Iterations of the last solve.
+//   converged    Whether the last solve reported convergence.
+//   residual     ||b - A*x|| / ||b|| of the last solution.
+//   peak_rss_kb  Peak resident set size during the configuration where
+//                the operating system permits resetting it (Linux), and
+//                the process-wide peak otherwise.
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <opm/core/linalg/LinearSolverFactory.hpp>
+#include <opm/core/linalg/linsys_binary.h>
+#include <opm/core/linalg/sparse_sys.h>
+#include <opm/core/utility/StopWatch.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    typedef std::vector<std::pair<std::string, std::string> > Options;
+
+    struct Configuration
+    {
+        std::string name;
+        Options     options;
+    };
+
+    struct Result
+    {
+        double setup_time;
+        double solve_time;
+        int    iterations;
+        bool   converged;
+        double residual;
+        long   peak_rss_kb;
+        std::string error;
+    };
+
+    std::vector<std::string> split(const std::string& s, const char sep)
+    {
+        std::vector<std::string> parts;
+        std::istringstream is(s);
+        std::string part;
+        while (std::getline(is, part, sep)) {
+            if (!part.empty()) {
+                parts.push_back(part);
+            }
+        }
+        return parts;
+    }
+
+    Configuration config(const std::string& name, const Options& opts)
+    {
+        Configuration c;
+        c.name = name;
+        c.options = opts;
+        return c;
+    }
+
+    Options opts(const std::string& solver)
+    {
+        return Options(1, std::make_pair(std::string("linsolver"), solver));
+    }
+
+    Options with(Options o, const std::string& key, const std::string& value)
+    {
+        o.push_back(std::make_pair(key, value));
+        return o;
+    }
+
+    bool wanted(const std::vector<std::string>& solvers, const std::string& s)
+    {
+        return solvers.empty() || std::find(solvers.begin(), solvers.end(), s) != solvers.end();
+    }
+
+    std::vector<Configuration> configurations(const std::vector<std::string>& solvers)
+    {
+        std::vector<Configuration> cfg;
+
+#if HAVE_SUITESPARSE_UMFPACK_H
+        if (wanted(solvers, "umfpack")) {
+            cfg.push_back(config("umfpack", opts("umfpack")));
+        }
+#endif
+
+#if HAVE_DUNE_ISTL
+        if (wanted(solvers, "istl")) {
+            const char* types[] = { "CG_ILU0", "CG_AMG", "BiCGStab_ILU0", "FastAMG", "KAMG" };
+            for (int t = 0; t < 5; ++t) {
+                std::ostringstream type;
+                type << t;
+                const Options o = with(opts("istl"), "linsolver_type", type.str());
+                cfg.push_back(config(std::string("istl-") + types[t], o));
+                cfg.push_back(config(std::string("istl-") + types[t] + "-mixed",
+                                     with(o, "linsolver_mixed_precision", "true")));
+            }
+        }
+#endif
+
+#if HAVE_PETSC
+        if (wanted(solvers, "petsc")) {
+            cfg.push_back(config("petsc-cg-jacobi",
+                                 with(with(opts("petsc"), "ksp_type", "cg"), "pc_type", "jacobi")));
+            cfg.push_back(config("petsc-bcgs-ilu",
+                                 with(with(opts("petsc"), "ksp_type", "bcgs"), "pc_type", "ilu")));
+        }
+#endif
+
+        if (wanted(solvers, "krylov")) {
+            const char* krylov[] = { "CG", "BiCGStab" };
+            const char* prec[]   = { "none", "Jacobi", "ILU0" };
+            for (int k = 0; k < 2; ++k) {
+                for (int p = 0; p < 3; ++p) {
+                    std::ostringstream ks, ps;
+                    ks << k;
+                    ps << p;
+                    cfg.push_back(config(std::string("krylov-") + krylov[k] + "-" + prec[p],
+                                         with(with(opts("krylov"), "linsolver_krylov", ks.str()),
+                                              "linsolver_preconditioner", ps.str())));
+                }
+            }
+        }
+
+        return cfg;
+    }
+
+    // Reset the peak resident set size, if supported.  Returns whether
+    // the reset succeeded.
+    bool resetPeakRss()
+    {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        if (!clear_refs) {
+            return false;
+        }
+        clear_refs << "5" << std::flush;
+        return bool(clear_refs);
+    }
+
+    long peakRssKb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::atol(line.c_str() + 6);
+            }
+        }
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss; // Kilobytes on Linux.
+    }
+
+    double relativeResidual(const CSRMatrix& A, const double* b, const double* x)
+    {
+        double rr = 0.0, bb = 0.0;
+        for (std::size_t i = 0; i < A.m; ++i) {
+            double ri = b[i];
+            for (int k = A.ia[i]; k < A.ia[i + 1]; ++k) {
+                ri -= A.sa[k] * x[A.ja[k]];
+            }
+            rr += ri * ri;
+            bb += b[i] * b[i];
+        }
+        return (bb > 0.0) ? std::sqrt(rr / bb) : std::sqrt(rr);
+    }
+
+    Result run(const Configuration& cfg, const CSRMatrix& A, const double* b, const int repeat)
+    {
+        Result res;
+        res.setup_time = res.solve_time = res.residual = 0.0;
+        res.iterations = 0;
+        res.converged = false;
+
+        resetPeakRss();
+        try {
+            Opm::ParameterGroup param;
+            for (Options::const_iterator o = cfg.options.begin(); o != cfg.options.end(); ++o) {
+                param.insertParameter(o->first, o->second);
+            }
+            Opm::LinearSolverFactory solver(param);
+            std::shared_ptr<Opm::LinearSolverInterface::Session> session = solver.makeSession();
+
+            std::vector<double> x(A.m, 0.0);
+            Opm::LinearSolverInterface::LinearSolverReport rep;
+
+            Opm::time::StopWatch clock;
+            clock.start();
+            rep = session->solve(&A, b, &x[0]);
+            clock.stop();
+            const double first = clock.secsSinceStart();
+
+            double best = std::numeric_limits<double>::max();
+            for (int r = 0; r < repeat; ++r) {
+                std::fill(x.begin(), x.end(), 0.0);
+                clock.start();
+                rep = session->solve(&A, b, &x[0]);
+                clock.stop();
+                best = std::min(best, clock.secsSinceStart());
+            }
+            if (repeat == 0) {
+                best = first;
+            }
+
+            res.solve_time = best;
+            res.setup_time = std::max(0.0, first - best);
+            res.iterations = rep.iterations;
+            res.converged = rep.converged;
+            res.residual = relativeResidual(A, b, &x[0]);
+        }
+        catch (const std::exception& e) {
+            res.error = e.what();
+        }
+        res.peak_rss_kb = peakRssKb();
+
+        return res;
+    }
+
+    std::string jsonString(const std::string& s)
+    {
+        std::ostringstream os;
+        os << '"';
+        for (std::string::const_iterator c = s.begin(); c != s.end(); ++c) {
+            switch (*c) {
+            case '"':  os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n";  break;
+            case '\t': os << "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20) {
+                    os << ' ';
+                } else {
+                    os << *c;
+                }
+            }
+        }
+        os << '"';
+        return os.str();
+    }
+
+    std::string jsonNumber(const double x)
+    {
+        if (!std::isfinite(x)) {
+            return "null";
+        }
+        std::ostringstream os;
+        os.precision(9);
+        os << x;
+        return os.str();
+    }
+} // anon namespace
+
+
+
+// ----------------- Main program -----------------
+int
+main(int argc, char** argv)
+try
+{
+    using namespace Opm;
+
+    ParameterGroup param(argc, argv);
+
+    const std::vector<std::string> systems = split(param.get<std::string>("systems"), ',');
+    const int repeat = param.getDefault("repeat", 3);
+    const std::string output = param.getDefault("output", std::string(""));
+    const std::vector<std::string> solvers = split(param.getDefault("solvers", std::string("")), ',');
+
+    const std::vector<Configuration> cfg = configurations(solvers);
+    if (cfg.empty()) {
+        OPM_THROW(std::runtime_error, "No linear solver configurations selected.");
+    }
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output.c_str());
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Cannot open output file " << output);
+        }
+    }
+    std::ostream& os = output.empty() ? std::cout : file;
+
+    os << "{\n  \"results\": [";
+    bool first = true;
+    for (std::size_t s = 0; s < systems.size(); ++s) {
+        LinsysBinary sys;
+        if (linsys_binary_open(systems[s].c_str(), 1, &sys) != 0) {
+            OPM_THROW(std::runtime_error, "Cannot read linear system " << systems[s]);
+        }
+        if (!(sys.flags & LINSYS_HAS_MATRIX) || !(sys.flags & LINSYS_HAS_VECTOR)) {
+            linsys_binary_close(&sys);
+            OPM_THROW(std::runtime_error, "File " << systems[s] << " lacks matrix or right hand side.");
+        }
+
+        for (std::size_t c = 0; c < cfg.size(); ++c) {
+            std::cerr << systems[s] << ": " << cfg[c].name << std::endl;
+            const Result r = run(cfg[c], sys.A, sys.v, repeat);
+
+            os << (first ? "\n" : ",\n");
+            first = false;
+            os << "    {\"system\": " << jsonString(systems[s])
+               << ", \"rows\": " << sys.A.m
+               << ", \"nonzeros\": " << sys.A.nnz
+               << ", \"configuration\": " << jsonString(cfg[c].name)
+               << ", \"options\": {";
+            for (std::size_t o = 0; o < cfg[c].options.size(); ++o) {
+                os << (o ? ", " : "") << jsonString(cfg[c].options[o].first)
+                   << ": " << jsonString(cfg[c].options[o].second);
+            }
+            os << "}";
+            if (r.error.empty()) {
+                os << ", \"setup_time\": " << jsonNumber(r.setup_time)
+                   << ", \"solve_time\": " << jsonNumber(r.solve_time)
+                   << ", \"iterations\": " << r.iterations
+                   << ", \"converged\": " << (r.converged ? "true" : "false")
+                   << ", \"residual\": " << jsonNumber(r.residual);
+            } else {
+                os << ", \"error\": " << jsonString(r.error);
+            }
+            os << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}";
+        }
+
+        linsys_binary_close(&sys);
+    }
+    os << "\n  ]\n}\n";
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    throw;
+}
@@ -0,0 +1,367 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Time the strongly connected component ordering of reorder transport
+// (compute_sequence(), or tarjan_64() on a 64-bit upwind graph) on a
+// synthetic corner-point-like model, and report the results as JSON.
+//
+// The model is an nx-by-ny-by-nz logically Cartesian grid.  Every
+// fault_spacing'th column boundary in the x direction is a fault with
+// a throw of fault_throw layers, across which each cell connects to
+// two cells of the neighbouring column (as in a corner-point grid).
+// The flux is a diagonal flow field with a fraction reverse_fraction
+// of randomly reversed connections, which creates loops.
+//
+// Parameters:
+//   nx, ny, nz        Grid dimensions (default 200, 200, 50).  For
+//                     example, 1000 x 1000 x 100 gives 100M cells.
+//   fault_spacing     Columns between faults (default 10, 0: none).
+//   fault_throw       Fault throw in layers (default 3).
+//   reverse_fraction  Fraction of reversed fluxes (default 0.02).
+//   index_bits        32 for compute_sequence() on an UnstructuredGrid
+//                     topology, 64 for tarjan_64() (default 32).
+//   repeat            Number of timed orderings (default 3).
+//   seed              Random seed (default 1).
+//   dry_run           Only report the memory estimate (default false).
+//
+// The memory needed for the model and for the ordering is reported
+// before anything is allocated.  The reported time is the fastest
+// ordering, including the upwind graph construction for index_bits=32
+// (compute_sequence() builds it internally) and excluding it for
+// index_bits=64 (the graph is part of the model).
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <opm/core/grid.h>
+#include <opm/core/transport/reorder/reordersequence.h>
+#include <opm/core/transport/reorder/tarjan.h>
+#include <opm/core/utility/StopWatch.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Model
+    {
+        std::int64_t nx, ny, nz;
+        std::int64_t fault_spacing;
+        std::int64_t fault_throw;
+
+        std::int64_t numCells() const { return nx*ny*nz; }
+        std::int64_t cell(std::int64_t i, std::int64_t j, std::int64_t k) const
+        {
+            return i + nx*(j + ny*k);
+        }
+        bool fault(std::int64_t i) const
+        {
+            return fault_spacing > 0 && (i + 1) % fault_spacing == 0;
+        }
+    };
+
+    // Visit all connections (c1, c2), with flow from c1 to c2 being
+    // the main flow direction, in a fixed order.
+    template <class Visitor>
+    void forEachConnection(const Model& m, Visitor& visit)
+    {
+        for (std::int64_t k = 0; k < m.nz; ++k) {
+            for (std::int64_t j = 0; j < m.ny; ++j) {
+                for (std::int64_t i = 0; i < m.nx; ++i) {
+                    const std::int64_t c = m.cell(i, j, k);
+                    if (i + 1 < m.nx) {
+                        if (m.fault(i)) {
+                            // Two partially overlapping cells across the fault.
+                            for (std::int64_t d = 0; d < 2; ++d) {
+                                const std::int64_t kk = k + m.fault_throw - d;
+                                if (kk >= 0 && kk < m.nz) {
+                                    visit(c, m.cell(i + 1, j, kk));
+                                }
+                            }
+                        } else {
+                            visit(c, m.cell(i + 1, j, k));
+                        }
+                    }
+                    if (j + 1 < m.ny) {
+                        visit(c, m.cell(i, j + 1, k));
+                    }
+                    if (k + 1 < m.nz) {
+                        visit(c, m.cell(i, j, k + 1));
+                    }
+                }
+            }
+        }
+    }
+
+    struct CountConnections
+    {
+        std::int64_t n;
+        std::vector<int> per_cell;   // Connections per cell, if non-empty.
+        void operator()(std::int64_t c1, std::int64_t c2)
+        {
+            ++n;
+            if (!per_cell.empty()) {
+                ++per_cell[c1];
+                ++per_cell[c2];
+            }
+        }
+    };
+
+    // Fast deterministic pseudo-random numbers in [0, 1).
+    struct Random
+    {
+        explicit Random(unsigned long seed = 1) : state(seed * 2862933555777941757ULL + 3037000493ULL) {}
+        double operator()()
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return double(state >> 11) / 9007199254740992.0;
+        }
+        std::uint64_t state;
+    };
+
+    // Face-based topology as used by UnstructuredGrid, 32-bit indices.
+    struct FillTopology
+    {
+        std::vector<int>    face_cells;
+        std::vector<int>    cell_faces;
+        std::vector<int>    pos;
+        std::vector<double> flux;
+        Random              rnd;
+        double              reverse_fraction;
+        void operator()(std::int64_t c1, std::int64_t c2)
+        {
+            const int f = flux.size();
+            face_cells.push_back(int(c1));
+            face_cells.push_back(int(c2));
+            cell_faces[pos[c1]++] = f;
+            cell_faces[pos[c2]++] = f;
+            flux.push_back(rnd() < reverse_fraction ? -1.0 : 1.0);
+        }
+    };
+
+    // Upwind graph with 64-bit indices.  The upwind cells of a cell
+    // are stored in ja[ia[c] ... ia[c+1]-1].
+    struct FillGraph
+    {
+        std::vector<std::int64_t> ia;
+        std::vector<std::int64_t> ja;
+        Random                    rnd;
+        double                    reverse_fraction;
+        bool                      count_only;
+        void operator()(std::int64_t c1, std::int64_t c2)
+        {
+            if (rnd() < reverse_fraction) {
+                std::swap(c1, c2);
+            }
+            if (count_only) {
+                ++ia[c2 + 1];
+            } else {
+                ja[ia[c2]++] = c1;
+            }
+        }
+    };
+
+    long peakRssKb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::atol(line.c_str() + 6);
+            }
+        }
+        return 0;
+    }
+} // anon namespace
+
+
+
+// ----------------- Main program -----------------
+int
+main(int argc, char** argv)
+try
+{
+    using namespace Opm;
+
+    ParameterGroup param(argc, argv);
+
+    Model m;
+    m.nx = param.getDefault("nx", 200);
+    m.ny = param.getDefault("ny", 200);
+    m.nz = param.getDefault("nz", 50);
+    m.fault_spacing = param.getDefault("fault_spacing", 10);
+    m.fault_throw = param.getDefault("fault_throw", 3);
+    const double reverse_fraction = param.getDefault("reverse_fraction", 0.02);
+    const int index_bits = param.getDefault("index_bits", 32);
+    const int repeat = param.getDefault("repeat", 3);
+    const int seed = param.getDefault("seed", 1);
+    const bool dry_run = param.getDefault("dry_run", false);
+
+    if (index_bits != 32 && index_bits != 64) {
+        OPM_THROW(std::runtime_error, "index_bits must be 32 or 64, got " << index_bits);
+    }
+
+    const std::int64_t nc = m.numCells();
+    CountConnections counter = { 0, std::vector<int>() };
+    forEachConnection(m, counter);
+    const std::int64_t nconn = counter.n;
+
+    // Memory estimate, before allocating anything.
+    std::int64_t model_bytes, order_bytes;
+    if (index_bits == 32) {
+        if (nc >= std::numeric_limits<int>::max() / 2
+            || 2*nconn >= std::numeric_limits<int>::max()) {
+            OPM_THROW(std::runtime_error, "Model too large for 32-bit indices, use index_bits=64.");
+        }
+        // face_cells, cell_faces, cell_facepos, flux.
+        model_bytes = (2*nconn + 2*nconn + nc + 1) * sizeof(int) + nconn * sizeof(double);
+        UnstructuredGrid g;
+        std::memset(&g, 0, sizeof(g));
+        g.number_of_cells = nc;
+        g.number_of_faces = nconn;
+        // sequence and components, plus the internal workspace.
+        order_bytes = (2*nc + 1) * sizeof(int) + compute_sequence_workspace_bytes(&g, 0);
+    } else {
+        // ia, ja.
+        model_bytes = (nc + 1 + nconn) * sizeof(std::int64_t);
+        // sequence, components, tarjan workspace.
+        order_bytes = (2*nc + 1 + std::int64_t(tarjan_workspace_size(nc))) * sizeof(std::int64_t);
+    }
+    std::cerr << "Model: " << nc << " cells, " << nconn << " connections, "
+              << model_bytes / (1024*1024) << " MiB.\n"
+              << "Ordering: " << order_bytes / (1024*1024) << " MiB." << std::endl;
+
+    std::cout << "{\n  \"cells\": " << nc
+              << ",\n  \"connections\": " << nconn
+              << ",\n  \"index_bits\": " << index_bits
+              << ",\n  \"model_bytes\": " << model_bytes
+              << ",\n  \"ordering_bytes\": " << order_bytes;
+    if (dry_run) {
+        std::cout << "\n}\n";
+        return EXIT_SUCCESS;
+    }
+
+    time::StopWatch clock;
+    clock.start();
+    double best = std::numeric_limits<double>::max();
+    std::int64_t ncomp = 0, largest = 0;
+
+    if (index_bits == 32) {
+        CountConnections count = { 0, std::vector<int>(nc, 0) };
+        forEachConnection(m, count);
+
+        FillTopology topo;
+        topo.face_cells.reserve(2*nconn);
+        topo.flux.reserve(nconn);
+        topo.cell_faces.resize(2*nconn);
+        topo.pos.resize(nc + 1, 0);
+        for (std::int64_t c = 0; c < nc; ++c) {
+            topo.pos[c + 1] = topo.pos[c] + count.per_cell[c];
+        }
+        std::vector<int> cell_facepos(topo.pos);
+        std::vector<int>().swap(count.per_cell);
+        topo.rnd = Random(seed);
+        topo.reverse_fraction = reverse_fraction;
+        forEachConnection(m, topo);
+        std::vector<int>().swap(topo.pos);
+        clock.stop();
+        std::cerr << "Model setup: " << clock.secsSinceStart() << " s" << std::endl;
+
+        UnstructuredGrid g;
+        std::memset(&g, 0, sizeof(g));
+        g.dimensions = 3;
+        g.number_of_cells = nc;
+        g.number_of_faces = nconn;
+        g.face_cells = &topo.face_cells[0];
+        g.cell_faces = &topo.cell_faces[0];
+        g.cell_facepos = &cell_facepos[0];
+
+        std::vector<int> sequence(nc), components(nc + 1);
+        int n = 0;
+        for (int r = 0; r < repeat; ++r) {
+            clock.start();
+            compute_sequence(&g, &topo.flux[0], &sequence[0], &components[0], &n);
+            clock.stop();
+            best = std::min(best, clock.secsSinceStart());
+        }
+        ncomp = n;
+        for (int i = 0; i < n; ++i) {
+            largest = std::max(largest, std::int64_t(components[i + 1] - components[i]));
+        }
+    } else {
+        FillGraph graph;
+        graph.ia.assign(nc + 1, 0);
+        graph.rnd = Random(seed);
+        graph.reverse_fraction = reverse_fraction;
+        graph.count_only = true;
+        forEachConnection(m, graph);
+        for (std::int64_t c = 0; c < nc; ++c) {
+            graph.ia[c + 1] += graph.ia[c];
+        }
+        graph.ja.resize(nconn);
+        graph.rnd = Random(seed);
+        graph.count_only = false;
+        forEachConnection(m, graph);   // Shifts ia one position up.
+        for (std::int64_t c = nc; c > 0; --c) {
+            graph.ia[c] = graph.ia[c - 1];
+        }
+        graph.ia[0] = 0;
+        clock.stop();
+        std::cerr << "Model setup: " << clock.secsSinceStart() << " s" << std::endl;
+
+        std::vector<std::int64_t> sequence(nc), components(nc + 1);
+        std::vector<std::int64_t> work(tarjan_workspace_size(nc));
+        std::int64_t n = 0;
+        for (int r = 0; r < repeat; ++r) {
+            clock.start();
+            tarjan_64(nc, &graph.ia[0], &graph.ja[0], &sequence[0], &components[0], &n, &work[0]);
+            clock.stop();
+            best = std::min(best, clock.secsSinceStart());
+        }
+        ncomp = n;
+        for (std::int64_t i = 0; i < n; ++i) {
+            largest = std::max(largest, components[i + 1] - components[i]);
+        }
+    }
+
+    std::cout << ",\n  \"time\": " << best
+              << ",\n  \"components\": " << ncomp
+              << ",\n  \"largest_component\": " << largest
+              << ",\n  \"peak_rss_kb\": " << peakRssKb()
+              << "\n}\n";
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    throw;
+}
@@ -0,0 +1,185 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Time SaturationPropsFromDeck::relperm() and capPress() for all cells
+// of a deck, with per-cell and with batch evaluation, and report the
+// results as JSON. The program fails if the two do not give identical
+// values.
+//
+// Saturations are drawn in the allowed range of each cell, and the
+// cells are visited in a random order, as when evaluating over the
+// cells of a well or a partition.
+//
+// Parameters:
+//   deck_filename  Input deck.
+//   repeat         Number of timed evaluations (default 5).
+//   derivatives    Also compute saturation derivatives (default true).
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <opm/core/props/satfunc/SaturationPropsFromDeck.hpp>
+#include <opm/core/props/phaseUsageFromDeck.hpp>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/grid.h>
+#include <opm/core/utility/compressedToCartesian.hpp>
+#include <opm/core/utility/extractPvtTableIndex.hpp>
+#include <opm/core/utility/StopWatch.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <opm/material/fluidmatrixinteractions/EclMaterialLawManager.hpp>
+
+#include <opm/parser/eclipse/Parser/ParseContext.hpp>
+#include <opm/parser/eclipse/Parser/Parser.hpp>
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Result
+    {
+        double relperm_time;
+        double cappress_time;
+        std::vector<double> values;
+    };
+
+    Result timeEvaluation(const Opm::SaturationPropsFromDeck& props,
+                          const std::vector<double>& s,
+                          const std::vector<int>& cells,
+                          const bool derivatives,
+                          const int repeat)
+    {
+        const int n = cells.size();
+        const int np = props.numPhases();
+        std::vector<double> kr(n*np), pc(n*np);
+        std::vector<double> dkrds(derivatives ? n*np*np : 0), dpcds(derivatives ? n*np*np : 0);
+        Result result;
+        result.relperm_time = std::numeric_limits<double>::max();
+        result.cappress_time = std::numeric_limits<double>::max();
+        Opm::time::StopWatch clock;
+        for (int r = 0; r < repeat; ++r) {
+            clock.start();
+            props.relperm(n, s.data(), cells.data(), kr.data(), derivatives ? dkrds.data() : 0);
+            clock.stop();
+            result.relperm_time = std::min(result.relperm_time, clock.secsSinceStart());
+            clock.start();
+            props.capPress(n, s.data(), cells.data(), pc.data(), derivatives ? dpcds.data() : 0);
+            clock.stop();
+            result.cappress_time = std::min(result.cappress_time, clock.secsSinceStart());
+        }
+        result.values = kr;
+        result.values.insert(result.values.end(), dkrds.begin(), dkrds.end());
+        result.values.insert(result.values.end(), pc.begin(), pc.end());
+        result.values.insert(result.values.end(), dpcds.begin(), dpcds.end());
+        return result;
+    }
+} // anon namespace
+
+
+
+// ----------------- Main program -----------------
+int
+main(int argc, char** argv)
+try
+{
+    using namespace Opm;
+
+    ParameterGroup param(argc, argv);
+    const std::string deck_filename = param.get<std::string>("deck_filename");
+    const int repeat = param.getDefault("repeat", 5);
+    const bool derivatives = param.getDefault("derivatives", true);
+
+    ParseContext parseContext;
+    Parser parser;
+    const Deck& deck = parser.parseFile(deck_filename, parseContext);
+    const EclipseState eclState(deck, parseContext);
+    GridManager gm(eclState.getInputGrid());
+    const UnstructuredGrid& grid = *gm.c_grid();
+    const int nc = grid.number_of_cells;
+
+    const std::vector<int> compressedToCartesianIdx
+        = compressedToCartesian(nc, grid.global_cell);
+    auto materialLawManager = std::make_shared<SaturationPropsFromDeck::MaterialLawManager>();
+    materialLawManager->initFromDeck(deck, eclState, compressedToCartesianIdx);
+    SaturationPropsFromDeck props;
+    props.init(phaseUsageFromDeck(deck), materialLawManager);
+    std::vector<int> satnum;
+    extractSatTableIndex(satnum, eclState, nc, grid.global_cell);
+    props.initBatchEvaluation(satnum);
+    if (!props.batchEvaluation()) {
+        OPM_THROW(std::runtime_error, "Batch evaluation is not available for this deck (hysteresis?).");
+    }
+
+    // Random cell order and saturations within the range of each cell.
+    std::vector<int> cells(nc);
+    for (int cell = 0; cell < nc; ++cell) {
+        cells[cell] = cell;
+    }
+    std::mt19937 gen(1234);
+    std::shuffle(cells.begin(), cells.end(), gen);
+    const int np = props.numPhases();
+    std::vector<double> smin(nc*np), smax(nc*np), s(nc*np);
+    props.satRange(nc, cells.data(), smin.data(), smax.data());
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int i = 0; i < nc; ++i) {
+        double rest = 1.0;
+        for (int p = 0; p < np - 1; ++p) {
+            const double lo = smin[np*i + p];
+            const double hi = std::max(lo, std::min(smax[np*i + p], rest));
+            s[np*i + p] = lo + unit(gen)*(hi - lo);
+            rest -= s[np*i + p];
+        }
+        s[np*i + np - 1] = rest;
+    }
+
+    props.setBatchEvaluation(false);
+    const Result per_cell = timeEvaluation(props, s, cells, derivatives, repeat);
+    props.setBatchEvaluation(true);
+    const Result batch = timeEvaluation(props, s, cells, derivatives, repeat);
+    if (batch.values != per_cell.values) {
+        OPM_THROW(std::runtime_error, "Batch and per-cell evaluation differ.");
+    }
+
+    std::cout << "{\n  \"cells\": " << nc
+              << ",\n  \"classes\": " << props.numBatchClasses()
+              << ",\n  \"derivatives\": " << (derivatives ? "true" : "false")
+              << ",\n  \"per_cell\": { \"relperm\": " << per_cell.relperm_time
+              << ", \"cappress\": " << per_cell.cappress_time << " }"
+              << ",\n  \"batch\": { \"relperm\": " << batch.relperm_time
+              << ", \"cappress\": " << batch.cappress_time << " }"
+              << "\n}\n";
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception &e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    throw;
+}
@@ -111,8 +111,13 @@ try
     Opm::time::StopWatch timer;
     timer.start();
     std::vector<double> solution;
-    AnisotropicEikonal2d ae(grid);
-    ae.solve(metric.data(), startcells, solution);
+    if (grid.dimensions == 3) {
+        AnisotropicEikonal3d ae(grid);
+        ae.solve(metric.data(), startcells, solution);
+    } else {
+        AnisotropicEikonal2d ae(grid);
+        ae.solve(metric.data(), startcells, solution);
+    }
     timer.stop();
     double tt = timer.secsSinceStart();
     std::cout << "Eikonal solver took: " << tt << " seconds." << std::endl;
@@ -45,6 +45,11 @@
 #include <opm/core/pressure/IncompTpfa.hpp>
 #include <opm/core/flowdiagnostics/TofReorder.hpp>
 #include <opm/core/flowdiagnostics/TofDiscGalReorder.hpp>
+#include <opm/core/flowdiagnostics/DGBasis.hpp>
+#include <opm/core/flowdiagnostics/FlowDiagnostics.hpp>
+#include <opm/core/flowdiagnostics/CompressedTracers.hpp>
+#include <opm/core/flowdiagnostics/ColumnarFile.hpp>
+#include <opm/core/linalg/linsys_binary.h>
 
 #include <memory>
 #include <boost/filesystem.hpp>
@@ -66,6 +71,200 @@ namespace
             std::cout << "-------------------------------------------------------------------------" << std::endl;
         }
     }
+
+    // A cell or face field, read from a text file with one number per
+    // entry, or from a binary vector file as written by
+    // linsys_binary_write(), which is memory mapped and used in place.
+    class FieldInput
+    {
+    public:
+        FieldInput(const std::string& filename, const bool binary,
+                   const int expected_size, const std::string& what)
+            : binary_(binary)
+        {
+            if (binary_) {
+                if (linsys_binary_open(filename.c_str(), 0, &sys_) != 0
+                    || !(sys_.flags & LINSYS_HAS_VECTOR)) {
+                    OPM_THROW(std::runtime_error, "Could not read binary " << what << " field from " << filename);
+                }
+                size_ = sys_.n;
+                data_ = sys_.v;
+            } else {
+                std::ifstream stream(filename.c_str());
+                std::istream_iterator<double> beg(stream);
+                std::istream_iterator<double> end;
+                values_.assign(beg, end);
+                size_ = values_.size();
+                data_ = values_.empty() ? 0 : &values_[0];
+            }
+            if (int(size_) != expected_size) {
+                OPM_THROW(std::runtime_error, "Size of " << what << " field is " << size_
+                          << ", expected " << expected_size << ".");
+            }
+        }
+
+        ~FieldInput()
+        {
+            if (binary_) {
+                linsys_binary_close(&sys_);
+            }
+        }
+
+        const double* data() const
+        {
+            return data_;
+        }
+
+    private:
+        FieldInput(const FieldInput&);
+        FieldInput& operator=(const FieldInput&);
+
+        bool binary_;
+        LinsysBinary sys_;
+        std::vector<double> values_;
+        const double* data_;
+        std::size_t size_;
+    };
+
+
+
+    Opm::SparseTable<int> readTracerheads(const std::string& filename)
+    {
+        Opm::SparseTable<int> tracerheads;
+        std::ifstream tr_stream(filename.c_str());
+        if (!tr_stream) {
+            OPM_THROW(std::runtime_error, "Could not open tracer heads file " << filename);
+        }
+        int num_rows;
+        tr_stream >> num_rows;
+        for (int row = 0; row < num_rows; ++row) {
+            int row_size;
+            tr_stream >> row_size;
+            std::vector<int> rowdata(row_size);
+            for (int elem = 0; elem < row_size; ++elem) {
+                tr_stream >> rowdata[elem];
+            }
+            tracerheads.appendRow(rowdata.begin(), rowdata.end());
+        }
+        return tracerheads;
+    }
+
+
+
+    // Solve for time-of-flight and, if tracerheads is nonempty,
+    // tracers. Tracers are computed batch_size at a time and moved to
+    // compressed storage after each batch, which bounds the memory
+    // used for uncompressed tracers. The discontinuous Galerkin
+    // solver gives K coefficients per tracer and cell, which are
+    // stored as K consecutive tracers. If averages is non-null, the
+    // cell averages of the tracers are stored there as well.
+    template <class Solver>
+    void solveTofAndTracers(Solver& solver,
+                            const int num_cells,
+                            const double* flux,
+                            const double* porevol,
+                            const double* src,
+                            const Opm::SparseTable<int>& tracerheads,
+                            const int batch_size,
+                            const Opm::DGBasisInterface* basis,
+                            std::vector<double>& tof,
+                            Opm::CompressedTracers& tracers,
+                            Opm::CompressedTracers* averages)
+    {
+        const int num_tracers = tracerheads.size();
+        if (num_tracers == 0) {
+            solver.solveTof(flux, porevol, src, tof);
+            return;
+        }
+        const int k = basis ? basis->numBasisFunc() : 1;
+        const int batch = (batch_size > 0) ? batch_size : num_tracers;
+        std::vector<double> tracer;
+        std::vector<double> average;
+        for (int first = 0; first < num_tracers; first += batch) {
+            const int last = std::min(num_tracers, first + batch);
+            Opm::SparseTable<int> heads;
+            for (int t = first; t < last; ++t) {
+                heads.appendRow(tracerheads[t].begin(), tracerheads[t].end());
+            }
+            // The solver sets all tracers but one to zero in the head
+            // cells of each tracer. An extra tracer, dropped below,
+            // holds the heads of the tracers outside the batch so
+            // batches give the same result as a single solve.
+            std::vector<int> other_heads;
+            for (int t = 0; t < num_tracers; ++t) {
+                if (t < first || t >= last) {
+                    other_heads.insert(other_heads.end(), tracerheads[t].begin(), tracerheads[t].end());
+                }
+            }
+            const bool extra = !other_heads.empty();
+            if (extra) {
+                heads.appendRow(other_heads.begin(), other_heads.end());
+            }
+            // Time-of-flight is the same for all batches.
+            std::vector<double> batch_tof;
+            solver.solveTofTracer(flux, porevol, src, heads, first == 0 ? tof : batch_tof, tracer);
+            const int nb = last - first;
+            if (extra) {
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    std::copy(tracer.begin() + cell*(nb + 1)*k,
+                              tracer.begin() + (cell*(nb + 1) + nb)*k,
+                              tracer.begin() + cell*nb*k);
+                }
+                tracer.resize(num_cells*nb*k);
+            }
+            tracers.append(tracer, nb*k);
+            if (averages) {
+                average.resize(num_cells*nb);
+                for (int i = 0; i < num_cells*nb; ++i) {
+                    average[i] = basis ? basis->functionAverage(&tracer[i*k]) : tracer[i];
+                }
+                averages->append(average, nb);
+            }
+        }
+    }
+
+
+
+    // Cell averages of a field given by K coefficients per cell.
+    std::vector<double> cellAverages(const Opm::DGBasisInterface& basis,
+                                     const std::vector<double>& coeff)
+    {
+        const int k = basis.numBasisFunc();
+        std::vector<double> average(coeff.size()/k);
+        for (std::size_t cell = 0; cell < average.size(); ++cell) {
+            average[cell] = basis.functionAverage(&coeff[cell*k]);
+        }
+        return average;
+    }
+
+
+
+    void writeText(const std::string& filename, const std::vector<double>& values)
+    {
+        std::ofstream stream(filename.c_str());
+        stream.precision(16);
+        std::copy(values.begin(), values.end(), std::ostream_iterator<double>(stream, "\n"));
+    }
+
+
+
+    // One line per cell, with the values of all tracers.
+    void writeText(const std::string& filename, const Opm::CompressedTracers& tracers)
+    {
+        std::ofstream stream(filename.c_str());
+        stream.precision(16);
+        const int nc = tracers.numCells();
+        const int nt = tracers.numTracers();
+        const int block_size = 1024;
+        std::vector<double> block(block_size*nt);
+        for (int begin = 0; begin < nc; begin += block_size) {
+            const int end = std::min(nc, begin + block_size);
+            tracers.expand(begin, end, block.empty() ? 0 : &block[0]);
+            for (int i = 0; i < (end - begin)*nt; ++i) {
+                stream << block[i] << (((i + 1) % nt == 0) ? '\n' : ' ');
+            }
+        }
+    }
 } // anon namespace
 
 
@@ -83,62 +282,66 @@ try
     GridManager grid_manager(param.get<std::string>("grid_filename"));
     const UnstructuredGrid& grid = *grid_manager.c_grid();
 
-    // Read porosity, compute pore volume.
-    std::vector<double> porevol;
-    {
-        std::ifstream poro_stream(param.get<std::string>("poro_filename").c_str());
-        std::istream_iterator<double> beg(poro_stream);
-        std::istream_iterator<double> end;
-        porevol.assign(beg, end); // Now contains poro.
-        if (int(porevol.size()) != grid.number_of_cells) {
-            OPM_THROW(std::runtime_error, "Size of porosity field differs from number of cells.");
-        }
-        for (int i = 0; i < grid.number_of_cells; ++i) {
-            porevol[i] *= grid.cell_volumes[i];
-        }
+    // Input fields are text files with one number per entry by
+    // default, or binary vector files (see linsys_binary.h), which are
+    // memory mapped.
+    const std::string input_format = param.getDefault("input_format", std::string("text"));
+    if (input_format != "text" && input_format != "binary") {
+        OPM_THROW(std::runtime_error, "Unknown input_format " << input_format << ", use text or binary.");
     }
+    const bool binary_input = input_format == "binary";
 
-    // Read flux.
-    std::vector<double> flux;
+    // Read porosity, compute pore volume.
+    std::vector<double> porevol(grid.number_of_cells);
     {
-        std::ifstream flux_stream(param.get<std::string>("flux_filename").c_str());
-        std::istream_iterator<double> beg(flux_stream);
-        std::istream_iterator<double> end;
-        flux.assign(beg, end);
-        if (int(flux.size()) != grid.number_of_faces) {
-            OPM_THROW(std::runtime_error, "Size of flux field differs from number of faces.");
+        const FieldInput poro(param.get<std::string>("poro_filename"), binary_input,
+                              grid.number_of_cells, "porosity");
+        for (int i = 0; i < grid.number_of_cells; ++i) {
+            porevol[i] = poro.data()[i] * grid.cell_volumes[i];
         }
     }
 
-    // Read source terms.
-    std::vector<double> src;
-    {
-        std::ifstream src_stream(param.get<std::string>("src_filename").c_str());
-        std::istream_iterator<double> beg(src_stream);
-        std::istream_iterator<double> end;
-        src.assign(beg, end);
-        if (int(src.size()) != grid.number_of_cells) {
-            OPM_THROW(std::runtime_error, "Size of source term field differs from number of cells.");
-        }
-    }
+    // Read flux and source terms.
+    const FieldInput flux(param.get<std::string>("flux_filename"), binary_input,
+                          grid.number_of_faces, "flux");
+    const FieldInput src(param.get<std::string>("src_filename"), binary_input,
+                         grid.number_of_cells, "source term");
 
+    // Tracers, and the reverse problem (from producers) for
+    // F-Phi, Lorenz coefficient and well-pair volumes.
     const bool compute_tracer = param.getDefault("compute_tracer", false);
+    const bool compute_reverse = param.getDefault("compute_reverse", false);
     Opm::SparseTable<int> tracerheads;
+    Opm::SparseTable<int> reverse_tracerheads;
     if (compute_tracer) {
-        std::ifstream tr_stream(param.get<std::string>("tracerheads_filename").c_str());
-        int num_rows;
-        tr_stream >> num_rows;
-        for (int row = 0; row < num_rows; ++row) {
-            int row_size;
-            tr_stream >> row_size;
-            std::vector<int> rowdata(row_size);
-            for (int elem = 0; elem < row_size; ++elem) {
-                tr_stream >> rowdata[elem];
-            }
-            tracerheads.appendRow(rowdata.begin(), rowdata.end());
+        tracerheads = readTracerheads(param.get<std::string>("tracerheads_filename"));
+        if (compute_reverse) {
+            reverse_tracerheads = readTracerheads(param.get<std::string>("reverse_tracerheads_filename"));
         }
     }
 
+    // Tracer storage: double, float or sparse (float values of the
+    // cells where the tracer exceeds sparse_tracer_tolerance).
+    const std::string tracer_storage = param.getDefault("tracer_storage", std::string("double"));
+    CompressedTracers::Storage storage = CompressedTracers::Double;
+    if (tracer_storage == "float") {
+        storage = CompressedTracers::Float;
+    } else if (tracer_storage == "sparse") {
+        storage = CompressedTracers::Sparse;
+    } else if (tracer_storage != "double") {
+        OPM_THROW(std::runtime_error, "Unknown tracer_storage " << tracer_storage
+                  << ", use double, float or sparse.");
+    }
+    const double sparse_tolerance = param.getDefault("sparse_tracer_tolerance", 0.0);
+    const int tracer_batch_size = param.getDefault("tracer_batch_size", 0);
+    const bool parallel_sweep = param.getDefault("parallel_sweep", false);
+
+    // Output as text files, or as a single columnar binary file.
+    const std::string output_format = param.getDefault("output_format", std::string("text"));
+    if (output_format != "text" && output_format != "binary") {
+        OPM_THROW(std::runtime_error, "Unknown output_format " << output_format << ", use text or binary.");
+    }
+
     // Choice of tof solver.
     bool use_dg = param.getDefault("use_dg", false);
     bool use_multidim_upwind = false;
@@ -170,44 +373,134 @@ try
     // Issue a warning if any parameters were unused.
     warnIfUnusedParams(param);
 
-    // Solve time-of-flight.
+    // Cell values for the diagnostics. With a discontinuous Galerkin
+    // solver of degree above zero, these are cell averages computed
+    // with a basis matching the one used by the solver.
+    std::unique_ptr<DGBasisInterface> basis;
+    if (use_dg && param.getDefault("dg_degree", 0) > 0) {
+        if (param.getDefault("use_tensorial_basis", false)) {
+            basis.reset(new DGBasisMultilin(grid, param.getDefault("dg_degree", 0)));
+        } else {
+            basis.reset(new DGBasisBoundedTotalDegree(grid, param.getDefault("dg_degree", 0)));
+        }
+    }
+    const bool average_tracers = basis && compute_reverse;
+
+    // Solve time-of-flight, from injectors and optionally from producers.
     Opm::time::StopWatch transport_timer;
     transport_timer.start();
+    const int nc = grid.number_of_cells;
     std::vector<double> tof;
-    std::vector<double> tracer;
+    std::vector<double> rtof;
+    CompressedTracers tracers(nc, storage, sparse_tolerance);
+    CompressedTracers rtracers(nc, storage, sparse_tolerance);
+    CompressedTracers tracer_avg(nc, storage, sparse_tolerance);
+    CompressedTracers rtracer_avg(nc, storage, sparse_tolerance);
+    std::vector<double> rflux;
+    std::vector<double> rsrc;
+    if (compute_reverse) {
+        rflux.assign(flux.data(), flux.data() + grid.number_of_faces);
+        rsrc.assign(src.data(), src.data() + nc);
+        for (double& f : rflux) {
+            f = -f;
+        }
+        for (double& q : rsrc) {
+            q = -q;
+        }
+    }
     if (use_dg) {
-        if (compute_tracer) {
-            dg_solver->solveTofTracer(&flux[0], &porevol[0], &src[0], tracerheads, tof, tracer);
-        } else {
-            dg_solver->solveTof(&flux[0], &porevol[0], &src[0], tof);
+        dg_solver->setParallelSweep(parallel_sweep);
+        solveTofAndTracers(*dg_solver, nc, flux.data(), &porevol[0], src.data(),
+                           tracerheads, tracer_batch_size, basis.get(),
+                           tof, tracers, average_tracers ? &tracer_avg : 0);
+        if (compute_reverse) {
+            solveTofAndTracers(*dg_solver, nc, &rflux[0], &porevol[0], &rsrc[0],
+                               reverse_tracerheads, tracer_batch_size, basis.get(),
+                               rtof, rtracers, average_tracers ? &rtracer_avg : 0);
         }
     } else {
         Opm::TofReorder tofsolver(grid, use_multidim_upwind);
-        if (compute_tracer) {
-            tofsolver.solveTofTracer(&flux[0], &porevol[0], &src[0], tracerheads, tof, tracer);
-        } else {
-            tofsolver.solveTof(&flux[0], &porevol[0], &src[0], tof);
+        tofsolver.setParallelSweep(parallel_sweep);
+        solveTofAndTracers(tofsolver, nc, flux.data(), &porevol[0], src.data(),
+                           tracerheads, tracer_batch_size, 0, tof, tracers, 0);
+        if (compute_reverse) {
+            solveTofAndTracers(tofsolver, nc, &rflux[0], &porevol[0], &rsrc[0],
+                               reverse_tracerheads, tracer_batch_size, 0, rtof, rtracers, 0);
         }
     }
     transport_timer.stop();
     double tt = transport_timer.secsSinceStart();
     std::cout << "Transport solver took: " << tt << " seconds." << std::endl;
+    if (compute_tracer) {
+        const std::size_t bytes = tracers.memoryUsage() + rtracers.memoryUsage()
+            + tracer_avg.memoryUsage() + rtracer_avg.memoryUsage();
+        std::cout << "Tracer storage: " << bytes/(1024.0*1024.0) << " MB." << std::endl;
+    }
+
+    // Diagnostics from both directions.
+    std::pair<std::vector<double>, std::vector<double> > fphi;
+    double lorenz = 0.0;
+    WellPairVolumes wellpairs;
+    if (compute_reverse) {
+        if (basis) {
+            fphi = computeFandPhi(porevol, cellAverages(*basis, tof), cellAverages(*basis, rtof));
+        } else {
+            fphi = computeFandPhi(porevol, tof, rtof);
+        }
+        lorenz = computeLorenz(fphi.first, fphi.second);
+        std::cout << "Lorenz coefficient: " << lorenz << std::endl;
+        if (compute_tracer) {
+            wellpairs = basis ? computeWellPairVolumes(porevol, tracer_avg, rtracer_avg)
+                              : computeWellPairVolumes(porevol, tracers, rtracers);
+        }
+    }
 
     // Output.
-    if (output) {
-        std::string tof_filename = output_dir + "/tof.txt";
-        std::ofstream tof_stream(tof_filename.c_str());
-        tof_stream.precision(16);
-        std::copy(tof.begin(), tof.end(), std::ostream_iterator<double>(tof_stream, "\n"));
+    if (output && output_format == "text") {
+        writeText(output_dir + "/tof.txt", tof);
         if (compute_tracer) {
-            std::string tracer_filename = output_dir + "/tracer.txt";
-            std::ofstream tracer_stream(tracer_filename.c_str());
-            tracer_stream.precision(16);
-            const int nt = tracer.size()/grid.number_of_cells;
-            for (int i = 0; i < nt*grid.number_of_cells; ++i) {
-                tracer_stream << tracer[i] << (((i + 1) % nt == 0) ? '\n' : ' ');
+            writeText(output_dir + "/tracer.txt", tracers);
+        }
+        if (compute_reverse) {
+            writeText(output_dir + "/rtof.txt", rtof);
+            if (compute_tracer) {
+                writeText(output_dir + "/rtracer.txt", rtracers);
+            }
+            std::ofstream fphi_stream((output_dir + "/fphi.txt").c_str());
+            fphi_stream.precision(16);
+            for (std::size_t i = 0; i < fphi.first.size(); ++i) {
+                fphi_stream << fphi.first[i] << ' ' << fphi.second[i] << '\n';
+            }
+            if (compute_tracer) {
+                std::ofstream wp_stream((output_dir + "/wellpairs.txt").c_str());
+                wp_stream.precision(16);
+                for (std::size_t i = 0; i < wellpairs.injectors.size(); ++i) {
+                    for (std::size_t p = 0; p < wellpairs.producers.size(); ++p) {
+                        wp_stream << i << ' ' << p << ' ' << wellpairs(i, p) << '\n';
+                    }
+                }
+            }
+        }
+    } else if (output) {
+        // All results in one file, see ColumnarWriter for the format.
+        ColumnarWriter writer(output_dir + "/diagnostics.opmcol");
+        writer.write("tof", tof);
+        if (compute_tracer) {
+            tracers.write(writer, "tracer");
+        }
+        if (compute_reverse) {
+            writer.write("rtof", rtof);
+            if (compute_tracer) {
+                rtracers.write(writer, "rtracer");
+            }
+            writer.write("F", fphi.first);
+            writer.write("Phi", fphi.second);
+            writer.write("lorenz", &lorenz, 1);
+            if (compute_tracer) {
+                writer.write("wellpair_volume", wellpairs.volume);
             }
         }
+        writer.close();
     }
 }
 catch (const std::exception &e) {
@@ -23,6 +23,10 @@
 #include <opm/core/grid.h>
 #include <opm/core/utility/RootFinders.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
 #if BOOST_HEAP_AVAILABLE
 
 namespace Opm
@@ -31,27 +35,109 @@ namespace Opm
     namespace
     {
         /// Euclidean (isotropic) distance.
-        double distanceIso(const double v1[2],
-                           const double v2[2])
+        template <int dim>
+        double distanceIso(const double* v1,
+                           const double* v2)
         {
-            const double d[2] = { v2[0] - v1[0], v2[1] - v1[1] };
-            const double dist = std::sqrt(d[0]*d[0] + d[1]*d[1]);
-            return dist;
+            double dist2 = 0.0;
+            for (int d = 0; d < dim; ++d) {
+                dist2 += (v2[d] - v1[d])*(v2[d] - v1[d]);
+            }
+            return std::sqrt(dist2);
         }
 
         /// Anisotropic distance with respect to a metric g.
         /// If d = v2 - v1, the distance is sqrt(d^T g d).
-        double distanceAniso(const double v1[2],
-                             const double v2[2],
-                             const double g[4])
+        template <int dim>
+        double distanceAniso(const double* v1,
+                             const double* v2,
+                             const double* g)
         {
-            const double d[2] = { v2[0] - v1[0], v2[1] - v1[1] };
-            const double dist = std::sqrt(+ g[0] * d[0] * d[0]
-                                          + g[1] * d[0] * d[1]
-                                          + g[2] * d[1] * d[0]
-                                          + g[3] * d[1] * d[1]);
-            return dist;
+            double d[dim];
+            for (int i = 0; i < dim; ++i) {
+                d[i] = v2[i] - v1[i];
+            }
+            double dist2 = 0.0;
+            for (int i = 0; i < dim; ++i) {
+                for (int j = 0; j < dim; ++j) {
+                    dist2 += g[dim*i + j] * d[i] * d[j];
+                }
+            }
+            return std::sqrt(dist2);
         }
+
+        /// Largest ratio of eigenvalues of a symmetric 2x2 matrix.
+        double eigenvalueRatio(const double* m, std::integral_constant<int, 2>)
+        {
+            // Find the two eigenvalues from trace and determinant.
+            const double t = m[0] + m[3];
+            const double d = m[0]*m[3] - m[1]*m[2];
+            const double sd = std::sqrt(t*t/4.0 - d);
+            const double eig[2] = { t/2.0 - sd, t/2.0 + sd };
+            // Anisotropy ratio is the max ratio of the eigenvalues.
+            return std::max(eig[0]/eig[1], eig[1]/eig[0]);
+        }
+
+        /// Largest ratio of eigenvalues of a symmetric positive
+        /// definite 3x3 matrix.
+        double eigenvalueRatio(const double* m, std::integral_constant<int, 3>)
+        {
+            // Closed form eigenvalues of a symmetric 3x3 matrix, see
+            // O. K. Smith, "Eigenvalues of a symmetric 3 x 3 matrix",
+            // Comm. ACM 4(4), 1961.
+            const double p1 = m[1]*m[1] + m[2]*m[2] + m[5]*m[5];
+            const double q = (m[0] + m[4] + m[8])/3.0;
+            const double p2 = (m[0] - q)*(m[0] - q) + (m[4] - q)*(m[4] - q)
+                + (m[8] - q)*(m[8] - q) + 2.0*p1;
+            const double p = std::sqrt(p2/6.0);
+            if (p <= 1e-14*std::fabs(q)) {
+                // Multiple of the identity.
+                return 1.0;
+            }
+            double b[9];
+            for (int i = 0; i < 9; ++i) {
+                b[i] = (m[i] - ((i % 4 == 0) ? q : 0.0))/p;
+            }
+            const double det_b = b[0]*(b[4]*b[8] - b[5]*b[7])
+                - b[1]*(b[3]*b[8] - b[5]*b[6])
+                + b[2]*(b[3]*b[7] - b[4]*b[6]);
+            const double r = std::max(-1.0, std::min(1.0, det_b/2.0));
+            const double phi = std::acos(r)/3.0;
+            const double pi = 3.14159265358979323846;
+            const double eig_max = q + 2.0*p*std::cos(phi);
+            const double eig_min = q + 2.0*p*std::cos(phi + 2.0*pi/3.0);
+            return eig_max/eig_min;
+        }
+
+        /// Derivative of the distance from the point x to the point
+        /// (1 - theta) x1 + theta x2, plus the interpolated value.
+        template <int dim>
+        struct DistanceDerivative
+        {
+            const double* x1;
+            const double* x2;
+            const double* x;
+            double u1;
+            double u2;
+            const double* g;
+            double operator()(const double theta) const
+            {
+                double xt[dim], a[dim], b[dim];
+                for (int d = 0; d < dim; ++d) {
+                    xt[d] = (1-theta)*x1[d] + theta*x2[d];
+                    a[d] = x[d] - xt[d];
+                    b[d] = x1[d] - x2[d];
+                }
+                double dQdtheta = 0.0;
+                for (int i = 0; i < dim; ++i) {
+                    for (int j = 0; j < dim; ++j) {
+                        dQdtheta += 2*a[i]*b[j]*g[dim*i + j];
+                    }
+                }
+                const double val =  u2 - u1 + dQdtheta/(2*distanceAniso<dim>(x, xt, g));
+                return val;
+            }
+        };
     } // anonymous namespace
 
 
@@ -60,16 +146,20 @@ namespace Opm
 
 
     /// Construct solver.
-    /// \param[in] grid      A 2d grid.
-    AnisotropicEikonal2d::AnisotropicEikonal2d(const UnstructuredGrid& grid)
+    /// \param[in] grid      A grid of dimension dim.
+    template <int dim>
+    AnisotropicEikonal<dim>::AnisotropicEikonal(const UnstructuredGrid& grid)
         : grid_(grid),
           safety_factor_(1.2)
     {
-        if (grid.dimensions != 2) {
-            OPM_THROW(std::logic_error, "Grid for AnisotropicEikonal2d must be 2d.");
+        if (grid.dimensions != dim) {
+            OPM_THROW(std::logic_error, "Grid for AnisotropicEikonal" << dim << "d must be " << dim << "d.");
         }
         cell_neighbours_ = cellNeighboursAcrossVertices(grid);
-        orderCounterClockwise(grid, cell_neighbours_);
+        if (dim == 2) {
+            orderCounterClockwise(grid, cell_neighbours_);
+        }
+        computeNeighbourPairs();
         computeGridRadius();
     }
 
@@ -77,9 +167,10 @@ namespace Opm
     /// \param[in]  metric            Array of metric tensors, M, for each cell.
     /// \param[in]  startcells        Array of cells where u = 0 at the centroid.
     /// \param[out] solution          Array of solution to the eikonal equation.
-    void AnisotropicEikonal2d::solve(const double* metric,
-                                     const std::vector<int>& startcells,
-                                     std::vector<double>& solution)
+    template <int dim>
+    void AnisotropicEikonal<dim>::solve(const double* metric,
+                                        const std::vector<int>& startcells,
+                                        std::vector<double>& solution)
     {
         // Compute anisotropy ratios to be used by isClose().
         computeAnisoRatio(metric);
@@ -107,13 +198,11 @@ namespace Opm
         const double inf = 1e100;
         solution.clear();
         solution.resize(num_cells, inf);
-        is_accepted_.clear();
-        is_accepted_.resize(num_cells, false);
-        accepted_front_.clear();
+        is_accepted_.assign(num_cells, false);
+        is_front_.assign(num_cells, false);
         considered_.clear();
-        considered_handles_.clear();
-        is_considered_.clear();
-        is_considered_.resize(num_cells, false);
+        considered_handles_.resize(num_cells);
+        is_considered_.assign(num_cells, false);
 
         // 2. Move the startcells to Accepted. U_i = q(x_i)
         const int num_startcells = startcells.size();
@@ -121,7 +210,9 @@ namespace Opm
             is_accepted_[startcells[ii]] = true;
             solution[startcells[ii]] = 0.0;
         }
-        accepted_front_.insert(startcells.begin(), startcells.end());
+        for (int ii = 0; ii < num_startcells; ++ii) {
+            is_front_[startcells[ii]] = hasUnacceptedNeighbour(startcells[ii]);
+        }
 
         // 3. Move cells adjacent to startcells to Considered, evaluate
         //    U_i = min_{(x_j,x_k) \in NF(x_i)} G_{j,k}
@@ -140,38 +231,29 @@ namespace Opm
         while (!considered_.empty()) {
             // 4. Find the Considered cell with the smallest value: r.
             const ValueAndCell r = topConsidered();
-            // std::cout << "Accepting cell " << r.second << std::endl;
 
             // 5. Move cell r to Accepted. Update AcceptedFront.
+            //    Only r and its neighbours can change front status.
             const int rcell = r.second;
             is_accepted_[rcell] = true;
             solution[rcell] = r.first;
             popConsidered();
-            accepted_front_.insert(rcell);
-            for (auto it = accepted_front_.begin(); it != accepted_front_.end();) {
-                // Note that loop increment happens in the body of this loop.
-                const int cell = *it;
-                bool on_front = false;
-                for (auto it2 = cell_neighbours_[cell].begin(); it2 != cell_neighbours_[cell].end(); ++it2) {
-                    if (!is_accepted_[*it2]) {
-                        on_front = true;
-                        break;
-                    }
-                }
-                if (!on_front) {
-                    accepted_front_.erase(it++);
-                } else {
-                    ++it;
+            is_front_[rcell] = hasUnacceptedNeighbour(rcell);
+            for (auto it = cell_neighbours_[rcell].begin(); it != cell_neighbours_[rcell].end(); ++it) {
+                if (is_front_[*it] && !hasUnacceptedNeighbour(*it)) {
+                    is_front_[*it] = false;
                 }
             }
 
             // 6. Recompute the value for all Considered cells within
             //    distance h * F_2/F1 from x_r. Use min of previous and new.
-            for (auto it = considered_.begin(); it != considered_.end(); ++it) {
-                const int ccell = it->second;
-                if (isClose(rcell, ccell)) {
+            //    The update stencil of a cell is its neighbours, so
+            //    only the Considered neighbours of r can change.
+            for (auto it = cell_neighbours_[rcell].begin(); it != cell_neighbours_[rcell].end(); ++it) {
+                const int ccell = *it;
+                if (is_considered_[ccell] && isClose(rcell, ccell)) {
                     const double value = computeValueUpdate(ccell, metric, solution.data(), rcell);
-                    if (value < it->first) {
+                    if (value < (*considered_handles_[ccell]).first) {
                         // Update value for considered cell.
                         // Note that as solution values decrease, their
                         // goodness w.r.t. the heap comparator increase,
@@ -201,30 +283,46 @@ namespace Opm
 
 
 
-    bool AnisotropicEikonal2d::isClose(const int c1,
-                                       const int c2) const
+    template <int dim>
+    bool AnisotropicEikonal<dim>::isClose(const int c1,
+                                          const int c2) const
     {
-        const double* v[] = { grid_.cell_centroids + 2*c1,
-                              grid_.cell_centroids + 2*c2 };
-        return distanceIso(v[0], v[1]) < safety_factor_ * aniso_ratio_[c1] * grid_radius_[c1];
+        const double* v[] = { grid_.cell_centroids + dim*c1,
+                              grid_.cell_centroids + dim*c2 };
+        return distanceIso<dim>(v[0], v[1]) < safety_factor_ * aniso_ratio_[c1] * grid_radius_[c1];
     }
 
 
 
 
 
-    double AnisotropicEikonal2d::computeValue(const int cell,
-                                              const double* metric,
-                                              const double* solution) const
+    template <int dim>
+    bool AnisotropicEikonal<dim>::hasUnacceptedNeighbour(const int cell) const
+    {
+        for (auto it = cell_neighbours_[cell].begin(); it != cell_neighbours_[cell].end(); ++it) {
+            if (!is_accepted_[*it]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+
+
+
+    template <int dim>
+    double AnisotropicEikonal<dim>::computeValue(const int cell,
+                                                 const double* metric,
+                                                 const double* solution) const
     {
-        // std::cout << "++++ computeValue(), cell = " << cell << std::endl;
-        const auto& nbs = cell_neighbours_[cell];
-        const int num_nbs = nbs.size();
+        const auto& pairs = neighbour_pairs_[cell];
+        const int num_pairs = pairs.size()/2;
         const double inf = 1e100;
         double val = inf;
-        for (int ii = 0; ii < num_nbs; ++ii) {
-            const int n[2] = { nbs[ii], nbs[(ii+1) % num_nbs] };
-            if (accepted_front_.count(n[0]) && accepted_front_.count(n[1])) {
+        for (int ii = 0; ii < num_pairs; ++ii) {
+            const int n[2] = { pairs[2*ii], pairs[2*ii + 1] };
+            if (is_front_[n[0]] && is_front_[n[1]]) {
                 const double cand_val = computeFromTri(cell, n[0], n[1], metric, solution);
                 val = std::min(val, cand_val);
             }
@@ -232,15 +330,16 @@ namespace Opm
         if (val == inf) {
             // Failed to find two accepted front nodes adjacent to this,
             // so we go for a single-neighbour update.
+            const auto& nbs = cell_neighbours_[cell];
+            const int num_nbs = nbs.size();
             for (int ii = 0; ii < num_nbs; ++ii) {
-                if (accepted_front_.count(nbs[ii])) {
+                if (is_front_[nbs[ii]]) {
                     const double cand_val = computeFromLine(cell, nbs[ii], metric, solution);
                     val = std::min(val, cand_val);
                 }
             }
         }
         assert(val != inf);
-        // std::cout << "---> " << val << std::endl;
         return val;
     }
 
@@ -248,35 +347,29 @@ namespace Opm
 
 
 
-    double AnisotropicEikonal2d::computeValueUpdate(const int cell,
-                                                    const double* metric,
-                                                    const double* solution,
-                                                    const int new_cell) const
+    template <int dim>
+    double AnisotropicEikonal<dim>::computeValueUpdate(const int cell,
+                                                       const double* metric,
+                                                       const double* solution,
+                                                       const int new_cell) const
     {
-        // std::cout << "++++ computeValueUpdate(), cell = " << cell << std::endl;
-        const auto& nbs = cell_neighbours_[cell];
-        const int num_nbs = nbs.size();
+        const auto& pairs = neighbour_pairs_[cell];
+        const int num_pairs = pairs.size()/2;
         const double inf = 1e100;
         double val = inf;
-        for (int ii = 0; ii < num_nbs; ++ii) {
-            const int n[2] = { nbs[ii], nbs[(ii+1) % num_nbs] };
+        for (int ii = 0; ii < num_pairs; ++ii) {
+            const int n[2] = { pairs[2*ii], pairs[2*ii + 1] };
             if ((n[0] == new_cell || n[1] == new_cell)
-                && accepted_front_.count(n[0]) && accepted_front_.count(n[1])) {
+                && is_front_[n[0]] && is_front_[n[1]]) {
                 const double cand_val = computeFromTri(cell, n[0], n[1], metric, solution);
                 val = std::min(val, cand_val);
             }
         }
-        if (val == inf) {
+        if (val == inf && is_front_[new_cell]) {
             // Failed to find two accepted front nodes adjacent to this,
             // so we go for a single-neighbour update.
-            for (int ii = 0; ii < num_nbs; ++ii) {
-                if (nbs[ii] == new_cell && accepted_front_.count(nbs[ii])) {
-                    const double cand_val = computeFromLine(cell, nbs[ii], metric, solution);
-                    val = std::min(val, cand_val);
-                }
-            }
+            val = computeFromLine(cell, new_cell, metric, solution);
         }
-        // std::cout << "---> " << val << std::endl;
         return val;
     }
 
@@ -284,18 +377,19 @@ namespace Opm
 
 
 
-    double AnisotropicEikonal2d::computeFromLine(const int cell,
-                                                 const int from,
-                                                 const double* metric,
-                                                 const double* solution) const
+    template <int dim>
+    double AnisotropicEikonal<dim>::computeFromLine(const int cell,
+                                                    const int from,
+                                                    const double* metric,
+                                                    const double* solution) const
     {
         assert(!is_accepted_[cell]);
         assert(is_accepted_[from]);
         // Applying the first fundamental form to compute geodesic distance.
         // Using the metric of 'cell', not 'from'.
-        const double dist = distanceAniso(grid_.cell_centroids + 2 * cell,
-                                          grid_.cell_centroids + 2 * from,
-                                          metric + 4 * cell);
+        const double dist = distanceAniso<dim>(grid_.cell_centroids + dim * cell,
+                                               grid_.cell_centroids + dim * from,
+                                               metric + dim * dim * cell);
         return solution[from] + dist;
     }
 
@@ -303,54 +397,32 @@ namespace Opm
 
 
 
-    struct DistanceDerivative
+    template <int dim>
+    double AnisotropicEikonal<dim>::computeFromTri(const int cell,
+                                                   const int n0,
+                                                   const int n1,
+                                                   const double* metric,
+                                                   const double* solution) const
     {
-        const double* x1;
-        const double* x2;
-        const double* x;
-        double u1;
-        double u2;
-        const double* g;
-        double operator()(const double theta) const
-        {
-            const double xt[2] = { (1-theta)*x1[0] + theta*x2[0], (1-theta)*x1[1] + theta*x2[1] };
-            const double a[2] = { x[0] - xt[0], x[1] - xt[1] };
-            const double b[2] = { x1[0] - x2[0], x1[1] - x2[1] };
-            const double dQdtheta = 2*(a[0]*b[0]*g[0] + a[0]*b[1]*g[1] + a[1]*b[0]*g[2] + a[1]*b[1]*g[3]);
-            const double val =  u2 - u1 + dQdtheta/(2*distanceAniso(x, xt, g));
-            // std::cout << theta << "   " << val << std::endl;
-            return val;
-        }
-    };
-
-
-
-
-
-    double AnisotropicEikonal2d::computeFromTri(const int cell,
-                                                const int n0,
-                                                const int n1,
-                                                const double* metric,
-                                                const double* solution) const
-    {
-        // std::cout << "====  cell = " << cell << "   n0 = " << n0 << "   n1 = " << n1 << std::endl;
         assert(!is_accepted_[cell]);
         assert(is_accepted_[n0]);
         assert(is_accepted_[n1]);
-        DistanceDerivative dd;
-        dd.x1 = grid_.cell_centroids + 2 * n0;
-        dd.x2 = grid_.cell_centroids + 2 * n1;
-        dd.x = grid_.cell_centroids + 2 * cell;
+        DistanceDerivative<dim> dd;
+        dd.x1 = grid_.cell_centroids + dim * n0;
+        dd.x2 = grid_.cell_centroids + dim * n1;
+        dd.x = grid_.cell_centroids + dim * cell;
         dd.u1 = solution[n0];
         dd.u2 = solution[n1];
-        dd.g = metric + 4 * cell;
+        dd.g = metric + dim * dim * cell;
         int iter = 0;
         const double theta = RegulaFalsi<ContinueOnError>::solve(dd, 0.0, 1.0, 15, 1e-8, iter);
-        const double xt[2] = { (1-theta)*dd.x1[0] + theta*dd.x2[0],
-                               (1-theta)*dd.x1[1] + theta*dd.x2[1] };
-        const double d1 = distanceAniso(dd.x1, dd.x, dd.g) + solution[n0];
-        const double d2 = distanceAniso(dd.x2, dd.x, dd.g) + solution[n1];
-        const double dt = distanceAniso(xt, dd.x, dd.g) + (1-theta)*solution[n0] + theta*solution[n1];
+        double xt[dim];
+        for (int d = 0; d < dim; ++d) {
+            xt[d] = (1-theta)*dd.x1[d] + theta*dd.x2[d];
+        }
+        const double d1 = distanceAniso<dim>(dd.x1, dd.x, dd.g) + solution[n0];
+        const double d2 = distanceAniso<dim>(dd.x2, dd.x, dd.g) + solution[n1];
+        const double dt = distanceAniso<dim>(xt, dd.x, dd.g) + (1-theta)*solution[n0] + theta*solution[n1];
         return std::min(d1, std::min(d2, dt));
     }
 
@@ -358,7 +430,8 @@ namespace Opm
 
 
 
-    const AnisotropicEikonal2d::ValueAndCell& AnisotropicEikonal2d::topConsidered() const
+    template <int dim>
+    const typename AnisotropicEikonal<dim>::ValueAndCell& AnisotropicEikonal<dim>::topConsidered() const
     {
         return considered_.top();
     }
@@ -367,10 +440,10 @@ namespace Opm
 
 
 
-    void AnisotropicEikonal2d::pushConsidered(const ValueAndCell& vc)
+    template <int dim>
+    void AnisotropicEikonal<dim>::pushConsidered(const ValueAndCell& vc)
     {
-        HeapHandle h = considered_.push(vc);
-        considered_handles_[vc.second] = h;
+        considered_handles_[vc.second] = considered_.push(vc);
         is_considered_[vc.second] = true;
     }
 
@@ -378,27 +451,77 @@ namespace Opm
 
 
 
-    void AnisotropicEikonal2d::popConsidered()
+    template <int dim>
+    void AnisotropicEikonal<dim>::popConsidered()
     {
         is_considered_[considered_.top().second] = false;
-        considered_handles_.erase(considered_.top().second);
         considered_.pop();
     }
 
 
 
 
-    void AnisotropicEikonal2d::computeGridRadius()
+    template <int dim>
+    void AnisotropicEikonal<dim>::computeNeighbourPairs()
+    {
+        const int num_cells = cell_neighbours_.size();
+        neighbour_pairs_ = SparseTable<int>();
+        std::vector<int> pairs;
+        if (dim == 2) {
+            // Consecutive neighbours in counter-clockwise order.
+            for (int cell = 0; cell < num_cells; ++cell) {
+                const auto& nbs = cell_neighbours_[cell];
+                const int num_nbs = nbs.size();
+                pairs.clear();
+                for (int ii = 0; ii < num_nbs; ++ii) {
+                    pairs.push_back(nbs[ii]);
+                    pairs.push_back(nbs[(ii+1) % num_nbs]);
+                }
+                neighbour_pairs_.appendRow(pairs.begin(), pairs.end());
+            }
+        } else {
+            // Neighbours that are neighbours of each other.
+            std::vector<int> sorted_pos(num_cells + 1, 0);
+            std::vector<int> sorted;
+            for (int cell = 0; cell < num_cells; ++cell) {
+                sorted.insert(sorted.end(), cell_neighbours_[cell].begin(), cell_neighbours_[cell].end());
+                std::sort(sorted.begin() + sorted_pos[cell], sorted.end());
+                sorted_pos[cell + 1] = sorted.size();
+            }
+            for (int cell = 0; cell < num_cells; ++cell) {
+                const auto& nbs = cell_neighbours_[cell];
+                const int num_nbs = nbs.size();
+                pairs.clear();
+                for (int ii = 0; ii < num_nbs; ++ii) {
+                    const int* nb_begin = sorted.data() + sorted_pos[nbs[ii]];
+                    const int* nb_end = sorted.data() + sorted_pos[nbs[ii] + 1];
+                    for (int jj = ii + 1; jj < num_nbs; ++jj) {
+                        if (std::binary_search(nb_begin, nb_end, nbs[jj])) {
+                            pairs.push_back(nbs[ii]);
+                            pairs.push_back(nbs[jj]);
+                        }
+                    }
+                }
+                neighbour_pairs_.appendRow(pairs.begin(), pairs.end());
+            }
+        }
+    }
+
+
+
+
+    template <int dim>
+    void AnisotropicEikonal<dim>::computeGridRadius()
     {
         const int num_cells = cell_neighbours_.size();
         grid_radius_.resize(num_cells);
         for (int cell = 0; cell < num_cells; ++cell) {
             double radius = 0.0;
-            const double* v1 = grid_.cell_centroids + 2*cell;
+            const double* v1 = grid_.cell_centroids + dim*cell;
             const auto& nb = cell_neighbours_[cell];
             for (auto it = nb.begin(); it != nb.end(); ++it) {
-                const double* v2 = grid_.cell_centroids + 2*(*it);
-                radius = std::max(radius, distanceIso(v1, v2));
+                const double* v2 = grid_.cell_centroids + dim*(*it);
+                radius = std::max(radius, distanceIso<dim>(v1, v2));
             }
             grid_radius_[cell] = radius;
         }
@@ -407,25 +530,22 @@ namespace Opm
 
 
 
-    void AnisotropicEikonal2d::computeAnisoRatio(const double* metric)
+    template <int dim>
+    void AnisotropicEikonal<dim>::computeAnisoRatio(const double* metric)
     {
         const int num_cells = cell_neighbours_.size();
         aniso_ratio_.resize(num_cells);
         for (int cell = 0; cell < num_cells; ++cell) {
-            const double* m = metric + 4*cell;
-            // Find the two eigenvalues from trace and determinant.
-            const double t = m[0] + m[3];
-            const double d = m[0]*m[3] - m[1]*m[2];
-            const double sd = std::sqrt(t*t/4.0 - d);
-            const double eig[2] = { t/2.0 - sd, t/2.0 + sd };
-            // Anisotropy ratio is the max ratio of the eigenvalues.
-            aniso_ratio_[cell] = std::max(eig[0]/eig[1], eig[1]/eig[0]);
+            aniso_ratio_[cell] = eigenvalueRatio(metric + dim*dim*cell, std::integral_constant<int, dim>());
         }
     }
 
 
 
 
+    template class AnisotropicEikonal<2>;
+    template class AnisotropicEikonal<3>;
+
 
 } // namespace Opm
 
@@ -436,9 +556,9 @@ namespace {
     const char* AnisotropicEikonal2derrmsg =
         "\n********************************************************************************\n"
         "This library has not been compiled with support for the AnisotropicEikonal2d\n"
-        "class, due to too old version of the boost libraries (Boost.Heap from boost\n"
-        "version 1.49 or newer is required.\n"
-        "To use this class you must recompile opm-core on a system with sufficiently new\n"
+        "and AnisotropicEikonal3d classes, due to too old version of the boost libraries\n"
+        "(Boost.Heap from boost version 1.49 or newer is required.\n"
+        "To use these classes you must recompile opm-core on a system with sufficiently new\n"
         "version of the boost libraries."
         "\n********************************************************************************\n";
 }
@@ -446,17 +566,22 @@ namespace {
 namespace Opm
 {
 
-    AnisotropicEikonal2d::AnisotropicEikonal2d(const UnstructuredGrid&)
+    template <int dim>
+    AnisotropicEikonal<dim>::AnisotropicEikonal(const UnstructuredGrid&)
     {
         OPM_THROW(std::logic_error, AnisotropicEikonal2derrmsg);
     }
 
-    void AnisotropicEikonal2d::solve(const double*,
-                                     const std::vector<int>&,
-                                     std::vector<double>&)
+    template <int dim>
+    void AnisotropicEikonal<dim>::solve(const double*,
+                                        const std::vector<int>&,
+                                        std::vector<double>&)
     {
         OPM_THROW(std::logic_error, AnisotropicEikonal2derrmsg);
     }
+
+    template class AnisotropicEikonal<2>;
+    template class AnisotropicEikonal<3>;
 }
 
 #endif // BOOST_HEAP_AVAILABLE
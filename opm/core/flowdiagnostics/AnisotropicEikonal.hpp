@@ -22,8 +22,6 @@
 
 #include <opm/core/utility/SparseTable.hpp>
 #include <vector>
-#include <set>
-#include <map>
 
 #include <opm/common/utility/platform_dependent/disable_warnings.h>
 
@@ -32,7 +30,7 @@
 #define BOOST_HEAP_AVAILABLE ((BOOST_VERSION / 100 % 1000) >= 49)
 
 #if BOOST_HEAP_AVAILABLE
-#include <boost/heap/fibonacci_heap.hpp>
+#include <boost/heap/d_ary_heap.hpp>
 #endif
 
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
@@ -47,15 +45,27 @@ namespace Opm
     /// where M(x) is a symmetric positive definite matrix.
     /// The boundary conditions are assumed to be
     ///    \f[ u(x) = 0 \qquad x \in \partial\Omega \f].
-    class AnisotropicEikonal2d
+    ///
+    /// The solver is an ordered upwind method on cell centroids, for
+    /// grids of dimension dim (2 or 3), see AnisotropicEikonal2d and
+    /// AnisotropicEikonal3d. Values are computed from pairs of
+    /// neighbouring cells on the accepted front, which are
+    /// consecutive neighbours in counter-clockwise order in 2d and
+    /// cells that are neighbours of each other in 3d. Cells are
+    /// accepted in order from a heap with a decrease-key operation,
+    /// and each acceptance only visits the neighbourhood of the
+    /// accepted cell, so the cost is O(N log N) for N cells.
+    template <int dim>
+    class AnisotropicEikonal
     {
     public:
         /// Construct solver.
-        /// \param[in] grid      A 2d grid.
-        explicit AnisotropicEikonal2d(const UnstructuredGrid& grid);
+        /// \param[in] grid      A grid of dimension dim.
+        explicit AnisotropicEikonal(const UnstructuredGrid& grid);
 
         /// Solve the eikonal equation.
-        /// \param[in]  metric            Array of metric tensors, M, for each cell.
+        /// \param[in]  metric            Array of metric tensors, M, for each cell,
+        ///                               dim*dim entries per cell.
         /// \param[in]  startcells        Array of cells where u = 0 at the centroid.
         /// \param[out] solution          Array of solution to the eikonal equation.
         void solve(const double* metric,
@@ -66,10 +76,13 @@ namespace Opm
         // Grid and topology.
         const UnstructuredGrid& grid_;
         SparseTable<int> cell_neighbours_;
+        // For each cell, the pairs of neighbours used for updates,
+        // two consecutive entries per pair.
+        SparseTable<int> neighbour_pairs_;
 
         // Keep track of accepted cells.
         std::vector<char> is_accepted_;
-        std::set<int> accepted_front_;
+        std::vector<char> is_front_;
 
         // Quantities relating to anisotropy.
         std::vector<double> grid_radius_;
@@ -79,13 +92,15 @@ namespace Opm
         // Keep track of considered cells.
         typedef std::pair<double, int> ValueAndCell;
         typedef boost::heap::compare<std::greater<ValueAndCell>> Comparator;
-        typedef boost::heap::fibonacci_heap<ValueAndCell, Comparator> Heap;
+        typedef boost::heap::d_ary_heap<ValueAndCell, boost::heap::arity<4>,
+                                        boost::heap::mutable_<true>, Comparator> Heap;
         Heap considered_;
         typedef Heap::handle_type HeapHandle;
-        std::map<int, HeapHandle> considered_handles_;
+        std::vector<HeapHandle> considered_handles_;
         std::vector<char> is_considered_;
 
         bool isClose(const int c1, const int c2) const;
+        bool hasUnacceptedNeighbour(const int cell) const;
         double computeValue(const int cell, const double* metric, const double* solution) const;
         double computeValueUpdate(const int cell, const double* metric, const double* solution, const int new_cell) const;
         double computeFromLine(const int cell, const int from, const double* metric, const double* solution) const;
@@ -95,11 +110,18 @@ namespace Opm
         void pushConsidered(const ValueAndCell& vc);
         void popConsidered();
 
+        void computeNeighbourPairs();
         void computeGridRadius();
         void computeAnisoRatio(const double* metric);
 #endif // BOOST_HEAP_AVAILABLE
     };
 
+    /// Anisotropic eikonal solver for 2d grids.
+    typedef AnisotropicEikonal<2> AnisotropicEikonal2d;
+
+    /// Anisotropic eikonal solver for 3d grids.
+    typedef AnisotropicEikonal<3> AnisotropicEikonal3d;
+
 } // namespace Opm
 
 
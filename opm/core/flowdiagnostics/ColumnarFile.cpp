@@ -0,0 +1,306 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <opm/core/flowdiagnostics/ColumnarFile.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cstring>
+
+namespace Opm
+{
+
+    namespace
+    {
+        const char column_magic[8] = { 'O', 'P', 'M', 'C', 'O', 'L', 'S', '\0' };
+        const std::uint32_t column_version = 1;
+        const std::size_t file_header_size = 16;
+        const std::size_t column_header_size = 16;
+
+        bool hostIsLittleEndian()
+        {
+            const std::uint32_t one = 1;
+            unsigned char first;
+            std::memcpy(&first, &one, 1);
+            return first == 1;
+        }
+
+        void requireLittleEndian()
+        {
+            if (!hostIsLittleEndian()) {
+                OPM_THROW(std::runtime_error, "Columnar files require a little-endian host.");
+            }
+        }
+
+        std::uint64_t padding(const std::uint64_t n)
+        {
+            return (8 - n % 8) % 8;
+        }
+
+        std::size_t elementSize(const ColumnType type)
+        {
+            switch (type) {
+            case ColumnInt32:
+            case ColumnFloat32:
+                return 4;
+            case ColumnFloat64:
+                return 8;
+            }
+            return 0;
+        }
+    } // anonymous namespace
+
+
+
+
+    // ----------------  ColumnarWriter  ----------------
+
+
+    ColumnarWriter::ColumnarWriter(const std::string& filename)
+        : filename_(filename)
+    {
+        requireLittleEndian();
+        os_.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!os_) {
+            OPM_THROW(std::runtime_error, "Could not open columnar file " << filename << " for writing.");
+        }
+        const std::uint32_t header[2] = { column_version, 0 };
+        os_.write(column_magic, sizeof(column_magic));
+        os_.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+
+
+
+    ColumnarWriter::~ColumnarWriter()
+    {
+        // Errors are only reported by an explicit close().
+        if (os_.is_open()) {
+            os_.close();
+        }
+    }
+
+
+
+    void ColumnarWriter::write(const std::string& name, const int* data, const std::size_t n)
+    {
+        static_assert(sizeof(int) == 4, "ColumnarWriter requires 32-bit int.");
+        writeColumn(name, ColumnInt32, data, n, sizeof(int));
+    }
+
+
+
+    void ColumnarWriter::write(const std::string& name, const float* data, const std::size_t n)
+    {
+        writeColumn(name, ColumnFloat32, data, n, sizeof(float));
+    }
+
+
+
+    void ColumnarWriter::write(const std::string& name, const double* data, const std::size_t n)
+    {
+        writeColumn(name, ColumnFloat64, data, n, sizeof(double));
+    }
+
+
+
+    void ColumnarWriter::close()
+    {
+        if (!os_.is_open()) {
+            return;
+        }
+        os_.close();
+        if (!os_) {
+            OPM_THROW(std::runtime_error, "Writing columnar file " << filename_ << " failed.");
+        }
+    }
+
+
+
+    void ColumnarWriter::writeColumn(const std::string& name, const ColumnType type,
+                                     const void* data, const std::size_t n, const std::size_t elem_size)
+    {
+        if (!os_.is_open()) {
+            OPM_THROW(std::logic_error, "Column " << name << " written to closed file " << filename_);
+        }
+        static const char zero[8] = { 0 };
+        const std::uint32_t name_type[2] = { std::uint32_t(name.size()), std::uint32_t(type) };
+        const std::uint64_t count = n;
+        os_.write(reinterpret_cast<const char*>(name_type), sizeof(name_type));
+        os_.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        os_.write(name.data(), name.size());
+        os_.write(zero, padding(name.size()));
+        if (n > 0) {
+            os_.write(static_cast<const char*>(data), n*elem_size);
+        }
+        os_.write(zero, padding(n*elem_size));
+        if (!os_) {
+            OPM_THROW(std::runtime_error, "Writing column " << name << " to " << filename_ << " failed.");
+        }
+    }
+
+
+
+
+    // ----------------  ColumnarReader  ----------------
+
+
+    ColumnarReader::ColumnarReader(const std::string& filename)
+        : filename_(filename)
+    {
+        requireLittleEndian();
+        is_.open(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!is_) {
+            OPM_THROW(std::runtime_error, "Could not open columnar file " << filename);
+        }
+        is_.seekg(0, std::ios::end);
+        const std::uint64_t file_size = is_.tellg();
+        is_.seekg(0, std::ios::beg);
+
+        char magic[8];
+        std::uint32_t header[2];
+        is_.read(magic, sizeof(magic));
+        is_.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!is_ || std::memcmp(magic, column_magic, sizeof(magic)) != 0 || header[0] != column_version) {
+            OPM_THROW(std::runtime_error, filename << " is not a columnar file of version " << column_version);
+        }
+
+        // Scan the column headers, skipping the data.
+        std::uint64_t pos = file_header_size;
+        while (pos < file_size) {
+            std::uint32_t name_type[2];
+            std::uint64_t count;
+            is_.read(reinterpret_cast<char*>(name_type), sizeof(name_type));
+            is_.read(reinterpret_cast<char*>(&count), sizeof(count));
+            const std::size_t elem_size = elementSize(ColumnType(name_type[1]));
+            if (!is_ || elem_size == 0 || pos + column_header_size + name_type[0] > file_size) {
+                OPM_THROW(std::runtime_error, "Corrupt column header at offset " << pos << " in " << filename);
+            }
+            Column col;
+            col.name.resize(name_type[0]);
+            if (!col.name.empty()) {
+                is_.read(&col.name[0], col.name.size());
+            }
+            col.type = ColumnType(name_type[1]);
+            col.size = count;
+            col.offset = pos + column_header_size + name_type[0] + padding(name_type[0]);
+            const std::uint64_t nbytes = count*elem_size;
+            if (!is_ || col.offset > file_size || nbytes > file_size - col.offset) {
+                OPM_THROW(std::runtime_error, "Column " << col.name << " is truncated in " << filename);
+            }
+            pos = col.offset + nbytes + padding(nbytes);
+            columns_.push_back(col);
+            is_.seekg(pos, std::ios::beg);
+        }
+    }
+
+
+
+    std::vector<std::string> ColumnarReader::names() const
+    {
+        std::vector<std::string> result;
+        for (const Column& col : columns_) {
+            result.push_back(col.name);
+        }
+        return result;
+    }
+
+
+
+    bool ColumnarReader::has(const std::string& name) const
+    {
+        for (const Column& col : columns_) {
+            if (col.name == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+
+    ColumnType ColumnarReader::type(const std::string& name) const
+    {
+        return find(name).type;
+    }
+
+
+
+    std::size_t ColumnarReader::size(const std::string& name) const
+    {
+        return find(name).size;
+    }
+
+
+
+    std::vector<int> ColumnarReader::readInt(const std::string& name)
+    {
+        std::vector<int> data(size(name));
+        readColumn(name, ColumnInt32, data.empty() ? 0 : &data[0], sizeof(int));
+        return data;
+    }
+
+
+
+    std::vector<float> ColumnarReader::readFloat(const std::string& name)
+    {
+        std::vector<float> data(size(name));
+        readColumn(name, ColumnFloat32, data.empty() ? 0 : &data[0], sizeof(float));
+        return data;
+    }
+
+
+
+    std::vector<double> ColumnarReader::readDouble(const std::string& name)
+    {
+        std::vector<double> data(size(name));
+        readColumn(name, ColumnFloat64, data.empty() ? 0 : &data[0], sizeof(double));
+        return data;
+    }
+
+
+
+    const ColumnarReader::Column& ColumnarReader::find(const std::string& name) const
+    {
+        for (const Column& col : columns_) {
+            if (col.name == name) {
+                return col;
+            }
+        }
+        OPM_THROW(std::runtime_error, "No column " << name << " in " << filename_);
+    }
+
+
+
+    void ColumnarReader::readColumn(const std::string& name, const ColumnType type,
+                                    void* data, const std::size_t elem_size)
+    {
+        const Column& col = find(name);
+        if (col.type != type) {
+            OPM_THROW(std::runtime_error, "Column " << name << " in " << filename_
+                      << " has type " << col.type << ", requested " << type);
+        }
+        is_.clear();
+        is_.seekg(col.offset, std::ios::beg);
+        is_.read(static_cast<char*>(data), col.size*elem_size);
+        if (!is_) {
+            OPM_THROW(std::runtime_error, "Reading column " << name << " from " << filename_ << " failed.");
+        }
+    }
+
+} // namespace Opm
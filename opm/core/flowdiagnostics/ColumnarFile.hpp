@@ -0,0 +1,118 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_COLUMNARFILE_HEADER_INCLUDED
+#define OPM_COLUMNARFILE_HEADER_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Element types of the columns of a columnar file.
+    enum ColumnType { ColumnInt32 = 1, ColumnFloat32 = 2, ColumnFloat64 = 3 };
+
+
+    /// Writes named, typed columns of numbers to a binary file.
+    ///
+    /// The file starts with the eight byte magic "OPMCOLS\0", a 32-bit
+    /// format version (1) and four reserved bytes. Each column follows
+    /// as a 16 byte record header (32-bit name length, 32-bit
+    /// ColumnType, 64-bit element count), the name, and the elements.
+    /// Names and element arrays are zero padded to a multiple of eight
+    /// bytes, so all arrays start on an eight byte boundary. All
+    /// numbers are little-endian. Columns are written as they are
+    /// added, so results can be streamed out one at a time.
+    class ColumnarWriter
+    {
+    public:
+        /// Create the file, throw if it cannot be opened.
+        explicit ColumnarWriter(const std::string& filename);
+
+        /// Append a column.
+        void write(const std::string& name, const int* data, std::size_t n);
+        void write(const std::string& name, const float* data, std::size_t n);
+        void write(const std::string& name, const double* data, std::size_t n);
+
+        template <typename T>
+        void write(const std::string& name, const std::vector<T>& data)
+        {
+            write(name, data.empty() ? static_cast<const T*>(0) : &data[0], data.size());
+        }
+
+        /// Flush and close the file, throw on I/O failure.
+        void close();
+
+        ~ColumnarWriter();
+
+    private:
+        void writeColumn(const std::string& name, ColumnType type,
+                         const void* data, std::size_t n, std::size_t elem_size);
+        std::string filename_;
+        std::ofstream os_;
+    };
+
+
+    /// Reads files written by ColumnarWriter.
+    class ColumnarReader
+    {
+    public:
+        /// Open the file and read its column directory, throw if the
+        /// file cannot be read or is not a columnar file.
+        explicit ColumnarReader(const std::string& filename);
+
+        /// Names of the columns, in file order.
+        std::vector<std::string> names() const;
+
+        /// True if the file contains a column with the given name.
+        bool has(const std::string& name) const;
+
+        /// Element type of a column.
+        ColumnType type(const std::string& name) const;
+
+        /// Number of elements of a column.
+        std::size_t size(const std::string& name) const;
+
+        /// Read a column. The element type must match the stored type.
+        std::vector<int> readInt(const std::string& name);
+        std::vector<float> readFloat(const std::string& name);
+        std::vector<double> readDouble(const std::string& name);
+
+    private:
+        struct Column
+        {
+            std::string name;
+            ColumnType type;
+            std::uint64_t size;
+            std::uint64_t offset;
+        };
+        const Column& find(const std::string& name) const;
+        void readColumn(const std::string& name, ColumnType type, void* data, std::size_t elem_size);
+        std::string filename_;
+        std::ifstream is_;
+        std::vector<Column> columns_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_COLUMNARFILE_HEADER_INCLUDED
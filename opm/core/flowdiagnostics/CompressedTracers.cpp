@@ -0,0 +1,214 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <opm/core/flowdiagnostics/CompressedTracers.hpp>
+#include <opm/core/flowdiagnostics/ColumnarFile.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace Opm
+{
+
+
+    CompressedTracers::CompressedTracers(const int num_cells,
+                                         const Storage storage,
+                                         const double drop_tolerance)
+        : num_cells_(num_cells),
+          storage_(storage),
+          drop_tolerance_(drop_tolerance),
+          num_tracers_(0)
+    {
+        if (num_cells < 0) {
+            OPM_THROW(std::runtime_error, "CompressedTracers: negative number of cells " << num_cells);
+        }
+    }
+
+
+
+    void CompressedTracers::append(const std::vector<double>& tracer, const int num_tracers)
+    {
+        if (num_tracers < 0 || tracer.size() != std::size_t(num_tracers)*num_cells_) {
+            OPM_THROW(std::runtime_error, "CompressedTracers::append(): expected " << num_tracers
+                      << " tracers for " << num_cells_ << " cells, got " << tracer.size() << " values.");
+        }
+        const int nc = num_cells_;
+        for (int t = 0; t < num_tracers; ++t) {
+            switch (storage_) {
+            case Double: {
+                std::vector<double> col(nc);
+                for (int cell = 0; cell < nc; ++cell) {
+                    col[cell] = tracer[std::size_t(cell)*num_tracers + t];
+                }
+                dense_double_.push_back(std::vector<double>());
+                dense_double_.back().swap(col);
+                break;
+            }
+            case Float: {
+                std::vector<float> col(nc);
+                for (int cell = 0; cell < nc; ++cell) {
+                    col[cell] = float(tracer[std::size_t(cell)*num_tracers + t]);
+                }
+                dense_float_.push_back(std::vector<float>());
+                dense_float_.back().swap(col);
+                break;
+            }
+            case Sparse: {
+                std::vector<int> cells;
+                std::vector<float> values;
+                for (int cell = 0; cell < nc; ++cell) {
+                    const double v = tracer[std::size_t(cell)*num_tracers + t];
+                    if (std::fabs(v) > drop_tolerance_) {
+                        cells.push_back(cell);
+                        values.push_back(float(v));
+                    }
+                }
+                // Do not keep the growth slack of the vectors.
+                sparse_cells_.push_back(std::vector<int>(cells.begin(), cells.end()));
+                sparse_values_.push_back(std::vector<float>(values.begin(), values.end()));
+                break;
+            }
+            }
+        }
+        num_tracers_ += num_tracers;
+    }
+
+
+
+    int CompressedTracers::numCells() const
+    {
+        return num_cells_;
+    }
+
+
+
+    int CompressedTracers::numTracers() const
+    {
+        return num_tracers_;
+    }
+
+
+
+    CompressedTracers::Storage CompressedTracers::storage() const
+    {
+        return storage_;
+    }
+
+
+
+    double CompressedTracers::value(const int tracer, const int cell) const
+    {
+        switch (storage_) {
+        case Double:
+            return dense_double_[tracer][cell];
+        case Float:
+            return dense_float_[tracer][cell];
+        case Sparse: {
+            const std::vector<int>& cells = sparse_cells_[tracer];
+            const std::vector<int>::const_iterator it = std::lower_bound(cells.begin(), cells.end(), cell);
+            return (it != cells.end() && *it == cell) ? sparse_values_[tracer][it - cells.begin()] : 0.0;
+        }
+        }
+        return 0.0;
+    }
+
+
+
+    void CompressedTracers::expand(const int begin, const int end, double* out) const
+    {
+        const int nt = num_tracers_;
+        const int n = end - begin;
+        if (n <= 0) {
+            return;
+        }
+        switch (storage_) {
+        case Double:
+            for (int t = 0; t < nt; ++t) {
+                const double* col = &dense_double_[t][begin];
+                for (int i = 0; i < n; ++i) {
+                    out[i*nt + t] = col[i];
+                }
+            }
+            break;
+        case Float:
+            for (int t = 0; t < nt; ++t) {
+                const float* col = &dense_float_[t][begin];
+                for (int i = 0; i < n; ++i) {
+                    out[i*nt + t] = col[i];
+                }
+            }
+            break;
+        case Sparse:
+            std::fill(out, out + std::size_t(n)*nt, 0.0);
+            for (int t = 0; t < nt; ++t) {
+                const std::vector<int>& cells = sparse_cells_[t];
+                const std::vector<float>& values = sparse_values_[t];
+                std::vector<int>::const_iterator it = std::lower_bound(cells.begin(), cells.end(), begin);
+                for (; it != cells.end() && *it < end; ++it) {
+                    out[(*it - begin)*nt + t] = values[it - cells.begin()];
+                }
+            }
+            break;
+        }
+    }
+
+
+
+    std::size_t CompressedTracers::memoryUsage() const
+    {
+        std::size_t bytes = 0;
+        for (const auto& col : dense_double_) {
+            bytes += col.capacity()*sizeof(double);
+        }
+        for (const auto& col : dense_float_) {
+            bytes += col.capacity()*sizeof(float);
+        }
+        for (std::size_t t = 0; t < sparse_cells_.size(); ++t) {
+            bytes += sparse_cells_[t].capacity()*sizeof(int) + sparse_values_[t].capacity()*sizeof(float);
+        }
+        return bytes;
+    }
+
+
+
+    void CompressedTracers::write(ColumnarWriter& writer, const std::string& prefix) const
+    {
+        for (int t = 0; t < num_tracers_; ++t) {
+            std::ostringstream name;
+            name << prefix << t;
+            switch (storage_) {
+            case Double:
+                writer.write(name.str(), dense_double_[t]);
+                break;
+            case Float:
+                writer.write(name.str(), dense_float_[t]);
+                break;
+            case Sparse:
+                writer.write(name.str() + "_cells", sparse_cells_[t]);
+                writer.write(name.str() + "_values", sparse_values_[t]);
+                break;
+            }
+        }
+    }
+
+
+} // namespace Opm
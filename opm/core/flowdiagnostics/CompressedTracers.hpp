@@ -0,0 +1,102 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_COMPRESSEDTRACERS_HEADER_INCLUDED
+#define OPM_COMPRESSEDTRACERS_HEADER_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    class ColumnarWriter;
+
+    /// Storage for many tracer fields over the same cells, with
+    /// reduced memory use.
+    ///
+    /// The time-of-flight solvers return tracers as a dense array of
+    /// doubles with N values per cell. Tracers from wells are zero in
+    /// most of the domain, so for models with many wells and cells it
+    /// pays to keep them in single precision, or as lists of the cells
+    /// where they are nonzero. Tracers are added in batches in the
+    /// solver layout and stored one tracer at a time.
+    class CompressedTracers
+    {
+    public:
+        enum Storage {
+            Double,  ///< Dense, double precision (no compression).
+            Float,   ///< Dense, single precision.
+            Sparse   ///< Cells with values above a drop tolerance, single precision.
+        };
+
+        /// Construct empty storage.
+        /// \param[in] num_cells       Number of cells.
+        /// \param[in] storage         Storage scheme.
+        /// \param[in] drop_tolerance  With Sparse storage, values whose
+        ///                            magnitude is not above this are
+        ///                            stored as zero.
+        CompressedTracers(const int num_cells,
+                          const Storage storage,
+                          const double drop_tolerance = 0.0);
+
+        /// Add tracers in the layout of TofReorder::solveTofTracer(),
+        /// i.e. tracer[cell*num_tracers + t]. They get the indices
+        /// numTracers(), ..., numTracers() + num_tracers - 1.
+        void append(const std::vector<double>& tracer, const int num_tracers);
+
+        /// Number of cells.
+        int numCells() const;
+
+        /// Number of tracers stored.
+        int numTracers() const;
+
+        /// Storage scheme.
+        Storage storage() const;
+
+        /// Value of a tracer in a cell.
+        double value(const int tracer, const int cell) const;
+
+        /// Write all tracers for the cells [begin, end) to out in the
+        /// solver layout, out[(cell - begin)*numTracers() + t].
+        void expand(const int begin, const int end, double* out) const;
+
+        /// Approximate number of bytes used by the stored tracers.
+        std::size_t memoryUsage() const;
+
+        /// Write the tracers as columns prefix0, prefix1, ... with
+        /// Double or Float storage, or as column pairs
+        /// prefix0_cells, prefix0_values, ... with Sparse storage.
+        void write(ColumnarWriter& writer, const std::string& prefix) const;
+
+    private:
+        int num_cells_;
+        Storage storage_;
+        double drop_tolerance_;
+        int num_tracers_;
+        std::vector<std::vector<double> > dense_double_;
+        std::vector<std::vector<float> > dense_float_;
+        std::vector<std::vector<int> > sparse_cells_;
+        std::vector<std::vector<float> > sparse_values_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_COMPRESSEDTRACERS_HEADER_INCLUDED
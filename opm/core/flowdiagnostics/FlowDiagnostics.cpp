@@ -18,12 +18,18 @@
 */
 
 #include <opm/core/flowdiagnostics/FlowDiagnostics.hpp>
+#include <opm/core/flowdiagnostics/CompressedTracers.hpp>
 #include <opm/core/wells.h>
+#include <opm/core/linalg/blas_lapack.h>
 
 #include <opm/common/ErrorMacros.hpp>
 #include <algorithm>
 #include <numeric>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace Opm
 {
 
@@ -166,56 +172,301 @@ namespace Opm
 
 
 
+    namespace {
+
+        // Number of cells gathered for each dgemm call.
+        const int well_pair_block_size = 512;
+
+        // Accumulate the contributions of the cells [begin, end) to
+        // the column-major NP x NI matrix vol. Cells where the product
+        // of the nonzero tracer counts is small compared to NI*NP are
+        // added directly, the rest are gathered, scaled by pore volume,
+        // and added by a single matrix product.
+        void accumulateWellPairs(const int begin, const int end,
+                                 const int num_inj, const int num_prod,
+                                 const double* porevol,
+                                 const double* ftracer,
+                                 const double* btracer,
+                                 std::vector<int>& fnz,
+                                 std::vector<int>& bnz,
+                                 std::vector<double>& fbuf,
+                                 std::vector<double>& bbuf,
+                                 double* vol)
+        {
+            int num_dense = 0;
+            for (int c = begin; c < end; ++c) {
+                if (porevol[c] == 0.0) {
+                    continue;
+                }
+                const double* f = ftracer + num_inj*c;
+                const double* b = btracer + num_prod*c;
+                fnz.clear();
+                bnz.clear();
+                for (int i = 0; i < num_inj; ++i) {
+                    if (f[i] != 0.0) {
+                        fnz.push_back(i);
+                    }
+                }
+                if (fnz.empty()) {
+                    continue;
+                }
+                for (int p = 0; p < num_prod; ++p) {
+                    if (b[p] != 0.0) {
+                        bnz.push_back(p);
+                    }
+                }
+                if (bnz.empty()) {
+                    continue;
+                }
+                if (8*fnz.size()*bnz.size() <= std::size_t(num_inj)*num_prod) {
+                    for (std::size_t ii = 0; ii < fnz.size(); ++ii) {
+                        const int i = fnz[ii];
+                        const double pvf = porevol[c]*f[i];
+                        for (std::size_t pp = 0; pp < bnz.size(); ++pp) {
+                            const int p = bnz[pp];
+                            vol[i*num_prod + p] += pvf*b[p];
+                        }
+                    }
+                } else {
+                    for (int i = 0; i < num_inj; ++i) {
+                        fbuf[num_dense*num_inj + i] = porevol[c]*f[i];
+                    }
+                    std::copy(b, b + num_prod, bbuf.begin() + num_dense*num_prod);
+                    ++num_dense;
+                }
+            }
+            if (num_dense > 0) {
+                // vol += bbuf * fbuf^T, both stored column-major with
+                // one column per cell.
+                const MAT_SIZE_T m = num_prod;
+                const MAT_SIZE_T n = num_inj;
+                const MAT_SIZE_T k = num_dense;
+                const double one = 1.0;
+                dgemm_("N", "T", &m, &n, &k,
+                       &one, &bbuf[0], &m,
+                       &fbuf[0], &n,
+                       &one, vol, &m);
+            }
+        }
+
+
+        // Tracer values of a block of cells, in the solver layout,
+        // taken directly from the full arrays.
+        class DenseTracerBlocks
+        {
+        public:
+            DenseTracerBlocks(const std::vector<double>& ftracer,
+                              const std::vector<double>& btracer,
+                              const int num_inj, const int num_prod)
+                : ftracer_(ftracer), btracer_(btracer), num_inj_(num_inj), num_prod_(num_prod)
+            {
+            }
+
+            void operator()(const int begin, const int /* end */,
+                            std::vector<double>& /* fscratch */,
+                            std::vector<double>& /* bscratch */,
+                            const double*& f, const double*& b) const
+            {
+                f = &ftracer_[0] + std::size_t(num_inj_)*begin;
+                b = &btracer_[0] + std::size_t(num_prod_)*begin;
+            }
+
+        private:
+            const std::vector<double>& ftracer_;
+            const std::vector<double>& btracer_;
+            int num_inj_;
+            int num_prod_;
+        };
+
+        // Tracer values of a block of cells, expanded from compressed storage.
+        class CompressedTracerBlocks
+        {
+        public:
+            CompressedTracerBlocks(const CompressedTracers& ftracer,
+                                   const CompressedTracers& btracer)
+                : ftracer_(ftracer), btracer_(btracer)
+            {
+            }
+
+            void operator()(const int begin, const int end,
+                            std::vector<double>& fscratch,
+                            std::vector<double>& bscratch,
+                            const double*& f, const double*& b) const
+            {
+                fscratch.resize(std::size_t(end - begin)*ftracer_.numTracers());
+                bscratch.resize(std::size_t(end - begin)*btracer_.numTracers());
+                ftracer_.expand(begin, end, &fscratch[0]);
+                btracer_.expand(begin, end, &bscratch[0]);
+                f = &fscratch[0];
+                b = &bscratch[0];
+            }
+
+        private:
+            const CompressedTracers& ftracer_;
+            const CompressedTracers& btracer_;
+        };
+
+        // Sum the pair volumes over all cells, block by block. Each
+        // thread has its own accumulator, and these are summed in
+        // thread order afterwards so the result does not depend on
+        // thread scheduling.
+        template <class TracerBlocks>
+        void sumWellPairs(const std::vector<double>& porevol,
+                          const int num_inj, const int num_prod,
+                          const TracerBlocks& blocks,
+                          std::vector<double>& volume)
+        {
+            const int nc = porevol.size();
+            const int num_pairs = num_inj*num_prod;
+            volume.assign(num_pairs, 0.0);
+            if (num_pairs == 0 || nc == 0) {
+                return;
+            }
+            const int num_blocks = (nc + well_pair_block_size - 1)/well_pair_block_size;
+#ifdef _OPENMP
+            const int num_threads = std::max(1, std::min(omp_get_max_threads(), num_blocks));
+#else
+            const int num_threads = 1;
+#endif
+            std::vector<double> thread_vol(num_threads*num_pairs, 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads)
+#endif
+            {
+#ifdef _OPENMP
+                const int thread = omp_get_thread_num();
+#else
+                const int thread = 0;
+#endif
+                std::vector<int> fnz, bnz;
+                std::vector<double> fbuf(well_pair_block_size*num_inj);
+                std::vector<double> bbuf(well_pair_block_size*num_prod);
+                std::vector<double> fscratch, bscratch;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int blk = 0; blk < num_blocks; ++blk) {
+                    const int begin = blk*well_pair_block_size;
+                    const int end = std::min(nc, begin + well_pair_block_size);
+                    const double* f = 0;
+                    const double* b = 0;
+                    blocks(begin, end, fscratch, bscratch, f, b);
+                    accumulateWellPairs(0, end - begin, num_inj, num_prod,
+                                        &porevol[begin], f, b,
+                                        fnz, bnz, fbuf, bbuf, &thread_vol[thread*num_pairs]);
+                }
+            }
+            for (int thread = 0; thread < num_threads; ++thread) {
+                for (int k = 0; k < num_pairs; ++k) {
+                    volume[k] += thread_vol[thread*num_pairs + k];
+                }
+            }
+        }
+
+    } // anonymous namespace
+
+
+
     /// \brief Compute volumes associated with injector-producer pairs.
     ///
     /// \param[in]  wells       wells structure, containing NI injector wells and NP producer wells.
     /// \param[in]  porevol     pore volume of each grid cell
     /// \param[in]  ftracer     array of forward (injector) tracer values, NI per cell
     /// \param[in]  btracer     array of backward (producer) tracer values, NP per cell
-    /// \return                 a vector of tuples, one tuple for each injector-producer pair,
-    ///                         where the first and second elements are well indices for the
-    ///                         injector and producer, and the third element is the pore volume
-    ///                         associated with that pair.
-    std::vector<std::tuple<int, int, double> >
-    computeWellPairs(const Wells& wells,
-                     const std::vector<double>& porevol,
-                     const std::vector<double>& ftracer,
-                     const std::vector<double>& btracer)
+    /// \return                 the pair volumes.
+    WellPairVolumes
+    computeWellPairVolumes(const Wells& wells,
+                           const std::vector<double>& porevol,
+                           const std::vector<double>& ftracer,
+                           const std::vector<double>& btracer)
     {
         // Identify injectors and producers.
-        std::vector<int> inj;
-        std::vector<int> prod;
+        WellPairVolumes result;
         const int nw = wells.number_of_wells;
         for (int w = 0; w < nw; ++w) {
             if (wells.type[w] == INJECTOR) {
-                inj.push_back(w);
+                result.injectors.push_back(w);
             } else {
-                prod.push_back(w);
+                result.producers.push_back(w);
             }
         }
 
         // Check sizes of input arrays.
         const int nc = porevol.size();
-        if (nc * inj.size() != ftracer.size()) {
+        if (nc * result.injectors.size() != ftracer.size()) {
             OPM_THROW(std::runtime_error, "computeWellPairs(): wrong size of input array ftracer.");
         }
-        if (nc * prod.size() != btracer.size()) {
+        if (nc * result.producers.size() != btracer.size()) {
             OPM_THROW(std::runtime_error, "computeWellPairs(): wrong size of input array btracer.");
         }
 
         // Compute associated pore volumes.
+        sumWellPairs(porevol, result.injectors.size(), result.producers.size(),
+                     DenseTracerBlocks(ftracer, btracer, result.injectors.size(), result.producers.size()),
+                     result.volume);
+        return result;
+    }
+
+
+
+    /// \brief Compute volumes associated with pairs of forward and backward tracers.
+    ///
+    /// \param[in]  porevol     pore volume of each grid cell
+    /// \param[in]  ftracer     NI forward (injector) tracers
+    /// \param[in]  btracer     NP backward (producer) tracers
+    /// \return                 the pair volumes, with tracer indices as well indices.
+    WellPairVolumes
+    computeWellPairVolumes(const std::vector<double>& porevol,
+                           const CompressedTracers& ftracer,
+                           const CompressedTracers& btracer)
+    {
+        const int nc = porevol.size();
+        if (ftracer.numCells() != nc) {
+            OPM_THROW(std::runtime_error, "computeWellPairVolumes(): wrong number of cells in ftracer.");
+        }
+        if (btracer.numCells() != nc) {
+            OPM_THROW(std::runtime_error, "computeWellPairVolumes(): wrong number of cells in btracer.");
+        }
+        WellPairVolumes result;
+        for (int t = 0; t < ftracer.numTracers(); ++t) {
+            result.injectors.push_back(t);
+        }
+        for (int t = 0; t < btracer.numTracers(); ++t) {
+            result.producers.push_back(t);
+        }
+        sumWellPairs(porevol, ftracer.numTracers(), btracer.numTracers(),
+                     CompressedTracerBlocks(ftracer, btracer), result.volume);
+        return result;
+    }
+
+
+
+    /// \brief Compute volumes associated with injector-producer pairs.
+    ///
+    /// \param[in]  wells       wells structure, containing NI injector wells and NP producer wells.
+    /// \param[in]  porevol     pore volume of each grid cell
+    /// \param[in]  ftracer     array of forward (injector) tracer values, NI per cell
+    /// \param[in]  btracer     array of backward (producer) tracer values, NP per cell
+    /// \return                 a vector of tuples, one tuple for each injector-producer pair,
+    ///                         where the first and second elements are well indices for the
+    ///                         injector and producer, and the third element is the pore volume
+    ///                         associated with that pair.
+    std::vector<std::tuple<int, int, double> >
+    computeWellPairs(const Wells& wells,
+                     const std::vector<double>& porevol,
+                     const std::vector<double>& ftracer,
+                     const std::vector<double>& btracer)
+    {
+        const WellPairVolumes vol = computeWellPairVolumes(wells, porevol, ftracer, btracer);
         std::vector<std::tuple<int, int, double> > result;
-        const int num_inj = inj.size();
-        const int num_prod = prod.size();
+        const int num_inj = vol.injectors.size();
+        const int num_prod = vol.producers.size();
+        result.reserve(num_inj*num_prod);
         for (int inj_ix = 0; inj_ix < num_inj; ++inj_ix) {
             for (int prod_ix = 0; prod_ix < num_prod; ++prod_ix) {
-                double assoc_porevol = 0.0;
-                for (int c = 0; c < nc; ++c) {
-                    assoc_porevol += porevol[c]
-                        * ftracer[num_inj * c + inj_ix]
-                        * btracer[num_prod * c + prod_ix];
-                }
-                result.push_back(std::make_tuple(inj[inj_ix], prod[prod_ix], assoc_porevol));
+                result.push_back(std::make_tuple(vol.injectors[inj_ix], vol.producers[prod_ix],
+                                                 vol(inj_ix, prod_ix)));
             }
         }
         return result;
@@ -30,6 +30,8 @@ struct Wells;
 namespace Opm
 {
 
+    class CompressedTracers;
+
     /// \brief Compute flow-capacity/storage-capacity based on time-of-flight.
     ///
     /// The F-Phi curve is an analogue to the fractional flow curve in a 1D
@@ -82,8 +84,64 @@ namespace Opm
                  const std::vector<double>& storagecap);
 
 
+    /// \brief Pore volumes associated with injector-producer pairs.
+    struct WellPairVolumes
+    {
+        std::vector<int> injectors;   ///< Well indices of the NI injectors.
+        std::vector<int> producers;   ///< Well indices of the NP producers.
+        std::vector<double> volume;   ///< NI*NP pair volumes, injector by injector.
+
+        /// Pore volume of the pair of the given injector and producer,
+        /// indexed like the injectors and producers members.
+        double operator()(const int inj_ix, const int prod_ix) const
+        {
+            return volume[inj_ix*producers.size() + prod_ix];
+        }
+    };
+
+
     /// \brief Compute volumes associated with injector-producer pairs.
     ///
+    /// The volume of a pair is the sum over all cells of the pore
+    /// volume times the injector and producer tracer values. This is
+    /// computed as the matrix product (pv .* F)^T B by BLAS dgemm over
+    /// blocks of cells, except for cells with only a few nonzero
+    /// tracer values, which are accumulated directly.
+    ///
+    /// \param[in]  wells       wells structure, containing NI injector wells and NP producer wells.
+    /// \param[in]  porevol     pore volume of each grid cell
+    /// \param[in]  ftracer     array of forward (injector) tracer values, NI per cell
+    /// \param[in]  btracer     array of backward (producer) tracer values, NP per cell
+    /// \return                 the pair volumes.
+    WellPairVolumes
+    computeWellPairVolumes(const Wells& wells,
+                           const std::vector<double>& porevol,
+                           const std::vector<double>& ftracer,
+                           const std::vector<double>& btracer);
+
+
+    /// \brief Compute volumes associated with pairs of forward and backward tracers.
+    ///
+    /// Same as computeWellPairVolumes() above, for tracers that are
+    /// not tied to a Wells structure and kept in compressed storage.
+    /// Cells are expanded one block at a time, so the full tracer
+    /// arrays are never formed.
+    ///
+    /// \param[in]  porevol     pore volume of each grid cell
+    /// \param[in]  ftracer     NI forward (injector) tracers
+    /// \param[in]  btracer     NP backward (producer) tracers
+    /// \return                 the pair volumes. The injectors and producers
+    ///                         members hold the tracer indices 0, 1, ...
+    WellPairVolumes
+    computeWellPairVolumes(const std::vector<double>& porevol,
+                           const CompressedTracers& ftracer,
+                           const CompressedTracers& btracer);
+
+
+    /// \brief Compute volumes associated with injector-producer pairs.
+    ///
+    /// Same as computeWellPairVolumes(), with the result as a list.
+    ///
     /// \param[in]  wells       wells structure, containing NI injector wells and NP producer wells.
     /// \param[in]  porevol     pore volume of each grid cell
     /// \param[in]  ftracer     array of forward (injector) tracer values, NI per cell
@@ -47,9 +47,9 @@ namespace Opm
           limiter_relative_flux_threshold_(1e-3),
           limiter_method_(MinUpwindAverage),
           limiter_usage_(DuringComputations),
-          coord_(grid.dimensions),
-          velocity_(grid.dimensions),
-          gauss_seidel_tol_(1e-3)
+          gauss_seidel_tol_(1e-3),
+          use_quadrature_cache_(false),
+          quadrature_cache_max_mb_(1024.0)
     {
         const int dg_degree = param.getDefault("dg_degree", 0);
         const bool use_tensorial_basis = param.getDefault("use_tensorial_basis", false);
@@ -96,6 +96,12 @@ namespace Opm
         } else {
             velocity_interpolation_.reset(new VelocityInterpolationConstant(grid_));
         }
+
+        use_quadrature_cache_ = param.getDefault("use_quadrature_cache", use_quadrature_cache_);
+        quadrature_cache_max_mb_ = param.getDefault("quadrature_cache_max_mb", quadrature_cache_max_mb_);
+        if (use_quadrature_cache_) {
+            buildQuadratureCache();
+        }
     }
 
 
@@ -122,39 +128,10 @@ namespace Opm
         tof_coeff.resize(num_basis*grid_.number_of_cells);
         std::fill(tof_coeff.begin(), tof_coeff.end(), 0.0);
         tof_coeff_ = &tof_coeff[0];
-        rhs_.resize(num_basis);
-        jac_.resize(num_basis*num_basis);
-        orig_jac_.resize(num_basis*num_basis);
-        basis_.resize(num_basis);
-        basis_nb_.resize(num_basis);
-        grad_basis_.resize(num_basis*grid_.dimensions);
         velocity_interpolation_->setupFluxes(darcyflux);
         num_tracers_ = 0;
-        num_multicell_ = 0;
-        max_size_multicell_ = 0;
-        max_iter_multicell_ = 0;
-        num_singlesolves_ = 0;
-        reorderAndTransport(grid_, darcyflux);
-        switch (limiter_usage_) {
-        case AsPostProcess:
-            applyLimiterAsPostProcess();
-            break;
-        case AsSimultaneousPostProcess:
-            applyLimiterAsSimultaneousPostProcess();
-            break;
-        case DuringComputations:
-            // Do nothing.
-            break;
-        default:
-            OPM_THROW(std::runtime_error, "Unknown limiter usage choice: " << limiter_usage_);
-        }
-        if (num_multicell_ > 0) {
-            std::cout << num_multicell_ << " multicell blocks with max size "
-                      << max_size_multicell_ << " cells in upto "
-                      << max_iter_multicell_ << " iterations." << std::endl;
-            std::cout << "Average solves per cell (for all cells) was "
-                      << double(num_singlesolves_)/double(grid_.number_of_cells) << std::endl;
-        }
+        initWorkspace();
+        executeSolve();
     }
 
 
@@ -201,12 +178,6 @@ namespace Opm
         tof_coeff.resize(num_basis*grid_.number_of_cells);
         std::fill(tof_coeff.begin(), tof_coeff.end(), 0.0);
         tof_coeff_ = &tof_coeff[0];
-        rhs_.resize(num_basis*(num_tracers_ + 1));
-        jac_.resize(num_basis*num_basis);
-        orig_jac_.resize(num_basis*num_basis);
-        basis_.resize(num_basis);
-        basis_nb_.resize(num_basis);
-        grad_basis_.resize(num_basis*grid_.dimensions);
         velocity_interpolation_->setupFluxes(darcyflux);
 
         // Set up tracer
@@ -221,17 +192,66 @@ namespace Opm
             for (unsigned int i = 0; i < tracerheadsSize; ++i) {
                 const int cell = tracerheads[tr][i];
                 basis_func_->addConstant(1.0, &tracer_coeff[cell*num_tracers_*num_basis + tr*num_basis]);
-                tracer_coeff[cell*num_tracers_ + tr] = 1.0;
                 tracerhead_by_cell_[cell] = tr;
             }
         }
 
         tracer_coeff_ = &tracer_coeff[0];
-        num_multicell_ = 0;
-        max_size_multicell_ = 0;
-        max_iter_multicell_ = 0;
-        num_singlesolves_ = 0;
-        reorderAndTransport(grid_, darcyflux);
+        initWorkspace();
+        executeSolve();
+    }
+
+
+
+
+    bool TofDiscGalReorder::hasQuadratureCache() const
+    {
+        return !cell_mass_.empty();
+    }
+
+
+
+
+    // A cell solve only writes the coefficients of its own cell and
+    // only reads those of upwind cells, and all scratch arrays are in
+    // the per-thread workspace. The ECVI velocity interpolation keeps
+    // scratch data of its own, so it must run serially.
+    bool TofDiscGalReorder::supportsParallelSweep() const
+    {
+        return !use_cvi_;
+    }
+
+
+
+
+    void TofDiscGalReorder::initWorkspace()
+    {
+        const int num_basis = basis_func_->numBasisFunc();
+        const int dim = grid_.dimensions;
+        workspace_.resize(maxSweepThreads());
+        for (std::size_t t = 0; t < workspace_.size(); ++t) {
+            Workspace& ws = workspace_[t];
+            ws.rhs.resize(num_basis*(num_tracers_ + 1));
+            ws.jac.resize(num_basis*num_basis);
+            ws.orig_jac.resize(num_basis*num_basis);
+            ws.coord.resize(dim);
+            ws.basis.resize(num_basis);
+            ws.basis_nb.resize(num_basis);
+            ws.grad_basis.resize(num_basis*dim);
+            ws.velocity.resize(dim);
+            ws.num_singlesolves = 0;
+            ws.num_multicell = 0;
+            ws.max_size_multicell = 0;
+            ws.max_iter_multicell = 0;
+        }
+    }
+
+
+
+
+    void TofDiscGalReorder::executeSolve()
+    {
+        reorderAndTransport(grid_, darcyflux_);
         switch (limiter_usage_) {
         case AsPostProcess:
             applyLimiterAsPostProcess();
@@ -245,12 +265,128 @@ namespace Opm
         default:
             OPM_THROW(std::runtime_error, "Unknown limiter usage choice: " << limiter_usage_);
         }
-        if (num_multicell_ > 0) {
-            std::cout << num_multicell_ << " multicell blocks with max size "
-                      << max_size_multicell_ << " cells in upto "
-                      << max_iter_multicell_ << " iterations." << std::endl;
+        int num_singlesolves = 0;
+        int num_multicell = 0;
+        int max_size_multicell = 0;
+        int max_iter_multicell = 0;
+        for (std::size_t t = 0; t < workspace_.size(); ++t) {
+            num_singlesolves += workspace_[t].num_singlesolves;
+            num_multicell += workspace_[t].num_multicell;
+            max_size_multicell = std::max(max_size_multicell, workspace_[t].max_size_multicell);
+            max_iter_multicell = std::max(max_iter_multicell, workspace_[t].max_iter_multicell);
+        }
+        if (num_multicell > 0) {
+            std::cout << num_multicell << " multicell blocks with max size "
+                      << max_size_multicell << " cells in upto "
+                      << max_iter_multicell << " iterations." << std::endl;
             std::cout << "Average solves per cell (for all cells) was "
-                      << double(num_singlesolves_)/double(grid_.number_of_cells) << std::endl;
+                      << double(num_singlesolves)/double(grid_.number_of_cells) << std::endl;
+        }
+    }
+
+
+
+
+    // Precompute the integrals of products of basis functions (and
+    // their gradients) used by cellContribs() and faceContribs(), with
+    // the same quadrature rules. These depend only on the grid and
+    // basis, so that a solve just scales them by fluxes and pore
+    // volumes.
+    void TofDiscGalReorder::buildQuadratureCache()
+    {
+        const int nc = grid_.number_of_cells;
+        const int nf = grid_.number_of_faces;
+        const int dim = grid_.dimensions;
+        const int nb = basis_func_->numBasisFunc();
+        const int nb2 = nb*nb;
+        const int deg = basis_func_->degree();
+
+        const double bytes = sizeof(double)*(double(nc)*(nb + nb2 + (use_cvi_ ? 0 : dim*nb2))
+                                             + double(nf)*3*nb2);
+        if (bytes > quadrature_cache_max_mb_*1024.0*1024.0) {
+            std::cout << "Quadrature cache would need " << bytes/(1024.0*1024.0)
+                      << " MB, exceeding the limit of " << quadrature_cache_max_mb_
+                      << " MB. Integrating in every solve." << std::endl;
+            return;
+        }
+
+        std::vector<double> coord(dim);
+        std::vector<double> basis(nb);
+        std::vector<double> basis_nb(nb);
+        std::vector<double> grad_basis(nb*dim);
+
+        cell_source_integral_.assign(nc*nb, 0.0);
+        cell_mass_.assign(nc*nb2, 0.0);
+        if (!use_cvi_) {
+            cell_advection_.assign(nc*dim*nb2, 0.0);
+        }
+        for (int cell = 0; cell < nc; ++cell) {
+            {
+                CellQuadrature quad(grid_, cell, deg);
+                double* integral = &cell_source_integral_[cell*nb];
+                for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
+                    quad.quadPtCoord(quad_pt, &coord[0]);
+                    basis_func_->eval(cell, &coord[0], &basis[0]);
+                    const double w = quad.quadPtWeight(quad_pt);
+                    for (int j = 0; j < nb; ++j) {
+                        integral[j] += w * basis[j];
+                    }
+                }
+            }
+            CellQuadrature quad(grid_, cell, 2*deg);
+            double* mass = &cell_mass_[cell*nb2];
+            double* advection = use_cvi_ ? 0 : &cell_advection_[cell*dim*nb2];
+            for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
+                quad.quadPtCoord(quad_pt, &coord[0]);
+                basis_func_->eval(cell, &coord[0], &basis[0]);
+                const double w = quad.quadPtWeight(quad_pt);
+                for (int j = 0; j < nb; ++j) {
+                    for (int i = 0; i < nb; ++i) {
+                        mass[j*nb + i] += w * basis[i] * basis[j];
+                    }
+                }
+                if (advection) {
+                    basis_func_->evalGrad(cell, &coord[0], &grad_basis[0]);
+                    for (int dd = 0; dd < dim; ++dd) {
+                        for (int j = 0; j < nb; ++j) {
+                            for (int i = 0; i < nb; ++i) {
+                                advection[dd*nb2 + j*nb + i] += w * basis[j] * grad_basis[dim*i + dd];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        face_coupling_.assign(nf*nb2, 0.0);
+        face_mass_.assign(2*nf*nb2, 0.0);
+        for (int face = 0; face < nf; ++face) {
+            const int c0 = grid_.face_cells[2*face];
+            const int c1 = grid_.face_cells[2*face + 1];
+            FaceQuadrature quad(grid_, face, 2*deg);
+            for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
+                quad.quadPtCoord(quad_pt, &coord[0]);
+                const double w = quad.quadPtWeight(quad_pt);
+                if (c0 >= 0) {
+                    basis_func_->eval(c0, &coord[0], &basis[0]);
+                }
+                if (c1 >= 0) {
+                    basis_func_->eval(c1, &coord[0], &basis_nb[0]);
+                }
+                for (int j = 0; j < nb; ++j) {
+                    for (int i = 0; i < nb; ++i) {
+                        if (c0 >= 0) {
+                            face_mass_[2*face*nb2 + j*nb + i] += w * basis[i] * basis[j];
+                        }
+                        if (c1 >= 0) {
+                            face_mass_[(2*face + 1)*nb2 + j*nb + i] += w * basis_nb[i] * basis_nb[j];
+                        }
+                        if (c0 >= 0 && c1 >= 0) {
+                            face_coupling_[face*nb2 + j*nb + i] += w * basis[j] * basis_nb[i];
+                        }
+                    }
+                }
+            }
         }
     }
 
@@ -272,29 +408,35 @@ namespace Opm
         // For tracers, the equation is the same, except for the last
         // term being zero (the one with \phi).
         //
-        // The rhs_ vector contains a (Fortran ordering) matrix of all
+        // The rhs vector contains a (Fortran ordering) matrix of all
         // right-hand-sides, first for tof and then (optionally) for
         // all tracers.
 
         const int num_basis = basis_func_->numBasisFunc();
-        ++num_singlesolves_;
+        Workspace& ws = workspace_[sweepThread()];
+        ++ws.num_singlesolves;
 
-        std::fill(rhs_.begin(), rhs_.end(), 0.0);
-        std::fill(jac_.begin(), jac_.end(), 0.0);
+        std::fill(ws.rhs.begin(), ws.rhs.end(), 0.0);
+        std::fill(ws.jac.begin(), ws.jac.end(), 0.0);
 
-        // Add cell contributions to res_ and jac_.
-        cellContribs(cell);
+        if (hasQuadratureCache()) {
+            cachedCellContribs(cell, ws);
+            cachedFaceContribs(cell, ws);
+        } else {
+            // Add cell contributions to res and jac.
+            cellContribs(cell, ws);
 
-        // Add face contributions to res_ and jac_.
-        faceContribs(cell);
+            // Add face contributions to res and jac.
+            faceContribs(cell, ws);
+        }
 
         // Solve linear equation.
-        solveLinearSystem(cell);
+        solveLinearSystem(cell, ws);
 
-        // The solution ends up in rhs_, so we must copy it.
-        std::copy(rhs_.begin(), rhs_.begin() + num_basis, tof_coeff_ + num_basis*cell);
+        // The solution ends up in rhs, so we must copy it.
+        std::copy(ws.rhs.begin(), ws.rhs.begin() + num_basis, tof_coeff_ + num_basis*cell);
         if (num_tracers_ && tracerhead_by_cell_[cell] == NoTracerHead) {
-            std::copy(rhs_.begin() + num_basis, rhs_.end(), tracer_coeff_ + num_tracers_*num_basis*cell);
+            std::copy(ws.rhs.begin() + num_basis, ws.rhs.end(), tracer_coeff_ + num_tracers_*num_basis*cell);
         }
 
         // Apply limiter.
@@ -331,7 +473,7 @@ namespace Opm
 
 
 
-    void TofDiscGalReorder::cellContribs(const int cell)
+    void TofDiscGalReorder::cellContribs(const int cell, Workspace& ws)
     {
         const int num_basis = basis_func_->numBasisFunc();
         const int dim = grid_.dimensions;
@@ -342,18 +484,18 @@ namespace Opm
             CellQuadrature quad(grid_, cell, deg_needed);
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
                 // Integral of: b_i \phi
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
+                quad.quadPtCoord(quad_pt, &ws.coord[0]);
+                basis_func_->eval(cell, &ws.coord[0], &ws.basis[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 for (int j = 0; j < num_basis; ++j) {
                     // Only adding to the tof rhs.
-                    rhs_[j] += w * basis_[j] * porevolume_[cell] / grid_.cell_volumes[cell];
+                    ws.rhs[j] += w * ws.basis[j] * porevolume_[cell] / grid_.cell_volumes[cell];
                 }
             }
         }
 
         // Compute cell jacobian contribution. We use Fortran ordering
-        // for jac_, i.e. rows cycling fastest.
+        // for the jacobian, i.e. rows cycling fastest.
         {
             // Even with ECVI velocity interpolation, degree of precision 1
             // is sufficient for optimal convergence order for DG1 when we
@@ -368,15 +510,15 @@ namespace Opm
             CellQuadrature quad(grid_, cell, deg_needed);
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
                 // b_i (v \cdot \grad b_j)
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
-                basis_func_->evalGrad(cell, &coord_[0], &grad_basis_[0]);
-                velocity_interpolation_->interpolate(cell, &coord_[0], &velocity_[0]);
+                quad.quadPtCoord(quad_pt, &ws.coord[0]);
+                basis_func_->eval(cell, &ws.coord[0], &ws.basis[0]);
+                basis_func_->evalGrad(cell, &ws.coord[0], &ws.grad_basis[0]);
+                velocity_interpolation_->interpolate(cell, &ws.coord[0], &ws.velocity[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 for (int j = 0; j < num_basis; ++j) {
                     for (int i = 0; i < num_basis; ++i) {
                         for (int dd = 0; dd < dim; ++dd) {
-                            jac_[j*num_basis + i] -= w * basis_[j] * grad_basis_[dim*i + dd] * velocity_[dd];
+                            ws.jac[j*num_basis + i] -= w * ws.basis[j] * ws.grad_basis[dim*i + dd] * ws.velocity[dd];
                         }
                     }
                 }
@@ -396,12 +538,12 @@ namespace Opm
             // \int_{K} b_i flux b_j dx
             CellQuadrature quad(grid_, cell, 2*basis_func_->degree());
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
+                quad.quadPtCoord(quad_pt, &ws.coord[0]);
+                basis_func_->eval(cell, &ws.coord[0], &ws.basis[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 for (int j = 0; j < num_basis; ++j) {
                     for (int i = 0; i < num_basis; ++i) {
-                        jac_[j*num_basis + i] += w * basis_[i] * flux_density * basis_[j];
+                        ws.jac[j*num_basis + i] += w * ws.basis[i] * flux_density * ws.basis[j];
                     }
                 }
             }
@@ -411,7 +553,7 @@ namespace Opm
 
 
 
-    void TofDiscGalReorder::faceContribs(const int cell)
+    void TofDiscGalReorder::faceContribs(const int cell, Workspace& ws)
     {
         const int num_basis = basis_func_->numBasisFunc();
 
@@ -448,23 +590,23 @@ namespace Opm
             const int deg_needed = 2*basis_func_->degree();
             FaceQuadrature quad(grid_, face, deg_needed);
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
-                basis_func_->eval(upstream_cell, &coord_[0], &basis_nb_[0]);
+                quad.quadPtCoord(quad_pt, &ws.coord[0]);
+                basis_func_->eval(cell, &ws.coord[0], &ws.basis[0]);
+                basis_func_->eval(upstream_cell, &ws.coord[0], &ws.basis_nb[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 // Modify tof rhs
-                const double tof_upstream = std::inner_product(basis_nb_.begin(), basis_nb_.end(),
+                const double tof_upstream = std::inner_product(ws.basis_nb.begin(), ws.basis_nb.end(),
                                                                tof_coeff_ + num_basis*upstream_cell, 0.0);
                 for (int j = 0; j < num_basis; ++j) {
-                    rhs_[j] -= w * tof_upstream * normal_velocity * basis_[j];
+                    ws.rhs[j] -= w * tof_upstream * normal_velocity * ws.basis[j];
                 }
                 // Modify tracer rhs
                 if (num_tracers_ && tracerhead_by_cell_[cell] == NoTracerHead) {
                     for (int tr = 0; tr < num_tracers_; ++tr) {
                         const double* up_tr_co = tracer_coeff_ + num_tracers_*num_basis*upstream_cell + num_basis*tr;
-                        const double tracer_up = std::inner_product(basis_nb_.begin(), basis_nb_.end(), up_tr_co, 0.0);
+                        const double tracer_up = std::inner_product(ws.basis_nb.begin(), ws.basis_nb.end(), up_tr_co, 0.0);
                         for (int j = 0; j < num_basis; ++j) {
-                            rhs_[num_basis*(tr + 1) + j] -= w * tracer_up * normal_velocity * basis_[j];
+                            ws.rhs[num_basis*(tr + 1) + j] -= w * tracer_up * normal_velocity * ws.basis[j];
                         }
                     }
                 }
@@ -490,12 +632,12 @@ namespace Opm
             FaceQuadrature quad(grid_, face, 2*basis_func_->degree());
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
                 // u^ext flux B   (B = {b_j})
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
+                quad.quadPtCoord(quad_pt, &ws.coord[0]);
+                basis_func_->eval(cell, &ws.coord[0], &ws.basis[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 for (int j = 0; j < num_basis; ++j) {
                     for (int i = 0; i < num_basis; ++i) {
-                        jac_[j*num_basis + i] += w * basis_[i] * normal_velocity * basis_[j];
+                        ws.jac[j*num_basis + i] += w * ws.basis[i] * normal_velocity * ws.basis[j];
                     }
                 }
             }
@@ -504,11 +646,115 @@ namespace Opm
 
 
 
-    // This function assumes that jac_ and rhs_ contain the
-    // linear system to be solved. They are stored in orig_jac_
-    // and orig_rhs_, then the system is solved via LAPACK,
-    // overwriting the input data (jac_ and rhs_).
-    void TofDiscGalReorder::solveLinearSystem(const int cell)
+    // Same as cellContribs(), using the precomputed integrals.
+    void TofDiscGalReorder::cachedCellContribs(const int cell, Workspace& ws)
+    {
+        const int num_basis = basis_func_->numBasisFunc();
+        const int nb2 = num_basis*num_basis;
+        const int dim = grid_.dimensions;
+
+        // Cell residual contribution: \int_K b_j \phi.
+        const double* integral = &cell_source_integral_[cell*num_basis];
+        const double phi = porevolume_[cell] / grid_.cell_volumes[cell];
+        for (int j = 0; j < num_basis; ++j) {
+            ws.rhs[j] += integral[j] * phi;
+        }
+
+        // Cell jacobian contribution: - \int_K b_j (v \cdot \grad b_i).
+        if (use_cvi_) {
+            // The velocity varies within the cell, integrate as usual.
+            const int deg_needed = 2*basis_func_->degree();
+            CellQuadrature quad(grid_, cell, deg_needed);
+            for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
+                quad.quadPtCoord(quad_pt, &ws.coord[0]);
+                basis_func_->eval(cell, &ws.coord[0], &ws.basis[0]);
+                basis_func_->evalGrad(cell, &ws.coord[0], &ws.grad_basis[0]);
+                velocity_interpolation_->interpolate(cell, &ws.coord[0], &ws.velocity[0]);
+                const double w = quad.quadPtWeight(quad_pt);
+                for (int j = 0; j < num_basis; ++j) {
+                    for (int i = 0; i < num_basis; ++i) {
+                        for (int dd = 0; dd < dim; ++dd) {
+                            ws.jac[j*num_basis + i] -= w * ws.basis[j] * ws.grad_basis[dim*i + dd] * ws.velocity[dd];
+                        }
+                    }
+                }
+            }
+        } else {
+            // Constant velocity, evaluated anywhere in the cell.
+            velocity_interpolation_->interpolate(cell, grid_.cell_centroids + dim*cell, &ws.velocity[0]);
+            const double* advection = &cell_advection_[cell*dim*nb2];
+            for (int dd = 0; dd < dim; ++dd) {
+                const double v = ws.velocity[dd];
+                for (int k = 0; k < nb2; ++k) {
+                    ws.jac[k] -= v * advection[dd*nb2 + k];
+                }
+            }
+        }
+
+        // Sink contribution: \int_K b_i flux b_j dx.
+        if (source_[cell] < 0.0) {
+            const double flux_density = -source_[cell] / grid_.cell_volumes[cell];
+            const double* mass = &cell_mass_[cell*nb2];
+            for (int k = 0; k < nb2; ++k) {
+                ws.jac[k] += flux_density * mass[k];
+            }
+        }
+    }
+
+
+
+
+    // Same as faceContribs(), using the precomputed integrals.
+    void TofDiscGalReorder::cachedFaceContribs(const int cell, Workspace& ws)
+    {
+        const int num_basis = basis_func_->numBasisFunc();
+        const int nb2 = num_basis*num_basis;
+        const bool compute_tracers = num_tracers_ && tracerhead_by_cell_[cell] == NoTracerHead;
+
+        for (int hface = grid_.cell_facepos[cell]; hface < grid_.cell_facepos[cell+1]; ++hface) {
+            const int face = grid_.cell_faces[hface];
+            const int side = (cell == grid_.face_cells[2*face]) ? 0 : 1;
+            const double flux = side == 0 ? darcyflux_[face] : -darcyflux_[face];
+            const int other_cell = grid_.face_cells[2*face + 1 - side];
+            const double normal_velocity = flux / grid_.face_areas[face];
+            if (flux > 0.0) {
+                // Downstream jacobian contribution: \int_{\partial K} b_i (v \cdot n) b_j ds.
+                const double* mass = &face_mass_[(2*face + side)*nb2];
+                for (int k = 0; k < nb2; ++k) {
+                    ws.jac[k] += normal_velocity * mass[k];
+                }
+            } else if (flux < 0.0 && other_cell >= 0) {
+                // Upstream residual contribution: \int_{\partial K} u_h^{ext} (v \cdot n) b_j ds.
+                // The coupling matrix has rows for the basis of cell
+                // c0, so it is transposed when this cell is c1.
+                const double* coupling = &face_coupling_[face*nb2];
+                const int row_stride = side == 0 ? num_basis : 1;
+                const int col_stride = side == 0 ? 1 : num_basis;
+                const int num_up = compute_tracers ? num_tracers_ + 1 : 1;
+                for (int comp = 0; comp < num_up; ++comp) {
+                    const double* up_co = comp == 0
+                        ? tof_coeff_ + num_basis*other_cell
+                        : tracer_coeff_ + num_tracers_*num_basis*other_cell + num_basis*(comp - 1);
+                    for (int j = 0; j < num_basis; ++j) {
+                        double up = 0.0;
+                        for (int k = 0; k < num_basis; ++k) {
+                            up += coupling[j*row_stride + k*col_stride] * up_co[k];
+                        }
+                        ws.rhs[num_basis*comp + j] -= normal_velocity * up;
+                    }
+                }
+            }
+        }
+    }
+
+
+
+
+    // This function assumes that ws.jac and ws.rhs contain the
+    // linear system to be solved. They are stored in ws.orig_jac
+    // and ws.orig_rhs, then the system is solved via LAPACK,
+    // overwriting the input data (ws.jac and ws.rhs).
+    void TofDiscGalReorder::solveLinearSystem(const int cell, Workspace& ws)
     {
         MAT_SIZE_T n = basis_func_->numBasisFunc();
         int num_tracer_to_compute = num_tracers_;
@@ -522,22 +768,22 @@ namespace Opm
         std::vector<MAT_SIZE_T> piv(n);
         MAT_SIZE_T ldb = n;
         MAT_SIZE_T info = 0;
-        orig_jac_ = jac_;
-        orig_rhs_ = rhs_;
-        dgesv_(&n, &nrhs, &jac_[0], &lda, &piv[0], &rhs_[0], &ldb, &info);
+        ws.orig_jac = ws.jac;
+        ws.orig_rhs = ws.rhs;
+        dgesv_(&n, &nrhs, &ws.jac[0], &lda, &piv[0], &ws.rhs[0], &ldb, &info);
         if (info != 0) {
             // Print the local matrix and rhs.
             std::cerr << "Failed solving single-cell system Ax = b in cell " << cell
                       << " with A = \n";
             for (int row = 0; row < n; ++row) {
                 for (int col = 0; col < n; ++col) {
-                    std::cerr << "    " << orig_jac_[row + n*col];
+                    std::cerr << "    " << ws.orig_jac[row + n*col];
                 }
                 std::cerr << '\n';
             }
             std::cerr << "and b = \n";
             for (int row = 0; row < n; ++row) {
-                std::cerr << "    " << orig_rhs_[row] << '\n';
+                std::cerr << "    " << ws.orig_rhs[row] << '\n';
             }
             OPM_THROW(std::runtime_error, "Lapack error: " << info << " encountered in cell " << cell);
         }
@@ -548,8 +794,9 @@ namespace Opm
 
     void TofDiscGalReorder::solveMultiCell(const int num_cells, const int* cells)
     {
-        ++num_multicell_;
-        max_size_multicell_ = std::max(max_size_multicell_, num_cells);
+        Workspace& ws = workspace_[sweepThread()];
+        ++ws.num_multicell;
+        ws.max_size_multicell = std::max(ws.max_size_multicell, num_cells);
         // std::cout << "Multiblock solve with " << num_cells << " cells." << std::endl;
 
         // Using a Gauss-Seidel approach.
@@ -568,7 +815,7 @@ namespace Opm
             }
             // std::cout << "Max delta = " << max_delta << std::endl;
         }
-        max_iter_multicell_ = std::max(max_iter_multicell_, num_iter);
+        ws.max_iter_multicell = std::max(ws.max_iter_multicell, num_iter);
     }
 
 
@@ -748,10 +995,11 @@ namespace Opm
         const int dim = grid_.dimensions;
         const int num_basis = basis_func_->numBasisFunc();
         double min_cornerval = 1e100;
+        std::vector<double>& basis = workspace_[sweepThread()].basis;
         for (int fnode = grid_.face_nodepos[face]; fnode < grid_.face_nodepos[face+1]; ++fnode) {
             const double* nc = grid_.node_coordinates + dim*grid_.face_nodes[fnode];
-            basis_func_->eval(cell, nc, &basis_[0]);
-            const double tof_corner = std::inner_product(basis_.begin(), basis_.end(),
+            basis_func_->eval(cell, nc, &basis[0]);
+            const double tof_corner = std::inner_product(basis.begin(), basis.end(),
                                                          tof_coeff_ + num_basis*cell, 0.0);
             min_cornerval = std::min(min_cornerval, tof_corner);
         }
@@ -767,12 +1015,13 @@ namespace Opm
         const int num_basis = basis_func_->numBasisFunc();
         double min_cornerval = 1e100;
         double max_cornerval = -1e100;
+        std::vector<double>& basis = workspace_[sweepThread()].basis;
         for (int hface = grid_.cell_facepos[cell]; hface < grid_.cell_facepos[cell+1]; ++hface) {
             const int face = grid_.cell_faces[hface];
             for (int fnode = grid_.face_nodepos[face]; fnode < grid_.face_nodepos[face+1]; ++fnode) {
                 const double* nc = grid_.node_coordinates + dim*grid_.face_nodes[fnode];
-                basis_func_->eval(cell, nc, &basis_[0]);
-                const double tracer_corner = std::inner_product(basis_.begin(), basis_.end(),
+                basis_func_->eval(cell, nc, &basis[0]);
+                const double tracer_corner = std::inner_product(basis.begin(), basis.end(),
                                                                 local_coeff, 0.0);
                 min_cornerval = std::min(min_cornerval, tracer_corner);
                 max_cornerval = std::max(min_cornerval, tracer_corner);
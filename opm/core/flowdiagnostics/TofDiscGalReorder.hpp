@@ -71,6 +71,12 @@ namespace Opm
         ///                                             computing (unlimited) solution.
         ///             - AsSimultaneousPostProcess  -- Apply to each cell independently, using un-
         ///                                             limited solution in neighbouring cells.
+        ///   - \c use_quadrature_cache (false)            -- Precompute the quadrature integrals of the
+        ///                                                   basis functions over all cells and faces once,
+        ///                                                   instead of in every solve. With use_cvi, the
+        ///                                                   advection term is still integrated in every solve.
+        ///   - \c quadrature_cache_max_mb (1024)          -- Memory budget for the cache. If exceeded, no
+        ///                                                   cache is built.
         TofDiscGalReorder(const UnstructuredGrid& grid,
                           const ParameterGroup& param);
 
@@ -117,13 +123,42 @@ namespace Opm
                             std::vector<double>& tof_coeff,
                             std::vector<double>& tracer_coeff);
 
+        /// True if the quadrature integrals are precomputed, see the
+        /// use_quadrature_cache parameter.
+        bool hasQuadratureCache() const;
+
     private:
+        // Per-thread scratch arrays and statistics.
+        struct Workspace
+        {
+            std::vector<double> rhs;        // single-cell right-hand-sides
+            std::vector<double> jac;        // single-cell jacobian
+            std::vector<double> orig_rhs;   // single-cell right-hand-sides (copy)
+            std::vector<double> orig_jac;   // single-cell jacobian (copy)
+            std::vector<double> coord;
+            std::vector<double> basis;
+            std::vector<double> basis_nb;
+            std::vector<double> grad_basis;
+            std::vector<double> velocity;
+            int num_singlesolves;
+            // For solveMultiCell():
+            int num_multicell;
+            int max_size_multicell;
+            int max_iter_multicell;
+        };
+
+        virtual bool supportsParallelSweep() const;
         virtual void solveSingleCell(const int cell);
         virtual void solveMultiCell(const int num_cells, const int* cells);
 
-        void cellContribs(const int cell);
-        void faceContribs(const int cell);
-        void solveLinearSystem(const int cell);
+        void initWorkspace();
+        void executeSolve();
+        void buildQuadratureCache();
+        void cellContribs(const int cell, Workspace& ws);
+        void faceContribs(const int cell, Workspace& ws);
+        void cachedCellContribs(const int cell, Workspace& ws);
+        void cachedFaceContribs(const int cell, Workspace& ws);
+        void solveLinearSystem(const int cell, Workspace& ws);
 
     private:
         // Disable copying and assignment.
@@ -151,22 +186,19 @@ namespace Opm
         enum { NoTracerHead = -1 };
         std::vector<int> tracerhead_by_cell_;
         bool tracers_ensure_unity_;
-        // Used by solveSingleCell().
-        std::vector<double> rhs_;   // single-cell right-hand-sides
-        std::vector<double> jac_;   // single-cell jacobian
-        std::vector<double> orig_rhs_;   // single-cell right-hand-sides (copy)
-        std::vector<double> orig_jac_;   // single-cell jacobian (copy)
-        std::vector<double> coord_;
-        mutable std::vector<double> basis_;
-        mutable std::vector<double> basis_nb_;
-        std::vector<double> grad_basis_;
-        std::vector<double> velocity_;
-        int num_singlesolves_;
+        // Used by solveSingleCell(), one per sweep thread.
+        mutable std::vector<Workspace> workspace_;
         // Used by solveMultiCell():
         double gauss_seidel_tol_;
-        int num_multicell_;
-        int max_size_multicell_;
-        int max_iter_multicell_;
+        // Precomputed quadrature integrals, empty unless use_quadrature_cache_.
+        // Matrices are nb*nb with nb basis functions, entry (j, i) at j*nb + i.
+        bool use_quadrature_cache_;
+        double quadrature_cache_max_mb_;
+        std::vector<double> cell_source_integral_;  // \int_K b_j, nb per cell
+        std::vector<double> cell_mass_;             // \int_K b_i b_j, one matrix per cell
+        std::vector<double> cell_advection_;        // \int_K b_j d b_i/dx_d, dim matrices per cell
+        std::vector<double> face_coupling_;         // \int_F b_j^{c0} b_i^{c1}, one matrix per face
+        std::vector<double> face_mass_;             // \int_F b_i^c b_j^c, c = c0, c1, two matrices per face
 
         // Private methods
 
@@ -42,6 +42,10 @@ namespace Opm
           porevolume_(0),
           source_(0),
           tof_(0),
+          compute_tracer_(false),
+          num_tracers_(0),
+          tracer_(0),
+          num_comp_(1),
           gauss_seidel_tol_(1e-3),
           use_multidim_upwind_(use_multidim_upwind)
     {
@@ -76,13 +80,11 @@ namespace Opm
         tof.resize(grid_.number_of_cells);
         std::fill(tof.begin(), tof.end(), 0.0);
         tof_ = &tof[0];
-        if (use_multidim_upwind_) {
-            face_tof_.resize(grid_.number_of_faces);
-            std::fill(face_tof_.begin(), face_tof_.end(), 0.0);
-            face_part_tof_.resize(grid_.face_nodepos[grid_.number_of_faces]);
-            std::fill(face_part_tof_.begin(), face_part_tof_.end(), 0.0);
-        }
         compute_tracer_ = false;
+        num_tracers_ = 0;
+        tracer_ = 0;
+        num_comp_ = 1;
+        initWorkspace();
         executeSolve();
     }
 
@@ -122,18 +124,9 @@ namespace Opm
         std::fill(tof.begin(), tof.end(), 0.0);
         tof_ = &tof[0];
 
-        if (use_multidim_upwind_) {
-            face_tof_.resize(grid_.number_of_faces);
-            std::fill(face_tof_.begin(), face_tof_.end(), 0.0);
-            face_part_tof_.resize(grid_.face_nodepos[grid_.number_of_faces]);
-            std::fill(face_part_tof_.begin(), face_part_tof_.end(), 0.0);
-        }
-
-        // Execute solve for tof
-        compute_tracer_ = false;
-        executeSolve();
-
-        // Find the tracer heads (injectors).
+        // Find the tracer heads (injectors).  Tracer values are
+        // stored cell by cell, so that a single sweep updates all
+        // tracers of a cell in one contiguous block.
         const int num_tracers = tracerheads.size();
         tracer.resize(num_cells*num_tracers);
         std::fill(tracer.begin(), tracer.end(), 0.0);
@@ -145,26 +138,53 @@ namespace Opm
             const unsigned int tracerheadsSize = tracerheads[tr].size();
             for (unsigned int i = 0; i < tracerheadsSize; ++i) {
                 const int cell = tracerheads[tr][i];
-                tracer[num_cells * tr + cell] = 1.0;
+                tracer[num_tracers * cell + tr] = 1.0;
                 tracerhead_by_cell_[cell] = tr;
             }
         }
 
-        // Execute solve for tracers.
-        std::vector<double> fake_pv(num_cells, 0.0);
-        porevolume_ = fake_pv.data();
-        for (int tr = 0; tr < num_tracers; ++tr) {
-            tof_ = tracer.data() + tr * num_cells;
-            compute_tracer_ = true;
-            executeSolve();
-        }
+        // Execute a single solve for tof and all tracers.
+        compute_tracer_ = num_tracers > 0;
+        num_tracers_ = num_tracers;
+        tracer_ = compute_tracer_ ? tracer.data() : 0;
+        num_comp_ = 1 + num_tracers;
+        initWorkspace();
+        executeSolve();
+    }
 
-        // Write output tracer data (transposing the computed data).
-        std::vector<double> computed = tracer;
-        for (int cell = 0; cell < num_cells; ++cell) {
-            for (int tr = 0; tr < num_tracers; ++tr) {
-                tracer[num_tracers * cell + tr] = computed[num_cells * tr + cell];
-            }
+
+
+
+    // Every cell solve only writes the values of its own cell and of
+    // its downwind faces, and only reads values of upwind cells and
+    // faces, so only the per-cell workspace must be thread-private.
+    bool TofReorder::supportsParallelSweep() const
+    {
+        return true;
+    }
+
+
+
+
+    void TofReorder::initWorkspace()
+    {
+        if (use_multidim_upwind_) {
+            face_tof_.resize(num_comp_*grid_.number_of_faces);
+            std::fill(face_tof_.begin(), face_tof_.end(), 0.0);
+            face_part_tof_.resize(num_comp_*grid_.face_nodepos[grid_.number_of_faces]);
+            std::fill(face_part_tof_.begin(), face_part_tof_.end(), 0.0);
+        }
+        workspace_.resize(maxSweepThreads());
+        for (std::size_t t = 0; t < workspace_.size(); ++t) {
+            Workspace& ws = workspace_[t];
+            ws.upwind_term.resize(num_comp_);
+            ws.downwind_term_face.resize(num_comp_);
+            ws.face_term.resize(num_comp_);
+            ws.value_before.resize(num_comp_);
+            ws.local_face_term.resize(num_comp_);
+            ws.num_multicell = 0;
+            ws.max_size_multicell = 0;
+            ws.max_iter_multicell = 0;
         }
     }
 
@@ -173,14 +193,19 @@ namespace Opm
 
     void TofReorder::executeSolve()
     {
-        num_multicell_ = 0;
-        max_size_multicell_ = 0;
-        max_iter_multicell_ = 0;
         reorderAndTransport(grid_, darcyflux_);
-        if (num_multicell_ > 0) {
-            std::cout << num_multicell_ << " multicell blocks with max size "
-                      << max_size_multicell_ << " cells in upto "
-                      << max_iter_multicell_ << " iterations." << std::endl;
+        int num_multicell = 0;
+        int max_size_multicell = 0;
+        int max_iter_multicell = 0;
+        for (std::size_t t = 0; t < workspace_.size(); ++t) {
+            num_multicell += workspace_[t].num_multicell;
+            max_size_multicell = std::max(max_size_multicell, workspace_[t].max_size_multicell);
+            max_iter_multicell = std::max(max_iter_multicell, workspace_[t].max_iter_multicell);
+        }
+        if (num_multicell > 0) {
+            std::cout << num_multicell << " multicell blocks with max size "
+                      << max_size_multicell << " cells in upto "
+                      << max_iter_multicell << " iterations." << std::endl;
         }
     }
 
@@ -198,9 +223,13 @@ namespace Opm
         // to the downwind_flux (note sign change resulting from
         // different sign conventions: pos. source is injection,
         // pos. flux is outflow).
-        if (compute_tracer_ && tracerhead_by_cell_[cell] != NoTracerHead) {
-            // This is a tracer head cell, already has solution.
-            return;
+        // Tracer head cells already have their tracer solution.
+        const bool solve_tracer = compute_tracer_ && tracerhead_by_cell_[cell] == NoTracerHead;
+        const int nt = num_tracers_;
+        Workspace& ws = workspace_[sweepThread()];
+        double* upwind_tracer = solve_tracer ? &ws.upwind_term[1] : 0;
+        if (solve_tracer) {
+            std::fill(upwind_tracer, upwind_tracer + nt, 0.0);
         }
         double upwind_term = 0.0;
         double downwind_flux = std::max(-source_[cell], 0.0);
@@ -220,17 +249,30 @@ namespace Opm
             if (flux < 0.0) {
                 // Using tof == 0 on inflow, so we only add a
                 // nonzero contribution if we are on an internal
-                // face.
+                // face. The same holds for the tracers.
                 if (other != -1) {
                     upwind_term += flux*tof_[other];
+                    if (solve_tracer) {
+                        const double* other_tracer = tracer_ + nt*other;
+                        for (int tr = 0; tr < nt; ++tr) {
+                            upwind_tracer[tr] += flux*other_tracer[tr];
+                        }
+                    }
                 }
             } else {
                 downwind_flux += flux;
             }
         }
 
-        // Compute tof.
+        // Compute tof and tracers. The tracer equations are the tof
+        // equation with zero pore volume.
         tof_[cell] = (porevolume_[cell] - upwind_term)/downwind_flux;
+        if (solve_tracer) {
+            double* cell_tracer = tracer_ + nt*cell;
+            for (int tr = 0; tr < nt; ++tr) {
+                cell_tracer[tr] = -upwind_tracer[tr]/downwind_flux;
+            }
+        }
     }
 
 
@@ -244,9 +286,16 @@ namespace Opm
         // to the downwind terms (note sign change resulting from
         // different sign conventions: pos. source is injection,
         // pos. flux is outflow).
-        double upwind_term = 0.0;
+        // All terms are computed for tof (component 0) and, if
+        // requested, the tracers (components 1, ..., num_tracers_).
+        const int nc = num_comp_;
+        Workspace& ws = workspace_[sweepThread()];
+        std::vector<double>& upwind_term = ws.upwind_term;
+        std::vector<double>& downwind_term_face = ws.downwind_term_face;
+        std::vector<double>& face_term = ws.face_term;
+        std::fill(upwind_term.begin(), upwind_term.end(), 0.0);
+        std::fill(downwind_term_face.begin(), downwind_term_face.end(), 0.0);
         double downwind_term_cell_factor = std::max(-source_[cell], 0.0);
-        double downwind_term_face = 0.0;
         for (int i = grid_.cell_facepos[cell]; i < grid_.cell_facepos[cell+1]; ++i) {
             int f = grid_.cell_faces[i];
             double flux;
@@ -258,20 +307,28 @@ namespace Opm
             }
             // Add flux to upwind_term or downwind_term_[face|cell_factor].
             if (flux < 0.0) {
-                upwind_term += flux*face_tof_[f];
+                for (int k = 0; k < nc; ++k) {
+                    upwind_term[k] += flux*face_tof_[nc*f + k];
+                }
             } else if (flux > 0.0) {
-                double fterm, cterm_factor;
-                multidimUpwindTerms(f, cell, fterm, cterm_factor);
-                downwind_term_face += fterm*flux;
+                double cterm_factor;
+                multidimUpwindTerms(f, cell, &ws.local_face_term[0], &face_term[0], cterm_factor);
+                for (int k = 0; k < nc; ++k) {
+                    downwind_term_face[k] += face_term[k]*flux;
+                }
                 downwind_term_cell_factor += cterm_factor*flux;
             }
         }
 
         // Compute tof for cell.
-        if (compute_tracer_ && tracerhead_by_cell_[cell] != NoTracerHead) {
-            // Do nothing to the value in this cell, since we are at a tracer head.
-        } else {
-            tof_[cell] = (porevolume_[cell] - upwind_term - downwind_term_face)/downwind_term_cell_factor;
+        tof_[cell] = (porevolume_[cell] - upwind_term[0] - downwind_term_face[0])/downwind_term_cell_factor;
+
+        // Compute tracers for cell, unless we are at a tracer head.
+        if (compute_tracer_ && tracerhead_by_cell_[cell] == NoTracerHead) {
+            double* cell_tracer = tracer_ + num_tracers_*cell;
+            for (int tr = 0; tr < num_tracers_; ++tr) {
+                cell_tracer[tr] = (-upwind_term[1 + tr] - downwind_term_face[1 + tr])/downwind_term_cell_factor;
+            }
         }
 
         // Compute tof for downwind faces.
@@ -279,21 +336,21 @@ namespace Opm
             int f = grid_.cell_faces[i];
             const double outflux_f = (grid_.face_cells[2*f] == cell) ? darcyflux_[f] : -darcyflux_[f];
             if (outflux_f > 0.0) {
-                double fterm, cterm_factor;
-                multidimUpwindTerms(f, cell, fterm, cterm_factor);
-                face_tof_[f] = fterm + cterm_factor*tof_[cell];
+                double cterm_factor;
+                multidimUpwindTerms(f, cell, &ws.local_face_term[0], &face_term[0], cterm_factor);
+                setFaceValues(cell, &face_term[0], cterm_factor, &face_tof_[nc*f]);
 
                 // Combine locally computed (for each adjacent vertex) terms, with uniform weighting.
                 const int* face_nodes_beg = grid_.face_nodes + grid_.face_nodepos[f];
                 const int* face_nodes_end = grid_.face_nodes + grid_.face_nodepos[f + 1];
                 assert((face_nodes_end - face_nodes_beg) == 2 || grid_.dimensions != 2);
                 for (const int* fn_iter = face_nodes_beg; fn_iter < face_nodes_end; ++fn_iter) {
-                    double loc_face_term = 0.0;
                     double loc_cell_term_factor = 0.0;
                     const int node_pos = fn_iter - grid_.face_nodes;
                     localMultidimUpwindTerms(f, cell, node_pos,
-                                             loc_face_term, loc_cell_term_factor);
-                    face_part_tof_[node_pos] = loc_face_term + loc_cell_term_factor * tof_[cell];
+                                             &face_term[0], loc_cell_term_factor);
+                    setFaceValues(cell, &face_term[0], loc_cell_term_factor,
+                                  &face_part_tof_[nc*node_pos]);
                 }
             }
         }
@@ -302,10 +359,29 @@ namespace Opm
 
 
 
+    // Set face (or face-part) values of all components:
+    //   value(face) = face_term + cell_term_factor*value(upwind_cell).
+    void TofReorder::setFaceValues(const int upwind_cell,
+                                   const double* face_term,
+                                   const double cell_term_factor,
+                                   double* face_values) const
+    {
+        face_values[0] = face_term[0] + cell_term_factor*tof_[upwind_cell];
+        for (int tr = 0; tr < num_comp_ - 1; ++tr) {
+            face_values[1 + tr] = face_term[1 + tr]
+                + cell_term_factor*tracer_[num_tracers_*upwind_cell + tr];
+        }
+    }
+
+
+
+
     void TofReorder::solveMultiCell(const int num_cells, const int* cells)
     {
-        ++num_multicell_;
-        max_size_multicell_ = std::max(max_size_multicell_, num_cells);
+        Workspace& ws = workspace_[sweepThread()];
+        std::vector<double>& value_before = ws.value_before;
+        ++ws.num_multicell;
+        ws.max_size_multicell = std::max(ws.max_size_multicell, num_cells);
         // std::cout << "Multiblock solve with " << num_cells << " cells." << std::endl;
 
         // Using a Gauss-Seidel approach.
@@ -317,12 +393,21 @@ namespace Opm
             for (int ci = 0; ci < num_cells; ++ci) {
                 const int cell = cells[ci];
                 const double tof_before = tof_[cell];
+                double* cell_tracer = tracer_ + num_tracers_*cell;
+                if (compute_tracer_) {
+                    std::copy(cell_tracer, cell_tracer + num_tracers_, value_before.begin());
+                }
                 solveSingleCell(cell);
                 max_delta = std::max(max_delta, std::fabs(tof_[cell] - tof_before));
+                if (compute_tracer_) {
+                    for (int tr = 0; tr < num_tracers_; ++tr) {
+                        max_delta = std::max(max_delta, std::fabs(cell_tracer[tr] - value_before[tr]));
+                    }
+                }
             }
             // std::cout << "Max delta = " << max_delta << std::endl;
         }
-        max_iter_multicell_ = std::max(max_iter_multicell_, num_iter);
+        ws.max_iter_multicell = std::max(ws.max_iter_multicell, num_iter);
     }
 
 
@@ -333,13 +418,15 @@ namespace Opm
     // 'node_pos' is the same as the one used for the grid face-node
     // connectivity.
     // Assumes that darcyflux_[face] is != 0.0.
+    // The array 'scratch' must hold num_comp_ values.
     // This function returns factors to compute the tof for 'face':
     //   tof(face) = face_term + cell_term_factor*tof(upwind_cell).
     // It is not computed here, since these factors are needed to
     // compute the tof(upwind_cell) itself.
     void TofReorder::multidimUpwindTerms(const int face,
                                          const int upwind_cell,
-                                         double& face_term,
+                                         double* scratch,
+                                         double* face_term,
                                          double& cell_term_factor) const
     {
         // Implements multidim upwind inspired by
@@ -357,17 +444,22 @@ namespace Opm
         const int* face_nodes_end = grid_.face_nodes + grid_.face_nodepos[face + 1];
         const int num_terms = face_nodes_end - face_nodes_beg;
         assert(num_terms == 2 || grid_.dimensions != 2);
-        face_term = 0.0;
+        const int nc = num_comp_;
+        double* loc = scratch;
+        std::fill(face_term, face_term + nc, 0.0);
         cell_term_factor = 0.0;
         for (const int* fn_iter = face_nodes_beg; fn_iter < face_nodes_end; ++fn_iter) {
-            double loc_face_term = 0.0;
             double loc_cell_term_factor = 0.0;
             localMultidimUpwindTerms(face, upwind_cell, fn_iter - grid_.face_nodes,
-                                     loc_face_term, loc_cell_term_factor);
-            face_term += loc_face_term;
+                                     loc, loc_cell_term_factor);
+            for (int k = 0; k < nc; ++k) {
+                face_term[k] += loc[k];
+            }
             cell_term_factor += loc_cell_term_factor;
         }
-        face_term /= double(num_terms);
+        for (int k = 0; k < nc; ++k) {
+            face_term[k] /= double(num_terms);
+        }
         cell_term_factor /= double(num_terms);
 
     }
@@ -393,7 +485,7 @@ namespace Opm
     void TofReorder::localMultidimUpwindTerms(const int face,
                                               const int upwind_cell,
                                               const int node_pos,
-                                              double& face_term,
+                                              double* face_term,
                                               double& cell_term_factor) const
     {
         // Loop over all faces adjacent to the given cell and the
@@ -434,10 +526,14 @@ namespace Opm
         const double w_factor = weightFunc(sum_influx / part_outflux);
         const int num_influx = influx.size();
         std::vector<double> w(num_influx);
-        face_term = 0.0;
+        const int nc = num_comp_;
+        std::fill(face_term, face_term + nc, 0.0);
         for (int ii = 0; ii < num_influx; ++ii) {
             w[ii] = (influx[ii] / sum_influx) * w_factor;
-            face_term += w[ii] * face_part_tof_[node_pos_influx[ii]];
+            const double* part_values = &face_part_tof_[nc*node_pos_influx[ii]];
+            for (int k = 0; k < nc; ++k) {
+                face_term[k] += w[ii] * part_values[k];
+            }
         }
         const double sum_w = std::accumulate(w.begin(), w.end(), 0.0);
         cell_term_factor = 1.0 - sum_w;
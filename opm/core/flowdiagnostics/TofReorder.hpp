@@ -40,6 +40,9 @@ namespace Opm
     /// in which \f$ v \f$ is the fluid velocity, \f$ \tau \f$ is time-of-flight and
     /// \f$ \phi \f$ is the porosity. This is a boundary value problem, and
     /// \f$ \tau \f$ is specified to be zero on all inflow boundaries.
+    ///
+    /// The solver supports level-scheduled parallel sweeps, see
+    /// ReorderSolverInterface::setParallelSweep().
     class TofReorder : public ReorderSolverInterface
     {
     public:
@@ -72,6 +75,10 @@ namespace Opm
         /// \param[out] tof               Array of time-of-flight values (1 per cell).
         /// \param[out] tracer            Array of tracer values. N per cell, where N is
         ///                               equalt to tracerheads.size().
+        /// Time-of-flight and all tracers are computed in a single
+        /// sweep over the cells, using a single ordering, so the cost
+        /// grows with the number of cells rather than with the number
+        /// of cells times the number of tracers.
         void solveTofTracer(const double* darcyflux,
                             const double* porevolume,
                             const double* source,
@@ -80,6 +87,8 @@ namespace Opm
                             std::vector<double>& tracer);
 
     private:
+        virtual bool supportsParallelSweep() const;
+        void initWorkspace();
         void executeSolve();
         virtual void solveSingleCell(const int cell);
         void solveSingleCellMultidimUpwind(const int cell);
@@ -89,10 +98,12 @@ namespace Opm
                                 double& rhs);
         virtual void solveMultiCell(const int num_cells, const int* cells);
 
-        void multidimUpwindTerms(const int face, const int upwind_cell,
-                                 double& face_term, double& cell_term_factor) const;
+        void multidimUpwindTerms(const int face, const int upwind_cell, double* scratch,
+                                 double* face_term, double& cell_term_factor) const;
         void localMultidimUpwindTerms(const int face, const int upwind_cell, const int node_pos,
-                                      double& face_term, double& cell_term_factor) const;
+                                      double* face_term, double& cell_term_factor) const;
+        void setFaceValues(const int upwind_cell, const double* face_term,
+                           const double cell_term_factor, double* face_values) const;
 
     private:
         const UnstructuredGrid& grid_;
@@ -103,15 +114,30 @@ namespace Opm
         bool compute_tracer_;
         enum { NoTracerHead = -1 };
         std::vector<int> tracerhead_by_cell_;
+        int num_tracers_;
+        double* tracer_;            // num_tracers_ values per cell, cell by cell
+        int num_comp_;              // 1 (tof) + number of tracers computed
+        // Per-thread workspace and statistics.
+        struct Workspace
+        {
+            // Per-cell terms, one value per component.
+            std::vector<double> upwind_term;
+            std::vector<double> downwind_term_face;
+            std::vector<double> face_term;
+            std::vector<double> value_before;
+            std::vector<double> local_face_term;  // For multidimUpwindTerms().
+            // For solveMultiCell():
+            int num_multicell;
+            int max_size_multicell;
+            int max_iter_multicell;
+        };
+        std::vector<Workspace> workspace_;
         // For solveMultiCell():
         double gauss_seidel_tol_;
-        int num_multicell_;
-        int max_size_multicell_;
-        int max_iter_multicell_;
         // For multidim upwinding:
         bool use_multidim_upwind_;
-        std::vector<double> face_tof_;       // For multidim upwind face tofs.
-        std::vector<double> face_part_tof_;  // For multidim upwind face tofs.
+        std::vector<double> face_tof_;       // For multidim upwind face tofs (and tracers).
+        std::vector<double> face_part_tof_;  // For multidim upwind face tofs (and tracers).
     };
 
 } // namespace Opm
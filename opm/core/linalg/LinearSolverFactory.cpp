@@ -22,6 +22,7 @@
 #endif
 
 #include <opm/core/linalg/LinearSolverFactory.hpp>
+#include <opm/core/linalg/LinearSolverKrylov.hpp>
 
 #if HAVE_SUITESPARSE_UMFPACK_H
 #include <opm/core/linalg/LinearSolverUmfpack.hpp>
@@ -52,7 +53,7 @@ namespace Opm
 #elif HAVE_PETSC
         solver_.reset(new LinearSolverPetsc);
 #else
-        OPM_THROW(std::runtime_error, "No linear solver available, you must have UMFPACK , dune-istl or Petsc installed to use LinearSolverFactory.");
+        solver_.reset(new LinearSolverKrylov);
 #endif
     }
 
@@ -68,8 +69,7 @@ namespace Opm
 #elif HAVE_PETSC
         std::string default_solver = "petsc";
 #else
-        std::string default_solver = "no_solver_available";
-        OPM_THROW(std::runtime_error, "No linear solver available, you must have UMFPACK , dune-istl or Petsc installed to use LinearSolverFactory.");
+        std::string default_solver = "krylov";
 #endif
 
         const std::string ls =
@@ -92,6 +92,10 @@ namespace Opm
 #endif
         }
 
+        else if (ls == "krylov") {
+            solver_.reset(new LinearSolverKrylov(param));
+        }
+
         else {
             OPM_THROW(std::runtime_error, "Linear solver " << ls << " is unknown.");
         }
@@ -135,6 +139,12 @@ namespace Opm
         return solver_->getTolerance();
     }
 
+    std::shared_ptr<LinearSolverInterface::Session>
+    LinearSolverFactory::makeSession(const SessionPolicy& policy) const
+    {
+        return solver_->makeSession(policy);
+    }
+
 
 
 } // namespace Opm
@@ -31,9 +31,11 @@ namespace Opm
 
 
     /// Concrete class encapsulating any available linear solver.
-    /// For the moment, this means UMFPACK and dune-istl.
-    /// Since both are optional dependencies, either or both
-    /// may be unavailable, depending on configuration.
+    /// For the moment, this means UMFPACK, dune-istl, PETSc and the
+    /// built-in LinearSolverKrylov.  The first three are optional
+    /// dependencies and may be unavailable, depending on configuration;
+    /// LinearSolverKrylov is always available and is the default when
+    /// none of the others are.
     class LinearSolverFactory : public LinearSolverInterface
     {
     public:
@@ -42,7 +44,7 @@ namespace Opm
 
         /// Construct from parameters.
         /// The accepted parameters are (default) (allowed values):
-        ///    linsolver ("umfpack")   ("umfpack", "istl", "petsc")
+        ///    linsolver ("umfpack")   ("umfpack", "istl", "petsc", "krylov")
         /// For the umfpack solver to be available, this class must be
         /// compiled with UMFPACK support, as indicated by the
         /// variable HAVE_SUITESPARSE_UMFPACK_H in config.h.
@@ -52,9 +54,11 @@ namespace Opm
         /// For the petsc solver to be available, this class must be
         /// compiled with petsc support, as indicated by the
         /// variable HAVE_PETSC in config.h.
+        /// The krylov solver is always available.
         /// Any further parameters are passed on to the constructors
         /// of the actual solver used, see LinearSolverUmfpack,
-        /// LinearSolverIstl and LinearSolverPetsc for details.
+        /// LinearSolverIstl, LinearSolverPetsc and LinearSolverKrylov
+        /// for details.
         LinearSolverFactory(const ParameterGroup& param);
 
         /// Destructor.
@@ -90,6 +94,10 @@ namespace Opm
         /// Not used for LinearSolverFactory. Returns -1.
         virtual double getTolerance() const;
 
+        /// Create a session bound to the underlying solver.
+        virtual std::shared_ptr<Session>
+        makeSession(const SessionPolicy& policy = SessionPolicy()) const;
+
     private:
         std::shared_ptr<LinearSolverInterface> solver_;
     };
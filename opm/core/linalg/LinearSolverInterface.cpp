@@ -23,6 +23,9 @@
 #include <opm/core/linalg/sparse_sys.h>
 #include <opm/core/linalg/call_umfpack.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace Opm
 {
 
@@ -41,5 +44,171 @@ namespace Opm
         return solve(A->m, A->nnz, A->ia, A->ja, A->sa, rhs, solution);
     }
 
+
+
+    namespace
+    {
+        /// Session for solvers without reusable setup.
+        class ForwardingSession : public LinearSolverInterface::Session
+        {
+        public:
+            ForwardingSession(const LinearSolverInterface& solver,
+                              const LinearSolverInterface::SessionPolicy& policy)
+                : LinearSolverInterface::Session(policy),
+                  solver_(solver)
+            {
+            }
+
+        protected:
+            virtual LinearSolverInterface::LinearSolverReport
+            solveWithSetup(SetupAction /* action */,
+                           const int size,
+                           const int nonzeros,
+                           const int* ia,
+                           const int* ja,
+                           const double* sa,
+                           const double* rhs,
+                           double* solution,
+                           const boost::any& comm)
+            {
+                return solver_.solve(size, nonzeros, ia, ja, sa, rhs, solution, comm);
+            }
+
+        private:
+            const LinearSolverInterface& solver_;
+        };
+    } // anonymous namespace
+
+
+
+    std::shared_ptr<LinearSolverInterface::Session>
+    LinearSolverInterface::makeSession(const SessionPolicy& policy) const
+    {
+        return std::make_shared<ForwardingSession>(*this, policy);
+    }
+
+
+
+    LinearSolverInterface::Session::Session(const SessionPolicy& policy)
+        : policy_(policy),
+          consecutive_reuses_(0)
+    {
+    }
+
+
+
+    LinearSolverInterface::Session::~Session()
+    {
+    }
+
+
+
+    LinearSolverInterface::LinearSolverReport
+    LinearSolverInterface::Session::solve(const CSRMatrix* A,
+                                          const double* rhs,
+                                          double* solution)
+    {
+        return solve(A->m, A->nnz, A->ia, A->ja, A->sa, rhs, solution);
+    }
+
+
+
+    LinearSolverInterface::LinearSolverReport
+    LinearSolverInterface::Session::solve(const int size,
+                                          const int nonzeros,
+                                          const int* ia,
+                                          const int* ja,
+                                          const double* sa,
+                                          const double* rhs,
+                                          double* solution,
+                                          const boost::any& comm)
+    {
+        if (! comm.empty()) {
+            // Parallel solves are not cached.
+            reset();
+            ++stats_.pattern_setups;
+            ++stats_.solves;
+
+            return solveWithSetup(PatternSetup, size, nonzeros, ia, ja, sa,
+                                  rhs, solution, comm);
+        }
+
+        const SetupAction action = classify(size, nonzeros, ia, ja, sa);
+
+        switch (action) {
+        case PatternSetup:
+            ia_.assign(ia, ia + size + 1);
+            ja_.assign(ja, ja + nonzeros);
+            sa_.assign(sa, sa + nonzeros);
+            consecutive_reuses_ = 0;
+            ++stats_.pattern_setups;
+            break;
+        case ValueSetup:
+            sa_.assign(sa, sa + nonzeros);
+            consecutive_reuses_ = 0;
+            ++stats_.value_setups;
+            break;
+        case ReuseSetup:
+            ++consecutive_reuses_;
+            ++stats_.reuses;
+            break;
+        }
+        ++stats_.solves;
+
+        return solveWithSetup(action, size, nonzeros, ia, ja, sa, rhs, solution, comm);
+    }
+
+
+
+    void LinearSolverInterface::Session::reset()
+    {
+        ia_.clear();
+        ja_.clear();
+        sa_.clear();
+        consecutive_reuses_ = 0;
+    }
+
+
+
+    const LinearSolverInterface::SessionStatistics&
+    LinearSolverInterface::Session::statistics() const
+    {
+        return stats_;
+    }
+
+
+
+    LinearSolverInterface::Session::SetupAction
+    LinearSolverInterface::Session::classify(const int size,
+                                             const int nonzeros,
+                                             const int* ia,
+                                             const int* ja,
+                                             const double* sa) const
+    {
+        if ((ia_.size() != std::size_t(size + 1)) ||
+            (ja_.size() != std::size_t(nonzeros)) ||
+            !std::equal(ia_.begin(), ia_.end(), ia) ||
+            !std::equal(ja_.begin(), ja_.end(), ja)) {
+            return PatternSetup;
+        }
+
+        if ((policy_.max_reuse > 0) && (consecutive_reuses_ >= policy_.max_reuse)) {
+            return ValueSetup;
+        }
+
+        double max_coeff  = 0.0;
+        double max_change = 0.0;
+        for (int i = 0; i < nonzeros; ++i) {
+            max_coeff  = std::max(max_coeff,  std::fabs(sa_[i]));
+            max_change = std::max(max_change, std::fabs(sa[i] - sa_[i]));
+        }
+
+        if (max_change > policy_.refresh_tolerance * max_coeff) {
+            return ValueSetup;
+        }
+
+        return ReuseSetup;
+    }
+
 } // namespace Opm
 
@@ -21,6 +21,8 @@
 #define OPM_LINEARSOLVERINTERFACE_HEADER_INCLUDED
 
 #include<boost/any.hpp>
+#include <memory>
+#include <vector>
 
 struct CSRMatrix;
 
@@ -81,6 +83,125 @@ namespace Opm
         /// \param[out] tolerance value
         virtual double getTolerance() const = 0;
 
+        /// Policy controlling when a Session reuses the matrix dependent
+        /// setup (symbolic/numeric factorisation, AMG hierarchy,
+        /// incomplete factorisation) of a previous solve.
+        struct SessionPolicy
+        {
+            SessionPolicy()
+                : refresh_tolerance(0.1),
+                  max_reuse(20)
+            {}
+
+            /// Refresh the setup when the maximum absolute change in the
+            /// matrix coefficients, relative to the maximum absolute
+            /// coefficient of the matrix used for the current setup,
+            /// exceeds this value.  Zero means refresh whenever any
+            /// coefficient changes.
+            double refresh_tolerance;
+
+            /// Refresh the setup after this many consecutive reuses.
+            /// Zero means no limit.
+            int max_reuse;
+        };
+
+        /// Counters for the setups performed by a Session.
+        struct SessionStatistics
+        {
+            SessionStatistics()
+                : solves(0), pattern_setups(0), value_setups(0), reuses(0)
+            {}
+
+            int solves;          ///< Number of calls to Session::solve().
+            int pattern_setups;  ///< Setups following a new sparsity pattern.
+            int value_setups;    ///< Setups for new values, same pattern.
+            int reuses;          ///< Solves that reused the previous setup.
+        };
+
+        /// A persistent solver state for a sequence of systems sharing
+        /// the same sparsity pattern, e.g. the Newton iterations and time
+        /// steps of a pressure solver.  Sessions are obtained from
+        /// makeSession() and cache whatever setup the underlying solver
+        /// can reuse between solves.  A session must not outlive the
+        /// solver that created it.
+        class Session
+        {
+        public:
+            explicit Session(const SessionPolicy& policy);
+
+            virtual ~Session();
+
+            /// Solve a linear system, reusing previous setup according
+            /// to the session's policy.
+            /// \param[in] A           matrix in CSR format
+            /// \param[in] rhs         array of length A->m containing the right hand side
+            /// \param[inout] solution array of length A->m to which the solution will be written
+            LinearSolverReport solve(const CSRMatrix* A,
+                                     const double* rhs,
+                                     double* solution);
+
+            /// Solve a linear system, reusing previous setup according
+            /// to the session's policy.  Arguments as for
+            /// LinearSolverInterface::solve().  Solves given a parallel
+            /// communicator in 'comm' are not cached; they perform a full
+            /// setup exactly like LinearSolverInterface::solve().
+            LinearSolverReport solve(const int size,
+                                     const int nonzeros,
+                                     const int* ia,
+                                     const int* ja,
+                                     const double* sa,
+                                     const double* rhs,
+                                     double* solution,
+                                     const boost::any& comm = boost::any());
+
+            /// Discard the current setup.  The next solve will redo the
+            /// full (pattern and value dependent) setup.
+            void reset();
+
+            /// Setup counters accumulated since construction.
+            const SessionStatistics& statistics() const;
+
+        protected:
+            /// What a solve must recompute before solving.
+            enum SetupAction {
+                PatternSetup,   ///< New sparsity pattern: full setup.
+                ValueSetup,     ///< Same pattern, new values: numeric setup.
+                ReuseSetup      ///< Reuse previous setup as is.
+            };
+
+            /// Solve with the given matrix after performing 'action'.
+            /// A non-empty 'comm' is always accompanied by PatternSetup.
+            virtual LinearSolverReport solveWithSetup(SetupAction action,
+                                                      const int size,
+                                                      const int nonzeros,
+                                                      const int* ia,
+                                                      const int* ja,
+                                                      const double* sa,
+                                                      const double* rhs,
+                                                      double* solution,
+                                                      const boost::any& comm) = 0;
+
+        private:
+            SetupAction classify(const int size,
+                                 const int nonzeros,
+                                 const int* ia,
+                                 const int* ja,
+                                 const double* sa) const;
+
+            SessionPolicy policy_;
+            SessionStatistics stats_;
+            int consecutive_reuses_;
+            std::vector<int> ia_;
+            std::vector<int> ja_;
+            std::vector<double> sa_;  // Values of the current setup.
+        };
+
+        /// Create a session bound to this solver.  The default
+        /// implementation forwards every solve to solve() and so reuses
+        /// nothing; solvers with expensive matrix setup override it.
+        virtual std::shared_ptr<Session>
+        makeSession(const SessionPolicy& policy = SessionPolicy()) const;
+
     };
 
 
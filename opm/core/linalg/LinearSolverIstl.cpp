@@ -24,6 +24,7 @@
 
 #include <opm/core/linalg/LinearSolverIstl.hpp>
 #include <opm/core/linalg/ParallelIstlInformation.hpp>
+#include <opm/core/linalg/linsys_binary.h>
 #include <opm/common/ErrorMacros.hpp>
 
 // Silence compatibility warning from DUNE headers since we don't use
@@ -53,6 +54,7 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <memory>
 #include <type_traits>
 
 namespace Opm
@@ -66,6 +68,13 @@ namespace Opm
         typedef Dune::BlockVector<VectorBlockType>        Vector;
         typedef Dune::MatrixAdapter<Mat,Vector,Vector> Operator;
 
+        // Single precision counterparts, used by the mixed precision mode.
+        typedef Dune::FieldVector<float, 1   > VectorBlockTypeF;
+        typedef Dune::FieldMatrix<float, 1, 1> MatrixBlockTypeF;
+        typedef Dune::BCRSMatrix <MatrixBlockTypeF>       MatF;
+        typedef Dune::BlockVector<VectorBlockTypeF>       VectorF;
+        typedef Dune::MatrixAdapter<MatF,VectorF,VectorF> OperatorF;
+
         template<class O, class S, class C>
         LinearSolverInterface::LinearSolverReport
         solveCG_ILU0(O& A, Vector& x, Vector& b, S& sp, const C& comm, double tolerance, int maxit, int verbosity);
@@ -88,6 +97,26 @@ namespace Opm
         template<class O, class S, class C>
         LinearSolverInterface::LinearSolverReport
         solveBiCGStab_ILU0(O& A, Vector& x, Vector& b, S& sp, const C& comm, double tolerance, int maxit, int verbosity);
+
+        /// Non-owning view of a system matrix in CSR format.
+        struct CsrView
+        {
+            int size;
+            const int* ia;
+            const int* ja;
+            const double* sa;
+        };
+
+        LinearSolverInterface::LinearSolverReport
+        solveMixedPrecision(const CsrView& A, Vector& x, Vector& b, int type, double tolerance, int maxit, int verbosity,
+                            double prolongateFactor, int smoothsteps);
+
+        void writeSystemBinary(const std::string& filename, const int size, const int nonzeros,
+                               const int* ia, const int* ja, const double* sa, const double* rhs);
+
+        void writeSystemMatlab(const std::string& filename, const Mat& A, const Vector& b);
+
+        Mat buildMatrix(const CsrView& A, const int nonzeros);
     } // anonymous namespace
 
 
@@ -98,9 +127,11 @@ namespace Opm
           linsolver_verbosity_(0),
           linsolver_type_(CG_AMG),
           linsolver_save_system_(false),
+          linsolver_save_binary_(false),
           linsolver_max_iterations_(0),
           linsolver_smooth_steps_(2),
-          linsolver_prolongate_factor_(1.6)
+          linsolver_prolongate_factor_(1.6),
+          linsolver_mixed_precision_(false)
     {
     }
 
@@ -112,9 +143,11 @@ namespace Opm
           linsolver_verbosity_(0),
           linsolver_type_(CG_AMG),
           linsolver_save_system_(false),
+          linsolver_save_binary_(false),
           linsolver_max_iterations_(0),
           linsolver_smooth_steps_(2),
-          linsolver_prolongate_factor_(1.6)
+          linsolver_prolongate_factor_(1.6),
+          linsolver_mixed_precision_(false)
     {
         linsolver_residual_tolerance_ = param.getDefault("linsolver_residual_tolerance", linsolver_residual_tolerance_);
         linsolver_verbosity_ = param.getDefault("linsolver_verbosity", linsolver_verbosity_);
@@ -122,10 +155,12 @@ namespace Opm
         linsolver_save_system_ = param.getDefault("linsolver_save_system", linsolver_save_system_);
         if (linsolver_save_system_) {
             linsolver_save_filename_ = param.getDefault("linsolver_save_filename", std::string("linsys"));
+            linsolver_save_binary_ = param.getDefault("linsolver_save_binary", linsolver_save_binary_);
         }
         linsolver_max_iterations_ = param.getDefault("linsolver_max_iterations", linsolver_max_iterations_);
         linsolver_smooth_steps_ = param.getDefault("linsolver_smooth_steps", linsolver_smooth_steps_);
         linsolver_prolongate_factor_ = param.getDefault("linsolver_prolongate_factor", linsolver_prolongate_factor_);
+        linsolver_mixed_precision_ = param.getDefault("linsolver_mixed_precision", linsolver_mixed_precision_);
     }
 
     LinearSolverIstl::~LinearSolverIstl()
@@ -141,6 +176,34 @@ namespace Opm
                             double* solution,
                             const boost::any& comm) const
     {
+        int maxit = linsolver_max_iterations_;
+        if (maxit == 0) {
+            maxit = 5000;
+        }
+
+        if (linsolver_mixed_precision_ && comm.empty()) {
+            // No double precision ISTL matrix: the preconditioner holds a
+            // single precision copy and residuals are formed directly
+            // from the input arrays.
+            const CsrView csr = { size, ia, ja, sa };
+            Vector b(size);
+            std::copy(rhs, rhs + size, b.begin());
+            Vector x(size);
+            x = 0.0;
+            if (linsolver_save_system_) {
+                if (linsolver_save_binary_) {
+                    writeSystemBinary(linsolver_save_filename_, size, nonzeros, ia, ja, sa, rhs);
+                } else {
+                    writeSystemMatlab(linsolver_save_filename_, buildMatrix(csr, nonzeros), b);
+                }
+            }
+            LinearSolverReport res =
+                solveMixedPrecision(csr, x, b, int(linsolver_type_), linsolver_residual_tolerance_, maxit,
+                                    linsolver_verbosity_, linsolver_prolongate_factor_, linsolver_smooth_steps_);
+            std::copy(x.begin(), x.end(), solution);
+            return res;
+        }
+
         // Build Istl structures from input.
         // System matrix
         Mat A(size, size, nonzeros, Mat::row_wise);
@@ -156,10 +219,10 @@ namespace Opm
             }
         }
 
-        int maxit = linsolver_max_iterations_;
-        if (maxit == 0) {
-            maxit = 5000;
+        if (linsolver_save_system_ && linsolver_save_binary_) {
+            writeSystemBinary(linsolver_save_filename_, size, nonzeros, ia, ja, sa, rhs);
         }
+
 #if HAVE_MPI
         if(comm.type()==typeid(ParallelISTLInformation))
         {
@@ -197,16 +260,9 @@ namespace Opm
         Vector x(opA.getmat().M());
         x = 0.0;
 
-        if (linsolver_save_system_)
+        if (linsolver_save_system_ && !linsolver_save_binary_)
         {
-            // Save system to files.
-            writeMatrixToMatlab(opA.getmat(), linsolver_save_filename_ + "-mat");
-            std::string rhsfile(linsolver_save_filename_ + "-rhs");
-            std::ofstream rhsf(rhsfile.c_str());
-            rhsf.precision(15);
-            rhsf.setf(std::ios::scientific | std::ios::showpos);
-            std::copy(b.begin(), b.end(),
-                      std::ostream_iterator<VectorBlockType>(rhsf, "\n"));
+            writeSystemMatlab(linsolver_save_filename_, opA.getmat(), b);
         }
 
         LinearSolverReport res;
@@ -520,7 +576,477 @@ namespace Opm
 
 
 
+    /// Build the preconditioner used by solver type 'type' for the
+    /// sequential operator 'opA'.  Mirrors the setup of the solve*()
+    /// functions above.  The matrix type M and vector type V may be
+    /// single or double precision.
+    template<class M, class V>
+    std::shared_ptr<Dune::Preconditioner<V,V> >
+    makeSeqPreconditioner(const int type, Dune::MatrixAdapter<M,V,V>& opA, int verbosity,
+                          double linsolver_prolongate_factor,
+                          int linsolver_smooth_steps)
+    {
+#if FIRST_DIAGONAL
+        typedef Dune::Amg::FirstDiagonal CouplingMetric;
+#else
+        typedef Dune::Amg::RowSum        CouplingMetric;
+#endif
+
+#if SMOOTHER_ILU
+        typedef Dune::SeqILU0<M,V,V>        Smoother;
+#else
+        typedef Dune::SeqSOR<M,V,V>        Smoother;
+#endif
+
+#if SYMMETRIC
+        typedef Dune::Amg::SymmetricCriterion<M,CouplingMetric>   CriterionBase;
+#else
+        typedef Dune::Amg::UnSymmetricCriterion<M,CouplingMetric> CriterionBase;
+#endif
+        typedef Dune::Amg::CoarsenCriterion<CriterionBase> Criterion;
+        typedef Dune::Amg::SequentialInformation SeqInfo;
+        typedef Dune::MatrixAdapter<M,V,V> Op;
+
+        switch (type) {
+        case 0:   // CG_ILU0
+        case 2: { // BiCGStab_ILU0
+            typedef Dune::SeqILU0<M,V,V> Precond;
+            return std::make_shared<Precond>(opA.getmat(), 1.0);
+        }
+        case 1: { // CG_AMG
+            typedef Dune::Amg::AMG<Op,V,Smoother,SeqInfo> Precond;
+            Criterion criterion;
+            typename Precond::SmootherArgs smootherArgs;
+            setUpCriterion(criterion, linsolver_prolongate_factor, verbosity,
+                           linsolver_smooth_steps);
+            return std::make_shared<Precond>(opA, criterion, smootherArgs);
+        }
+        case 3: { // FastAMG
+            typedef Dune::Amg::AggregationCriterion<Dune::Amg::SymmetricMatrixDependency<M,CouplingMetric> > FastCriterionBase;
+            typedef Dune::Amg::CoarsenCriterion<FastCriterionBase> FastCriterion;
+            typedef Dune::Amg::FastAMG<Op, V> Precond;
+            FastCriterion criterion;
+            const int smooth_steps = 1;
+            setUpCriterion(criterion, linsolver_prolongate_factor, verbosity, smooth_steps);
+            Dune::Amg::Parameters parms;
+            parms.setDebugLevel(verbosity);
+            parms.setNoPreSmoothSteps(smooth_steps);
+            parms.setNoPostSmoothSteps(smooth_steps);
+            parms.setProlongationDampingFactor(linsolver_prolongate_factor);
+            return std::make_shared<Precond>(opA, criterion, parms);
+        }
+        case 4: { // KAMG
+            typedef Dune::Amg::KAMG<Op,V,Smoother,SeqInfo> Precond;
+            Criterion criterion;
+            typename Precond::SmootherArgs smootherArgs;
+            setUpCriterion(criterion, linsolver_prolongate_factor, verbosity,
+                           linsolver_smooth_steps);
+            return std::make_shared<Precond>(opA, criterion, smootherArgs);
+        }
+        default:
+            OPM_THROW(std::runtime_error, "Unknown linsolver_type: " << type);
+        }
+    }
+
+
+
+    /// Sequential operator applying a CSR matrix owned by the caller.
+    /// Lets the mixed precision solve form double precision residuals
+    /// without a double precision copy of the matrix.
+    class CsrOperator : public Dune::LinearOperator<Vector,Vector>
+    {
+    public:
+        enum { category = Dune::SolverCategory::sequential };
+
+        explicit CsrOperator(const CsrView& A)
+            : A_(A)
+        {
+        }
+
+        virtual void apply(const Vector& x, Vector& y) const
+        {
+            for (int r = 0; r < A_.size; ++r) {
+                double yr = 0.0;
+                for (int i = A_.ia[r]; i < A_.ia[r + 1]; ++i) {
+                    yr += A_.sa[i] * x[A_.ja[i]][0];
+                }
+                y[r] = yr;
+            }
+        }
+
+        virtual void applyscaleadd(field_type alpha, const Vector& x, Vector& y) const
+        {
+            for (int r = 0; r < A_.size; ++r) {
+                double yr = 0.0;
+                for (int i = A_.ia[r]; i < A_.ia[r + 1]; ++i) {
+                    yr += A_.sa[i] * x[A_.ja[i]][0];
+                }
+                y[r] += alpha * yr;
+            }
+        }
+
+    private:
+        CsrView A_;
+    };
+
+
+
+    /// Double precision preconditioner applying a preconditioner built
+    /// on a single precision copy of the matrix.  The copy, and any AMG
+    /// hierarchy built from it, needs half the memory and bandwidth of
+    /// its double precision counterpart.
+    class MixedPrecisionPreconditioner : public Dune::Preconditioner<Vector,Vector>
+    {
+    public:
+        enum { category = Dune::SolverCategory::sequential };
+
+        MixedPrecisionPreconditioner(const CsrView& A, const int nonzeros, const int type, int verbosity,
+                                     double linsolver_prolongate_factor,
+                                     int linsolver_smooth_steps)
+            : A_(A.size, A.size, nonzeros, MatF::row_wise),
+              v_(A.size),
+              d_(A.size)
+        {
+            for (MatF::CreateIterator row = A_.createbegin(); row != A_.createend(); ++row) {
+                const int ri = row.index();
+                for (int i = A.ia[ri]; i < A.ia[ri + 1]; ++i) {
+                    row.insert(A.ja[i]);
+                }
+            }
+            for (int ri = 0; ri < A.size; ++ri) {
+                for (int i = A.ia[ri]; i < A.ia[ri + 1]; ++i) {
+                    A_[ri][A.ja[i]] = static_cast<float>(A.sa[i]);
+                }
+            }
+            opA_.reset(new OperatorF(A_));
+            precond_ = makeSeqPreconditioner(type, *opA_, verbosity,
+                                             linsolver_prolongate_factor,
+                                             linsolver_smooth_steps);
+        }
+
+        virtual void pre(Vector& x, Vector& b)
+        {
+            toSingle(x, v_);
+            toSingle(b, d_);
+            precond_->pre(v_, d_);
+        }
+
+        virtual void apply(Vector& v, const Vector& d)
+        {
+            toSingle(d, d_);
+            v_ = 0.0f;
+            precond_->apply(v_, d_);
+            for (std::size_t i = 0; i < v.size(); ++i) {
+                v[i] = v_[i][0];
+            }
+        }
+
+        virtual void post(Vector& /* x */)
+        {
+            precond_->post(v_);
+        }
+
+    private:
+        static void toSingle(const Vector& x, VectorF& xf)
+        {
+            for (std::size_t i = 0; i < x.size(); ++i) {
+                xf[i] = static_cast<float>(x[i][0]);
+            }
+        }
+
+        // The preconditioner refers to the operator, which refers to the
+        // matrix; members are destroyed in reverse order.
+        MatF A_;
+        std::unique_ptr<OperatorF> opA_;
+        std::shared_ptr<Dune::Preconditioner<VectorF,VectorF> > precond_;
+        VectorF v_;
+        VectorF d_;
+    };
+
+
+
+    /// Solve with a single precision preconditioner inside a double
+    /// precision Krylov iteration.  The outer iteration computes
+    /// residuals in double precision from the caller's CSR arrays, so
+    /// the attained accuracy is governed by 'tolerance' as usual, while
+    /// the only matrix copy made is the single precision one.  Flexible
+    /// CG replaces CG, since the rounded preconditioner is not exactly
+    /// symmetric.
+    LinearSolverInterface::LinearSolverReport
+    solveMixedPrecision(const CsrView& A, Vector& x, Vector& b, int type, double tolerance, int maxit, int verbosity,
+                        double linsolver_prolongate_factor, int linsolver_smooth_steps)
+    {
+        CsrOperator opA(A);
+        MixedPrecisionPreconditioner precond(A, A.ia[A.size], type, verbosity,
+                                             linsolver_prolongate_factor,
+                                             linsolver_smooth_steps);
+
+        Dune::InverseOperatorResult result;
+        if (type == 2) { // BiCGStab_ILU0
+            Dune::SeqScalarProduct<Vector> sp;
+            Dune::BiCGSTABSolver<Vector> linsolve(opA, sp, precond, tolerance, maxit, verbosity);
+            linsolve.apply(x, b, result);
+        } else {
+            Dune::GeneralizedPCGSolver<Vector> linsolve(opA, precond, tolerance, maxit, verbosity);
+            linsolve.apply(x, b, result);
+        }
+
+        LinearSolverInterface::LinearSolverReport res;
+        res.converged = result.converged;
+        res.iterations = result.iterations;
+        res.residual_reduction = result.reduction;
+        return res;
+    }
+
+
+
+    /// Copy a CSR matrix into an ISTL matrix.
+    Mat buildMatrix(const CsrView& A, const int nonzeros)
+    {
+        Mat M(A.size, A.size, nonzeros, Mat::row_wise);
+        for (Mat::CreateIterator row = M.createbegin(); row != M.createend(); ++row) {
+            const int ri = row.index();
+            for (int i = A.ia[ri]; i < A.ia[ri + 1]; ++i) {
+                row.insert(A.ja[i]);
+            }
+        }
+        for (int ri = 0; ri < A.size; ++ri) {
+            for (int i = A.ia[ri]; i < A.ia[ri + 1]; ++i) {
+                M[ri][A.ja[i]] = A.sa[i];
+            }
+        }
+        return M;
+    }
+
+
+
+    /// Save a system in the binary format of linsys_binary.h to
+    /// 'filename'.linsys, straight from the input arrays.
+    void writeSystemBinary(const std::string& filename, const int size, const int nonzeros,
+                           const int* ia, const int* ja, const double* sa, const double* rhs)
+    {
+        CSRMatrix csr;
+        csr.m   = size;
+        csr.nnz = nonzeros;
+        csr.ia  = const_cast<int*>(ia);
+        csr.ja  = const_cast<int*>(ja);
+        csr.sa  = const_cast<double*>(sa);
+        const std::string sysfile(filename + ".linsys");
+        if (linsys_binary_write(&csr, size, rhs, 1, sysfile.c_str()) != 0) {
+            OPM_THROW(std::runtime_error, "Failed to write linear system to " << sysfile);
+        }
+    }
+
+
+
+    /// Save a system as Matlab readable text files 'filename'-mat and
+    /// 'filename'-rhs.
+    void writeSystemMatlab(const std::string& filename, const Mat& A, const Vector& b)
+    {
+        writeMatrixToMatlab(A, filename + "-mat");
+        std::string rhsfile(filename + "-rhs");
+        std::ofstream rhsf(rhsfile.c_str());
+        rhsf.precision(15);
+        rhsf.setf(std::ios::scientific | std::ios::showpos);
+        std::copy(b.begin(), b.end(),
+                  std::ostream_iterator<VectorBlockType>(rhsf, "\n"));
+    }
+
+
+
+    /// Run the Krylov method of solver type 'krylov' (0 and 1: CG, 2:
+    /// BiCGStab, otherwise flexible CG) on a sequential operator.
+    template<class O>
+    Dune::InverseOperatorResult
+    solveKrylov(O& opA, Dune::Preconditioner<Vector,Vector>& precond, const int krylov,
+                Vector& x, Vector& b, double tolerance, int maxit, int verbosity)
+    {
+        Dune::InverseOperatorResult result;
+        switch (krylov) {
+        case 0:
+        case 1: {
+            Dune::SeqScalarProduct<Vector> sp;
+            Dune::CGSolver<Vector> linsolve(opA, sp, precond, tolerance, maxit, verbosity);
+            linsolve.apply(x, b, result);
+            break;
+        }
+        case 2: {
+            Dune::SeqScalarProduct<Vector> sp;
+            Dune::BiCGSTABSolver<Vector> linsolve(opA, sp, precond, tolerance, maxit, verbosity);
+            linsolve.apply(x, b, result);
+            break;
+        }
+        default: {
+            Dune::GeneralizedPCGSolver<Vector> linsolve(opA, precond, tolerance, maxit, verbosity);
+            linsolve.apply(x, b, result);
+            break;
+        }
+        }
+        return result;
+    }
+
+
+
+    /// Session keeping the matrix and preconditioner alive between
+    /// sequential solves.  Parallel solves, and the saving of systems,
+    /// go through the same code as LinearSolverIstl::solve().
+    class IstlSession : public LinearSolverInterface::Session
+    {
+    public:
+        IstlSession(const LinearSolverInterface::SessionPolicy& policy,
+                    const LinearSolverInterface& solver,
+                    const int type, const bool mixed_precision,
+                    const int maxit, const int verbosity,
+                    const double prolongate_factor, const int smooth_steps,
+                    const bool save_system, const bool save_binary,
+                    const std::string& save_filename)
+            : LinearSolverInterface::Session(policy),
+              solver_(solver),
+              type_(type),
+              mixed_precision_(mixed_precision),
+              maxit_(maxit),
+              verbosity_(verbosity),
+              prolongate_factor_(prolongate_factor),
+              smooth_steps_(smooth_steps),
+              save_system_(save_system),
+              save_binary_(save_binary),
+              save_filename_(save_filename)
+        {
+        }
+
+    protected:
+        virtual LinearSolverInterface::LinearSolverReport
+        solveWithSetup(SetupAction action,
+                       const int size,
+                       const int nonzeros,
+                       const int* ia,
+                       const int* ja,
+                       const double* sa,
+                       const double* rhs,
+                       double* solution,
+                       const boost::any& comm)
+        {
+            if (! comm.empty()) {
+                // Full setup with the communicator; drop the cached one.
+                precond_.reset();
+                opA_.reset();
+                A_.reset();
+                return solver_.solve(size, nonzeros, ia, ja, sa, rhs, solution, comm);
+            }
+
+            if (save_system_ && save_binary_) {
+                writeSystemBinary(save_filename_, size, nonzeros, ia, ja, sa, rhs);
+            }
+
+            Vector b(size);
+            std::copy(rhs, rhs + size, b.begin());
+            Vector x(size);
+            x = 0.0;
+
+            const double tolerance = solver_.getTolerance();
+            Dune::InverseOperatorResult result;
+
+            if (mixed_precision_) {
+                // Only the single precision copy inside the preconditioner
+                // is kept.  Residuals use the caller's arrays directly.
+                const CsrView csr = { size, ia, ja, sa };
+                if (save_system_ && !save_binary_) {
+                    writeSystemMatlab(save_filename_, buildMatrix(csr, nonzeros), b);
+                }
+                if (action != ReuseSetup || !precond_) {
+                    precond_.reset(); // Release old hierarchy before building new.
+                    precond_ = std::make_shared<MixedPrecisionPreconditioner>(csr, nonzeros, type_, verbosity_,
+                                                                              prolongate_factor_, smooth_steps_);
+                }
+                // Flexible CG copes with the rounding in a single
+                // precision preconditioner; see solveMixedPrecision().
+                CsrOperator opA(csr);
+                result = solveKrylov(opA, *precond_, (type_ < 2) ? 3 : type_,
+                                     x, b, tolerance, maxit_, verbosity_);
+            } else {
+                if (action == PatternSetup || !A_) {
+                    // The preconditioner refers to the operator, which
+                    // refers to the matrix.  Release them in that order.
+                    precond_.reset();
+                    opA_.reset();
+                    A_.reset(new Mat(size, size, nonzeros, Mat::row_wise));
+                    for (Mat::CreateIterator row = A_->createbegin(); row != A_->createend(); ++row) {
+                        int ri = row.index();
+                        for (int i = ia[ri]; i < ia[ri + 1]; ++i) {
+                            row.insert(ja[i]);
+                        }
+                    }
+                    opA_.reset(new Operator(*A_));
+                }
+
+                // Same pattern: update values in place.  A reused AMG
+                // hierarchy keeps its coarse levels but smooths with the
+                // new fine-level matrix.
+                for (int ri = 0; ri < size; ++ri) {
+                    for (int i = ia[ri]; i < ia[ri + 1]; ++i) {
+                        (*A_)[ri][ja[i]] = sa[i];
+                    }
+                }
+
+                if (save_system_ && !save_binary_) {
+                    writeSystemMatlab(save_filename_, *A_, b);
+                }
+
+                if (action != ReuseSetup || !precond_) {
+                    precond_.reset(); // Release old hierarchy before building new.
+                    precond_ = makeSeqPreconditioner(type_, *opA_, verbosity_,
+                                                     prolongate_factor_, smooth_steps_);
+                }
+
+                result = solveKrylov(*opA_, *precond_, type_,
+                                     x, b, tolerance, maxit_, verbosity_);
+            }
+
+            std::copy(x.begin(), x.end(), solution);
+
+            LinearSolverInterface::LinearSolverReport res;
+            res.converged = result.converged;
+            res.iterations = result.iterations;
+            res.residual_reduction = result.reduction;
+            return res;
+        }
+
+    private:
+        const LinearSolverInterface& solver_;
+        const int type_;
+        const bool mixed_precision_;
+        const int maxit_;
+        const int verbosity_;
+        const double prolongate_factor_;
+        const int smooth_steps_;
+        const bool save_system_;
+        const bool save_binary_;
+        const std::string save_filename_;
+
+        std::unique_ptr<Mat> A_;
+        std::unique_ptr<Operator> opA_;
+        std::shared_ptr<Dune::Preconditioner<Vector,Vector> > precond_;
+    };
+
+
+
     } // anonymous namespace
 
 
+
+    std::shared_ptr<LinearSolverInterface::Session>
+    LinearSolverIstl::makeSession(const SessionPolicy& policy) const
+    {
+        const int maxit = (linsolver_max_iterations_ == 0) ? 5000 : linsolver_max_iterations_;
+        return std::make_shared<IstlSession>(policy, *this, int(linsolver_type_),
+                                             linsolver_mixed_precision_, maxit,
+                                             linsolver_verbosity_,
+                                             linsolver_prolongate_factor_,
+                                             linsolver_smooth_steps_,
+                                             linsolver_save_system_,
+                                             linsolver_save_binary_,
+                                             linsolver_save_filename_);
+    }
+
+
 } // namespace Opm
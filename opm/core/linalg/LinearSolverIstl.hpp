@@ -42,11 +42,24 @@ namespace Opm
         ///                                 FastAMG=3, KAMG=4 };
         ///   linsolver_save_system         false
         ///   linsolver_save_filename       <empty string>
+        ///   linsolver_save_binary         false
         ///   linsolver_max_iterations      0 (unlimited=5000)
         ///   linsolver_residual_tolerance  1e-8
         ///   linsolver_smooth_steps        2
         ///   linsolver_prolongate_factor   1.6
         ///   linsolver_verbosity           0
+        ///   linsolver_mixed_precision     false
+        /// With linsolver_save_binary, a saved system is written to
+        /// <linsolver_save_filename>.linsys in the binary format of
+        /// linsys_binary_write() instead of as MATLAB text files.
+        /// With linsolver_mixed_precision, sequential solves build the
+        /// preconditioner (ILU0 or AMG hierarchy) from a single precision
+        /// copy of the matrix and apply it inside the usual double
+        /// precision Krylov iteration, which still reduces the residual
+        /// by linsolver_residual_tolerance.  No double precision ISTL
+        /// matrix is built in this mode; the outer residuals are formed
+        /// from the input CSR arrays.  CG is replaced by flexible CG in
+        /// this mode.  Parallel solves ignore the setting.
         LinearSolverIstl();
 
         /// Construct from parameters
@@ -85,6 +98,16 @@ namespace Opm
         /// \param[out] tolerance value
         virtual double getTolerance() const;
 
+        /// Create a session that keeps the system matrix and the
+        /// preconditioner (ILU0 factors or AMG hierarchy) between solves.
+        /// The preconditioner is rebuilt when the policy asks for a
+        /// refresh; otherwise only the matrix values are updated and the
+        /// Krylov solver runs to the usual tolerance with the previous
+        /// preconditioner.  Sessions honour linsolver_save_system like
+        /// solve(); parallel solves are passed on to solve() uncached.
+        virtual std::shared_ptr<Session>
+        makeSession(const SessionPolicy& policy = SessionPolicy()) const;
+
     private:
         /// \brief Solve the linear system using ISTL
         /// \param[in] opA The linear operator of the system to solve.
@@ -103,11 +126,14 @@ namespace Opm
         LinsolverType linsolver_type_;
         bool linsolver_save_system_;
         std::string linsolver_save_filename_;
+        bool linsolver_save_binary_;
         int linsolver_max_iterations_;
         /** \brief The number smoothing steps to apply in AMG. */
         int linsolver_smooth_steps_;
         /** \brief The factor to scale the coarse grid correction with. */
         double linsolver_prolongate_factor_;
+        /** \brief Whether to build the preconditioner in single precision. */
+        bool linsolver_mixed_precision_;
 
     };
 
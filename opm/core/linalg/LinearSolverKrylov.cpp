@@ -0,0 +1,572 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <opm/core/linalg/LinearSolverKrylov.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+namespace Opm
+{
+
+    namespace
+    {
+        int maxThreads()
+        {
+#ifdef _OPENMP
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
+        // Read-only view of a CSR matrix.
+        struct CSRView
+        {
+            int           n;
+            const int*    ia;
+            const int*    ja;
+            const double* sa;
+        };
+
+        // y = A*x
+        void spmv(const CSRView& A, const double* x, double* y, const int nt)
+        {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(nt) if(nt > 1)
+#endif
+            for (int i = 0; i < A.n; ++i) {
+                double yi = 0.0;
+                for (int k = A.ia[i]; k < A.ia[i + 1]; ++k) {
+                    yi += A.sa[k] * x[A.ja[k]];
+                }
+                y[i] = yi;
+            }
+        }
+
+        // r = b - A*x
+        void residual(const CSRView& A, const double* x, const double* b, double* r,
+                      const int nt)
+        {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(nt) if(nt > 1)
+#endif
+            for (int i = 0; i < A.n; ++i) {
+                double ri = b[i];
+                for (int k = A.ia[i]; k < A.ia[i + 1]; ++k) {
+                    ri -= A.sa[k] * x[A.ja[k]];
+                }
+                r[i] = ri;
+            }
+        }
+
+        double dot(const int n, const double* x, const double* y, const int nt)
+        {
+            double s = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(+:s) num_threads(nt) if(nt > 1)
+#endif
+            for (int i = 0; i < n; ++i) {
+                s += x[i] * y[i];
+            }
+            return s;
+        }
+
+        double norm2(const int n, const double* x, const int nt)
+        {
+            return std::sqrt(dot(n, x, x, nt));
+        }
+
+        // y += a*x
+        void axpy(const int n, const double a, const double* x, double* y, const int nt)
+        {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(nt) if(nt > 1)
+#endif
+            for (int i = 0; i < n; ++i) {
+                y[i] += a * x[i];
+            }
+        }
+
+
+
+
+        /// Preconditioner interface: z = M^{-1} r.
+        class PreconditionerBase
+        {
+        public:
+            virtual ~PreconditionerBase() {}
+            virtual void apply(const double* r, double* z) const = 0;
+        };
+
+
+        class IdentityPreconditioner : public PreconditionerBase
+        {
+        public:
+            explicit IdentityPreconditioner(const int n) : n_(n) {}
+
+            virtual void apply(const double* r, double* z) const
+            {
+                std::copy(r, r + n_, z);
+            }
+
+        private:
+            int n_;
+        };
+
+
+        class JacobiPreconditioner : public PreconditionerBase
+        {
+        public:
+            JacobiPreconditioner(const CSRView& A, const int nt)
+                : inv_diag_(A.n, 0.0),
+                  nt_(nt)
+            {
+                int singular = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(+:singular) num_threads(nt) if(nt > 1)
+#endif
+                for (int i = 0; i < A.n; ++i) {
+                    double d = 0.0;
+                    for (int k = A.ia[i]; k < A.ia[i + 1]; ++k) {
+                        if (A.ja[k] == i) {
+                            d += A.sa[k];
+                        }
+                    }
+                    if (d == 0.0) {
+                        ++singular;
+                    } else {
+                        inv_diag_[i] = 1.0 / d;
+                    }
+                }
+                if (singular > 0) {
+                    OPM_THROW(std::runtime_error, "Jacobi preconditioner: "
+                              << singular << " zero diagonal element(s).");
+                }
+            }
+
+            virtual void apply(const double* r, double* z) const
+            {
+                const int n = inv_diag_.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(nt_) if(nt_ > 1)
+#endif
+                for (int i = 0; i < n; ++i) {
+                    z[i] = inv_diag_[i] * r[i];
+                }
+            }
+
+        private:
+            std::vector<double> inv_diag_;
+            int nt_;
+        };
+
+
+        /// Block Jacobi preconditioner with an ILU(0) factorisation of
+        /// each diagonal block.  The rows are split into one contiguous
+        /// block per thread, so both setup and application run in
+        /// parallel.  Couplings between blocks are ignored.  A single
+        /// block is a plain serial ILU(0).
+        class BlockILU0Preconditioner : public PreconditionerBase
+        {
+        public:
+            BlockILU0Preconditioner(const CSRView& A, const int nblocks)
+                : nt_(nblocks),
+                  start_(nblocks + 1),
+                  ia_(A.n + 1, 0),
+                  diag_(A.n, -1)
+            {
+                for (int b = 0; b <= nblocks; ++b) {
+                    start_[b] = int((static_cast<long long>(A.n) * b) / nblocks);
+                }
+
+                // Count entries inside the diagonal block of each row.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(nt_) if(nt_ > 1)
+#endif
+                for (int b = 0; b < nblocks; ++b) {
+                    for (int i = start_[b]; i < start_[b + 1]; ++i) {
+                        int cnt = 0;
+                        for (int k = A.ia[i]; k < A.ia[i + 1]; ++k) {
+                            cnt += (start_[b] <= A.ja[k]) && (A.ja[k] < start_[b + 1]);
+                        }
+                        ia_[i + 1] = cnt;
+                    }
+                }
+                for (int i = 0; i < A.n; ++i) {
+                    ia_[i + 1] += ia_[i];
+                }
+                ja_.resize(ia_[A.n]);
+                lu_.resize(ia_[A.n]);
+
+                int singular = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) reduction(+:singular) num_threads(nt_) if(nt_ > 1)
+#endif
+                for (int b = 0; b < nblocks; ++b) {
+                    singular += extractAndFactor(A, start_[b], start_[b + 1]);
+                }
+                if (singular > 0) {
+                    OPM_THROW(std::runtime_error, "ILU0 preconditioner: "
+                              << singular << " zero or missing pivot(s).");
+                }
+            }
+
+            virtual void apply(const double* r, double* z) const
+            {
+                const int nblocks = start_.size() - 1;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(nt_) if(nt_ > 1)
+#endif
+                for (int b = 0; b < nblocks; ++b) {
+                    const int lo = start_[b];
+                    const int hi = start_[b + 1];
+
+                    // Forward substitution, unit lower triangular factor.
+                    for (int i = lo; i < hi; ++i) {
+                        double zi = r[i];
+                        for (int k = ia_[i]; k < diag_[i]; ++k) {
+                            zi -= lu_[k] * z[ja_[k]];
+                        }
+                        z[i] = zi;
+                    }
+
+                    // Backward substitution, upper triangular factor.
+                    for (int i = hi - 1; i >= lo; --i) {
+                        double zi = z[i];
+                        for (int k = diag_[i] + 1; k < ia_[i + 1]; ++k) {
+                            zi -= lu_[k] * z[ja_[k]];
+                        }
+                        z[i] = zi / lu_[diag_[i]];
+                    }
+                }
+            }
+
+        private:
+            // Copy rows [lo,hi) restricted to the diagonal block, sorted
+            // by column, and factor in place (IKJ variant of ILU(0)).
+            // Returns the number of zero or missing pivots.
+            int extractAndFactor(const CSRView& A, const int lo, const int hi)
+            {
+                std::vector<std::pair<int, double> > row;
+                for (int i = lo; i < hi; ++i) {
+                    row.clear();
+                    for (int k = A.ia[i]; k < A.ia[i + 1]; ++k) {
+                        if ((lo <= A.ja[k]) && (A.ja[k] < hi)) {
+                            row.push_back(std::make_pair(A.ja[k], A.sa[k]));
+                        }
+                    }
+                    std::sort(row.begin(), row.end());
+
+                    for (int p = 0; p < int(row.size()); ++p) {
+                        ja_[ia_[i] + p] = row[p].first;
+                        lu_[ia_[i] + p] = row[p].second;
+                        if (row[p].first == i) {
+                            diag_[i] = ia_[i] + p;
+                        }
+                    }
+                }
+
+                // The elimination below uses the diagonal of every
+                // earlier row, so do not start it if any is missing.
+                int singular = 0;
+                for (int i = lo; i < hi; ++i) {
+                    singular += (diag_[i] < 0);
+                }
+                if (singular > 0) {
+                    return singular;
+                }
+
+                std::vector<int> pos(hi - lo, -1);
+                for (int i = lo; i < hi; ++i) {
+                    for (int k = ia_[i]; k < ia_[i + 1]; ++k) {
+                        pos[ja_[k] - lo] = k;
+                    }
+
+                    for (int k = ia_[i]; k < diag_[i]; ++k) {
+                        const int j = ja_[k];
+                        lu_[k] /= lu_[diag_[j]];
+
+                        for (int q = diag_[j] + 1; q < ia_[j + 1]; ++q) {
+                            const int p = pos[ja_[q] - lo];
+                            if (p >= 0) {
+                                lu_[p] -= lu_[k] * lu_[q];
+                            }
+                        }
+                    }
+
+                    for (int k = ia_[i]; k < ia_[i + 1]; ++k) {
+                        pos[ja_[k] - lo] = -1;
+                    }
+
+                    if (lu_[diag_[i]] == 0.0) {
+                        ++singular;
+                    }
+                }
+
+                return singular;
+            }
+
+            int                 nt_;
+            std::vector<int>    start_;
+            std::vector<int>    ia_;
+            std::vector<int>    ja_;
+            std::vector<int>    diag_;
+            std::vector<double> lu_;
+        };
+    } // anonymous namespace
+
+
+
+
+    LinearSolverKrylov::LinearSolverKrylov()
+        : linsolver_residual_tolerance_(1e-8),
+          linsolver_max_iterations_(0),
+          linsolver_verbosity_(0),
+          linsolver_krylov_(BiCGStab),
+          linsolver_preconditioner_(ILU0),
+          linsolver_threads_(0)
+    {
+    }
+
+
+
+
+    LinearSolverKrylov::LinearSolverKrylov(const ParameterGroup& param)
+        : linsolver_residual_tolerance_(1e-8),
+          linsolver_max_iterations_(0),
+          linsolver_verbosity_(0),
+          linsolver_krylov_(BiCGStab),
+          linsolver_preconditioner_(ILU0),
+          linsolver_threads_(0)
+    {
+        linsolver_residual_tolerance_ = param.getDefault("linsolver_residual_tolerance", linsolver_residual_tolerance_);
+        linsolver_max_iterations_ = param.getDefault("linsolver_max_iterations", linsolver_max_iterations_);
+        linsolver_verbosity_ = param.getDefault("linsolver_verbosity", linsolver_verbosity_);
+        linsolver_krylov_ = KrylovMethod(param.getDefault("linsolver_krylov", int(linsolver_krylov_)));
+        linsolver_preconditioner_ = Preconditioner(param.getDefault("linsolver_preconditioner", int(linsolver_preconditioner_)));
+        linsolver_threads_ = param.getDefault("linsolver_threads", linsolver_threads_);
+    }
+
+
+
+
+    LinearSolverKrylov::~LinearSolverKrylov()
+    {}
+
+
+
+
+    LinearSolverInterface::LinearSolverReport
+    LinearSolverKrylov::solve(const int size,
+                              const int nonzeros,
+                              const int* ia,
+                              const int* ja,
+                              const double* sa,
+                              const double* rhs,
+                              double* solution,
+                              const boost::any&) const
+    {
+        (void) nonzeros;
+
+        const CSRView A = { size, ia, ja, sa };
+        const int maxit = linsolver_max_iterations_ == 0 ? 5000 : linsolver_max_iterations_;
+        const double tol = linsolver_residual_tolerance_;
+        const int nt = std::max(1, std::min(linsolver_threads_ > 0 ? linsolver_threads_ : maxThreads(), size));
+
+        std::unique_ptr<PreconditionerBase> prec;
+        switch (linsolver_preconditioner_) {
+        case NoPreconditioner:
+            prec.reset(new IdentityPreconditioner(size));
+            break;
+        case Jacobi:
+            prec.reset(new JacobiPreconditioner(A, nt));
+            break;
+        case ILU0:
+            prec.reset(new BlockILU0Preconditioner(A, nt));
+            break;
+        default:
+            OPM_THROW(std::runtime_error, "Unknown preconditioner " << int(linsolver_preconditioner_));
+        }
+
+        // Callers are not required to initialise 'solution' (IncompTpfa
+        // passes uninitialised storage), so start from zero like the ISTL
+        // solvers.  Convergence is then measured relative to ||b||.
+        std::fill(solution, solution + size, 0.0);
+
+        std::vector<double> r(size);
+        residual(A, solution, rhs, &r[0], nt);
+        const double norm0 = norm2(size, &r[0], nt);
+        const double ref = std::max(norm2(size, rhs, nt), norm0);
+        double norm = norm0;
+
+        LinearSolverReport res;
+        res.iterations = 0;
+        res.residual_reduction = 1.0;
+        res.converged = (norm0 == 0.0);
+
+        if (! res.converged) {
+            if (linsolver_krylov_ == CG) {
+                std::vector<double> z(size), p(size), q(size);
+                prec->apply(&r[0], &z[0]);
+                p = z;
+                double rz = dot(size, &r[0], &z[0], nt);
+
+                while ((res.iterations < maxit) && (norm > tol * ref)) {
+                    spmv(A, &p[0], &q[0], nt);
+                    const double alpha = rz / dot(size, &p[0], &q[0], nt);
+                    axpy(size,  alpha, &p[0], solution, nt);
+                    axpy(size, -alpha, &q[0], &r[0], nt);
+                    ++res.iterations;
+
+                    norm = norm2(size, &r[0], nt);
+
+                    prec->apply(&r[0], &z[0]);
+                    const double rz_new = dot(size, &r[0], &z[0], nt);
+                    const double beta = rz_new / rz;
+                    rz = rz_new;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(nt) if(nt > 1)
+#endif
+                    for (int i = 0; i < size; ++i) {
+                        p[i] = z[i] + beta * p[i];
+                    }
+                }
+            } else if (linsolver_krylov_ == BiCGStab) {
+                std::vector<double> rhat(r), p(size, 0.0), v(size, 0.0);
+                std::vector<double> phat(size), s(size), shat(size), t(size);
+                double rho = 1.0, alpha = 1.0, omega = 1.0;
+                const double eps = std::numeric_limits<double>::epsilon();
+                bool restarted = true;
+
+                while ((res.iterations < maxit) && (norm > tol * ref)) {
+                    // On breakdown, i.e. when rhat is (numerically)
+                    // orthogonal to r or to A*p, restart with rhat set
+                    // to the current residual unless that is what we
+                    // just did.
+                    const double rho_new = dot(size, &rhat[0], &r[0], nt);
+                    bool breakdown = std::fabs(rho_new) <= eps * norm2(size, &rhat[0], nt) * norm;
+                    double rhat_v = 0.0;
+                    if (! breakdown) {
+                        const double beta = (rho_new / rho) * (alpha / omega);
+                        rho = rho_new;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(nt) if(nt > 1)
+#endif
+                        for (int i = 0; i < size; ++i) {
+                            p[i] = r[i] + beta * (p[i] - omega * v[i]);
+                        }
+
+                        prec->apply(&p[0], &phat[0]);
+                        spmv(A, &phat[0], &v[0], nt);
+                        rhat_v = dot(size, &rhat[0], &v[0], nt);
+                        breakdown = std::fabs(rhat_v) <= eps * norm2(size, &rhat[0], nt) * norm2(size, &v[0], nt);
+                    }
+                    if (breakdown) {
+                        if (restarted) {
+                            break;
+                        }
+                        rhat = r;
+                        std::fill(p.begin(), p.end(), 0.0);
+                        std::fill(v.begin(), v.end(), 0.0);
+                        rho = alpha = omega = 1.0;
+                        restarted = true;
+                        continue;
+                    }
+                    restarted = false;
+                    alpha = rho / rhat_v;
+
+                    s = r;
+                    axpy(size, -alpha, &v[0], &s[0], nt);
+                    axpy(size,  alpha, &phat[0], solution, nt);
+                    ++res.iterations;
+
+                    norm = norm2(size, &s[0], nt);
+                    if (norm <= tol * ref) {
+                        r.swap(s);
+                        break;
+                    }
+
+                    prec->apply(&s[0], &shat[0]);
+                    spmv(A, &shat[0], &t[0], nt);
+                    const double tt = dot(size, &t[0], &t[0], nt);
+                    omega = (tt > 0.0) ? dot(size, &t[0], &s[0], nt) / tt : 0.0;
+
+                    axpy(size, omega, &shat[0], solution, nt);
+                    r.swap(s);
+                    axpy(size, -omega, &t[0], &r[0], nt);
+
+                    norm = norm2(size, &r[0], nt);
+                    if (omega == 0.0) {
+                        break;  // Breakdown.
+                    }
+                }
+            } else {
+                OPM_THROW(std::runtime_error, "Unknown Krylov method " << int(linsolver_krylov_));
+            }
+
+            res.residual_reduction = norm / norm0;
+            res.converged = (norm <= tol * ref);
+        }
+
+        if (linsolver_verbosity_ > 0) {
+            std::cout << "LinearSolverKrylov: " << res.iterations << " iterations, "
+                      << "residual reduction " << res.residual_reduction
+                      << (res.converged ? "" : " (not converged)") << std::endl;
+        }
+
+        return res;
+    }
+
+
+
+
+    void LinearSolverKrylov::setTolerance(const double tol)
+    {
+        linsolver_residual_tolerance_ = tol;
+    }
+
+
+
+
+    double LinearSolverKrylov::getTolerance() const
+    {
+        return linsolver_residual_tolerance_;
+    }
+
+
+
+} // namespace Opm
+
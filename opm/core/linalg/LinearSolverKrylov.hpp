@@ -0,0 +1,112 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_LINEARSOLVERKRYLOV_HEADER_INCLUDED
+#define OPM_LINEARSOLVERKRYLOV_HEADER_INCLUDED
+
+
+#include <opm/core/linalg/LinearSolverInterface.hpp>
+#include <boost/any.hpp>
+
+namespace Opm
+{
+
+    class ParameterGroup;
+
+    /// Concrete class encapsulating preconditioned Krylov solvers
+    /// implemented directly on CSR matrices, without any external
+    /// dependencies.  Matrix-vector products, vector operations and
+    /// preconditioner applications use OpenMP threads when available.
+    class LinearSolverKrylov : public LinearSolverInterface
+    {
+    public:
+        enum KrylovMethod   { CG = 0, BiCGStab = 1 };
+        enum Preconditioner { NoPreconditioner = 0, Jacobi = 1, ILU0 = 2 };
+
+        /// Default constructor.
+        /// All parameters controlling the solver are defaulted:
+        ///   linsolver_residual_tolerance  1e-8
+        ///   linsolver_max_iterations      0 (unlimited=5000)
+        ///   linsolver_verbosity           0
+        ///   linsolver_krylov              1 ( = BiCGStab), alternatives are:
+        ///                                 CG = 0, BiCGStab = 1
+        ///   linsolver_preconditioner      2 ( = ILU0), alternatives are:
+        ///                                 NoPreconditioner = 0, Jacobi = 1,
+        ///                                 ILU0 = 2
+        ///   linsolver_threads             0 (all OpenMP threads), 1 gives a serial
+        ///                                 solver that may be called from threads
+        ///                                 of an enclosing parallel region
+        /// The ILU0 preconditioner is block Jacobi with one incomplete
+        /// factorisation per thread, so that it can be applied in
+        /// parallel.  Its strength, and hence the iteration count, may
+        /// therefore vary slightly with the number of threads.  CG
+        /// requires a symmetric positive definite matrix.
+        LinearSolverKrylov();
+
+        /// Construct from parameters
+        /// Accepted parameters are, with defaults, listed in the
+        /// default constructor.
+        LinearSolverKrylov(const ParameterGroup& param);
+
+        /// Destructor.
+        virtual ~LinearSolverKrylov();
+
+        using LinearSolverInterface::solve;
+
+        /// Solve a linear system, with a matrix given in compressed sparse row format.
+        /// \param[in] size        # of rows in matrix
+        /// \param[in] nonzeros    # of nonzeros elements in matrix
+        /// \param[in] ia          array of length (size + 1) containing start and end indices for each row
+        /// \param[in] ja          array of length nonzeros containing column numbers for the nonzero elements
+        /// \param[in] sa          array of length nonzeros containing the values of the nonzero elements
+        /// \param[in] rhs         array of length size containing the right hand side
+        /// \param[out] solution  array of length size to which the solution will be written.
+        ///                        Its input values are ignored; the iteration starts from zero.
+        virtual LinearSolverReport solve(const int size,
+                                         const int nonzeros,
+                                         const int* ia,
+                                         const int* ja,
+                                         const double* sa,
+                                         const double* rhs,
+                                         double* solution,
+                                         const boost::any& add=boost::any()) const;
+
+        /// Set tolerance for the relative residual reduction.
+        /// \param[in] tol         tolerance value
+        virtual void setTolerance(const double tol);
+
+        /// Get tolerance for the relative residual reduction.
+        /// \param[out] tolerance value
+        virtual double getTolerance() const;
+
+    private:
+        double linsolver_residual_tolerance_;
+        int linsolver_max_iterations_;
+        int linsolver_verbosity_;
+        KrylovMethod linsolver_krylov_;
+        Preconditioner linsolver_preconditioner_;
+        int linsolver_threads_;
+    };
+
+
+} // namespace Opm
+
+
+
+#endif // OPM_LINEARSOLVERKRYLOV_HEADER_INCLUDED
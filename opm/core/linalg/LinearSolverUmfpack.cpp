@@ -22,6 +22,8 @@
 #include <opm/core/linalg/sparse_sys.h>
 #include <opm/core/linalg/call_umfpack.h>
 
+#include <new>
+
 namespace Opm
 {
 
@@ -72,5 +74,89 @@ namespace Opm
     }
 
 
+
+    namespace
+    {
+        /// Session retaining the UMFPACK symbolic and numeric factors.
+        class UmfpackSession : public LinearSolverInterface::Session
+        {
+        public:
+            explicit UmfpackSession(const LinearSolverInterface::SessionPolicy& policy)
+                : LinearSolverInterface::Session(policy),
+                  umf_(call_UMFPACK_session_new())
+            {
+                if (umf_ == 0) {
+                    throw std::bad_alloc();
+                }
+            }
+
+            virtual ~UmfpackSession()
+            {
+                call_UMFPACK_session_delete(umf_);
+            }
+
+        protected:
+            virtual LinearSolverInterface::LinearSolverReport
+            solveWithSetup(SetupAction action,
+                           const int size,
+                           const int nonzeros,
+                           const int* ia,
+                           const int* ja,
+                           const double* sa,
+                           const double* rhs,
+                           double* solution,
+                           const boost::any& /* comm */)
+            {
+                CSRMatrix A  = {
+                    (size_t)size,
+                    (size_t)nonzeros,
+                    const_cast<int*>(ia),
+                    const_cast<int*>(ja),
+                    const_cast<double*>(sa)
+                };
+
+                LinearSolverInterface::LinearSolverReport rep = {};
+
+                bool ok = true;
+                switch (action) {
+                case PatternSetup:
+                    ok = call_UMFPACK_session_symbolic(umf_, &A) &&
+                         call_UMFPACK_session_numeric (umf_, &A);
+                    break;
+                case ValueSetup:
+                    ok = call_UMFPACK_session_numeric(umf_, &A);
+                    break;
+                case ReuseSetup:
+                    break;
+                }
+
+                if (ok) {
+                    call_UMFPACK_session_solve(umf_, rhs, solution);
+                } else {
+                    // Force a complete setup on the next solve.
+                    reset();
+                }
+
+                rep.converged = ok;
+                return rep;
+            }
+
+        private:
+            UMFPACKSession* umf_;
+        };
+    } // anonymous namespace
+
+
+
+    std::shared_ptr<LinearSolverInterface::Session>
+    LinearSolverUmfpack::makeSession(const SessionPolicy& policy) const
+    {
+        SessionPolicy direct = policy;
+        direct.refresh_tolerance = 0.0;
+
+        return std::make_shared<UmfpackSession>(direct);
+    }
+
+
 } // namespace Opm
 
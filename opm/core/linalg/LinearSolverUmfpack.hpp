@@ -68,6 +68,13 @@ namespace Opm
         /// Not used for UMFPACK solver. Returns -1.
         virtual double getTolerance() const;
 
+        /// Create a session that keeps the symbolic analysis for as long
+        /// as the sparsity pattern is unchanged.  Since this is a direct
+        /// solver, the numeric factorisation is only reused for identical
+        /// matrices, i.e., policy.refresh_tolerance is treated as zero.
+        virtual std::shared_ptr<Session>
+        makeSession(const SessionPolicy& policy = SessionPolicy()) const;
+
 
     };
 
@@ -183,3 +183,134 @@ call_UMFPACK(struct CSRMatrix *A, const double *b, double *x)
     csc_deallocate(csc);
 }
 
+
+
+struct UMFPACKSession {
+    struct CSCMatrix *csc;
+    void             *Symbolic;
+    void             *Numeric;
+    double            Control[UMFPACK_CONTROL];
+};
+
+
+/* ---------------------------------------------------------------------- */
+static void
+session_free_factors(struct UMFPACKSession *s)
+/* ---------------------------------------------------------------------- */
+{
+    if (s->Numeric != NULL) {
+        umfpack_dl_free_numeric(&s->Numeric);
+    }
+
+    if (s->Symbolic != NULL) {
+        umfpack_dl_free_symbolic(&s->Symbolic);
+    }
+
+    s->Numeric  = NULL;
+    s->Symbolic = NULL;
+}
+
+
+/*---------------------------------------------------------------------------*/
+struct UMFPACKSession *
+call_UMFPACK_session_new(void)
+/*---------------------------------------------------------------------------*/
+{
+    struct UMFPACKSession *s;
+
+    s = malloc(1 * sizeof *s);
+
+    if (s != NULL) {
+        s->csc      = NULL;
+        s->Symbolic = NULL;
+        s->Numeric  = NULL;
+
+        umfpack_dl_defaults(s->Control);
+    }
+
+    return s;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void
+call_UMFPACK_session_delete(struct UMFPACKSession *s)
+/*---------------------------------------------------------------------------*/
+{
+    if (s != NULL) {
+        session_free_factors(s);
+        csc_deallocate(s->csc);
+    }
+
+    free(s);
+}
+
+
+/*---------------------------------------------------------------------------*/
+int
+call_UMFPACK_session_symbolic(struct UMFPACKSession  *s,
+                              const struct CSRMatrix *A)
+/*---------------------------------------------------------------------------*/
+{
+    UF_long status;
+    double  Info[UMFPACK_INFO];
+
+    session_free_factors(s);
+    csc_deallocate(s->csc);
+
+    s->csc = csc_allocate(A->m, A->ia[A->m]);
+    if (s->csc == NULL) {
+        return 0;
+    }
+
+    csr_to_csc(A->ia, A->ja, A->sa, s->csc);
+
+    status = umfpack_dl_symbolic(s->csc->n, s->csc->n,
+                                 s->csc->p, s->csc->i, s->csc->x,
+                                 &s->Symbolic, s->Control, Info);
+
+    return status == UMFPACK_OK;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int
+call_UMFPACK_session_numeric(struct UMFPACKSession  *s,
+                             const struct CSRMatrix *A)
+/*---------------------------------------------------------------------------*/
+{
+    UF_long status;
+    double  Info[UMFPACK_INFO];
+
+    assert (s->csc      != NULL);
+    assert (s->Symbolic != NULL);
+    assert (s->csc->n   == (UF_long) A->m);
+    assert (s->csc->nnz == (UF_long) A->ia[A->m]);
+
+    if (s->Numeric != NULL) {
+        umfpack_dl_free_numeric(&s->Numeric);
+        s->Numeric = NULL;
+    }
+
+    csr_to_csc(A->ia, A->ja, A->sa, s->csc);
+
+    status = umfpack_dl_numeric(s->csc->p, s->csc->i, s->csc->x,
+                                s->Symbolic, &s->Numeric, s->Control, Info);
+
+    return status == UMFPACK_OK;
+}
+
+
+/*---------------------------------------------------------------------------*/
+void
+call_UMFPACK_session_solve(struct UMFPACKSession *s,
+                           const double *b, double *x)
+/*---------------------------------------------------------------------------*/
+{
+    double Info[UMFPACK_INFO];
+
+    assert (s->Numeric != NULL);
+
+    umfpack_dl_solve(UMFPACK_A, s->csc->p, s->csc->i, s->csc->x, x, b,
+                     s->Numeric, s->Control, Info);
+}
@@ -43,6 +43,54 @@ struct CSRMatrix;
 
 void call_UMFPACK(struct CSRMatrix *A, const double *b, double *x);
 
+/**
+ * Persistent UMFPACK state for repeated solves with matrices that share
+ * a common sparsity pattern.  The symbolic analysis is kept between
+ * calls to call_UMFPACK_session_numeric() and the numeric factorisation
+ * between calls to call_UMFPACK_session_solve().
+ */
+struct UMFPACKSession;
+
+/**
+ * Create an empty session.  @c NULL in case of allocation failure.
+ */
+struct UMFPACKSession *
+call_UMFPACK_session_new(void);
+
+/**
+ * Release all resources held by session @c s.  Supports @c NULL.
+ */
+void
+call_UMFPACK_session_delete(struct UMFPACKSession *s);
+
+/**
+ * Perform symbolic analysis (column ordering) of the sparsity pattern of
+ * @c A.  Discards any previous analysis and factorisation.
+ *
+ * @return Non-zero on success, zero otherwise.
+ */
+int
+call_UMFPACK_session_symbolic(struct UMFPACKSession *s,
+                              const struct CSRMatrix *A);
+
+/**
+ * Compute the numeric factorisation of @c A reusing the symbolic
+ * analysis.  The sparsity pattern of @c A must be the one passed to the
+ * most recent call to call_UMFPACK_session_symbolic().
+ *
+ * @return Non-zero on success, zero otherwise.
+ */
+int
+call_UMFPACK_session_numeric(struct UMFPACKSession *s,
+                             const struct CSRMatrix *A);
+
+/**
+ * Solve @c A*x=b using the current numeric factorisation.
+ */
+void
+call_UMFPACK_session_solve(struct UMFPACKSession *s,
+                           const double *b, double *x);
+
 #ifdef __cplusplus
 }
 #endif
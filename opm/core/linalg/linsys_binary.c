@@ -0,0 +1,491 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <opm/core/linalg/linsys_binary.h>
+
+
+#define LINSYS_MAGIC       "OPMLSYS"
+#define LINSYS_VERSION     1u
+#define LINSYS_HEADER_SIZE 80
+#define LINSYS_CHUNK       4096
+
+struct fletcher64 {
+    unsigned long long s1, s2;
+};
+
+struct linsys_layout {
+    unsigned long long m, nnz;
+    unsigned long long off_ia, off_ja, off_sa, off_v, size;
+};
+
+
+/* ---------------------------------------------------------------------- */
+static int
+host_is_little_endian(void)
+/* ---------------------------------------------------------------------- */
+{
+    const unsigned int one = 1;
+
+    return *(const unsigned char *) &one == 1;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static unsigned long long
+align8(unsigned long long n)
+/* ---------------------------------------------------------------------- */
+{
+    return (n + 7) & ~7ull;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static void
+put_u32(unsigned char *p, unsigned long v)
+/* ---------------------------------------------------------------------- */
+{
+    int i;
+
+    for (i = 0; i < 4; i++) { p[i] = (unsigned char) ((v >> (8 * i)) & 0xFF); }
+}
+
+
+/* ---------------------------------------------------------------------- */
+static void
+put_u64(unsigned char *p, unsigned long long v)
+/* ---------------------------------------------------------------------- */
+{
+    int i;
+
+    for (i = 0; i < 8; i++) { p[i] = (unsigned char) ((v >> (8 * i)) & 0xFF); }
+}
+
+
+/* ---------------------------------------------------------------------- */
+static unsigned long
+get_u32(const unsigned char *p)
+/* ---------------------------------------------------------------------- */
+{
+    int           i;
+    unsigned long v = 0;
+
+    for (i = 3; i >= 0; i--) { v = (v << 8) | p[i]; }
+
+    return v;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static unsigned long long
+get_u64(const unsigned char *p)
+/* ---------------------------------------------------------------------- */
+{
+    int                i;
+    unsigned long long v = 0;
+
+    for (i = 7; i >= 0; i--) { v = (v << 8) | p[i]; }
+
+    return v;
+}
+
+
+/* Fletcher-64 over little-endian 32-bit words.  'nbytes' must be a
+ * multiple of four.  Reduction modulo 2^32-1 is deferred over blocks
+ * of words short enough that neither sum can overflow. */
+/* ---------------------------------------------------------------------- */
+static void
+fletcher64_update(struct fletcher64 *f, const unsigned char *p, size_t nbytes)
+/* ---------------------------------------------------------------------- */
+{
+    size_t             i, nw, blk;
+    unsigned long long s1, s2;
+
+    assert (nbytes % 4 == 0);
+
+    s1 = f->s1;
+    s2 = f->s2;
+    nw = nbytes / 4;
+
+    while (nw > 0) {
+        blk = (nw < LINSYS_CHUNK) ? nw : LINSYS_CHUNK;
+
+        for (i = 0; i < blk; i++, p += 4) {
+            s1 += get_u32(p);
+            s2 += s1;
+        }
+
+        s1 %= 0xFFFFFFFFull;
+        s2 %= 0xFFFFFFFFull;
+        nw -= blk;
+    }
+
+    f->s1 = s1;
+    f->s2 = s2;
+}
+
+
+/* Emit 'nelm' elements of size 'esz' as little-endian bytes, followed by
+ * zero padding up to 'nbytes', to stream 'fp' (if non-NULL) and checksum
+ * 'ck' (if non-NULL).  Little-endian hosts emit straight from 'data'. */
+/* ---------------------------------------------------------------------- */
+static int
+emit_array(const void *data, size_t nelm, size_t esz,
+           unsigned long long nbytes, FILE *fp, struct fletcher64 *ck)
+/* ---------------------------------------------------------------------- */
+{
+    static const unsigned char zero[8] = { 0 };
+
+    size_t               i, j, k, n, npad;
+    unsigned char        buf[LINSYS_CHUNK * 8];
+    const unsigned char *src;
+
+    src  = data;
+    npad = (size_t) (nbytes - (unsigned long long) nelm * esz);
+    assert (npad < 8);
+
+    if (host_is_little_endian()) {
+        if (ck != NULL) { fletcher64_update(ck, src, nelm * esz); }
+
+        if ((fp != NULL) && (nelm > 0) &&
+            (fwrite(src, esz, nelm, fp) != nelm)) {
+            return 1;
+        }
+    } else {
+        for (i = 0; i < nelm; i += n) {
+            n = ((nelm - i) < LINSYS_CHUNK) ? (nelm - i) : LINSYS_CHUNK;
+
+            for (j = 0; j < n; j++) {
+                for (k = 0; k < esz; k++) {
+                    buf[j*esz + k] = src[(i + j)*esz + (esz - 1 - k)];
+                }
+            }
+
+            if (ck != NULL) { fletcher64_update(ck, buf, n * esz); }
+
+            if ((fp != NULL) && (fwrite(buf, esz, n, fp) != n)) {
+                return 1;
+            }
+        }
+    }
+
+    if (npad > 0) {
+        if (ck != NULL) { fletcher64_update(ck, zero, npad); }
+
+        if ((fp != NULL) && (fwrite(zero, 1, npad, fp) != npad)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static void
+compute_layout(int has_matrix, int has_vector,
+               unsigned long long m, unsigned long long nnz,
+               struct linsys_layout *L)
+/* ---------------------------------------------------------------------- */
+{
+    unsigned long long off = LINSYS_HEADER_SIZE;
+
+    L->m   = m;
+    L->nnz = nnz;
+
+    L->off_ia = L->off_ja = L->off_sa = L->off_v = 0;
+
+    if (has_matrix) {
+        L->off_ia = off;   off += align8((m + 1) * 4);
+        L->off_ja = off;   off += align8(nnz     * 4);
+        L->off_sa = off;   off += nnz * 8;
+    }
+
+    if (has_vector) {
+        L->off_v  = off;   off += m * 8;
+    }
+
+    L->size = off;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static int
+emit_payload(const struct CSRMatrix *A, const double *v,
+             const struct linsys_layout *L,
+             FILE *fp, struct fletcher64 *ck)
+/* ---------------------------------------------------------------------- */
+{
+    int ret = 0;
+
+    if (A != NULL) {
+        ret = ret || emit_array(A->ia, A->m + 1, 4, align8((L->m + 1) * 4), fp, ck);
+        ret = ret || emit_array(A->ja, A->nnz  , 4, align8(L->nnz * 4)    , fp, ck);
+        ret = ret || emit_array(A->sa, A->nnz  , 8, L->nnz * 8            , fp, ck);
+    }
+
+    if (v != NULL) {
+        ret = ret || emit_array(v, (size_t) L->m, 8, L->m * 8, fp, ck);
+    }
+
+    return ret;
+}
+
+
+/* ---------------------------------------------------------------------- */
+int
+linsys_binary_write(const struct CSRMatrix *A,
+                    size_t                  n,
+                    const double           *v,
+                    int                     checksum,
+                    const char             *fn)
+/* ---------------------------------------------------------------------- */
+{
+    int                  ret;
+    unsigned int         flags;
+    unsigned char        hdr[LINSYS_HEADER_SIZE];
+    struct linsys_layout L;
+    struct fletcher64    ck = { 1, 0 };
+    FILE                *fp;
+
+    assert (sizeof(int) == 4);
+    assert ((A == NULL) || (v == NULL) || (A->m == n));
+
+    flags = 0;
+    if (A != NULL) { flags |= LINSYS_HAS_MATRIX;   }
+    if (v != NULL) { flags |= LINSYS_HAS_VECTOR;   }
+    if (checksum)  { flags |= LINSYS_HAS_CHECKSUM; }
+
+    compute_layout(A != NULL, v != NULL,
+                   (A != NULL) ? A->m   : n,
+                   (A != NULL) ? A->nnz : 0, &L);
+
+    if (checksum) {
+        emit_payload(A, v, &L, NULL, &ck);
+    }
+
+    memset(hdr, 0, sizeof hdr);
+    memcpy(hdr, LINSYS_MAGIC, sizeof LINSYS_MAGIC);
+    put_u32(hdr +  8, LINSYS_VERSION);
+    put_u32(hdr + 12, flags);
+    put_u64(hdr + 16, L.m);
+    put_u64(hdr + 24, L.nnz);
+    put_u64(hdr + 32, checksum ? ((ck.s2 << 32) | ck.s1) : 0);
+    put_u64(hdr + 40, L.off_ia);
+    put_u64(hdr + 48, L.off_ja);
+    put_u64(hdr + 56, L.off_sa);
+    put_u64(hdr + 64, L.off_v);
+
+    fp = fopen(fn, "wb");
+    if (fp == NULL) {
+        return 1;
+    }
+
+    ret = fwrite(hdr, 1, sizeof hdr, fp) != sizeof hdr;
+    ret = ret || emit_payload(A, v, &L, fp, NULL);
+    ret = (fclose(fp) != 0) || ret;
+
+    return ret;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static int
+read_all(int fd, void *buf, size_t size)
+/* ---------------------------------------------------------------------- */
+{
+    ssize_t        n;
+    unsigned char *p = buf;
+
+    while (size > 0) {
+        n = read(fd, p, size);
+        if (n <= 0) {
+            return 1;
+        }
+
+        p    += n;
+        size -= (size_t) n;
+    }
+
+    return 0;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static int
+map_file(const char *fn, struct LinsysBinary *sys)
+/* ---------------------------------------------------------------------- */
+{
+    int         fd, ret;
+    struct stat st;
+    void       *p;
+
+    fd = open(fn, O_RDONLY);
+    if (fd < 0) {
+        return 1;
+    }
+
+    ret = 1;
+    if ((fstat(fd, &st) == 0) && (st.st_size >= LINSYS_HEADER_SIZE)) {
+        sys->size = (size_t) st.st_size;
+
+        /* Private, writable mapping: callers may modify the system
+         * (e.g., sort rows) without touching the file. */
+        p = mmap(NULL, sys->size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE, fd, 0);
+
+        if (p != MAP_FAILED) {
+            sys->base   = p;
+            sys->mapped = 1;
+            ret         = 0;
+        } else {
+            sys->base = malloc(sys->size);
+
+            if ((sys->base != NULL) &&
+                (read_all(fd, sys->base, sys->size) == 0)) {
+                sys->mapped = 0;
+                ret         = 0;
+            } else {
+                free(sys->base);
+                sys->base = NULL;
+            }
+        }
+    }
+
+    close(fd);
+
+    return ret;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static int
+array_in_file(unsigned long long off, unsigned long long nbytes,
+              unsigned long long size)
+/* ---------------------------------------------------------------------- */
+{
+    return (off >= LINSYS_HEADER_SIZE) && (off % 8 == 0) &&
+           (off <= size) && (nbytes <= size - off);
+}
+
+
+/* ---------------------------------------------------------------------- */
+int
+linsys_binary_open(const char *fn, int verify, struct LinsysBinary *sys)
+/* ---------------------------------------------------------------------- */
+{
+    int                  ok;
+    unsigned char       *p;
+    unsigned long long   sum;
+    struct linsys_layout L;
+    struct fletcher64    ck = { 1, 0 };
+
+    memset(sys, 0, sizeof *sys);
+
+    if (!host_is_little_endian() || (sizeof(int) != 4) ||
+        map_file(fn, sys)) {
+        return 1;
+    }
+
+    p  = sys->base;
+    ok = (memcmp(p, LINSYS_MAGIC, sizeof LINSYS_MAGIC) == 0) &&
+         (get_u32(p + 8) == LINSYS_VERSION);
+
+    if (ok) {
+        sys->flags = get_u32(p + 12);
+
+        L.m      = get_u64(p + 16);
+        L.nnz    = get_u64(p + 24);
+        sum      = get_u64(p + 32);
+        L.off_ia = get_u64(p + 40);
+        L.off_ja = get_u64(p + 48);
+        L.off_sa = get_u64(p + 56);
+        L.off_v  = get_u64(p + 64);
+
+        if (sys->flags & LINSYS_HAS_MATRIX) {
+            ok = array_in_file(L.off_ia, (L.m + 1) * 4, sys->size) &&
+                 array_in_file(L.off_ja, L.nnz     * 4, sys->size) &&
+                 array_in_file(L.off_sa, L.nnz     * 8, sys->size);
+
+            if (ok) {
+                sys->A.m   = (size_t) L.m;
+                sys->A.nnz = (size_t) L.nnz;
+                sys->A.ia  = (int    *) (p + L.off_ia);
+                sys->A.ja  = (int    *) (p + L.off_ja);
+                sys->A.sa  = (double *) (p + L.off_sa);
+
+                ok = (sys->A.ia[0] == 0) &&
+                     ((unsigned long long) sys->A.ia[L.m] == L.nnz);
+            }
+        }
+
+        if (ok && (sys->flags & LINSYS_HAS_VECTOR)) {
+            ok = array_in_file(L.off_v, L.m * 8, sys->size);
+
+            if (ok) {
+                sys->v = (const double *) (p + L.off_v);
+                sys->n = (size_t) L.m;
+            }
+        }
+
+        if (ok && verify && (sys->flags & LINSYS_HAS_CHECKSUM)) {
+            ok = ((sys->size - LINSYS_HEADER_SIZE) % 4 == 0);
+
+            if (ok) {
+                fletcher64_update(&ck, p + LINSYS_HEADER_SIZE,
+                                  sys->size - LINSYS_HEADER_SIZE);
+
+                ok = sum == ((ck.s2 << 32) | ck.s1);
+            }
+        }
+    }
+
+    if (!ok) {
+        linsys_binary_close(sys);
+    }
+
+    return !ok;
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+linsys_binary_close(struct LinsysBinary *sys)
+/* ---------------------------------------------------------------------- */
+{
+    if (sys->base != NULL) {
+        if (sys->mapped) {
+            munmap(sys->base, sys->size);
+        } else {
+            free(sys->base);
+        }
+    }
+
+    memset(sys, 0, sizeof *sys);
+}
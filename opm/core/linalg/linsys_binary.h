@@ -0,0 +1,138 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_LINSYS_BINARY_HEADER_INCLUDED
+#define OPM_LINSYS_BINARY_HEADER_INCLUDED
+
+/**
+ * \file
+ * Compact binary storage of linear systems (CSR matrix and/or vector)
+ * for offline replay, e.g., solver benchmarking.
+ *
+ * A file consists of an 80 byte header followed by the arrays
+ * <CODE>ia</CODE> (<CODE>m + 1</CODE> 32-bit integers), <CODE>ja</CODE>
+ * (@c nnz 32-bit integers), <CODE>sa</CODE> (@c nnz IEEE doubles) and
+ * the vector (@c m IEEE doubles), all little-endian.  Each array starts
+ * on an eight byte boundary, at an offset recorded in the header, so a
+ * memory mapped file can be used in place.  The header layout is
+ * <PRE>
+ *   offset  size  field
+ *        0     8  magic "OPMLSYS\0"
+ *        8     4  format version (1)
+ *       12     4  flags (LINSYS_HAS_MATRIX | LINSYS_HAS_VECTOR |
+ *                        LINSYS_HAS_CHECKSUM)
+ *       16     8  m, number of rows (or vector elements)
+ *       24     8  nnz, number of matrix non-zeros
+ *       32     8  Fletcher-64 checksum of everything after the header
+ *       40     8  offset of ia
+ *       48     8  offset of ja
+ *       56     8  offset of sa
+ *       64     8  offset of vector
+ *       72     8  reserved (zero)
+ * </PRE>
+ * Absent arrays have offset zero.
+ */
+
+#include <stddef.h>
+
+#include <opm/core/linalg/sparse_sys.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** File contains a matrix (ia, ja, sa). */
+#define LINSYS_HAS_MATRIX   1u
+/** File contains a vector. */
+#define LINSYS_HAS_VECTOR   2u
+/** Header checksum is valid. */
+#define LINSYS_HAS_CHECKSUM 4u
+
+
+/**
+ * Linear system read back from a binary file.  Matrix and vector
+ * pointers refer directly into the (memory mapped) file contents and
+ * remain valid until linsys_binary_close().
+ */
+struct LinsysBinary
+{
+    unsigned int     flags;  /**< LINSYS_HAS_* flags of the file */
+    struct CSRMatrix A;      /**< Matrix.  Valid if LINSYS_HAS_MATRIX */
+    const double    *v;      /**< Vector.  Valid if LINSYS_HAS_VECTOR */
+    size_t           n;      /**< Number of vector elements */
+
+    void            *base;   /**< Start of file contents */
+    size_t           size;   /**< Size of file contents in bytes */
+    int              mapped; /**< Whether @c base is memory mapped */
+};
+
+
+/**
+ * Write matrix and/or vector to binary file.
+ *
+ * On little-endian hosts the arrays are written directly from the
+ * caller's memory without intermediate copies.
+ *
+ * \param[in] A        Matrix.  @c NULL to write vector only.
+ * \param[in] n        Number of vector elements.  Must equal
+ *                     <CODE>A->m</CODE> if both are present.
+ * \param[in] v        Vector.  @c NULL to write matrix only.
+ * \param[in] checksum Whether to compute and store a checksum.
+ * \param[in] fn       Name of output file.
+ *
+ * \return Zero on success, non-zero on I/O failure.
+ */
+int
+linsys_binary_write(const struct CSRMatrix *A,
+                    size_t                  n,
+                    const double           *v,
+                    int                     checksum,
+                    const char             *fn);
+
+
+/**
+ * Open binary file written by linsys_binary_write().
+ *
+ * The file is memory mapped where supported and read into memory
+ * otherwise.  Requires a little-endian host.
+ *
+ * \param[in]  fn     Name of input file.
+ * \param[in]  verify Whether to verify the checksum, if present.
+ * \param[out] sys    Linear system.  Release with linsys_binary_close().
+ *
+ * \return Zero on success, non-zero if the file cannot be read, is not
+ * a valid linear system file, or fails checksum verification.
+ */
+int
+linsys_binary_open(const char *fn, int verify, struct LinsysBinary *sys);
+
+
+/**
+ * Release resources of linear system opened by linsys_binary_open().
+ *
+ * \param[in,out] sys Linear system.  Its pointers are invalid on return.
+ */
+void
+linsys_binary_close(struct LinsysBinary *sys);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* OPM_LINSYS_BINARY_HEADER_INCLUDED */
@@ -262,3 +262,378 @@ vector_write_stream(size_t n, const double *v, FILE *fp)
         fprintf(fp, "%26.18e\n", v[i]);
     }
 }
+
+
+/* ======================================================================
+ * Block CSR matrices
+ * ====================================================================== */
+
+
+/* ---------------------------------------------------------------------- */
+struct BCSRMatrix *
+bcsrmatrix_new_count_nnz(size_t m, int bs)
+/* ---------------------------------------------------------------------- */
+{
+    size_t             i;
+    struct BCSRMatrix *new;
+
+    assert (m > 0);
+    assert ((0 < bs) && (bs <= BCSR_MAX_BLOCK_SIZE));
+
+    new = malloc(1 * sizeof *new);
+    if (new != NULL) {
+        new->ia = malloc((m + 1) * sizeof *new->ia);
+
+        if (new->ia != NULL) {
+            for (i = 0; i < m + 1; i++) { new->ia[i] = 0; }
+
+            new->m   = m;
+            new->nnz = 0;
+            new->bs  = bs;
+
+            new->ja  = NULL;
+            new->sa  = NULL;
+        } else {
+            bcsrmatrix_delete(new);
+            new = NULL;
+        }
+    }
+
+    return new;
+}
+
+
+/* ---------------------------------------------------------------------- */
+struct BCSRMatrix *
+bcsrmatrix_new_known_nnz(size_t m, size_t nnz, int bs)
+/* ---------------------------------------------------------------------- */
+{
+    struct BCSRMatrix *new;
+
+    assert ((0 < bs) && (bs <= BCSR_MAX_BLOCK_SIZE));
+
+    new = malloc(1 * sizeof *new);
+
+    if (new != NULL) {
+        new->ia = malloc((m + 1)          * sizeof *new->ia);
+        new->ja = malloc(nnz              * sizeof *new->ja);
+        new->sa = malloc(nnz * (bs * bs)  * sizeof *new->sa);
+
+        if ((new->ia == NULL) || (new->ja == NULL) || (new->sa == NULL)) {
+            bcsrmatrix_delete(new);
+            new = NULL;
+        } else {
+            new->m   = m;
+            new->nnz = nnz;
+            new->bs  = bs;
+        }
+    }
+
+    return new;
+}
+
+
+/* ---------------------------------------------------------------------- */
+size_t
+bcsrmatrix_new_elms_pushback(struct BCSRMatrix *A)
+/* ---------------------------------------------------------------------- */
+{
+    size_t i;
+
+    assert (A->ia[0] == 0);     /* Blocks for row 'i' in bin i+1 ... */
+
+    for (i = 1; i <= A->m; i++) {
+        A->ia[0] += A->ia[i];
+        A->ia[i]  = A->ia[0] - A->ia[i];
+    }
+
+    A->nnz = A->ia[0];
+    assert (A->nnz > 0);        /* Else not a real system. */
+
+    A->ia[0] = 0;
+
+    A->ja = malloc(A->nnz                   * sizeof *A->ja);
+    A->sa = malloc(A->nnz * (A->bs * A->bs) * sizeof *A->sa);
+
+    if ((A->ja == NULL) || (A->sa == NULL)) {
+        free(A->sa);   A->sa = NULL;
+        free(A->ja);   A->ja = NULL;
+
+        A->nnz = 0;
+    }
+
+    return A->nnz;
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+bcsrmatrix_sortrows(struct BCSRMatrix *A)
+/* ---------------------------------------------------------------------- */
+{
+    size_t i;
+
+    for (i = 0; i < A->m; i++) {
+        qsort(A->ja        + A->ia[i] ,
+              A->ia[i + 1] - A->ia[i] ,
+              sizeof A->ja  [A->ia[i]],
+              cmp_row_elems);
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+size_t
+bcsrmatrix_elm_index(int i, int j, const struct BCSRMatrix *A)
+/* ---------------------------------------------------------------------- */
+{
+    int *p;
+
+    p = bsearch(&j, A->ja + A->ia[i], A->ia[i + 1] - A->ia[i],
+                sizeof A->ja[A->ia[i]], cmp_row_elems);
+
+    assert (p != NULL);
+
+    return p - A->ja;
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+bcsrmatrix_delete(struct BCSRMatrix *A)
+/* ---------------------------------------------------------------------- */
+{
+    if (A != NULL) {
+        free(A->sa);
+        free(A->ja);
+        free(A->ia);
+    }
+
+    free(A);
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+bcsrmatrix_zero(struct BCSRMatrix *A)
+/* ---------------------------------------------------------------------- */
+{
+    vector_zero(A->nnz * (A->bs * A->bs), A->sa);
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+bcsrmatrix_assemble_block(int i, int j, const double *b,
+                          struct BCSRMatrix *A)
+/* ---------------------------------------------------------------------- */
+{
+    int     k, n;
+    double *a;
+
+    n = A->bs * A->bs;
+    a = A->sa + bcsrmatrix_elm_index(i, j, A)*n;
+
+    for (k = 0; k < n; k++) { a[k] += b[k]; }
+}
+
+
+/* y = A*x for block size 'bs'.  Called with literal block sizes only,
+ * so that each wrapper below gets its own, fully unrolled, kernel. */
+/* ---------------------------------------------------------------------- */
+static void
+bcsr_matvec_fixed(int bs, const struct BCSRMatrix *A,
+                  const double *x, double *y)
+/* ---------------------------------------------------------------------- */
+{
+    int i, m;
+
+    m = (int) A->m;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i = 0; i < m; i++) {
+        int           k, r, c;
+        double        yi[BCSR_MAX_BLOCK_SIZE];
+        const double *b, *xj;
+
+        for (r = 0; r < bs; r++) { yi[r] = 0.0; }
+
+        for (k = A->ia[i]; k < A->ia[i + 1]; k++) {
+            b  = A->sa + k*(bs * bs);
+            xj = x     + A->ja[k]*bs;
+
+            for (r = 0; r < bs; r++) {
+                for (c = 0; c < bs; c++) {
+                    yi[r] += b[r*bs + c] * xj[c];
+                }
+            }
+        }
+
+        for (r = 0; r < bs; r++) { y[i*bs + r] = yi[r]; }
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+static void
+bcsr_matvec_1(const struct BCSRMatrix *A, const double *x, double *y)
+/* ---------------------------------------------------------------------- */
+{
+    bcsr_matvec_fixed(1, A, x, y);
+}
+
+
+/* ---------------------------------------------------------------------- */
+static void
+bcsr_matvec_2(const struct BCSRMatrix *A, const double *x, double *y)
+/* ---------------------------------------------------------------------- */
+{
+    bcsr_matvec_fixed(2, A, x, y);
+}
+
+
+/* ---------------------------------------------------------------------- */
+static void
+bcsr_matvec_3(const struct BCSRMatrix *A, const double *x, double *y)
+/* ---------------------------------------------------------------------- */
+{
+    bcsr_matvec_fixed(3, A, x, y);
+}
+
+
+/* ---------------------------------------------------------------------- */
+static void
+bcsr_matvec_4(const struct BCSRMatrix *A, const double *x, double *y)
+/* ---------------------------------------------------------------------- */
+{
+    bcsr_matvec_fixed(4, A, x, y);
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+bcsrmatrix_matvec(const struct BCSRMatrix *A, const double *x, double *y)
+/* ---------------------------------------------------------------------- */
+{
+    switch (A->bs) {
+    case 1: bcsr_matvec_1(A, x, y); break;
+    case 2: bcsr_matvec_2(A, x, y); break;
+    case 3: bcsr_matvec_3(A, x, y); break;
+    case 4: bcsr_matvec_4(A, x, y); break;
+
+    default:
+        assert (0 && "Unsupported block size");
+        break;
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+struct CSRMatrix *
+bcsrmatrix_expand(const struct BCSRMatrix *A)
+/* ---------------------------------------------------------------------- */
+{
+    size_t            i, bs, r, c, k, len, p;
+    struct CSRMatrix *S;
+
+    bs = A->bs;
+    S  = csrmatrix_new_known_nnz(A->m * bs, A->nnz * (bs * bs));
+
+    if (S != NULL) {
+        S->ia[0] = 0;
+
+        for (i = 0; i < A->m; i++) {
+            len = A->ia[i + 1] - A->ia[i];
+
+            for (r = 0; r < bs; r++) {
+                p = A->ia[i]*(bs * bs) + r*(len * bs);
+
+                S->ia[i*bs + r + 1] = (int) (p + len*bs);
+
+                for (k = A->ia[i]; k < (size_t) A->ia[i + 1]; k++) {
+                    for (c = 0; c < bs; c++, p++) {
+                        S->ja[p] = (int) (A->ja[k]*bs + c);
+                    }
+                }
+            }
+        }
+
+        bcsrmatrix_expand_values(A, S);
+    }
+
+    return S;
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+bcsrmatrix_expand_values(const struct BCSRMatrix *A, struct CSRMatrix *S)
+/* ---------------------------------------------------------------------- */
+{
+    size_t        i, bs, r, c, k, p;
+    const double *b;
+
+    bs = A->bs;
+
+    assert (S->m   == A->m   * bs);
+    assert (S->nnz == A->nnz * (bs * bs));
+
+    for (i = 0; i < A->m; i++) {
+        for (r = 0; r < bs; r++) {
+            p = S->ia[i*bs + r];
+
+            for (k = A->ia[i]; k < (size_t) A->ia[i + 1]; k++) {
+                b = A->sa + k*(bs * bs) + r*bs;
+
+                for (c = 0; c < bs; c++, p++) {
+                    S->sa[p] = b[c];
+                }
+            }
+        }
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+bcsrmatrix_write(const struct BCSRMatrix *A, const char *fn)
+/* ---------------------------------------------------------------------- */
+{
+    FILE *fp;
+
+    fp = fopen(fn, "wt");
+
+    if (fp != NULL) {
+        bcsrmatrix_write_stream(A, fp);
+        fclose(fp);
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+bcsrmatrix_write_stream(const struct BCSRMatrix *A, FILE *fp)
+/* ---------------------------------------------------------------------- */
+{
+    size_t        i, bs, r, c, k;
+    const double *b;
+
+    bs = A->bs;
+
+    for (i = 0; i < A->m; i++) {
+        for (r = 0; r < bs; r++) {
+            for (k = A->ia[i]; k < (size_t) A->ia[i + 1]; k++) {
+                b = A->sa + k*(bs * bs) + r*bs;
+
+                for (c = 0; c < bs; c++) {
+                    fprintf(fp, "%lu %lu %26.18e\n",
+                            (unsigned long) (i*bs + r + 1),
+                            (unsigned long) (A->ja[k]*bs + c + 1),
+                            b[c]);
+                }
+            }
+        }
+    }
+}
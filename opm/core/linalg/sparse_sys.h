@@ -22,7 +22,8 @@
 
 /**
  * \file
- * Data structure and operations to manage sparse matrices in CSR formats.
+ * Data structure and operations to manage sparse matrices in CSR formats,
+ * including block CSR with small, fixed block sizes.
  */
 
 #include <stddef.h>
@@ -191,6 +192,8 @@ vector_zero(size_t n, double *v);
  * MATLAB© or Octave.
  *
  * This function is implemented in terms of csrmatrix_write_stream().
+ * See linsys_binary_write() for a compact binary alternative suitable
+ * for large systems.
  *
  * \param[in] A  Matrix.
  * \param[in] fn Name of file to which matrix contents will be output.
@@ -245,6 +248,221 @@ vector_write(size_t n, const double *v, const char *fn);
 void
 vector_write_stream(size_t n, const double *v, FILE *fp);
 
+
+
+/**
+ * Largest block size supported by struct BCSRMatrix.
+ */
+#define BCSR_MAX_BLOCK_SIZE 4
+
+
+/**
+ * Block compressed-sparse row (BCSR) matrix data structure.
+ *
+ * Every structurally non-zero element is a dense <CODE>bs-by-bs</CODE>
+ * block, stored in row major order.  Row pointers and column indices
+ * refer to block rows and block columns, so a system with @c bs
+ * unknowns per cell stores one column index per cell-to-cell
+ * connection rather than <CODE>bs*bs</CODE> of them.
+ */
+struct BCSRMatrix
+{
+    size_t      m;    /**< Number of block rows */
+    size_t      nnz;  /**< Number of structurally non-zero blocks */
+    int         bs;   /**< Block size, 1 to BCSR_MAX_BLOCK_SIZE */
+
+    int        *ia;   /**< Block row pointers */
+    int        *ja;   /**< Block column indices */
+
+    double     *sa;   /**< Block elements, <CODE>bs*bs</CODE> per block */
+};
+
+
+/**
+ * Allocate a block matrix structure and corresponding row pointers
+ * to support the "count and push-back" construction scheme.
+ *
+ * Block analogue of csrmatrix_new_count_nnz().  The matrix will be
+ * fully formed in bcsrmatrix_new_elms_pushback().
+ *
+ * \param[in] m  Number of block rows.
+ * \param[in] bs Block size.  Must be in the range
+ *               <CODE>1, ..., BCSR_MAX_BLOCK_SIZE</CODE>.
+ *
+ * \return Allocated matrix structure with zeroed row pointers.
+ * @c NULL in case of allocation failure.
+ */
+struct BCSRMatrix *
+bcsrmatrix_new_count_nnz(size_t m, int bs);
+
+
+/**
+ * Allocate a block matrix structure and all constituent fields to hold
+ * a matrix with a specified number of structurally non-zero blocks.
+ *
+ * Block analogue of csrmatrix_new_known_nnz().  The sparsity pattern
+ * must be constructed by external means.
+ *
+ * \param[in] m   Number of block rows.
+ * \param[in] nnz Number of structurally non-zero blocks.
+ * \param[in] bs  Block size.
+ *
+ * \return Allocated matrix structure and constituent element arrays.
+ * @c NULL in case of allocation failure.
+ */
+struct BCSRMatrix *
+bcsrmatrix_new_known_nnz(size_t m, size_t nnz, int bs);
+
+
+/**
+ * Set row pointers and allocate column index and block element arrays
+ * of a matrix previously obtained from bcsrmatrix_new_count_nnz().
+ *
+ * Follows the conventions of csrmatrix_new_elms_pushback(), counting
+ * non-zero blocks rather than non-zero elements.
+ *
+ * \param[in,out] A Block matrix.
+ *
+ * \return Total number of allocated non-zero blocks if successful and
+ * zero in case of allocation failure.
+ */
+size_t
+bcsrmatrix_new_elms_pushback(struct BCSRMatrix *A);
+
+
+/**
+ * Compute non-zero index of specified matrix block.
+ *
+ * The elements of block <CODE>(i,j)</CODE> start at
+ * <CODE>A->sa + k*A->bs*A->bs</CODE> in which @c k is the return
+ * value.  Requires sorted rows, see bcsrmatrix_sortrows().
+ *
+ * \param[in] i Block row index.
+ * \param[in] j Block column index.  Must be in the structural non-zero
+ *              block set of row @c i.
+ * \param[in] A Block matrix.
+ *
+ * \return Non-zero block index, into @c A->ja, of block
+ * <CODE>(i,j)</CODE>.
+ */
+size_t
+bcsrmatrix_elm_index(int i, int j, const struct BCSRMatrix *A);
+
+
+/**
+ * Sort block column indices within each block row in ascending order.
+ *
+ * As for csrmatrix_sortrows(), the block elements are not referenced.
+ *
+ * \param[in,out] A Block matrix.
+ */
+void
+bcsrmatrix_sortrows(struct BCSRMatrix *A);
+
+
+/**
+ * Dispose of memory resources obtained through prior calls to block
+ * matrix allocation routines.
+ *
+ * \param[in,out] A Block matrix.  Invalid following this call.
+ */
+void
+bcsrmatrix_delete(struct BCSRMatrix *A);
+
+
+/**
+ * Zero all block elements, typically in preparation of elemental
+ * assembly.
+ *
+ * \param[in,out] A Block matrix for which to zero the elements.
+ */
+void
+bcsrmatrix_zero(struct BCSRMatrix *A);
+
+
+/**
+ * Add a dense block into the matrix.
+ *
+ * \param[in]     i Block row index.
+ * \param[in]     j Block column index.  Must be in the structural
+ *                  non-zero block set of row @c i.
+ * \param[in]     b Block elements, <CODE>A->bs*A->bs</CODE> values in
+ *                  row major order.
+ * \param[in,out] A Block matrix.
+ */
+void
+bcsrmatrix_assemble_block(int i, int j, const double *b,
+                          struct BCSRMatrix *A);
+
+
+/**
+ * Compute matrix-vector product <CODE>y = A*x</CODE>.
+ *
+ * Vectors are stored with the @c bs unknowns of each block row
+ * consecutively.  Each supported block size uses its own, fully
+ * unrolled, kernel.
+ *
+ * \param[in]  A Block matrix.
+ * \param[in]  x Vector of size <CODE>A->m * A->bs</CODE>.
+ * \param[out] y Vector of size <CODE>A->m * A->bs</CODE>.  Must not
+ *               alias @c x.
+ */
+void
+bcsrmatrix_matvec(const struct BCSRMatrix *A, const double *x, double *y);
+
+
+/**
+ * Expand block matrix into an equivalent scalar CSR matrix, e.g., for
+ * use with solvers that accept only struct CSRMatrix.
+ *
+ * Scalar row <CODE>i*bs + r</CODE> and column <CODE>j*bs + c</CODE>
+ * hold element <CODE>(r,c)</CODE> of block <CODE>(i,j)</CODE>.  Column
+ * indices are sorted within each row if they are sorted in @c A.
+ *
+ * \param[in] A Block matrix.
+ *
+ * \return Newly allocated scalar matrix that must be released with
+ * csrmatrix_delete().  @c NULL in case of allocation failure.
+ */
+struct CSRMatrix *
+bcsrmatrix_expand(const struct BCSRMatrix *A);
+
+
+/**
+ * Copy block elements into a scalar CSR matrix previously created by
+ * bcsrmatrix_expand() from a matrix with the same sparsity pattern.
+ *
+ * \param[in]     A Block matrix.
+ * \param[in,out] S Scalar matrix.
+ */
+void
+bcsrmatrix_expand_values(const struct BCSRMatrix *A, struct CSRMatrix *S);
+
+
+/**
+ * Print block matrix to file.
+ *
+ * The matrix content is printed in the scalar coordinate format of
+ * csrmatrix_write().
+ *
+ * \param[in] A  Block matrix.
+ * \param[in] fn Name of file to which matrix contents will be output.
+ */
+void
+bcsrmatrix_write(const struct BCSRMatrix *A, const char *fn);
+
+
+/**
+ * Print block matrix to stream in the scalar coordinate format of
+ * csrmatrix_write_stream().
+ *
+ * \param[in]     A  Block matrix.
+ * \param[in,out] fp Open (text) stream to which matrix contents
+ *                   will be output.
+ */
+void
+bcsrmatrix_write_stream(const struct BCSRMatrix *A, FILE *fp);
+
 #ifdef __cplusplus
 }
 #endif
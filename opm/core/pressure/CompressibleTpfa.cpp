@@ -37,6 +37,7 @@
 #include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <numeric>
 
 namespace Opm
@@ -59,6 +60,7 @@ namespace Opm
     ///                                and completions does not change during the
     ///                                run. However, controls (only) are allowed
     ///                                to change.
+    /// \param[in] newton        Options for the Newton-Raphson iterations.
     CompressibleTpfa::CompressibleTpfa(const UnstructuredGrid& grid,
                                        const BlackoilPropertiesInterface& props,
                                        const RockCompressibility* rock_comp_props,
@@ -67,7 +69,8 @@ namespace Opm
                                        const double change_tol,
                                        const int maxiter,
                                        const double* gravity,
-                                       const struct Wells* wells)
+                                       const struct Wells* wells,
+                                       const NewtonOptions& newton)
         : grid_(grid),
           props_(props),
           rock_comp_props_(rock_comp_props),
@@ -77,9 +80,12 @@ namespace Opm
           maxiter_(maxiter),
           gravity_(gravity),
           wells_(wells),
+          newton_(newton),
           htrans_(grid.cell_facepos[ grid.number_of_cells ]),
           trans_ (grid.number_of_faces),
           allcells_(grid.number_of_cells),
+          prev_dt_(0.0),
+          jacobian_update_(true),
           singular_(false)
     {
         if (wells_ && (wells_->number_of_phases != props.numPhases())) {
@@ -126,16 +132,25 @@ namespace Opm
         const int nc = grid_.number_of_cells;
         const int nw = (wells_ != 0) ? wells_->number_of_wells : 0;
 
+        newton_stats_ = NewtonStatistics();
+
         // Set up dynamic data.
         computePerSolveDynamicData(dt, state, well_state);
+        if (newton_.extrapolate_pressure) {
+            extrapolatePressure(dt, state, well_state);
+        }
+        jacobian_update_ = true;
         computePerIterationDynamicData(dt, state, well_state);
 
         // Assemble J and F.
         assemble(dt, state, well_state);
+        ++newton_stats_.jacobian_evaluations;
 
         double inc_norm = 0.0;
         int iter = 0;
+        int chord_iter = 0;
         double res_norm = residualNorm();
+        double res_reduction = std::numeric_limits<double>::max();
         std::cout << "\nIteration         Residual        Change in p\n"
                   << std::setw(9) << iter
                   << std::setw(18) << res_norm
@@ -164,25 +179,49 @@ namespace Opm
                 break;
             }
 
+            // Keep the current Jacobian (chord iteration) if the last
+            // iteration reduced the residual sufficiently.  Identical
+            // matrix values also let the solver session reuse its setup.
+            const bool chord = (newton_.chord_reduction > 0.0)
+                && (chord_iter < newton_.max_chord_iterations)
+                && (res_reduction <= newton_.chord_reduction);
+            if (chord && (chord_iter == 0)) {
+                chord_jacobian_.assign(h_->J->sa, h_->J->sa + h_->J->nnz);
+            }
+            jacobian_update_ = !chord;
+
             // Set up dynamic data.
             computePerIterationDynamicData(dt, state, well_state);
 
             // Assemble J and F.
             assemble(dt, state, well_state);
+            if (chord) {
+                std::copy(chord_jacobian_.begin(), chord_jacobian_.end(), h_->J->sa);
+                ++chord_iter;
+                ++newton_stats_.chord_iterations;
+            } else {
+                chord_iter = 0;
+                ++newton_stats_.jacobian_evaluations;
+            }
 
             // Update residual norm.
+            const double prev_res_norm = res_norm;
             res_norm = residualNorm();
+            res_reduction = (prev_res_norm > 0.0) ? res_norm / prev_res_norm : 0.0;
 
             std::cout << std::setw(9) << iter
                       << std::setw(18) << res_norm
                       << std::setw(18) << inc_norm << std::endl;
         }
+        newton_stats_.iterations = iter;
+        jacobian_update_ = true;
 
         if ((iter == maxiter_) && (res_norm > residual_tol_) && (inc_norm > change_tol_)) {
             OPM_THROW(std::runtime_error, "CompressibleTpfa::solve() failed to converge in " << maxiter_ << " iterations.");
         }
 
-        std::cout << "Solved pressure in " << iter << " iterations." << std::endl;
+        std::cout << "Solved pressure in " << iter << " iterations ("
+                  << newton_stats_.jacobian_evaluations << " Jacobian evaluations)." << std::endl;
 
         // Compute fluxes and face pressures.
         computeResults(state, well_state);
@@ -207,6 +246,27 @@ namespace Opm
 
 
 
+    /// Work counters for the most recent call to solve().
+    const CompressibleTpfa::NewtonStatistics&
+    CompressibleTpfa::newtonStatistics() const
+    {
+        return newton_stats_;
+    }
+
+
+
+
+
+    /// Solve the linear systems through a session of the linear solver.
+    void CompressibleTpfa::useLinearSolverSession(const LinearSolverInterface::SessionPolicy& policy)
+    {
+        linsolver_session_ = linsolver_.makeSession(policy);
+    }
+
+
+
+
+
     /// Compute well potentials.
     void CompressibleTpfa::computeWellPotentials(const BlackoilState& state)
     {
@@ -264,6 +324,43 @@ namespace Opm
 
 
 
+    /// Extrapolate initial pressures and bhps from previous solves.
+    void CompressibleTpfa::extrapolatePressure(const double dt,
+                                               BlackoilState& state,
+                                               WellState& well_state)
+    {
+        const int nc = grid_.number_of_cells;
+        const int nw = (wells_ != 0) ? wells_->number_of_wells : 0;
+
+        std::vector<double> p(nc + nw);
+        std::copy(state.pressure().begin(), state.pressure().begin() + nc, p.begin());
+        for (int w = 0; w < nw; ++w) {
+            p[nc + w] = well_state.bhp()[w];
+        }
+
+        if (prev_dt_ > 0.0 && prev_pressure_.size() == p.size()) {
+            const double factor = dt / prev_dt_;
+            std::vector<double> pex(p.size());
+            bool positive = true;
+            for (std::vector<double>::size_type i = 0; i < p.size(); ++i) {
+                pex[i] = p[i] + factor*(p[i] - prev_pressure_[i]);
+                positive = positive && (pex[i] > 0.0);
+            }
+            if (positive) {
+                std::copy(pex.begin(), pex.begin() + nc, state.pressure().begin());
+                for (int w = 0; w < nw; ++w) {
+                    well_state.bhp()[w] = pex[nc + w];
+                }
+            }
+        }
+
+        prev_pressure_.swap(p);
+        prev_dt_ = dt;
+    }
+
+
+
+
     /// Compute per-iteration dynamic properties.
     void CompressibleTpfa::computePerIterationDynamicData(const double dt,
                                                           const BlackoilState& state,
@@ -274,6 +371,7 @@ namespace Opm
         // std::vector<double> cell_A_;
         // std::vector<double> cell_dA_;
         // std::vector<double> cell_viscosity_;
+        // std::vector<double> cell_rho_;  // Empty unless there is gravity.
         // std::vector<double> cell_phasemob_;
         // std::vector<double> cell_voldisc_;
         // std::vector<double> face_A_;
@@ -302,6 +400,7 @@ namespace Opm
         // std::vector<double> cell_A_;
         // std::vector<double> cell_dA_;
         // std::vector<double> cell_viscosity_;
+        // std::vector<double> cell_rho_;  // Empty unless there is gravity.
         // std::vector<double> cell_phasemob_;
         // std::vector<double> cell_voldisc_;
         // std::vector<double> porevol_;   // Only modified if rock_comp_props_ is non-null.
@@ -314,9 +413,22 @@ namespace Opm
         const double* cell_s = &state.saturation()[0];
         cell_A_.resize(nc*np*np);
         cell_dA_.resize(nc*np*np);
-        props_.matrix(nc, cell_p, cell_T, cell_z, &allcells_[0], &cell_A_[0], &cell_dA_[0]);
         cell_viscosity_.resize(nc*np);
-        props_.viscosity(nc, cell_p, cell_T, cell_z, &allcells_[0], &cell_viscosity_[0], 0);
+        // All PVT quantities in one call. In chord iterations the
+        // Jacobian is not used, so the derivatives are left as they
+        // are. Densities are only needed for gravity.
+        BlackoilPropertiesInterface::PvtOutput pvt;
+        pvt.A = &cell_A_[0];
+        pvt.dAdp = jacobian_update_ ? &cell_dA_[0] : 0;
+        pvt.mu = &cell_viscosity_[0];
+        const int dim = grid_.dimensions;
+        if (gravity_ && gravity_[dim - 1] != 0.0) {
+            cell_rho_.resize(nc*np);
+            pvt.rho = &cell_rho_[0];
+        } else {
+            cell_rho_.clear();
+        }
+        props_.pvtProperties(nc, cell_p, cell_T, cell_z, &allcells_[0], pvt);
         cell_phasemob_.resize(nc*np);
         props_.relperm(nc, cell_s, &allcells_[0], &cell_phasemob_[0], 0);
         std::transform(cell_phasemob_.begin(), cell_phasemob_.end(),
@@ -381,9 +493,8 @@ namespace Opm
                     // Gravity contribution, gravcontrib = rho*(face_z - cell_z) [per phase].
                     if (grav != 0.0) {
                         const double depth_diff = face_depth - grid_.cell_centroids[c[j]*dim + dim - 1];
-                        props_.density(1, &cell_A_[np*np*c[j]], &c[j], &gravcontrib[j][0]);
                         for (int p = 0; p < np; ++p) {
-                            gravcontrib[j][p] *= depth_diff*grav;
+                            gravcontrib[j][p] = cell_rho_[np*c[j] + p]*(depth_diff*grav);
                         }
                     } else {
                         std::fill(gravcontrib[j].begin(), gravcontrib[j].end(), 0.0);
@@ -552,7 +663,11 @@ namespace Opm
     void CompressibleTpfa::solveIncrement()
     {
         // Increment is equal to -J^{-1}F
-        linsolver_.solve(h_->J, h_->F, &pressure_increment_[0]);
+        if (linsolver_session_) {
+            linsolver_session_->solve(h_->J, h_->F, &pressure_increment_[0]);
+        } else {
+            linsolver_.solve(h_->J, h_->F, &pressure_increment_[0]);
+        }
         std::transform(pressure_increment_.begin(), pressure_increment_.end(),
                        pressure_increment_.begin(), std::negate<double>());
     }
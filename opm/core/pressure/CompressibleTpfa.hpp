@@ -21,6 +21,9 @@
 #define OPM_COMPRESSIBLETPFA_HEADER_INCLUDED
 
 
+#include <opm/core/linalg/LinearSolverInterface.hpp>
+
+#include <memory>
 #include <vector>
 
 struct UnstructuredGrid;
@@ -34,7 +37,6 @@ namespace Opm
     class BlackoilState;
     class BlackoilPropertiesInterface;
     class RockCompressibility;
-    class LinearSolverInterface;
     class WellState;
 
     /// Encapsulating a tpfa pressure solver for the compressible-fluid case.
@@ -44,6 +46,49 @@ namespace Opm
     class CompressibleTpfa
     {
     public:
+        /// Options for the Newton-Raphson iterations of solve().
+        /// The defaults give the plain Newton-Raphson scheme.
+        struct NewtonOptions
+        {
+            NewtonOptions()
+                : chord_reduction(0.0),
+                  max_chord_iterations(5),
+                  extrapolate_pressure(false)
+            {}
+
+            /// Chord (quasi-Newton) iterations: the Jacobian of an
+            /// iteration, and with useLinearSolverSession() also the
+            /// linear solver setup, is kept for the next iteration as
+            /// long as the residual inf-norm was reduced by at least
+            /// this factor, i.e.
+            ///   |F_{k+1}| <= chord_reduction * |F_k|.
+            /// Zero disables chord iterations.
+            double chord_reduction;
+
+            /// Maximum number of consecutive iterations reusing the
+            /// same Jacobian.
+            int max_chord_iterations;
+
+            /// Start the iterations from the pressures (and bhps)
+            /// linearly extrapolated from the two previous solves,
+            ///   p = p_n + dt/dt_prev*(p_n - p_{n-1}),
+            /// instead of from the current state.  Not applied if any
+            /// extrapolated pressure would be non-positive.
+            bool extrapolate_pressure;
+        };
+
+        /// Work counters for the most recent call to solve().
+        struct NewtonStatistics
+        {
+            NewtonStatistics()
+                : iterations(0), jacobian_evaluations(0), chord_iterations(0)
+            {}
+
+            int iterations;           ///< Newton iterations (linear solves).
+            int jacobian_evaluations; ///< Assemblies using a fresh Jacobian.
+            int chord_iterations;     ///< Iterations reusing a previous Jacobian.
+        };
+
         /// Construct solver.
         /// \param[in] grid             A 2d or 3d grid.
         /// \param[in] props            Rock and fluid properties.
@@ -61,6 +106,7 @@ namespace Opm
         ///                                   and completions does not change during the
         ///                                   run. However, controls (only) are allowed
         ///                                   to change.
+        /// \param[in] newton           Options for the Newton-Raphson iterations.
         CompressibleTpfa(const UnstructuredGrid& grid,
                          const BlackoilPropertiesInterface& props,
                          const RockCompressibility* rock_comp_props,
@@ -69,7 +115,8 @@ namespace Opm
                          const double change_tol,
                          const int maxiter,
                          const double* gravity,
-                         const Wells* wells);
+                         const Wells* wells,
+                         const NewtonOptions& newton = NewtonOptions());
 
         /// Destructor.
         virtual ~CompressibleTpfa();
@@ -89,6 +136,16 @@ namespace Opm
         /// are significant.)
         bool singularPressure() const;
 
+        /// Work counters for the most recent call to solve().
+        const NewtonStatistics& newtonStatistics() const;
+
+        /// Solve the linear systems through a session of the linear
+        /// solver, which may reuse its setup between Newton iterations
+        /// and calls to solve() as the policy allows.  By default, each
+        /// linear system is solved with a full setup.
+        void useLinearSolverSession(const LinearSolverInterface::SessionPolicy& policy
+                                    = LinearSolverInterface::SessionPolicy());
+
     private:
         virtual void computePerSolveDynamicData(const double dt,
                                                 const BlackoilState& state,
@@ -113,6 +170,9 @@ namespace Opm
         double incrementNorm() const;
         void computeResults(BlackoilState& state,
                             WellState& well_state) const;
+        void extrapolatePressure(const double dt,
+                                 BlackoilState& state,
+                                 WellState& well_state);
     protected:
         void computeWellPotentials(const BlackoilState& state);
 
@@ -126,6 +186,7 @@ namespace Opm
         const int maxiter_;
         const double* gravity_; // May be NULL
         const Wells* wells_;    // May be NULL, outside may modify controls (only) between calls to solve().
+        const NewtonOptions newton_;
         std::vector<double> htrans_;
         std::vector<double> trans_ ;
         std::vector<int> allcells_;
@@ -133,14 +194,23 @@ namespace Opm
         // ------ Internal data for the cfs_tpfa_res solver. ------
         struct cfs_tpfa_res_data* h_;
 
+        // ------ Linear solver setup reused between Newton iterations, may be null. ------
+        std::shared_ptr<LinearSolverInterface::Session> linsolver_session_;
+
         // ------ Data that will be modified for every solve. ------
         std::vector<double> wellperf_wdp_;
         std::vector<double> initial_porevol_;
+        NewtonStatistics newton_stats_;
+
+        // ------ Data kept between solves for pressure extrapolation. ------
+        std::vector<double> prev_pressure_; // Cell pressures and bhps at start of previous solve.
+        double prev_dt_;
 
         // ------ Data that will be modified for every solver iteration. ------
         std::vector<double> cell_A_;
         std::vector<double> cell_dA_;
         std::vector<double> cell_viscosity_;
+        std::vector<double> cell_rho_;  // Empty unless there is gravity.
         std::vector<double> cell_phasemob_;
         std::vector<double> cell_voldisc_;
         std::vector<double> face_A_;
@@ -152,6 +222,11 @@ namespace Opm
         std::vector<double> rock_comp_; // Empty unless rock_comp_props_ is non-null.
         // The update to be applied to the pressures (cell and bhp).
         std::vector<double> pressure_increment_;
+        // Jacobian values kept for chord iterations, and whether the
+        // current iteration evaluates a fresh Jacobian (otherwise
+        // cell_dA_ is not recomputed).
+        std::vector<double> chord_jacobian_;
+        bool jacobian_update_;
         // True if the matrix assembled would be singular but for the
         // adjustment made in the cfs_*_assemble() calls. This happens
         // if everything is incompressible and there are no pressure
@@ -168,6 +168,16 @@ namespace Opm
 
 
 
+
+
+    /// Solve the linear systems through a session of the linear solver.
+    void IncompTpfa::useLinearSolverSession(const LinearSolverInterface::SessionPolicy& policy)
+    {
+        linsolver_session_ = linsolver_.makeSession(policy);
+    }
+
+
+
     // Solve with no rock compressibility (linear eqn).
     void IncompTpfa::solveIncomp(const double dt,
                                  SimulationDataContainer& state,
@@ -184,7 +194,7 @@ namespace Opm
         }
 
         // Solve.
-        linsolver_.solve(h_->A, h_->b, h_->x);
+        solveSystem();
 
         // Obtain solution.
         assert(int(state.pressure().size()) == grid_.number_of_cells);
@@ -421,7 +431,7 @@ namespace Opm
     {
         // Increment is equal to -J^{-1}R.
         // The Jacobian is in h_->A, residual in h_->b.
-        linsolver_.solve(h_->A, h_->b, h_->x);
+        solveSystem();
         // It is not necessary to negate the increment,
         // apparently the system for the increment is generated,
         // not the Jacobian and residual as such.
@@ -429,6 +439,20 @@ namespace Opm
     }
 
 
+
+
+
+    /// Solves the system in h_->A and h_->b, puts the solution in h_->x.
+    void IncompTpfa::solveSystem()
+    {
+        if (linsolver_session_) {
+            linsolver_session_->solve(h_->A, h_->b, h_->x);
+        } else {
+            linsolver_.solve(h_->A, h_->b, h_->x);
+        }
+    }
+
+
     namespace {
         template <class FI>
         double infnorm(FI beg, FI end)
@@ -21,6 +21,8 @@
 #define OPM_INCOMPTPFA_HEADER_INCLUDED
 
 #include <opm/core/pressure/tpfa/ifs_tpfa.h>
+#include <opm/core/linalg/LinearSolverInterface.hpp>
+#include <memory>
 #include <vector>
 
 struct UnstructuredGrid;
@@ -32,7 +34,6 @@ namespace Opm
 
     class IncompPropertiesInterface;
     class RockCompressibility;
-    class LinearSolverInterface;
     class WellState;
     class SimulationDataContainer;
 
@@ -116,6 +117,13 @@ namespace Opm
                    WellState& well_state);
 
 
+        /// Solve the linear systems through a session of the linear
+        /// solver, which may reuse its setup between solves as the
+        /// policy allows.  By default, each linear system is solved
+        /// with a full setup.
+        void useLinearSolverSession(const LinearSolverInterface::SessionPolicy& policy
+                                    = LinearSolverInterface::SessionPolicy());
+
         /// Expose read-only reference to internal half-transmissibility.
         const std::vector<double>& getHalfTrans() const { return htrans_; }
 
@@ -141,6 +149,7 @@ namespace Opm
                       const SimulationDataContainer& state,
                       const WellState& well_state);
         void solveIncrement();
+        void solveSystem();
         double residualNorm() const;
         double incrementNorm() const;
 	void computeResults(SimulationDataContainer& state,
@@ -179,6 +188,9 @@ namespace Opm
 
         // ------ Internal data for the ifs_tpfa solver. ------
 	struct ifs_tpfa_data* h_;
+
+        // ------ Linear solver setup reused between solves, may be null. ------
+        std::shared_ptr<LinearSolverInterface::Session> linsolver_session_;
     };
 
 } // namespace Opm
@@ -26,6 +26,9 @@
  * Routines to assist in the calculation of two-point transmissibilities.
  */
 
+#include <cstddef>
+#include <vector>
+
 /**
  * Calculate static, one-sided transmissibilities for use in the two-point flux
  * approximation method.
@@ -101,5 +104,83 @@ tpfa_eff_trans_compute(const Grid   *G      ,
                        const double *htrans,
                        double       *trans );
 
+/**
+ * Index of the first half-face of every cell, and one past the last, in
+ * the ordering of tpfa_htrans_compute().  Computed once per grid and passed
+ * to tpfa_htrans_update() and tpfa_trans_update().
+ *
+ * @param[in] G Grid.
+ * @return Offsets, <CODE>numCells(G) + 1</CODE> entries.
+ */
+template<class Grid>
+std::vector<int>
+tpfa_half_face_pos(const Grid *G);
+
+/**
+ * Collect the faces of a set of cells, e.g., the cells whose permeability
+ * has changed, for use with tpfa_trans_update().
+ *
+ * @param[in]  G      Grid.
+ * @param[in]  ncells Number of cells.
+ * @param[in]  cells  Cell indices.
+ * @param[out] faces  Distinct faces of the cells, in increasing order.  Array
+ *                    of size at least the total number of half-faces of the
+ *                    cells.
+ * @return Number of distinct faces stored in @c faces.
+ */
+template<class Grid>
+std::size_t
+tpfa_cells_faces(const Grid   *G     ,
+                 std::size_t   ncells,
+                 const int    *cells ,
+                 int          *faces );
+
+/**
+ * Recompute, in place, the one-sided transmissibilities of a set of cells
+ * following a change in the permeability of those cells.
+ *
+ * @param[in]     G       Grid.
+ * @param[in]     hf_pos  Half-face offsets from tpfa_half_face_pos().
+ * @param[in]     perm    Permeability as for tpfa_htrans_compute().  Only the
+ *                        tensors of the listed cells are accessed.
+ * @param[in]     ncells  Number of cells.
+ * @param[in]     cells   Cells whose permeability has changed.
+ * @param[in,out] htrans  One-sided transmissibilities as defined by function
+ *                        tpfa_htrans_compute().  The entries of the half-faces
+ *                        of the listed cells are updated.
+ */
+template<class Grid>
+void
+tpfa_htrans_update(const Grid   *G     ,
+                   const int    *hf_pos,
+                   const double *perm  ,
+                   std::size_t   ncells,
+                   const int    *cells ,
+                   double       *htrans);
+
+/**
+ * Recompute, in place, the two-point transmissibilities of a set of faces,
+ * typically those returned by tpfa_cells_faces() for the cells passed to
+ * tpfa_htrans_update().
+ *
+ * @param[in]     G       Grid.
+ * @param[in]     hf_pos  Half-face offsets from tpfa_half_face_pos().
+ * @param[in]     htrans  One-sided transmissibilities as defined by function
+ *                        tpfa_htrans_compute().
+ * @param[in]     nf      Number of faces.
+ * @param[in]     faces   Faces whose transmissibilities to recompute.
+ * @param[in,out] trans   Interface, two-point transmissibilities as defined by
+ *                        function tpfa_trans_compute().  The entries of the
+ *                        listed faces are updated.
+ */
+template<class Grid>
+void
+tpfa_trans_update(const Grid   *G     ,
+                  const int    *hf_pos,
+                  const double *htrans,
+                  std::size_t   nf    ,
+                  const int    *faces ,
+                  double       *trans );
+
 #include "TransTpfa_impl.hpp"
 #endif  /* OPM_TRANS_TPFA_HEADER_INCLUDED */
@@ -2,7 +2,11 @@
 #include <opm/core/pressure/tpfa/trans_tpfa.h>
 #include <opm/core/grid/GridHelpers.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <vector>
 
 namespace Dune
 {
@@ -49,11 +53,12 @@ inline void maybeFreeFaceNormal(const UnstructuredGrid&, const double*)
 }
 
 /* ---------------------------------------------------------------------- */
-/* htrans <- sum(C(:,i) .* K(cellNo,:) .* N(:,j), 2) ./ sum(C.*C, 2) */
+/* One-sided transmissibilities of the half-faces of cell 'c', starting at */
+/* half-face index 'i'. */
 /* ---------------------------------------------------------------------- */
 template<class Grid>
 void
-tpfa_htrans_compute(const Grid* G, const double *perm, double *htrans)
+tpfa_cell_htrans(const Grid* G, int c, int i, const double *perm, double *htrans)
 /* ---------------------------------------------------------------------- */
 {
     using namespace Opm::UgGridHelpers;
@@ -61,10 +66,11 @@ tpfa_htrans_compute(const Grid* G, const double *perm, double *htrans)
     double s, dist, denom;
 
     double Kn[3];
-    typename CellCentroidTraits<Grid>::IteratorType cc = beginCellCentroids(*G);
+    typename CellCentroidTraits<Grid>::IteratorType cc =
+        increment(beginCellCentroids(*G), c, dimensions(*G));
     typename Cell2FacesTraits<Grid>::Type c2f = cell2Faces(*G);
     typename FaceCellTraits<Grid>::Type face_cells = faceCells(*G);
-    
+
     const double *n;
     const double *K;
 
@@ -77,37 +83,79 @@ tpfa_htrans_compute(const Grid* G, const double *perm, double *htrans)
     incx  = incy     = 1      ;
     a1    = 1.0;  a2 = 0.0    ;
 
-    for (int c =0, i = 0; c < numCells(*G); c++) {
-        K  = perm + (c * d * d);
-        
+    K  = perm + (c * d * d);
+
+    typedef typename Cell2FacesTraits<Grid>::Type::row_type FaceRow;
+    FaceRow faces = c2f[c];
+
+    for(typename FaceRow::const_iterator f=faces.begin(), end=faces.end();
+        f!=end; ++f, ++i)
+    {
+        s = 2.0*(face_cells(*f, 0) == c) - 1.0;
+        n = faceNormal(*G, *f);
+        const double* nn=multiplyFaceNormalWithArea(*G, *f, n);
+        const double* fc = &(faceCentroid(*G, *f)[0]);
+        dgemv_("No Transpose", &nrows, &ncols,
+               &a1, K, &ldA, nn, &incx, &a2, &Kn[0], &incy);
+        maybeFreeFaceNormal(*G, nn);
+
+        htrans[i] = denom = 0.0;
+        for (j = 0; j < d; j++) {
+            dist = fc[j] - getCoordinate(cc, j);
+
+            htrans[i] += s * dist * Kn[j];
+            denom     +=     dist * dist;
+        }
+
+        assert (denom > 0);
+        htrans[i] /= denom;
+        htrans[i]  = std::abs(htrans[i]);
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* Index of the first half-face of every cell (and one past the last).   */
+/* ---------------------------------------------------------------------- */
+template<class Grid>
+std::vector<int>
+tpfa_half_face_pos(const Grid* G)
+/* ---------------------------------------------------------------------- */
+{
+    using namespace Opm::UgGridHelpers;
+
+    typename Cell2FacesTraits<Grid>::Type c2f = cell2Faces(*G);
+    std::vector<int> pos(numCells(*G) + 1, 0);
+
+    for (int c = 0; c < numCells(*G); c++) {
         typedef typename Cell2FacesTraits<Grid>::Type::row_type FaceRow;
         FaceRow faces = c2f[c];
-        
-        for(typename FaceRow::const_iterator f=faces.begin(), end=faces.end();
-            f!=end; ++f, ++i)
-        {
-            s = 2.0*(face_cells(*f, 0) == c) - 1.0;
-            n = faceNormal(*G, *f);
-            const double* nn=multiplyFaceNormalWithArea(*G, *f, n);
-            const double* fc = &(faceCentroid(*G, *f)[0]);
-            dgemv_("No Transpose", &nrows, &ncols,
-                   &a1, K, &ldA, nn, &incx, &a2, &Kn[0], &incy);
-            maybeFreeFaceNormal(*G, nn);
-            
-            htrans[i] = denom = 0.0;
-            for (j = 0; j < d; j++) {
-                dist = fc[j] - getCoordinate(cc, j);
-
-                htrans[i] += s * dist * Kn[j];
-                denom     +=     dist * dist;
-            }
 
-            assert (denom > 0);
-            htrans[i] /= denom;
-            htrans[i]  = std::abs(htrans[i]);
-        }
-        // Move to next cell centroid.
-        cc = increment(cc, 1, d);
+        pos[c + 1] = pos[c] + std::distance(faces.begin(), faces.end());
+    }
+
+    return pos;
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* htrans <- sum(C(:,i) .* K(cellNo,:) .* N(:,j), 2) ./ sum(C.*C, 2) */
+/* ---------------------------------------------------------------------- */
+template<class Grid>
+void
+tpfa_htrans_compute(const Grid* G, const double *perm, double *htrans)
+/* ---------------------------------------------------------------------- */
+{
+    using namespace Opm::UgGridHelpers;
+
+    typename Cell2FacesTraits<Grid>::Type c2f = cell2Faces(*G);
+
+    for (int c = 0, i = 0; c < numCells(*G); c++) {
+        tpfa_cell_htrans(G, c, i, perm, htrans);
+
+        typedef typename Cell2FacesTraits<Grid>::Type::row_type FaceRow;
+        FaceRow faces = c2f[c];
+        i += std::distance(faces.begin(), faces.end());
     }
 }
 
@@ -175,3 +223,94 @@ tpfa_eff_trans_compute(const Grid*        G,
         trans[f] = 1.0 / trans[f];
     }
 }
+
+
+/* ---------------------------------------------------------------------- */
+template<class Grid>
+std::size_t
+tpfa_cells_faces(const Grid   *G     ,
+                 std::size_t   ncells,
+                 const int    *cells ,
+                 int          *faces )
+/* ---------------------------------------------------------------------- */
+{
+    using namespace Opm::UgGridHelpers;
+
+    typename Cell2FacesTraits<Grid>::Type c2f = cell2Faces(*G);
+
+    std::size_t nf = 0;
+    for (std::size_t k = 0; k < ncells; k++) {
+        typedef typename Cell2FacesTraits<Grid>::Type::row_type FaceRow;
+        FaceRow cf = c2f[cells[k]];
+
+        for(typename FaceRow::const_iterator f=cf.begin(), end=cf.end();
+            f!=end; ++f)
+        {
+            faces[nf++] = *f;
+        }
+    }
+
+    std::sort(faces, faces + nf);
+    return std::unique(faces, faces + nf) - faces;
+}
+
+
+/* ---------------------------------------------------------------------- */
+template<class Grid>
+void
+tpfa_htrans_update(const Grid   *G     ,
+                   const int    *hf_pos,
+                   const double *perm  ,
+                   std::size_t   ncells,
+                   const int    *cells ,
+                   double       *htrans)
+/* ---------------------------------------------------------------------- */
+{
+    for (std::size_t k = 0; k < ncells; k++) {
+        tpfa_cell_htrans(G, cells[k], hf_pos[cells[k]], perm, htrans);
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+template<class Grid>
+void
+tpfa_trans_update(const Grid   *G     ,
+                  const int    *hf_pos,
+                  const double *htrans,
+                  std::size_t   nf    ,
+                  const int    *faces ,
+                  double       *trans )
+/* ---------------------------------------------------------------------- */
+{
+    using namespace Opm::UgGridHelpers;
+
+    typename Cell2FacesTraits<Grid>::Type c2f = cell2Faces(*G);
+    typename FaceCellTraits<Grid>::Type face_cells = faceCells(*G);
+
+    for (std::size_t k = 0; k < nf; k++) {
+        const int face = faces[k];
+        double t = 0.0;
+
+        for (int j = 0; j < 2; j++) {
+            const int c = face_cells(face, j);
+            if ((c < 0) || ((j == 1) && (c == face_cells(face, 0)))) {
+                continue;
+            }
+
+            typedef typename Cell2FacesTraits<Grid>::Type::row_type FaceRow;
+            FaceRow cf = c2f[c];
+
+            int i = hf_pos[c];
+            for(typename FaceRow::const_iterator f=cf.begin(), end=cf.end();
+                f!=end; ++f, ++i)
+            {
+                if (*f == face) {
+                    t += 1.0 / htrans[i];
+                }
+            }
+        }
+
+        trans[face] = 1.0 / t;
+    }
+}
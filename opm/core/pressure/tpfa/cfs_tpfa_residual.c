@@ -5,6 +5,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <opm/core/wells.h>
 #include <opm/core/well_controls.h>
@@ -23,17 +26,26 @@
 
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
+#if defined(MIN)
+#undef MIN
+#endif
+
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+
 
 
 struct densrat_util {
-    MAT_SIZE_T *ipiv;
+    /* Current fluid matrix factorisation.  Points into the per-cell
+     * factors held in struct cfs_tpfa_res_impl. */
+    const MAT_SIZE_T *ipiv;
+    const double     *lu;
 
     double      residual;
-    double     *lu;
     double     *t1;
     double     *t2;
     double     *mat_row;
     double     *coeff;
+    double     *flux_work;
     double     *linsolve_buffer;
 };
 
@@ -54,8 +66,18 @@ struct cfs_tpfa_res_impl {
     /* Scratch array for face pressure calculation */
     double              *scratch_f;
 
+    /* LU factors of the cell fluid matrices, Ac, in DGETRF format.  One
+     * np-by-np block (column major) and np pivots per cell. */
+    double              *lu_c;
+    MAT_SIZE_T          *ipiv_c;
+
+    /* Scratch for serial (well) assembly.  Aliases thread_ratio[0]. */
     struct densrat_util *ratio;
 
+    /* One scratch block per assembly thread. */
+    int                   nthreads;
+    struct densrat_util **thread_ratio;
+
     /* Linear storage */
     double *ddata;
 };
@@ -67,8 +89,7 @@ deallocate_densrat(struct densrat_util *ratio)
 /* ---------------------------------------------------------------------- */
 {
     if (ratio != NULL) {
-        free(ratio->lu);
-        free(ratio->ipiv);
+        free(ratio->t1);
     }
 
     free(ratio);
@@ -90,24 +111,25 @@ allocate_densrat(size_t max_conn, int np)
         n_buffer_col += 1 * max_conn; /* A_{ij} v_{ij} */
         n_buffer_col += 2 * max_conn; /* A_{ij} \partial_{p} v_{ij} */
 
-        alloc_sz  = np             * np; /* lu */
-        alloc_sz += 2              * np; /* t1, t2 */
+        alloc_sz  = 2              * np; /* t1, t2 */
         alloc_sz += (max_conn + 1) * 1 ; /* mat_row */
         alloc_sz += (max_conn + 1) * 1 ; /* coeff */
+        alloc_sz += (1 + 2)        * np; /* flux_work */
         alloc_sz += n_buffer_col   * np; /* linsolve_buffer */
 
-        ratio->ipiv = malloc(np       * sizeof *ratio->ipiv);
-        ratio->lu   = malloc(alloc_sz * sizeof *ratio->lu  );
+        ratio->ipiv = NULL;
+        ratio->lu   = NULL;
+        ratio->t1   = malloc(alloc_sz * sizeof *ratio->t1);
 
-        if ((ratio->ipiv == NULL) || (ratio->lu == NULL)) {
+        if (ratio->t1 == NULL) {
             deallocate_densrat(ratio);
             ratio = NULL;
         } else {
-            ratio->t1              = ratio->lu      + (np             * np);
             ratio->t2              = ratio->t1      + (1              * np);
             ratio->mat_row         = ratio->t2      + (1              * np);
             ratio->coeff           = ratio->mat_row + ((max_conn + 1) * 1 );
-            ratio->linsolve_buffer = ratio->coeff   + ((max_conn + 1) * 1 );
+            ratio->flux_work       = ratio->coeff   + ((max_conn + 1) * 1 );
+            ratio->linsolve_buffer = ratio->flux_work + ((1 + 2)      * np);
         }
     }
 
@@ -115,14 +137,38 @@ allocate_densrat(size_t max_conn, int np)
 }
 
 
+/* ---------------------------------------------------------------------- */
+static int
+max_assembly_threads(void)
+/* ---------------------------------------------------------------------- */
+{
+#ifdef _OPENMP
+    return MAX(omp_get_max_threads(), 1);
+#else
+    return 1;
+#endif
+}
+
+
 /* ---------------------------------------------------------------------- */
 static void
 impl_deallocate(struct cfs_tpfa_res_impl *pimpl)
 /* ---------------------------------------------------------------------- */
 {
+    int t;
+
     if (pimpl != NULL) {
-        free              (pimpl->ddata);
-        deallocate_densrat(pimpl->ratio);
+        free(pimpl->ddata);
+        free(pimpl->lu_c);
+        free(pimpl->ipiv_c);
+
+        if (pimpl->thread_ratio != NULL) {
+            for (t = 0; t < pimpl->nthreads; t++) {
+                deallocate_densrat(pimpl->thread_ratio[t]);
+            }
+        }
+
+        free(pimpl->thread_ratio);
     }
 
     free(pimpl);
@@ -137,12 +183,14 @@ impl_allocate(struct UnstructuredGrid   *G       ,
               int                        np      )
 /* ---------------------------------------------------------------------- */
 {
-    size_t                nnu, nwperf;
+    int                   t, ok;
+    size_t                nc, nnu, nwperf;
     struct cfs_tpfa_res_impl *new;
 
     size_t ddata_sz;
 
-    nnu    = G->number_of_cells;
+    nc     = G->number_of_cells;
+    nnu    = nc;
     nwperf = 0;
 
     if ((wells != NULL) && (wells->W != NULL)) {
@@ -168,12 +216,25 @@ impl_allocate(struct UnstructuredGrid   *G       ,
     new = malloc(1 * sizeof *new);
 
     if (new != NULL) {
-        new->ddata = malloc(ddata_sz * sizeof *new->ddata);
-        new->ratio = allocate_densrat(max_conn, np);
+        new->nthreads     = max_assembly_threads();
+        new->ddata        = malloc(ddata_sz * sizeof *new->ddata);
+        new->lu_c         = malloc(nc * np * np * sizeof *new->lu_c);
+        new->ipiv_c       = malloc(nc * np      * sizeof *new->ipiv_c);
+        new->thread_ratio = calloc(new->nthreads, sizeof *new->thread_ratio);
+
+        ok = (new->ddata  != NULL) && (new->thread_ratio != NULL) &&
+             (new->lu_c   != NULL) && (new->ipiv_c       != NULL);
+
+        for (t = 0; ok && (t < new->nthreads); t++) {
+            new->thread_ratio[t] = allocate_densrat(max_conn, np);
+            ok = new->thread_ratio[t] != NULL;
+        }
 
-        if (new->ddata == NULL || new->ratio == NULL) {
+        if (! ok) {
             impl_deallocate(new);
             new = NULL;
+        } else {
+            new->ratio = new->thread_ratio[0];
         }
     }
 
@@ -281,19 +342,246 @@ construct_matrix(struct UnstructuredGrid   *G    ,
 }
 
 
+/* Solve A*X = B, with A = P*L*U in DGETRF format as produced by the batch
+ * kernels below.  Called with a literal 'n' so that the loops unroll. */
 static void
-factorise_fluid_matrix(int np, const double *A, struct densrat_util *ratio)
+lu_solve_small(int n, int nrhs, const double *lu,
+               const MAT_SIZE_T *ipiv, double *b)
+{
+    int     i, k, r, p;
+    double  t, *x;
+
+    for (r = 0, x = b; r < nrhs; r++, x += n) {
+        for (k = 0; k < n; k++) {
+            p    = ipiv[k] - 1;
+            t    = x[k];
+            x[k] = x[p];
+            x[p] = t;
+        }
+
+        for (k = 0; k < n; k++) {
+            for (i = k + 1; i < n; i++) {
+                x[i] -= lu[i + k*n] * x[k];
+            }
+        }
+
+        for (k = n - 1; k >= 0; k--) {
+            x[k] /= lu[k + k*n];
+            for (i = 0; i < k; i++) {
+                x[i] -= lu[i + k*n] * x[k];
+            }
+        }
+    }
+}
+
+
+/* Number of cells factored together by the interleaved batch kernels. */
+#define LU_BATCH_LANES 8
+
+
+/* LU factorisation, with partial pivoting, of LU_BATCH_LANES column-major
+ * n-by-n matrices stored interleaved in 'w', element (i,j) of lane 'l' at
+ * w[(i + j*n)*LU_BATCH_LANES + l].  The lane index is innermost in every
+ * loop and pivoting is expressed as selects rather than branches so that
+ * the compiler can vectorise across cells.  One-based pivots are stored
+ * in 'p' using the same interleaved layout.  Returns non-zero if any
+ * lane encountered a zero pivot. */
+static int
+lu_factor_lanes(int n, double *w, int *p)
+{
+    int    i, j, k, l, info;
+    double pv[LU_BATCH_LANES], t, u, v;
+
+    info = 0;
+
+    for (k = 0; k < n; k++) {
+        for (l = 0; l < LU_BATCH_LANES; l++) {
+            pv[l]                   = w[(k + k*n)*LU_BATCH_LANES + l];
+            p[k*LU_BATCH_LANES + l] = k;
+        }
+
+        for (i = k + 1; i < n; i++) {
+            for (l = 0; l < LU_BATCH_LANES; l++) {
+                v = w[(i + k*n)*LU_BATCH_LANES + l];
+                t = fabs(v) > fabs(pv[l]);
+
+                p[k*LU_BATCH_LANES + l] = t ? i : p[k*LU_BATCH_LANES + l];
+                pv[l]                   = t ? v : pv[l];
+            }
+        }
+
+        /* Row interchange k <-> p[k] in every lane. */
+        for (j = 0; j < n; j++) {
+            for (i = k + 1; i < n; i++) {
+                for (l = 0; l < LU_BATCH_LANES; l++) {
+                    t = w[(k + j*n)*LU_BATCH_LANES + l];
+                    u = w[(i + j*n)*LU_BATCH_LANES + l];
+
+                    w[(k + j*n)*LU_BATCH_LANES + l] =
+                        (p[k*LU_BATCH_LANES + l] == i) ? u : t;
+                    w[(i + j*n)*LU_BATCH_LANES + l] =
+                        (p[k*LU_BATCH_LANES + l] == i) ? t : u;
+                }
+            }
+        }
+
+        for (l = 0; l < LU_BATCH_LANES; l++) {
+            info |= (pv[l] == 0.0);
+
+            /* Keep unused and singular lanes finite. */
+            pv[l] = (pv[l] == 0.0) ? 1.0 : pv[l];
+        }
+
+        for (i = k + 1; i < n; i++) {
+            for (l = 0; l < LU_BATCH_LANES; l++) {
+                w[(i + k*n)*LU_BATCH_LANES + l] /= pv[l];
+            }
+        }
+
+        for (j = k + 1; j < n; j++) {
+            for (i = k + 1; i < n; i++) {
+                for (l = 0; l < LU_BATCH_LANES; l++) {
+                    w[(i + j*n)*LU_BATCH_LANES + l] -=
+                        w[(i + k*n)*LU_BATCH_LANES + l] *
+                        w[(k + j*n)*LU_BATCH_LANES + l];
+                }
+            }
+        }
+    }
+
+    return info;
+}
+
+
+/* Factor the 'nl' (<= LU_BATCH_LANES) consecutive n-by-n matrices in
+ * 'lu' in place.  The matrices are gathered into interleaved form, unused
+ * lanes being padded by identity matrices, factored together, and the
+ * factors and pivots are scattered back in DGETRF format. */
+static int
+lu_factor_chunk(int n, int nl, double *lu, MAT_SIZE_T *ipiv)
+{
+    int    i, l, n2, info;
+    int    p[3 * LU_BATCH_LANES];
+    double w[3 * 3 * LU_BATCH_LANES];
+
+    assert (n <= 3);
+
+    n2 = n * n;
+
+    for (i = 0; i < n2; i++) {
+        for (l = 0; l < LU_BATCH_LANES; l++) {
+            w[i*LU_BATCH_LANES + l] =
+                (l < nl) ? lu[l*n2 + i] : (double) ((i % (n + 1)) == 0);
+        }
+    }
+
+    info = lu_factor_lanes(n, w, p);
+
+    for (l = 0; l < nl; l++) {
+        for (i = 0; i < n2; i++) {
+            lu[l*n2 + i] = w[i*LU_BATCH_LANES + l];
+        }
+
+        for (i = 0; i < n; i++) {
+            ipiv[l*n + i] = p[i*LU_BATCH_LANES + l] + 1;
+        }
+    }
+
+    return info;
+}
+
+
+/* Batch kernels: factor all 'nc' consecutive np-by-np matrices of 'A' into
+ * 'lu'/'ipiv' using 'nthreads' threads.  The np=2 and np=3 cases, which
+ * are the only ones arising in practice, use the interleaved kernels
+ * above.  Other sizes use LAPACK. */
+static int
+factorise_batch_small(int nc, int np, int nthreads,
+                      double *lu, MAT_SIZE_T *ipiv)
 {
-    int        np2;
+    int b, nb, c, info = 0;
+
+    nb = (nc + LU_BATCH_LANES - 1) / LU_BATCH_LANES;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static) \
+    private(c) reduction(|:info)
+#endif
+    for (b = 0; b < nb; b++) {
+        c = b * LU_BATCH_LANES;
+
+        info |= lu_factor_chunk(np, MIN(LU_BATCH_LANES, nc - c),
+                                lu + (((size_t) c) * np * np),
+                                ipiv + (((size_t) c) * np));
+    }
+
+    (void) nthreads;
+
+    return info;
+}
+
+
+static int
+factorise_batch_general(int nc, int np, int nthreads,
+                        double *lu, MAT_SIZE_T *ipiv)
+{
+    int        c, ret = 0;
     MAT_SIZE_T m, n, ld, info;
 
     m = n = ld = np;
-    np2 = np * np;
 
-    memcpy (ratio->lu, A, np2 * sizeof *ratio->lu);
-    dgetrf_(&m, &n, ratio->lu, &ld, ratio->ipiv, &info);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static) \
+    private(info) reduction(|:ret)
+#endif
+    for (c = 0; c < nc; c++) {
+        dgetrf_(&m, &n, lu + (((size_t) c) * np * np), &ld,
+                ipiv + (((size_t) c) * np), &info);
+
+        ret |= (info != 0);
+    }
+
+    (void) nthreads;
+
+    return ret;
+}
+
+
+static void
+factorise_fluid_matrices(int nc, int np, const double *Ac,
+                         struct cfs_tpfa_res_impl *pimpl)
+{
+    int info;
+
+    memcpy(pimpl->lu_c, Ac, ((size_t) nc) * np * np * sizeof *pimpl->lu_c);
+
+    switch (np) {
+    case 2:
+    case 3:
+        info = factorise_batch_small(nc, np, pimpl->nthreads,
+                                     pimpl->lu_c, pimpl->ipiv_c);
+        break;
+
+    default:
+        info = factorise_batch_general(nc, np, pimpl->nthreads,
+                                       pimpl->lu_c, pimpl->ipiv_c);
+        break;
+    }
 
     assert (info == 0);
+    (void) info;
+}
+
+
+/* Select the (pre-computed) factorisation of cell 'c's fluid matrix. */
+static void
+factorise_fluid_matrix(int                             c    ,
+                       int                             np   ,
+                       const struct cfs_tpfa_res_impl *pimpl,
+                       struct densrat_util            *ratio)
+{
+    ratio->lu   = pimpl->lu_c   + (((size_t) c) * np * np);
+    ratio->ipiv = pimpl->ipiv_c + (((size_t) c) * np     );
 }
 
 
@@ -305,13 +593,25 @@ solve_linear_systems(int                  np   ,
 {
     MAT_SIZE_T n, ldA, ldB, info;
 
-    n = ldA = ldB = np;
+    switch (np) {
+    case 2:
+        lu_solve_small(2, nrhs, ratio->lu, ratio->ipiv, b);
+        break;
 
-    dgetrs_("No Transpose", &n,
-            &nrhs, ratio->lu, &ldA, ratio->ipiv,
-            b               , &ldB, &info);
+    case 3:
+        lu_solve_small(3, nrhs, ratio->lu, ratio->ipiv, b);
+        break;
 
-    assert (info == 0);
+    default:
+        n = ldA = ldB = np;
+
+        dgetrs_("No Transpose", &n,
+                &nrhs, ratio->lu, &ldA, ratio->ipiv,
+                b               , &ldB, &info);
+
+        assert (info == 0);
+        break;
+    }
 }
 
 
@@ -381,34 +681,40 @@ compute_compflux_and_deriv(struct UnstructuredGrid  *G     ,
                            const double             *Af    ,
                            struct cfs_tpfa_res_impl *pimpl )
 {
-    int     c1, c2, f, np2;
-    double  dp;
-    double *cflux, *dcflux;
-
-    np2    = np * np;
+    int     c1, c2, f, np2, nf;
+    double  dp, *fwork;
 
-    cflux  = pimpl->compflux_f;
-    dcflux = pimpl->compflux_deriv_f;
-
-    for (f = 0; f < G->number_of_faces;
-         f++, pmobf += np, gcapf += np, Af += np2,
-             cflux += np, dcflux += 2 * np) {
+    np2 = np * np;
+    nf  = G->number_of_faces;
 
+    /* Faces are independent.  Each thread uses its own flux_work. */
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(pimpl->nthreads) schedule(static) \
+    private(c1, c2, dp, fwork)
+#endif
+    for (f = 0; f < nf; f++) {
         c1 = G->face_cells[2*f + 0];
         c2 = G->face_cells[2*f + 1];
 
         if ((c1 >= 0) && (c2 >= 0)) {
+#ifdef _OPENMP
+            fwork = pimpl->thread_ratio[ omp_get_thread_num() ]->flux_work;
+#else
+            fwork = pimpl->ratio->flux_work;
+#endif
             dp = cpress[c1] - cpress[c2];
 
-            compute_darcyflux_and_deriv(np, trans[f], dp, pmobf, gcapf,
-                                        pimpl->flux_work,
-                                        pimpl->flux_work + np);
+            compute_darcyflux_and_deriv(np, trans[f], dp,
+                                        pmobf + (f * np), gcapf + (f * np),
+                                        fwork, fwork + np);
 
             /* Component flux = Af * v*/
-            matvec(np, np, Af, pimpl->flux_work     , cflux );
+            matvec(np, np, Af + (f * np2), fwork,
+                   pimpl->compflux_f + (f * np));
 
             /* Derivative = Af * (dv/dp) */
-            matmat(np, 2 , Af, pimpl->flux_work + np, dcflux);
+            matmat(np, 2 , Af + (f * np2), fwork + np,
+                   pimpl->compflux_deriv_f + (f * 2 * np));
         }
 
         /* Boundary connections excluded */
@@ -493,25 +799,26 @@ count_internal_conn(struct UnstructuredGrid *G, int c)
 
 
 static int
-init_cell_contrib(struct UnstructuredGrid  *G    ,
-                  int                       c    ,
-                  int                       np   ,
-                  double                    pvol ,
-                  double                    dt   ,
-                  const double             *z    ,
-                  struct cfs_tpfa_res_impl *pimpl)
+init_cell_contrib(struct UnstructuredGrid        *G    ,
+                  int                             c    ,
+                  int                             np   ,
+                  double                          pvol ,
+                  double                          dt   ,
+                  const double                   *z    ,
+                  const struct cfs_tpfa_res_impl *pimpl,
+                  struct densrat_util            *ratio)
 {
     int     c1, c2, f, i, conn, nconn;
     double *cflx, *dcflx;
 
     nconn = count_internal_conn(G, c);
 
-    memcpy(pimpl->ratio->linsolve_buffer, z, np * sizeof *z);
+    memcpy(ratio->linsolve_buffer, z, np * sizeof *z);
 
-    pimpl->ratio->coeff[0] = -pvol;
+    ratio->coeff[0] = -pvol;
     conn = 1;
 
-    cflx  = pimpl->ratio->linsolve_buffer + (1 * np);
+    cflx  = ratio->linsolve_buffer + (1 * np);
     dcflx = cflx + (nconn * np);
 
     for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
@@ -529,69 +836,71 @@ init_cell_contrib(struct UnstructuredGrid  *G    ,
             cflx  += 1 * np;
             dcflx += 2 * np;
 
-            pimpl->ratio->coeff[ conn++ ] = dt * (2*(c1 == c) - 1.0);
+            ratio->coeff[ conn++ ] = dt * (2*(c1 == c) - 1.0);
         }
     }
 
     assert (conn == nconn + 1);
-    assert (cflx == pimpl->ratio->linsolve_buffer + (nconn + 1)*np);
+    assert (cflx == ratio->linsolve_buffer + (nconn + 1)*np);
 
     return nconn;
 }
 
 
-static void
-compute_cell_contrib(struct UnstructuredGrid  *G    ,
-                     int                       c    ,
-                     int                       np   ,
-                     double                    pvol ,
-                     double                    dt   ,
-                     const double             *z    ,
-                     const double             *Ac   ,
-                     const double             *dAc  ,
-                     struct cfs_tpfa_res_impl *pimpl)
+/* Compute residual and Jacobian row of cell 'c' into 'ratio'.  Reads,
+ * but does not modify, the shared state in 'pimpl'.  Returns whether or
+ * not the cell's fluid matrix is pressure independent. */
+static int
+compute_cell_contrib(struct UnstructuredGrid        *G    ,
+                     int                             c    ,
+                     int                             np   ,
+                     double                          pvol ,
+                     double                          dt   ,
+                     const double                   *z    ,
+                     const double                   *dAc  ,
+                     const struct cfs_tpfa_res_impl *pimpl,
+                     struct densrat_util            *ratio)
 {
-    int        c1, c2, f, i, off, nconn, p;
+    int        c1, c2, f, i, off, nconn, p, is_incomp;
     MAT_SIZE_T nrhs;
     double     s, dF1, dF2, *dv, *dv1, *dv2;
 
-    nconn = init_cell_contrib(G, c, np, pvol, dt, z, pimpl);
+    nconn = init_cell_contrib(G, c, np, pvol, dt, z, pimpl, ratio);
     nrhs  = 1 + (1 + 2)*nconn;  /* [z, Af*v, Af*dv] */
 
-    factorise_fluid_matrix(np, Ac, pimpl->ratio);
-    solve_linear_systems  (np, nrhs, pimpl->ratio,
-                           pimpl->ratio->linsolve_buffer);
+    factorise_fluid_matrix(c, np, pimpl, ratio);
+    solve_linear_systems  (np, nrhs, ratio, ratio->linsolve_buffer);
 
     /* Sum residual contributions over the connections (+ accumulation):
      *   t1 <- (Ac \ [z, Af*v]) * [-pvol; repmat(dt, [nconn, 1])] */
-    matvec(np, nconn + 1, pimpl->ratio->linsolve_buffer,
-           pimpl->ratio->coeff, pimpl->ratio->t1);
+    matvec(np, nconn + 1, ratio->linsolve_buffer,
+           ratio->coeff, ratio->t1);
 
     /* Compute residual in cell 'c' */
-    pimpl->ratio->residual = pvol;
+    ratio->residual = pvol;
     for (p = 0; p < np; p++) {
-        pimpl->ratio->residual += pimpl->ratio->t1[ p ];
+        ratio->residual += ratio->t1[ p ];
     }
 
     /* Jacobian row */
 
     vector_zero(1 + (G->cell_facepos[c + 1] - G->cell_facepos[c]),
-                pimpl->ratio->mat_row);
+                ratio->mat_row);
 
     /* t2 <- A \ ((dA/dp) * t1) */
-    matvec(np, np, dAc, pimpl->ratio->t1, pimpl->ratio->t2);
-    solve_linear_systems(np, 1, pimpl->ratio, pimpl->ratio->t2);
+    matvec(np, np, dAc, ratio->t1, ratio->t2);
+    solve_linear_systems(np, 1, ratio, ratio->t2);
 
     dF2 = 0.0;
     for (p = 0; p < np; p++) {
-        dF2 += pimpl->ratio->t2[ p ];
+        dF2 += ratio->t2[ p ];
     }
 
-    pimpl->is_incomp           = pimpl->is_incomp && (! (fabs(dF2) > 0));
-    pimpl->ratio->mat_row[ 0 ] = - dF2;
+    is_incomp           = ! (fabs(dF2) > 0);
+    ratio->mat_row[ 0 ] = - dF2;
 
     /* Accumulate inter-cell Jacobian contributions */
-    dv  = pimpl->ratio->linsolve_buffer + (1 + nconn)*np;
+    dv  = ratio->linsolve_buffer + (1 + nconn)*np;
     off = 1;
     for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++, off++) {
 
@@ -609,12 +918,14 @@ compute_cell_contrib(struct UnstructuredGrid  *G    ,
                 dF2 += dv2[ p ];
             }
 
-            pimpl->ratio->mat_row[  0  ] += s * dt * dF1;
-            pimpl->ratio->mat_row[ off ] += s * dt * dF2;
+            ratio->mat_row[  0  ] += s * dt * dF1;
+            ratio->mat_row[ off ] += s * dt * dF2;
 
             dv += 2 * np;       /* '2' == number of one-sided derivatives. */
         }
     }
+
+    return is_incomp;
 }
 
 
@@ -636,16 +947,20 @@ assemble_sources(double                    dt ,
 
 /* ---------------------------------------------------------------------- */
 static int
-assemble_cell_contrib(struct UnstructuredGrid  *G,
-                      int                       c,
-                      struct cfs_tpfa_res_data *h)
+assemble_cell_contrib(struct UnstructuredGrid   *G    ,
+                      int                        c    ,
+                      const struct densrat_util *ratio,
+                      struct cfs_tpfa_res_data  *h    )
 /* ---------------------------------------------------------------------- */
 {
     int c1, c2, i, f, j1, j2, off;
 
+    /* Cell 'c' only ever touches row 'c' of the Jacobian and element 'c'
+     * of the residual.  Distinct cells may therefore be assembled
+     * concurrently without further synchronisation. */
     j1 = csrmatrix_elm_index(c, c, h->J);
 
-    h->J->sa[j1] += h->pimpl->ratio->mat_row[ 0 ];
+    h->J->sa[j1] += ratio->mat_row[ 0 ];
 
     off = 1;
     for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++, off++) {
@@ -659,11 +974,11 @@ assemble_cell_contrib(struct UnstructuredGrid  *G,
         if (c2 >= 0) {
             j2 = csrmatrix_elm_index(c, c2, h->J);
 
-            h->J->sa[j2] += h->pimpl->ratio->mat_row[ off ];
+            h->J->sa[j2] += ratio->mat_row[ off ];
         }
     }
 
-    h->F[ c ] = h->pimpl->ratio->residual;
+    h->F[ c ] = ratio->residual;
 
     return 0;
 }
@@ -671,8 +986,8 @@ assemble_cell_contrib(struct UnstructuredGrid  *G,
 
 static void
 init_completion_contrib(int                       i    ,
+                        int                       c    ,
                         int                       np   ,
-                        const double             *Ac   ,
                         const double             *dAc  ,
                         struct cfs_tpfa_res_impl *pimpl)
 {
@@ -685,7 +1000,7 @@ init_completion_contrib(int                       i    ,
            2 * np * sizeof *pimpl->ratio->linsolve_buffer);
 
     /* buffer <- Ac \ [A_{wi}q_{wi}, A_{wi} dq_{wi}] */
-    factorise_fluid_matrix(np, Ac, pimpl->ratio);
+    factorise_fluid_matrix(c, np, pimpl, pimpl->ratio);
     solve_linear_systems  (np, 1 + 2, pimpl->ratio,
                            pimpl->ratio->linsolve_buffer);
 
@@ -915,7 +1230,7 @@ assemble_well_contrib(struct cfs_tpfa_res_wells   *wells ,
     int           is_neumann, is_open;
     double        pw, dp, gpot[3] = { 0.0 };
     const double *WI, *wdp, *pmobp;
-    const double *Ac, *dAc;
+    const double *dAc;
 
     struct Wells        *W;
     struct WellControls *ctrl;
@@ -939,12 +1254,11 @@ assemble_well_contrib(struct cfs_tpfa_res_wells   *wells ,
         for (; i < W->well_connpos[w + 1]; i++, pmobp += np) {
 
             c   = W->well_cells[ i ];
-            Ac  = cq->Ac  + (c * np2);
             dAc = cq->dAc + (c * np2);
 
             dp  = pw + wdp[i] - cpress[ c ];
 
-            init_completion_contrib(i, np, Ac, dAc, h->pimpl);
+            init_completion_contrib(i, c, np, dAc, h->pimpl);
 
             if (is_open) {
                 assemble_completion_to_cell(c, nc + w, np, dt, h);
@@ -1230,30 +1544,54 @@ cfs_tpfa_res_assemble(struct UnstructuredGrid     *G        ,
                       struct cfs_tpfa_res_data    *h        )
 /* ---------------------------------------------------------------------- */
 {
-    int res_is_neumann, well_is_neumann, c, np2, singular;
+    int res_is_neumann, well_is_neumann, c, nc, np, np2, singular;
+    int is_incomp;
+
+    struct densrat_util *ratio;
 
     csrmatrix_zero(         h->J);
     vector_zero   (h->J->m, h->F);
 
-    h->pimpl->is_incomp = 1;
-
     compute_compflux_and_deriv(G, cq->nphases, cpress, trans,
                                cq->phasemobf, gravcap_f, cq->Af, h->pimpl);
 
     res_is_neumann  = 1;
     well_is_neumann = 1;
 
-    np2 = cq->nphases * cq->nphases;
-    for (c = 0; c < G->number_of_cells;
-         c++, zc += cq->nphases) {
+    nc  = G->number_of_cells;
+    np  = cq->nphases;
+    np2 = np * np;
+
+    /* Factor all cell fluid matrices in one batch.  Reused by the cell
+     * and the well completion contributions below. */
+    factorise_fluid_matrices(nc, np, cq->Ac, h->pimpl);
+
+    /* Cell contributions are computed in thread-private scratch and
+     * written into disjoint matrix rows, so the result is independent of
+     * the number of threads. */
+    is_incomp = 1;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(h->pimpl->nthreads) schedule(static) \
+    private(ratio) reduction(&&:is_incomp)
+#endif
+    for (c = 0; c < nc; c++) {
+#ifdef _OPENMP
+        ratio = h->pimpl->thread_ratio[ omp_get_thread_num() ];
+#else
+        ratio = h->pimpl->ratio;
+#endif
 
-        compute_cell_contrib(G, c, cq->nphases, porevol[c], dt, zc,
-                             cq->Ac + (c * np2), cq->dAc + (c * np2),
-                             h->pimpl);
+        is_incomp = compute_cell_contrib(G, c, np, porevol[c], dt,
+                                         zc + (c * np),
+                                         cq->dAc + (c * np2),
+                                         h->pimpl, ratio)
+            && is_incomp;
 
-        assemble_cell_contrib(G, c, h);
+        assemble_cell_contrib(G, c, ratio, h);
     }
 
+    h->pimpl->is_incomp = is_incomp;
+
     if ((forces           != NULL) &&
         (forces->wells    != NULL) &&
         (forces->wells->W != NULL)) {
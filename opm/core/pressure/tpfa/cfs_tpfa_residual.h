@@ -151,6 +151,16 @@ cfs_tpfa_res_destroy(struct cfs_tpfa_res_data *h);
  * The fully assembled system is presented in <CODE>h->J</CODE> and
  * <CODE>h->F</CODE> and must be solved separately using external software.
  *
+ * When built with OpenMP support, the interface and cell contributions are
+ * computed concurrently using at most as many threads as were available
+ * (<CODE>omp_get_max_threads()</CODE>) when the assembler was constructed.
+ * Every cell has its own work space and writes only to its own row of the
+ * Jacobian, so the assembled system does not depend on the number of
+ * threads.
+ *
+ * The cell fluid matrices \f$A_i\f$ are factored once per call, in a single
+ * batch, using fixed-size kernels for two and three phases.
+ *
  * @param[in]     G         Grid.
  * @param[in]     dt        Time step size \f$\Delta t\f$.
  * @param[in]     forces    Driving forces.
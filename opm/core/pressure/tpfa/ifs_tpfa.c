@@ -37,6 +37,8 @@ struct ifs_tpfa_impl {
     double *fgrav;              /* Accumulated grav contrib/face */
     double *work;
 
+    int     is_adjusted;        /* A(0,0) doubled to remove singularity */
+
     /* Linear storage */
     double *ddata;
 };
@@ -78,6 +80,7 @@ impl_allocate(struct UnstructuredGrid *G,
     new = malloc(1 * sizeof *new);
 
     if (new != NULL) {
+        new->is_adjusted = 0;
         new->ddata = malloc(ddata_sz * sizeof *new->ddata);
 
         if (new->ddata == NULL) {
@@ -599,6 +602,7 @@ assemble_incompressible(struct UnstructuredGrid      *G     ,
     double s;
 
     *ok = 1;
+    h->pimpl->is_adjusted = 0;
     csrmatrix_zero(         h->A);
     vector_zero   (h->A->m, h->b);
 
@@ -713,11 +717,85 @@ ifs_tpfa_assemble(struct UnstructuredGrid      *G     ,
     if (ok && system_singular) {
         /* Remove zero eigenvalue associated to constant pressure */
         h->A->sa[0] *= 2.0;
+        h->pimpl->is_adjusted = 1;
     }
     return ok;
 }
 
 
+/* ---------------------------------------------------------------------- */
+void
+ifs_tpfa_update_trans(struct UnstructuredGrid      *G     ,
+                      const struct ifs_tpfa_forces *F     ,
+                      size_t                        nf    ,
+                      const int                    *faces ,
+                      const double                 *dtrans,
+                      struct ifs_tpfa_data         *h     )
+/* ---------------------------------------------------------------------- */
+{
+    int    f, c, c1, c2, is_outflow;
+    size_t k, i, j, ix, j11, j12, j21, j22;
+    double dt, s;
+
+    const struct FlowBoundaryConditions *bc;
+
+    bc = (F != NULL) ? F->bc : NULL;
+
+    if (h->pimpl->is_adjusted) {
+        h->A->sa[0] /= 2.0;
+    }
+
+    for (k = 0; k < nf; k++) {
+        f  = faces [k];
+        dt = dtrans[k];
+        c1 = G->face_cells[2*f + 0];
+        c2 = G->face_cells[2*f + 1];
+
+        if ((c1 >= 0) && (c2 >= 0)) {
+            /* Interior face: same contributions as in
+             * assemble_incompressible(). */
+            j11 = csrmatrix_elm_index(c1, c1, h->A);
+            j12 = csrmatrix_elm_index(c1, c2, h->A);
+            j21 = csrmatrix_elm_index(c2, c1, h->A);
+            j22 = csrmatrix_elm_index(c2, c2, h->A);
+
+            h->A->sa[j11] += dt;
+            h->A->sa[j12] -= dt;
+            h->A->sa[j21] -= dt;
+            h->A->sa[j22] += dt;
+
+            h->b[c1] -= dt * h->pimpl->fgrav[f];
+            h->b[c2] += dt * h->pimpl->fgrav[f];
+        }
+        else if (bc != NULL) {
+            /* Boundary face: contributes only if subject to a pressure
+             * condition, as in assemble_bc_contrib(). */
+            for (i = 0; i < bc->nbc; i++) {
+                if (bc->type[ i ] != BC_PRESSURE) { continue; }
+
+                for (j = bc->cond_pos[ i ]; j < bc->cond_pos[i + 1]; j++) {
+                    if (bc->face[ j ] != f) { continue; }
+
+                    is_outflow = c1 >= 0;
+
+                    s  = 2.0*is_outflow - 1.0;
+                    c  = is_outflow ? c1 : c2;
+                    ix = csrmatrix_elm_index(c, c, h->A);
+
+                    h->A->sa[ ix ] += dt;
+                    h->b    [ c  ] += dt * bc->value[ i ];
+                    h->b    [ c  ] -= s * dt * h->pimpl->fgrav[ f ];
+                }
+            }
+        }
+    }
+
+    if (h->pimpl->is_adjusted) {
+        h->A->sa[0] *= 2.0;
+    }
+}
+
+
 /* ---------------------------------------------------------------------- */
 int
 ifs_tpfa_assemble_comprock(struct UnstructuredGrid      *G        ,
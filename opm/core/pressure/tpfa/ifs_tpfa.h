@@ -30,6 +30,8 @@
  * connection fluxes.
  */
 
+#include <stddef.h>
+
 #include <opm/core/grid.h>
 
 #ifdef __cplusplus
@@ -131,6 +133,38 @@ ifs_tpfa_assemble_comprock_increment(struct UnstructuredGrid      *G        ,
 				     struct ifs_tpfa_data         *h        );
 
 
+/**
+ * Update a system assembled by ifs_tpfa_assemble() or
+ * ifs_tpfa_assemble_comprock() in place following changes to the
+ * transmissibilities of a set of faces, e.g., as computed by
+ * tpfa_trans_update() after a local permeability perturbation.  Only the
+ * matrix coefficients and right-hand side entries of the cells adjacent to
+ * the listed faces are modified, so the cost is independent of the grid
+ * size.  The result equals a full reassembly with the new
+ * transmissibilities and the same driving forces and gravity terms.
+ *
+ * Not applicable to systems assembled by
+ * ifs_tpfa_assemble_comprock_increment(), whose right-hand side depends
+ * on all transmissibilities through the previous pressure.
+ *
+ * @param[in]     G      Grid.
+ * @param[in]     F      Driving forces used in the assembly.  Only the
+ *                       boundary conditions are consulted.
+ * @param[in]     nf     Number of faces.
+ * @param[in]     faces  Distinct faces whose transmissibilities changed.
+ * @param[in]     dtrans Change (new minus old value) of the transmissibility
+ *                       of each listed face.
+ * @param[in,out] h      Assembled system.
+ */
+void
+ifs_tpfa_update_trans(struct UnstructuredGrid      *G     ,
+                      const struct ifs_tpfa_forces *F     ,
+                      size_t                        nf    ,
+                      const int                    *faces ,
+                      const double                 *dtrans,
+                      struct ifs_tpfa_data         *h     );
+
+
 void
 ifs_tpfa_press_flux(struct UnstructuredGrid      *G    ,
                     const struct ifs_tpfa_forces *F    ,
@@ -13,17 +13,14 @@
 #endif
 
 /* ---------------------------------------------------------------------- */
-/* htrans <- sum(C(:,i) .* K(cellNo,:) .* N(:,j), 2) ./ sum(C.*C, 2) */
+/* One-sided transmissibilities of all half-faces of cell 'c'. */
 /* ---------------------------------------------------------------------- */
-void
-tpfa_htrans_compute(struct UnstructuredGrid *G, const double *perm, double *htrans)
+static void
+cell_htrans(struct UnstructuredGrid *G, int c, const double *perm,
+            double *htrans)
 /* ---------------------------------------------------------------------- */
 {
-    #ifdef __cplusplus
-    return tpfa_htrans_compute<UnstructuredGrid>(G, totmob, htrans, trans);
-    #endif
-    
-    int    c, d, f, i, j;
+    int    d, f, i, j;
     double s, dist, denom;
 
     double Kn[3];
@@ -39,33 +36,91 @@ tpfa_htrans_compute(struct UnstructuredGrid *G, const double *perm, double *htra
     incx  = incy     = 1      ;
     a1    = 1.0;  a2 = 0.0    ;
 
-    for (c = i = 0; c < G->number_of_cells; c++) {
-        K  = perm + (c * d * d);
-        cc = G->cell_centroids + (c * d);
+    K  = perm + (c * d * d);
+    cc = G->cell_centroids + (c * d);
 
-        for (; i < G->cell_facepos[c + 1]; i++) {
-            f = G->cell_faces[i];
-            s = 2.0*(G->face_cells[2*f + 0] == c) - 1.0;
+    for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
+        f = G->cell_faces[i];
+        s = 2.0*(G->face_cells[2*f + 0] == c) - 1.0;
 
-            n  = G->face_normals   + (f * d);
-            fc = G->face_centroids + (f * d);
+        n  = G->face_normals   + (f * d);
+        fc = G->face_centroids + (f * d);
 
-            dgemv_("No Transpose", &nrows, &ncols,
-                   &a1, K, &ldA, n, &incx, &a2, &Kn[0], &incy);
+        dgemv_("No Transpose", &nrows, &ncols,
+               &a1, K, &ldA, n, &incx, &a2, &Kn[0], &incy);
 
-            htrans[i] = denom = 0.0;
-            for (j = 0; j < d; j++) {
-                dist = fc[j] - cc[j];
+        htrans[i] = denom = 0.0;
+        for (j = 0; j < d; j++) {
+            dist = fc[j] - cc[j];
 
-                htrans[i] += s * dist * Kn[j];
-                denom     +=     dist * dist;
-            }
+            htrans[i] += s * dist * Kn[j];
+            denom     +=     dist * dist;
+        }
+
+        assert (denom > 0);
+        htrans[i] /= denom;
+        htrans[i]  = fabs(htrans[i]);
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* Two-point transmissibility of face 'f' from one-sided transmissibilities. */
+/* ---------------------------------------------------------------------- */
+static double
+face_trans(struct UnstructuredGrid *G, int f, const double *htrans)
+/* ---------------------------------------------------------------------- */
+{
+    int    j, c, i;
+    double t;
 
-            assert (denom > 0);
-            htrans[i] /= denom;
-            htrans[i]  = fabs(htrans[i]);
+    t = 0.0;
+    for (j = 0; j < 2; j++) {
+        c = G->face_cells[2*f + j];
+
+        if ((c < 0) || ((j == 1) && (c == G->face_cells[2*f + 0]))) {
+            continue;
+        }
+
+        for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
+            if (G->cell_faces[i] == f) {
+                t += 1.0 / htrans[i];
+            }
         }
     }
+
+    return 1.0 / t;
+}
+
+
+/* ---------------------------------------------------------------------- */
+static int
+compare_ints(const void *a, const void *b)
+/* ---------------------------------------------------------------------- */
+{
+    const int ia = *(const int *) a;
+    const int ib = *(const int *) b;
+
+    return (ia > ib) - (ia < ib);
+}
+
+
+/* ---------------------------------------------------------------------- */
+/* htrans <- sum(C(:,i) .* K(cellNo,:) .* N(:,j), 2) ./ sum(C.*C, 2) */
+/* ---------------------------------------------------------------------- */
+void
+tpfa_htrans_compute(struct UnstructuredGrid *G, const double *perm, double *htrans)
+/* ---------------------------------------------------------------------- */
+{
+    #ifdef __cplusplus
+    return tpfa_htrans_compute<UnstructuredGrid>(G, totmob, htrans, trans);
+    #endif
+    
+    int c;
+
+    for (c = 0; c < G->number_of_cells; c++) {
+        cell_htrans(G, c, perm, htrans);
+    }
 }
 
 
@@ -128,3 +183,72 @@ tpfa_eff_trans_compute(struct UnstructuredGrid       *G,
         trans[f] = 1.0 / trans[f];
     }
 }
+
+
+/* ---------------------------------------------------------------------- */
+size_t
+tpfa_cells_faces(struct UnstructuredGrid *G     ,
+                 size_t                   ncells,
+                 const int               *cells ,
+                 int                     *faces )
+/* ---------------------------------------------------------------------- */
+{
+    int    c, i;
+    size_t k, nf, n;
+
+    nf = 0;
+    for (k = 0; k < ncells; k++) {
+        c = cells[k];
+
+        for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
+            faces[nf++] = G->cell_faces[i];
+        }
+    }
+
+    if (nf > 0) {
+        qsort(faces, nf, sizeof *faces, compare_ints);
+
+        for (k = n = 1; k < nf; k++) {
+            if (faces[k] != faces[n - 1]) {
+                faces[n++] = faces[k];
+            }
+        }
+        nf = n;
+    }
+
+    return nf;
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+tpfa_htrans_update(struct UnstructuredGrid *G     ,
+                   const double            *perm  ,
+                   size_t                   ncells,
+                   const int               *cells ,
+                   double                  *htrans)
+/* ---------------------------------------------------------------------- */
+{
+    size_t k;
+
+    for (k = 0; k < ncells; k++) {
+        cell_htrans(G, cells[k], perm, htrans);
+    }
+}
+
+
+/* ---------------------------------------------------------------------- */
+void
+tpfa_trans_update(struct UnstructuredGrid *G     ,
+                  const double            *htrans,
+                  size_t                   nf    ,
+                  const int               *faces ,
+                  double                  *trans )
+/* ---------------------------------------------------------------------- */
+{
+    size_t k;
+
+    for (k = 0; k < nf; k++) {
+        trans[faces[k]] = face_trans(G, faces[k], htrans);
+    }
+}
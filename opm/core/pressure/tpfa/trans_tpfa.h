@@ -25,6 +25,8 @@
  * Routines to assist in the calculation of two-point transmissibilities.
  */
 
+#include <stddef.h>
+
 #include <opm/core/grid.h>
 
 #ifdef __cplusplus
@@ -103,6 +105,67 @@ tpfa_eff_trans_compute(struct UnstructuredGrid *G     ,
                        const double            *htrans,
                        double                  *trans );
 
+/**
+ * Collect the faces of a set of cells, e.g., the cells whose permeability
+ * has changed, for use with tpfa_trans_update().
+ *
+ * @param[in]  G      Grid.
+ * @param[in]  ncells Number of cells.
+ * @param[in]  cells  Cell indices.
+ * @param[out] faces  Distinct faces of the cells, in increasing order.  Array
+ *                    of size at least the total number of half-faces of the
+ *                    cells.
+ * @return Number of distinct faces stored in @c faces.
+ */
+size_t
+tpfa_cells_faces(struct UnstructuredGrid *G     ,
+                 size_t                   ncells,
+                 const int               *cells ,
+                 int                     *faces );
+
+/**
+ * Recompute, in place, the one-sided transmissibilities of a set of cells
+ * following a change in the permeability of those cells.  Equivalent to, but
+ * much cheaper than, calling tpfa_htrans_compute() for the whole grid when
+ * only few cells change.
+ *
+ * @param[in]     G       Grid.
+ * @param[in]     perm    Permeability as for tpfa_htrans_compute().  Only the
+ *                        tensors of the listed cells are accessed.
+ * @param[in]     ncells  Number of cells.
+ * @param[in]     cells   Cells whose permeability has changed.
+ * @param[in,out] htrans  One-sided transmissibilities as defined by function
+ *                        tpfa_htrans_compute().  The entries of the half-faces
+ *                        of the listed cells are updated.
+ */
+void
+tpfa_htrans_update(struct UnstructuredGrid *G     ,
+                   const double            *perm  ,
+                   size_t                   ncells,
+                   const int               *cells ,
+                   double                  *htrans);
+
+/**
+ * Recompute, in place, the two-point transmissibilities of a set of faces,
+ * typically those returned by tpfa_cells_faces() for the cells passed to
+ * tpfa_htrans_update().
+ *
+ * @param[in]     G       Grid.
+ * @param[in]     htrans  One-sided transmissibilities as defined by function
+ *                        tpfa_htrans_compute().
+ * @param[in]     nf      Number of faces.
+ * @param[in]     faces   Faces whose transmissibilities to recompute.
+ * @param[in,out] trans   Interface, two-point transmissibilities as defined by
+ *                        function tpfa_trans_compute().  The entries of the
+ *                        listed faces are updated.
+ */
+void
+tpfa_trans_update(struct UnstructuredGrid *G     ,
+                  const double            *htrans,
+                  size_t                   nf    ,
+                  const int               *faces ,
+                  double                  *trans );
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,11 +24,104 @@
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
 #include <opm/core/utility/compressedToCartesian.hpp>
 #include <opm/core/utility/extractPvtTableIndex.hpp>
+#include <opm/core/utility/buildUniformMonotoneTable.hpp>
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/OpmLog/OpmLog.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <sstream>
 #include <vector>
 #include <numeric>
 
 namespace Opm
 {
+    namespace
+    {
+        // Data points per batch below which evaluation is not split.
+        const int min_points_per_batch = 1024;
+
+        // Call body(begin, end) for contiguous batches covering the data
+        // points [0, n), one batch per thread, in parallel if there are
+        // enough points. Exceptions are rethrown in the calling thread.
+        template <class Body>
+        void forEachBatch(const int n, const int num_threads, const Body& body)
+        {
+            const int num_batches = std::max(1, std::min(num_threads, n / min_points_per_batch));
+            if (num_batches == 1) {
+                body(0, n);
+                return;
+            }
+            std::vector<std::exception_ptr> errors(num_batches);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(num_batches)
+#endif
+            for (int b = 0; b < num_batches; ++b) {
+                const int begin = int(std::int64_t(n) * b / num_batches);
+                const int end = int(std::int64_t(n) * (b + 1) / num_batches);
+                try {
+                    body(begin, end);
+                }
+                catch (...) {
+                    errors[b] = std::current_exception();
+                }
+            }
+            for (int b = 0; b < num_batches; ++b) {
+                if (errors[b]) {
+                    std::rethrow_exception(errors[b]);
+                }
+            }
+        }
+
+        // Offset an optional (possibly null) array.
+        template <class T>
+        T* offsetArray(T* array, const int offset)
+        {
+            return array ? array + offset : array;
+        }
+
+        // Output arrays for the data points from begin on.
+        BlackoilPropertiesInterface::PvtOutput offsetOutput(const BlackoilPropertiesInterface::PvtOutput& out,
+                                                            const int begin,
+                                                            const int np)
+        {
+            BlackoilPropertiesInterface::PvtOutput result;
+            result.B = offsetArray(out.B, np*begin);
+            result.dBdp = offsetArray(out.dBdp, np*begin);
+            result.R = offsetArray(out.R, np*begin);
+            result.dRdp = offsetArray(out.dRdp, np*begin);
+            result.mu = offsetArray(out.mu, np*begin);
+            result.dmudp = offsetArray(out.dmudp, np*begin);
+            result.A = offsetArray(out.A, np*np*begin);
+            result.dAdp = offsetArray(out.dAdp, np*np*begin);
+            result.rho = offsetArray(out.rho, np*begin);
+            return result;
+        }
+
+        // Access to values and pressure derivatives for both plain
+        // doubles and evaluations with a pressure derivative.
+        double valueOf(const double x) { return x; }
+        double derivativeOf(const double) { return 0.0; }
+        void setPressure(double& x, const double p) { x = p; }
+
+        template <class Eval>
+        double valueOf(const Eval& x) { return x.value(); }
+        template <class Eval>
+        double derivativeOf(const Eval& x) { return x.derivative(0); }
+        template <class Eval>
+        void setPressure(Eval& x, const double p) { x.setValue(p); x.setDerivative(0, 1.0); }
+
+        // Workspace of the viscosity() and matrix() overloads without
+        // one, kept per thread so that the many calls with few points,
+        // e.g. one per well perforation, do not allocate.
+        BlackoilPropertiesFromDeck::Workspace& threadWorkspace()
+        {
+            static thread_local BlackoilPropertiesFromDeck::Workspace ws;
+            return ws;
+        }
+    } // anonymous namespace
+
     BlackoilPropertiesFromDeck::BlackoilPropertiesFromDeck(const Opm::Deck& deck,
                                                            const Opm::EclipseState& eclState,
                                                            const UnstructuredGrid& grid,
@@ -127,6 +220,10 @@ namespace Opm
                                                  const int* cart_dims,
                                                  bool init_rock)
     {
+        num_threads_ = 1;
+        pvt_table_error_ = 0.0;
+        pvt_table_derivative_error_ = 0.0;
+
         // retrieve the cell specific PVT table index from the deck
         // and using the grid...
         extractPvtTableIndex(cellPvtRegionIdx_, eclState, number_of_cells, global_cell);
@@ -168,6 +265,23 @@ namespace Opm
         gasPvt_.initFromDeck(deck, eclState);
         waterPvt_.initFromDeck(deck, eclState);
 
+        setNumThreads(param.getDefault("props_threads", 1));
+
+        pvt_table_error_ = 0.0;
+        pvt_table_derivative_error_ = 0.0;
+        const double pvt_table_tolerance = param.getDefault("pvt_table_tolerance", 0.0);
+        if (pvt_table_tolerance > 0.0) {
+            const double error = initPvtTables(param.getDefault("pvt_table_pmin", 1e5),
+                                               param.getDefault("pvt_table_pmax", 1e8),
+                                               param.getDefault("pvt_table_temperature", 273.15 + 20),
+                                               pvt_table_tolerance);
+            std::ostringstream msg;
+            msg << "PVT tables: largest relative interpolation error " << error
+                << " (tolerance " << pvt_table_tolerance << "), "
+                << pvt_table_derivative_error_ << " for the viscosity derivatives.";
+            OpmLog::info(msg.str());
+        }
+
         // Unfortunate lack of pointer smartness here...
         std::string threephase_model = param.getDefault<std::string>("threephase_model", "gwseg");
         if (deck.hasKeyword("ENDSCALE") && threephase_model != "gwseg") {
@@ -177,6 +291,11 @@ namespace Opm
         SaturationPropsFromDeck* ptr
             = new SaturationPropsFromDeck();
         ptr->init(phaseUsageFromDeck(deck), materialLawManager);
+        if (param.getDefault("satfunc_batch", false)) {
+            std::vector<int> satnum;
+            extractSatTableIndex(satnum, eclState, number_of_cells, global_cell);
+            ptr->initBatchEvaluation(satnum);
+        }
         satprops_.reset(ptr);
     }
 
@@ -225,6 +344,113 @@ namespace Opm
         return phaseUsage_;
     }
 
+    void BlackoilPropertiesFromDeck::setNumThreads(const int num_threads)
+    {
+        if (num_threads < 1) {
+            OPM_THROW(std::runtime_error, "Number of threads must be positive, got " << num_threads);
+        }
+        num_threads_ = num_threads;
+    }
+
+    double BlackoilPropertiesFromDeck::initPvtTables(const double pmin,
+                                                     const double pmax,
+                                                     const double temperature,
+                                                     const double tolerance,
+                                                     const int max_samples)
+    {
+        if (!(pmin < pmax) || !(tolerance > 0.0)) {
+            OPM_THROW(std::runtime_error, "Invalid PVT table pressure range [" << pmin << ", " << pmax
+                      << "] or tolerance " << tolerance);
+        }
+        const auto& pu = phaseUsage_;
+        const int np = pu.num_phases;
+        const bool water = pu.phase_used[BlackoilPhases::Aqua];
+        const bool oil = pu.phase_used[BlackoilPhases::Liquid];
+        const bool gas = pu.phase_used[BlackoilPhases::Vapour];
+        const int num_regions = surfaceDensities_.size()/np;
+        const double T = temperature;
+
+        // The curves follow the saturated branches of computePvt_().
+        // As there, the viscosity derivatives are taken at fixed Rs
+        // and Rv, and are tabulated separately. They jump where the
+        // input tables have kinks, so they are sampled like the
+        // viscosities instead of being refined to the tolerance, and
+        // their error is reported separately.
+        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
+        const Eval TEval = T;
+        auto pressure = [](const double p) {
+            Eval pEval;
+            setPressure(pEval, p);
+            return pEval;
+        };
+        std::vector<UniformTableLinear<double> > B(np*num_regions), R(np*num_regions);
+        std::vector<UniformTableLinear<double> > mu(np*num_regions), dmu(np*num_regions);
+        double error = 0.0;
+        double dmu_error = 0.0;
+        for (int region = 0; region < num_regions; ++region) {
+            if (water) {
+                const int t = np*region + pu.phase_pos[BlackoilPhases::Aqua];
+                error = std::max(error, buildUniformTable([&](const double p) {
+                            return 1.0/waterPvt_.inverseFormationVolumeFactor(region, T, p);
+                        }, pmin, pmax, tolerance, max_samples, B[t]));
+                error = std::max(error, buildUniformTable([](const double) {
+                            return 0.0;
+                        }, pmin, pmax, tolerance, max_samples, R[t]));
+                error = std::max(error, buildUniformTable([&](const double p) {
+                            return waterPvt_.viscosity(region, T, p);
+                        }, pmin, pmax, tolerance, max_samples, mu[t]));
+                dmu_error = std::max(dmu_error, sampleUniformTable([&](const double p) {
+                            return waterPvt_.viscosity(region, TEval, pressure(p)).derivative(0);
+                        }, pmin, pmax, mu[t].numSamples(), dmu[t]));
+            }
+            if (oil) {
+                const int t = np*region + pu.phase_pos[BlackoilPhases::Liquid];
+                auto Rs = [&](const double p) {
+                    const double RsSat = oilPvt_.saturatedGasDissolutionFactor(region, T, p);
+                    return gas ? RsSat : std::min(RsSat, 0.0);
+                };
+                error = std::max(error, buildUniformTable([&](const double p) {
+                            return 1.0/oilPvt_.saturatedInverseFormationVolumeFactor(region, T, p);
+                        }, pmin, pmax, tolerance, max_samples, B[t]));
+                error = std::max(error, buildUniformTable(Rs, pmin, pmax, tolerance, max_samples, R[t]));
+                error = std::max(error, buildUniformTable([&](const double p) {
+                            return oilPvt_.viscosity(region, T, p, Rs(p));
+                        }, pmin, pmax, tolerance, max_samples, mu[t]));
+                dmu_error = std::max(dmu_error, sampleUniformTable([&](const double p) {
+                            return oilPvt_.viscosity(region, TEval, pressure(p), Eval(Rs(p))).derivative(0);
+                        }, pmin, pmax, mu[t].numSamples(), dmu[t]));
+            }
+            if (gas) {
+                const int t = np*region + pu.phase_pos[BlackoilPhases::Vapour];
+                auto Rv = [&](const double p) {
+                    const double RvSat = gasPvt_.saturatedOilVaporizationFactor(region, T, p);
+                    return oil ? RvSat : std::min(RvSat, 0.0);
+                };
+                error = std::max(error, buildUniformTable([&](const double p) {
+                            return 1.0/gasPvt_.saturatedInverseFormationVolumeFactor(region, T, p);
+                        }, pmin, pmax, tolerance, max_samples, B[t]));
+                error = std::max(error, buildUniformTable(Rv, pmin, pmax, tolerance, max_samples, R[t]));
+                error = std::max(error, buildUniformTable([&](const double p) {
+                            return gasPvt_.viscosity(region, T, p, Rv(p));
+                        }, pmin, pmax, tolerance, max_samples, mu[t]));
+                dmu_error = std::max(dmu_error, sampleUniformTable([&](const double p) {
+                            return gasPvt_.viscosity(region, TEval, pressure(p), Eval(Rv(p))).derivative(0);
+                        }, pmin, pmax, mu[t].numSamples(), dmu[t]));
+            }
+        }
+
+        pvt_table_pmin_ = pmin;
+        pvt_table_pmax_ = pmax;
+        pvt_table_temperature_ = temperature;
+        pvt_table_error_ = error;
+        pvt_table_derivative_error_ = dmu_error;
+        pvt_table_B_.swap(B);
+        pvt_table_R_.swap(R);
+        pvt_table_mu_.swap(mu);
+        pvt_table_dmu_.swap(dmu);
+        return error;
+    }
+
     /// \param[in]  n      Number of data points.
     /// \param[in]  p      Array of n pressure values.
     /// \param[in]  T      Array of n temperature values.
@@ -241,6 +467,32 @@ namespace Opm
                                                double* mu,
                                                double* dmudp) const
     {
+        const int np = numPhases();
+        forEachBatch(n, num_threads_, [&](const int begin, const int end) {
+                this->viscosity(end - begin, p + begin, T + begin, offsetArray(z, np*begin),
+                                cells + begin, mu + np*begin, offsetArray(dmudp, np*begin),
+                                threadWorkspace());
+            });
+    }
+
+    void BlackoilPropertiesFromDeck::viscosity(const int n,
+                                               const double* p,
+                                               const double* T,
+                                               const double* z,
+                                               const int* cells,
+                                               double* mu,
+                                               double* dmudp,
+                                               Workspace& ws) const
+    {
+        if (!pvt_table_B_.empty()) {
+            // The PVT tables are only used by the fused evaluation.
+            PvtOutput out;
+            out.mu = mu;
+            out.dmudp = dmudp;
+            computePvtSerial_(n, p, T, z, cells, out);
+            return;
+        }
+
         const auto& pu = phaseUsage();
         const int np = numPhases();
 
@@ -254,8 +506,8 @@ namespace Opm
 
         pEval.setDerivative(0, 1.0);
 
-        R_.resize(n*np);
-        this->compute_R_(n, p, T, z, cells, &R_[0]);
+        ws.R.resize(n*np);
+        this->compute_R_(n, p, T, z, cells, ws.R.data());
 
         for (int i = 0; i < n; ++ i) {
             int cellIdx = cells[i];
@@ -265,25 +517,31 @@ namespace Opm
 
             if (pu.phase_used[BlackoilPhases::Aqua]) {
                 muEval = waterPvt_.viscosity(pvtRegionIdx, TEval, pEval);
-                int offset = pu.num_phases*cellIdx + pu.phase_pos[BlackoilPhases::Aqua];
+                int offset = pu.num_phases*i + pu.phase_pos[BlackoilPhases::Aqua];
                 mu[offset] = muEval.value();
-                dmudp[offset] = muEval.derivative(0);
+                if (dmudp) {
+                    dmudp[offset] = muEval.derivative(0);
+                }
             }
 
             if (pu.phase_used[BlackoilPhases::Liquid]) {
-                RsEval.setValue(R_[i*np + pu.phase_pos[BlackoilPhases::Liquid]]);
+                RsEval.setValue(ws.R[i*np + pu.phase_pos[BlackoilPhases::Liquid]]);
                 muEval = oilPvt_.viscosity(pvtRegionIdx, TEval, pEval, RsEval);
-                int offset = pu.num_phases*cellIdx + pu.phase_pos[BlackoilPhases::Liquid];
+                int offset = pu.num_phases*i + pu.phase_pos[BlackoilPhases::Liquid];
                 mu[offset] = muEval.value();
-                dmudp[offset] = muEval.derivative(0);
+                if (dmudp) {
+                    dmudp[offset] = muEval.derivative(0);
+                }
             }
 
             if (pu.phase_used[BlackoilPhases::Vapour]) {
-                RvEval.setValue(R_[i*np + pu.phase_pos[BlackoilPhases::Vapour]]);
+                RvEval.setValue(ws.R[i*np + pu.phase_pos[BlackoilPhases::Vapour]]);
                 muEval = gasPvt_.viscosity(pvtRegionIdx, TEval, pEval, RvEval);
-                int offset = pu.num_phases*cellIdx + pu.phase_pos[BlackoilPhases::Vapour];
+                int offset = pu.num_phases*i + pu.phase_pos[BlackoilPhases::Vapour];
                 mu[offset] = muEval.value();
-                dmudp[offset] = muEval.derivative(0);
+                if (dmudp) {
+                    dmudp[offset] = muEval.derivative(0);
+                }
             }
         }
     }
@@ -307,19 +565,45 @@ namespace Opm
                                             double* A,
                                             double* dAdp) const
     {
+        const int np = numPhases();
+        forEachBatch(n, num_threads_, [&](const int begin, const int end) {
+                this->matrix(end - begin, p + begin, T + begin, offsetArray(z, np*begin),
+                             cells + begin, A + np*np*begin, offsetArray(dAdp, np*np*begin),
+                             threadWorkspace());
+            });
+    }
+
+    void BlackoilPropertiesFromDeck::matrix(const int n,
+                                            const double* p,
+                                            const double* T,
+                                            const double* z,
+                                            const int* cells,
+                                            double* A,
+                                            double* dAdp,
+                                            Workspace& ws) const
+    {
+        if (!pvt_table_B_.empty()) {
+            // The PVT tables are only used by the fused evaluation.
+            PvtOutput out;
+            out.A = A;
+            out.dAdp = dAdp;
+            computePvtSerial_(n, p, T, z, cells, out);
+            return;
+        }
+
         const int np = numPhases();
 
-        B_.resize(n*np);
-        R_.resize(n*np);
+        ws.B.resize(n*np);
+        ws.R.resize(n*np);
         if (dAdp) {
-            dB_.resize(n*np);
-            dR_.resize(n*np);
+            ws.dB.resize(n*np);
+            ws.dR.resize(n*np);
 
-            this->compute_dBdp_(n, p, T, z, cells, &B_[0], &dB_[0]);
-            this->compute_dRdp_(n, p, T, z, cells, &R_[0], &dR_[0]);
+            this->compute_dBdp_(n, p, T, z, cells, ws.B.data(), ws.dB.data());
+            this->compute_dRdp_(n, p, T, z, cells, ws.R.data(), ws.dR.data());
         } else {
-            this->compute_B_(n, p, T, z, cells, &B_[0]);
-            this->compute_R_(n, p, T, z, cells, &R_[0]);
+            this->compute_B_(n, p, T, z, cells, ws.B.data());
+            this->compute_R_(n, p, T, z, cells, ws.R.data());
         }
         const auto& pu = phaseUsage();
         bool oil_and_gas = pu.phase_used[BlackoilPhases::Liquid] &&
@@ -328,18 +612,17 @@ namespace Opm
         const int g = pu.phase_pos[BlackoilPhases::Vapour];
 
         // Compute A matrix
-// #pragma omp parallel for
         for (int i = 0; i < n; ++i) {
             double* m = A + i*np*np;
             std::fill(m, m + np*np, 0.0);
             // Diagonal entries.
             for (int phase = 0; phase < np; ++phase) {
-                m[phase + phase*np] = 1.0/B_[i*np + phase];
+                m[phase + phase*np] = 1.0/ws.B[i*np + phase];
             }
             // Off-diagonal entries.
             if (oil_and_gas) {
-                m[o + g*np] = R_[i*np + g]/B_[i*np + g];
-                m[g + o*np] = R_[i*np + o]/B_[i*np + o];
+                m[o + g*np] = ws.R[i*np + g]/ws.B[i*np + g];
+                m[g + o*np] = ws.R[i*np + o]/ws.B[i*np + o];
             }
         }
 
@@ -353,7 +636,6 @@ namespace Opm
         // The B matrix is diagonal and that fact is exploited in the
         // following implementation.
         if (dAdp) {
-// #pragma omp parallel for
             // (1): dA/dp <- A
             std::copy(A, A + n*np*np, dAdp);
 
@@ -361,7 +643,7 @@ namespace Opm
                 double*       m  = dAdp + i*np*np;
 
                 // (2): dA/dp <- -dA/dp*(dB/dp) == -A*(dB/dp)
-                const double* dB = & dB_[i * np];
+                const double* dB = & ws.dB[i * np];
                 for (int col = 0; col < np; ++col) {
                     for (int row = 0; row < np; ++row) {
                         m[col*np + row] *= - dB[ col ]; // Note sign.
@@ -370,14 +652,14 @@ namespace Opm
 
                 if (oil_and_gas) {
                     // (2b): dA/dp += dR/dp (== dR/dp - A*(dB/dp))
-                    const double* dR = & dR_[i * np];
+                    const double* dR = & ws.dR[i * np];
 
                     m[o*np + g] += dR[ o ];
                     m[g*np + o] += dR[ g ];
                 }
 
                 // (3): dA/dp *= inv(B) (== final result)
-                const double* B = & B_[i * np];
+                const double* B = & ws.B[i * np];
                 for (int col = 0; col < np; ++col) {
                     for (int row = 0; row < np; ++row) {
                         m[col*np + row] /= B[ col ];
@@ -387,6 +669,242 @@ namespace Opm
         }
     }
 
+    /// \param[in]  n      Number of data points.
+    /// \param[in]  p      Array of n pressure values.
+    /// \param[in]  T      Array of n temperature values.
+    /// \param[in]  z      Array of nP surface volume values.
+    /// \param[in]  cells  Array of n cell indices to be associated with the p and z values.
+    /// \param[out] out    Output arrays, see BlackoilPropertiesInterface::PvtOutput.
+    void BlackoilPropertiesFromDeck::pvtProperties(const int n,
+                                                   const double* p,
+                                                   const double* T,
+                                                   const double* z,
+                                                   const int* cells,
+                                                   const PvtOutput& out) const
+    {
+        const int np = numPhases();
+        forEachBatch(n, num_threads_, [&](const int begin, const int end) {
+                this->computePvtSerial_(end - begin, p + begin, T + begin, offsetArray(z, np*begin),
+                                        cells + begin, offsetOutput(out, begin, np));
+            });
+    }
+
+    void BlackoilPropertiesFromDeck::computePvtSerial_(const int n,
+                                                       const double* p,
+                                                       const double* T,
+                                                       const double* z,
+                                                       const int* cells,
+                                                       const PvtOutput& out) const
+    {
+        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
+        if (out.dBdp || out.dRdp || out.dmudp || out.dAdp) {
+            computePvt_<Eval>(n, p, T, z, cells, out);
+        } else {
+            computePvt_<double>(n, p, T, z, cells, out);
+        }
+    }
+
+    template <class Eval>
+    void BlackoilPropertiesFromDeck::computePvt_(const int n,
+                                                 const double* p,
+                                                 const double* T,
+                                                 const double* z,
+                                                 const int* cells,
+                                                 const PvtOutput& out) const
+    {
+        typedef Opm::MathToolbox<Eval> Toolbox;
+        const auto& pu = phaseUsage_;
+        const int np = pu.num_phases;
+        const bool water = pu.phase_used[BlackoilPhases::Aqua];
+        const bool oil = pu.phase_used[BlackoilPhases::Liquid];
+        const bool gas = pu.phase_used[BlackoilPhases::Vapour];
+        const int w = pu.phase_pos[BlackoilPhases::Aqua];
+        const int o = pu.phase_pos[BlackoilPhases::Liquid];
+        const int g = pu.phase_pos[BlackoilPhases::Vapour];
+        const bool need_A = out.A || out.dAdp || out.rho;
+
+        Eval pEval = 0.0;
+        Eval TEval = 0.0;
+
+        // Per-point B, R and derivatives.
+        double B[BlackoilPhases::MaxNumPhases];
+        double dB[BlackoilPhases::MaxNumPhases];
+        double R[BlackoilPhases::MaxNumPhases];
+        double dR[BlackoilPhases::MaxNumPhases];
+        double mu[BlackoilPhases::MaxNumPhases];
+        double dmu[BlackoilPhases::MaxNumPhases];
+        double A_local[BlackoilPhases::MaxNumPhases*BlackoilPhases::MaxNumPhases];
+
+        const bool use_tables = !pvt_table_B_.empty();
+        for (int i = 0; i < n; ++i) {
+            const int cellIdx = cells[i];
+            const int pvtRegionIdx = cellPvtRegionIdx_[cellIdx];
+            setPressure(pEval, p[i]);
+            TEval = T[i];
+
+            // Points covered by the PVT tables, see initPvtTables().
+            const bool tabulated = use_tables && T[i] == pvt_table_temperature_
+                && p[i] >= pvt_table_pmin_ && p[i] <= pvt_table_pmax_;
+            const int table = np*pvtRegionIdx;
+            auto lookup = [&](const int phase) {
+                const int t = table + phase;
+                B[phase] = pvt_table_B_[t](p[i]);
+                dB[phase] = pvt_table_B_[t].derivative(p[i]);
+                R[phase] = pvt_table_R_[t](p[i]);
+                dR[phase] = pvt_table_R_[t].derivative(p[i]);
+                mu[phase] = pvt_table_mu_[t](p[i]);
+                dmu[phase] = pvt_table_dmu_[t](p[i]);
+            };
+
+            if (water && tabulated) {
+                lookup(w);
+            }
+            else if (water) {
+                const Eval BEval = 1.0/waterPvt_.inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                B[w] = valueOf(BEval);
+                dB[w] = derivativeOf(BEval);
+                R[w] = 0.0; // water is always immiscible!
+                dR[w] = 0.0;
+                if (out.mu || out.dmudp) {
+                    const Eval muEval = waterPvt_.viscosity(pvtRegionIdx, TEval, pEval);
+                    mu[w] = valueOf(muEval);
+                    dmu[w] = derivativeOf(muEval);
+                }
+            }
+
+            if (oil) {
+                double currentRs = 0.0;
+                if (gas) {
+                    currentRs = (z[np*i + o] == 0.0) ? 0.0 : z[np*i + g]/z[np*i + o];
+                }
+                // The tables only hold the saturated curves.
+                if (tabulated && (!gas || currentRs >= pvt_table_R_[table + o](p[i]))) {
+                    lookup(o);
+                }
+                else {
+                    const Eval RsSatEval = oilPvt_.saturatedGasDissolutionFactor(pvtRegionIdx, TEval, pEval);
+                    const double maxRs = gas ? valueOf(RsSatEval) : 0.0;
+                    Eval BEval;
+                    if (currentRs >= maxRs) {
+                        BEval = 1.0/oilPvt_.saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                    }
+                    else {
+                        const Eval RsEval = currentRs;
+                        BEval = 1.0/oilPvt_.inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RsEval);
+                    }
+                    const Eval REval = Toolbox::min(RsSatEval, Eval(currentRs));
+                    B[o] = valueOf(BEval);
+                    dB[o] = derivativeOf(BEval);
+                    R[o] = valueOf(REval);
+                    dR[o] = derivativeOf(REval);
+                    if (out.mu || out.dmudp) {
+                        const Eval RsEval = R[o];
+                        const Eval muEval = oilPvt_.viscosity(pvtRegionIdx, TEval, pEval, RsEval);
+                        mu[o] = valueOf(muEval);
+                        dmu[o] = derivativeOf(muEval);
+                    }
+                }
+            }
+
+            if (gas) {
+                double currentRv = 0.0;
+                if (oil) {
+                    currentRv = (z[np*i + g] == 0.0) ? 0.0 : z[np*i + o]/z[np*i + g];
+                }
+                if (tabulated && (!oil || currentRv >= pvt_table_R_[table + g](p[i]))) {
+                    lookup(g);
+                }
+                else {
+                    const Eval RvSatEval = gasPvt_.saturatedOilVaporizationFactor(pvtRegionIdx, TEval, pEval);
+                    const double maxRv = oil ? valueOf(RvSatEval) : 0.0;
+                    Eval BEval;
+                    if (currentRv >= maxRv) {
+                        BEval = 1.0/gasPvt_.saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                    }
+                    else {
+                        const Eval RvEval = currentRv;
+                        BEval = 1.0/gasPvt_.inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RvEval);
+                    }
+                    const Eval REval = Toolbox::min(RvSatEval, Eval(currentRv));
+                    B[g] = valueOf(BEval);
+                    dB[g] = derivativeOf(BEval);
+                    R[g] = valueOf(REval);
+                    dR[g] = derivativeOf(REval);
+                    if (out.mu || out.dmudp) {
+                        const Eval RvEval = R[g];
+                        const Eval muEval = gasPvt_.viscosity(pvtRegionIdx, TEval, pEval, RvEval);
+                        mu[g] = valueOf(muEval);
+                        dmu[g] = derivativeOf(muEval);
+                    }
+                }
+            }
+
+            for (int phase = 0; phase < np; ++phase) {
+                if (out.B) {
+                    out.B[np*i + phase] = B[phase];
+                }
+                if (out.dBdp) {
+                    out.dBdp[np*i + phase] = dB[phase];
+                }
+                if (out.R) {
+                    out.R[np*i + phase] = R[phase];
+                }
+                if (out.dRdp) {
+                    out.dRdp[np*i + phase] = dR[phase];
+                }
+                if (out.mu) {
+                    out.mu[np*i + phase] = mu[phase];
+                }
+                if (out.dmudp) {
+                    out.dmudp[np*i + phase] = dmu[phase];
+                }
+            }
+
+            // A matrix and its derivative, as in matrix().
+            double* m = out.A ? out.A + i*np*np : A_local;
+            if (need_A) {
+                std::fill(m, m + np*np, 0.0);
+                for (int phase = 0; phase < np; ++phase) {
+                    m[phase + phase*np] = 1.0/B[phase];
+                }
+                if (oil && gas) {
+                    m[o + g*np] = R[g]/B[g];
+                    m[g + o*np] = R[o]/B[o];
+                }
+            }
+            if (out.dAdp) {
+                // dA/dp = (dR/dp - A*(dB/dp)) * inv(B), see matrix().
+                double* dm = out.dAdp + i*np*np;
+                for (int col = 0; col < np; ++col) {
+                    for (int row = 0; row < np; ++row) {
+                        dm[col*np + row] = m[col*np + row] * - dB[col];
+                    }
+                }
+                if (oil && gas) {
+                    dm[o*np + g] += dR[o];
+                    dm[g*np + o] += dR[g];
+                }
+                for (int col = 0; col < np; ++col) {
+                    for (int row = 0; row < np; ++row) {
+                        dm[col*np + row] /= B[col];
+                    }
+                }
+            }
+
+            // Densities, as in density().
+            if (out.rho) {
+                const double* sdens = surfaceDensity(cellIdx);
+                for (int phase = 0; phase < np; ++phase) {
+                    double rho = 0.0;
+                    for (int comp = 0; comp < np; ++comp) {
+                        rho += m[np*phase + comp]*sdens[comp];
+                    }
+                    out.rho[np*i + phase] = rho;
+                }
+            }
+        }
+    }
+
     void BlackoilPropertiesFromDeck::compute_B_(const int n,
                                                 const double* p,
                                                 const double* T,
@@ -668,17 +1186,18 @@ namespace Opm
                                              double* rho) const
     {
         const int np = numPhases();
-// #pragma omp parallel for
-        for (int i = 0; i < n; ++i) {
-            int cellIdx = cells?cells[i]:i;
-            const double *sdens = surfaceDensity(cellIdx);
-            for (int phase = 0; phase < np; ++phase) {
-                rho[np*i + phase] = 0.0;
-                for (int comp = 0; comp < np; ++comp) {
-                    rho[np*i + phase] += A[i*np*np + np*phase + comp]*sdens[comp];
+        forEachBatch(n, num_threads_, [&](const int begin, const int end) {
+                for (int i = begin; i < end; ++i) {
+                    int cellIdx = cells?cells[i]:i;
+                    const double *sdens = surfaceDensity(cellIdx);
+                    for (int phase = 0; phase < np; ++phase) {
+                        rho[np*i + phase] = 0.0;
+                        for (int comp = 0; comp < np; ++comp) {
+                            rho[np*i + phase] += A[i*np*np + np*phase + comp]*sdens[comp];
+                        }
+                    }
                 }
-            }
-        }
+            });
     }
 
     /// Densities of stock components at surface conditions.
@@ -733,7 +1252,11 @@ namespace Opm
                                              double* kr,
                                              double* dkrds) const
     {
-        satprops_->relperm(n, s, cells, kr, dkrds);
+        const int np = numPhases();
+        forEachBatch(n, num_threads_, [&](const int begin, const int end) {
+                satprops_->relperm(end - begin, s + np*begin, cells + begin,
+                                   kr + np*begin, offsetArray(dkrds, np*np*begin));
+            });
     }
 
 
@@ -752,7 +1275,11 @@ namespace Opm
                                               double* pc,
                                               double* dpcds) const
     {
-        satprops_->capPress(n, s, cells, pc, dpcds);
+        const int np = numPhases();
+        forEachBatch(n, num_threads_, [&](const int begin, const int end) {
+                satprops_->capPress(end - begin, s + np*begin, cells + begin,
+                                    pc + np*begin, offsetArray(dpcds, np*np*begin));
+            });
     }
 
 
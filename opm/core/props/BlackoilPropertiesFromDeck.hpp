@@ -24,6 +24,7 @@
 #include <opm/core/props/BlackoilPropertiesInterface.hpp>
 #include <opm/core/props/rock/RockFromDeck.hpp>
 #include <opm/core/props/satfunc/SaturationPropsFromDeck.hpp>
+#include <opm/core/utility/UniformTableLinear.hpp>
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
 #include <opm/material/fluidsystems/blackoilpvt/OilPvtMultiplexer.hpp>
 #include <opm/material/fluidsystems/blackoilpvt/GasPvtMultiplexer.hpp>
@@ -32,6 +33,7 @@
 #include <opm/parser/eclipse/Deck/Deck.hpp>
 
 #include <memory>
+#include <vector>
 
 struct UnstructuredGrid;
 
@@ -45,6 +47,17 @@ namespace Opm
     public:
         typedef typename SaturationPropsFromDeck::MaterialLawManager MaterialLawManager;
 
+        /// Scratch arrays for the formation volume and dissolution
+        /// factors used by viscosity() and matrix(). A workspace may
+        /// be reused between calls, but not shared by concurrent calls.
+        struct Workspace
+        {
+            std::vector<double> B;
+            std::vector<double> dB;
+            std::vector<double> R;
+            std::vector<double> dR;
+        };
+
         /// Initialize from deck and grid.
         /// \param[in]  deck     Deck input parser
         /// \param[in]  grid     Grid to which property object applies, needed for the
@@ -63,6 +76,13 @@ namespace Opm
         ///                        pvt_tab_size (200)          number of uniform sample points for dead-oil pvt tables.
         ///                        sat_tab_size (200)          number of uniform sample points for saturation tables.
         ///                        threephase_model("simple")  three-phase relperm model (accepts "simple" and "stone2").
+        ///                        props_threads (1)           number of threads for property evaluation, see setNumThreads().
+        ///                        satfunc_batch (false)       evaluate saturation functions in batches of cells that
+        ///                                                    share them, see SaturationPropsFromDeck::initBatchEvaluation().
+        ///                        pvt_table_tolerance (0)     if positive, use uniform PVT tables with this relative
+        ///                                                    error, see initPvtTables().
+        ///                        pvt_table_pmin (1e5), pvt_table_pmax (1e8), pvt_table_temperature (293.15)
+        ///                                                    pressure range [Pa] and temperature [K] of the tables.
         ///                      For both size parameters, a 0 or negative value indicates that no spline fitting is to
         ///                      be done, and the input fluid data used directly for linear interpolation.
         BlackoilPropertiesFromDeck(const Opm::Deck& deck,
@@ -145,6 +165,18 @@ namespace Opm
                                double* mu,
                                double* dmudp) const;
 
+        /// As viscosity() above, but serial and using the given
+        /// workspace instead of one owned by the calling thread.
+        /// Concurrent calls with different workspaces are safe.
+        void viscosity(const int n,
+                       const double* p,
+                       const double* T,
+                       const double* z,
+                       const int* cells,
+                       double* mu,
+                       double* dmudp,
+                       Workspace& ws) const;
+
         /// \param[in]  n      Number of data points.
         /// \param[in]  p      Array of n pressure values.
         /// \param[in]  T      Array of n temperature values.
@@ -164,6 +196,18 @@ namespace Opm
                             double* A,
                             double* dAdp) const;
 
+        /// As matrix() above, but serial and using the given
+        /// workspace instead of one owned by the calling thread.
+        /// Concurrent calls with different workspaces are safe.
+        void matrix(const int n,
+                    const double* p,
+                    const double* T,
+                    const double* z,
+                    const int* cells,
+                    double* A,
+                    double* dAdp,
+                    Workspace& ws) const;
+
 
         /// Densities of stock components at reservoir conditions.
         /// \param[in]  n      Number of data points.
@@ -182,6 +226,24 @@ namespace Opm
         /// \return Array of P density values.
         virtual const double* surfaceDensity(int cellIdx = 0) const;
 
+        /// Compute any of B, R, mu, A, rho and their pressure
+        /// derivatives in one pass over the data points, looking up
+        /// the PVT region and evaluating each PVT function once per
+        /// point and phase. The results are the same as from the
+        /// separate viscosity(), matrix() and density() calls.
+        /// \param[in]  n      Number of data points.
+        /// \param[in]  p      Array of n pressure values.
+        /// \param[in]  T      Array of n temperature values.
+        /// \param[in]  z      Array of nP surface volume values.
+        /// \param[in]  cells  Array of n cell indices to be associated with the p and z values.
+        /// \param[out] out    Output arrays, see BlackoilPropertiesInterface::PvtOutput.
+        virtual void pvtProperties(const int n,
+                                   const double* p,
+                                   const double* T,
+                                   const double* z,
+                                   const int* cells,
+                                   const PvtOutput& out) const;
+
         /// \param[in]  n      Number of data points.
         /// \param[in]  s      Array of nP saturation values.
         /// \param[in]  cells  Array of n cell indices to be associated with the s values.
@@ -235,6 +297,57 @@ namespace Opm
                                       const double pcow, 
                                       double & swat);
 
+        /// Set the number of threads used by viscosity(), matrix(),
+        /// density(), relperm() and capPress(). Each call splits its
+        /// data points into contiguous batches, one per thread, and
+        /// only batches of more than a thousand points or so are
+        /// evaluated in parallel. Results do not depend on the number
+        /// of threads. Without OpenMP support the batches are
+        /// evaluated in sequence. The default is one thread.
+        void setNumThreads(const int num_threads);
+
+        /// Number of threads used for property evaluation.
+        int numThreads() const
+        {
+            return num_threads_;
+        }
+
+        /// Evaluate PVT properties by lookup in uniform tables in
+        /// pressure, for pressures in [pmin, pmax] at the given
+        /// temperature. For each PVT region the formation volume
+        /// factors, the saturated Rs and Rv, and the viscosities along
+        /// the saturated curves are sampled from the PVT objects, with
+        /// enough samples for linear interpolation to be within the
+        /// relative tolerance (see buildUniformTable()), but at most
+        /// max_samples. The viscosity derivatives at fixed Rs and Rv
+        /// are sampled at the same pressures as the viscosities, see
+        /// pvtTableDerivativeError(). Undersaturated oil and gas, other
+        /// temperatures and pressures outside the tables are evaluated
+        /// as before. Used by viscosity(), matrix() and pvtProperties().
+        /// \return  The largest relative error of the tables, not
+        ///          counting the viscosity derivatives.
+        double initPvtTables(const double pmin,
+                             const double pmax,
+                             const double temperature,
+                             const double tolerance,
+                             const int max_samples = 1 << 16);
+
+        /// The largest relative error of the PVT tables, or zero if
+        /// initPvtTables() has not been called.
+        double pvtTableError() const
+        {
+            return pvt_table_error_;
+        }
+
+        /// The largest relative error of the viscosity derivative
+        /// tables, or zero if initPvtTables() has not been called.
+        /// The derivatives jump at the kinks of piecewise linear input
+        /// tables, so this is typically not small.
+        double pvtTableDerivativeError() const
+        {
+            return pvt_table_derivative_error_;
+        }
+
         const OilPvtMultiplexer<double>& oilPvt() const
         {
             return oilPvt_;
@@ -290,6 +403,21 @@ namespace Opm
                            double* R,
                            double* dRdp) const;
 
+        void computePvtSerial_(const int n,
+                               const double* p,
+                               const double* T,
+                               const double* z,
+                               const int* cells,
+                               const PvtOutput& out) const;
+
+        template <class Eval>
+        void computePvt_(const int n,
+                         const double* p,
+                         const double* T,
+                         const double* z,
+                         const int* cells,
+                         const PvtOutput& out) const;
+
         void init(const Opm::Deck& deck,
                   const Opm::EclipseState& eclState,
                   std::shared_ptr<MaterialLawManager> materialLawManager,
@@ -316,10 +444,21 @@ namespace Opm
         std::shared_ptr<MaterialLawManager> materialLawManager_;
         std::shared_ptr<SaturationPropsInterface> satprops_;
         std::vector<double> surfaceDensities_;
-        mutable std::vector<double> B_;
-        mutable std::vector<double> dB_;
-        mutable std::vector<double> R_;
-        mutable std::vector<double> dR_;
+        int num_threads_;
+
+        // PVT tables, see initPvtTables(). Entry np*region + phase
+        // holds the curve of the phase, and the vectors are empty if
+        // tables are not used. pvt_table_dmu_ holds the viscosity
+        // derivatives at fixed Rs or Rv.
+        double pvt_table_pmin_;
+        double pvt_table_pmax_;
+        double pvt_table_temperature_;
+        double pvt_table_error_;
+        double pvt_table_derivative_error_;
+        std::vector<UniformTableLinear<double> > pvt_table_B_;
+        std::vector<UniformTableLinear<double> > pvt_table_R_;
+        std::vector<UniformTableLinear<double> > pvt_table_mu_;
+        std::vector<UniformTableLinear<double> > pvt_table_dmu_;
     };
 
 
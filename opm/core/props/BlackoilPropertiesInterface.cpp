@@ -0,0 +1,103 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <opm/core/props/BlackoilPropertiesInterface.hpp>
+
+#include <vector>
+
+namespace Opm
+{
+
+    void BlackoilPropertiesInterface::pvtProperties(const int n,
+                                                    const double* p,
+                                                    const double* T,
+                                                    const double* z,
+                                                    const int* cells,
+                                                    const PvtOutput& out) const
+    {
+        const int np = numPhases();
+        const bool need_dA = out.dAdp || out.dBdp || out.dRdp;
+        // The derivatives of B and R are computed from A as well.
+        const bool need_A = out.A || out.B || out.R || out.rho || need_dA;
+        std::vector<double> A_storage, dA_storage;
+        double* A = out.A;
+        double* dA = out.dAdp;
+        if (need_A && !A) {
+            A_storage.resize(n*np*np);
+            A = A_storage.data();
+        }
+        if (need_dA && !dA) {
+            dA_storage.resize(n*np*np);
+            dA = dA_storage.data();
+        }
+        if (need_A) {
+            matrix(n, p, T, z, cells, A, dA);
+        }
+        if (out.mu || out.dmudp) {
+            std::vector<double> mu_storage;
+            double* mu = out.mu;
+            if (!mu) {
+                mu_storage.resize(n*np);
+                mu = mu_storage.data();
+            }
+            viscosity(n, p, T, z, cells, mu, out.dmudp);
+        }
+        if (out.rho) {
+            density(n, A, cells, out.rho);
+        }
+        if (!(out.B || out.dBdp || out.R || out.dRdp)) {
+            return;
+        }
+        // With B diagonal, A_pp = 1/B_p, and A_og = R_g/B_g, A_go = R_o/B_o.
+        const PhaseUsage pu = phaseUsage();
+        const bool oil_and_gas = pu.phase_used[BlackoilPhases::Liquid]
+            && pu.phase_used[BlackoilPhases::Vapour];
+        const int o = pu.phase_pos[BlackoilPhases::Liquid];
+        const int g = pu.phase_pos[BlackoilPhases::Vapour];
+        for (int i = 0; i < n; ++i) {
+            const double* m = A + i*np*np;
+            const double* dm = need_dA ? dA + i*np*np : 0;
+            for (int phase = 0; phase < np; ++phase) {
+                const int other = (phase == o) ? g : o;
+                const bool miscible = oil_and_gas && (phase == o || phase == g);
+                const double B = 1.0/m[phase + phase*np];
+                const double R = miscible ? m[other + phase*np]*B : 0.0;
+                if (out.B) {
+                    out.B[i*np + phase] = B;
+                }
+                if (out.R) {
+                    out.R[i*np + phase] = R;
+                }
+                if (dm) {
+                    // d(1/B)/dp = -dB/dp / B^2, d(R/B)/dp = dR/dp / B - R dB/dp / B^2.
+                    const double dB = -dm[phase + phase*np]*B*B;
+                    if (out.dBdp) {
+                        out.dBdp[i*np + phase] = dB;
+                    }
+                    if (out.dRdp) {
+                        out.dRdp[i*np + phase] = miscible ? B*dm[other + phase*np] + R*dB/B : 0.0;
+                    }
+                }
+            }
+        }
+    }
+
+
+} // namespace Opm
@@ -20,11 +20,13 @@
 #ifndef OPM_BLACKOILPROPERTIESINTERFACE_HEADER_INCLUDED
 #define OPM_BLACKOILPROPERTIESINTERFACE_HEADER_INCLUDED
 
+#include <opm/core/props/BlackoilPhases.hpp>
+
+#include <vector>
+
 namespace Opm
 {
 
-    struct PhaseUsage;
-
     /// Abstract base class for blackoil fluid and reservoir properties.
     /// Supports variable number of spatial dimensions, called D.
     /// Supports variable number of phases, but assumes that
@@ -121,6 +123,45 @@ namespace Opm
         /// \return Array of P density values.
         virtual const double* surfaceDensity(int regionIdx = 0) const = 0;
 
+        /// Output arrays of pvtProperties(). Each array must be valid
+        /// before calling, or null if the quantity is not wanted.
+        /// B, dBdp, R, dRdp, mu, dmudp and rho take nP values, A and
+        /// dAdp take nP^2 values ordered as by matrix().
+        struct PvtOutput
+        {
+            PvtOutput()
+                : B(0), dBdp(0), R(0), dRdp(0), mu(0), dmudp(0), A(0), dAdp(0), rho(0)
+            {
+            }
+            double* B;     ///< Formation volume factors.
+            double* dBdp;  ///< Pressure derivatives of B.
+            double* R;     ///< Dissolution factors: Rs for oil, Rv for gas, 0 for water.
+            double* dRdp;  ///< Pressure derivatives of R.
+            double* mu;    ///< Viscosities, as from viscosity().
+            double* dmudp; ///< Pressure derivatives of mu.
+            double* A;     ///< The matrices A = RB^{-1}, as from matrix().
+            double* dAdp;  ///< Pressure derivatives of A.
+            double* rho;   ///< Densities, as from density().
+        };
+
+        /// Compute any of the quantities of PvtOutput for the same data
+        /// points in one call. Implementations may evaluate the PVT
+        /// functions once per data point for all the quantities.
+        /// The default implementation calls matrix(), viscosity() and
+        /// density(), and derives B and R from A.
+        /// \param[in]  n      Number of data points.
+        /// \param[in]  p      Array of n pressure values.
+        /// \param[in]  T      Array of n temperature values.
+        /// \param[in]  z      Array of nP surface volume values.
+        /// \param[in]  cells  Array of n cell indices to be associated with the p and z values.
+        /// \param[out] out    Output arrays.
+        virtual void pvtProperties(const int n,
+                                   const double* p,
+                                   const double* T,
+                                   const double* z,
+                                   const int* cells,
+                                   const PvtOutput& out) const;
+
         /// \param[in]  n      Number of data points.
         /// \param[in]  s      Array of nP saturation values.
         /// \param[in]  cells  Array of n cell indices to be associated with the s values.
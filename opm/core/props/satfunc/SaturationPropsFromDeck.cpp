@@ -28,19 +28,41 @@
 #include <opm/core/simulator/ExplicitArraysFluidState.hpp>
 #include <opm/core/simulator/ExplicitArraysSatDerivativesFluidState.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <numeric>
+#include <utility>
 
 namespace Opm
 {
 
     typedef SaturationPropsFromDeck::MaterialLawManager::MaterialLaw MaterialLaw;
 
+    namespace
+    {
+        // The scaled end points of a cell, in a fixed order.
+        template <class EpsInfo>
+        std::vector<double> endPointKey(const EpsInfo& info)
+        {
+            return {
+                info.Swl, info.Sgl, info.Sowl, info.Sogl,
+                info.Swcr, info.Sgcr, info.Sowcr, info.Sogcr,
+                info.Swu, info.Sgu, info.Sowu, info.Sogu,
+                info.maxPcow, info.maxPcgo,
+                info.pcowLeverettFactor, info.pcgoLeverettFactor,
+                info.maxKrw, info.maxKrow, info.maxKrog, info.maxKrg
+            };
+        }
+    } // anonymous namespace
+
     // ----------- Methods of SaturationPropsFromDeck ---------
 
 
     /// Default constructor.
     SaturationPropsFromDeck::SaturationPropsFromDeck()
+        : batch_enabled_(true)
     {
     }
 
@@ -50,6 +72,68 @@ namespace Opm
     {
         phaseUsage_ = phaseUsage;
         materialLawManager_ = materialLawManager;
+        cell_class_.clear();
+        class_start_.clear();
+        class_members_.clear();
+        class_rep_.clear();
+    }
+
+    /// Set up batch evaluation of relperm() and capPress().
+    void SaturationPropsFromDeck::initBatchEvaluation(const std::vector<int>& satnum)
+    {
+        cell_class_.clear();
+        class_start_.clear();
+        class_members_.clear();
+        class_rep_.clear();
+        if (materialLawManager_->enableHysteresis()) {
+            return;
+        }
+
+        // The scaled end points are compared exactly, field by field,
+        // so cells end up in the same class only if their parameters
+        // are built from identical input.
+        const int nc = satnum.size();
+        typedef std::pair<int, std::vector<double> > Key;
+        std::map<Key, int> class_index;
+        std::vector<int> cell_class(nc);
+        for (int cell = 0; cell < nc; ++cell) {
+            const Key key(satnum[cell],
+                          endPointKey(materialLawManager_->oilWaterScaledEpsInfoDrainage(cell)));
+            const auto it = class_index.insert(std::make_pair(key, int(class_index.size()))).first;
+            cell_class[cell] = it->second;
+        }
+
+        const int num_classes = class_index.size();
+        class_start_.assign(num_classes + 1, 0);
+        for (int cell = 0; cell < nc; ++cell) {
+            ++class_start_[cell_class[cell] + 1];
+        }
+        std::partial_sum(class_start_.begin(), class_start_.end(), class_start_.begin());
+        class_members_.resize(nc);
+        std::vector<int> pos(class_start_.begin(), class_start_.end() - 1);
+        for (int cell = 0; cell < nc; ++cell) {
+            class_members_[pos[cell_class[cell]]++] = cell;
+        }
+        class_rep_.assign(class_start_.begin(), class_start_.end() - 1);
+        cell_class_.swap(cell_class);
+    }
+
+    /// Turn batch evaluation on or off.
+    void SaturationPropsFromDeck::setBatchEvaluation(const bool enable)
+    {
+        batch_enabled_ = enable;
+    }
+
+    /// True if relperm() and capPress() evaluate in batches.
+    bool SaturationPropsFromDeck::batchEvaluation() const
+    {
+        return batch_enabled_ && !cell_class_.empty();
+    }
+
+    /// Number of saturation function classes.
+    int SaturationPropsFromDeck::numBatchClasses() const
+    {
+        return class_rep_.size();
     }
 
     /// \return   P, the number of phases.
@@ -60,6 +144,57 @@ namespace Opm
 
 
 
+    // Order in which to evaluate the data points, grouped by class.
+    // Empty if the points should be evaluated in the given order.
+    std::vector<int> SaturationPropsFromDeck::evaluationOrder_(const int n,
+                                                               const int* cells) const
+    {
+        std::vector<int> order;
+        if (!batchEvaluation() || n < 2 || class_rep_.size() < 2) {
+            return order;
+        }
+        // Sort (class, point) pairs packed in one integer. Points
+        // outside all classes come first.
+        std::vector<std::uint64_t> keys(n);
+        for (int i = 0; i < n; ++i) {
+            const std::uint64_t c = cell_class_[cells[i]] + 1;
+            keys[i] = (c << 32) | std::uint64_t(i);
+        }
+        std::sort(keys.begin(), keys.end());
+        order.resize(n);
+        for (int k = 0; k < n; ++k) {
+            order[k] = int(keys[k] & 0xffffffffu);
+        }
+        return order;
+    }
+
+    // The cell whose material law parameters are used for the given cell.
+    int SaturationPropsFromDeck::paramsCell_(const int cell) const
+    {
+        if (!batchEvaluation()) {
+            return cell;
+        }
+        const int c = cell_class_[cell];
+        return (c < 0) ? cell : class_members_[class_rep_[c]];
+    }
+
+    // Make a cell use its own parameters, e.g. after they have been
+    // modified, and find a new representative for its class if needed.
+    void SaturationPropsFromDeck::leaveBatchClass_(const int cell)
+    {
+        if (cell_class_.empty() || cell_class_[cell] < 0) {
+            return;
+        }
+        const int c = cell_class_[cell];
+        cell_class_[cell] = -1;
+        int& rep = class_rep_[c];
+        while (rep < class_start_[c + 1] - 1 && cell_class_[class_members_[rep]] != c) {
+            ++rep;
+        }
+    }
+
+
+
 
     /// Relative permeability.
     /// \param[in]  n      Number of data points.
@@ -80,15 +215,17 @@ namespace Opm
         assert(cells != 0);
 
         const int np = numPhases();
+        const std::vector<int> order = evaluationOrder_(n, cells);
         if (dkrds) {
             ExplicitArraysSatDerivativesFluidState fluidState(phaseUsage_);
             fluidState.setSaturationArray(s);
 
             typedef ExplicitArraysSatDerivativesFluidState::Evaluation Evaluation;
             Evaluation relativePerms[BlackoilPhases::MaxNumPhases];
-            for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < n; ++k) {
+                const int i = order.empty() ? k : order[k];
                 fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
+                const auto& params = materialLawManager_->materialLawParams(paramsCell_(cells[i]));
                 MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
 
                 // copy the values calculated using opm-material to the target arrays
@@ -104,9 +241,10 @@ namespace Opm
             fluidState.setSaturationArray(s);
 
             double relativePerms[BlackoilPhases::MaxNumPhases] = { 0 };
-            for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < n; ++k) {
+                const int i = order.empty() ? k : order[k];
                 fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
+                const auto& params = materialLawManager_->materialLawParams(paramsCell_(cells[i]));
                 MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
 
                 // copy the values calculated using opm-material to the target arrays
@@ -140,6 +278,7 @@ namespace Opm
         assert(phaseUsage_.phase_used[BlackoilPhases::Liquid]);
 
         const int np = numPhases();
+        const std::vector<int> order = evaluationOrder_(n, cells);
 
         if (dpcds) {
             ExplicitArraysSatDerivativesFluidState fluidState(phaseUsage_);
@@ -147,9 +286,10 @@ namespace Opm
             fluidState.setSaturationArray(s);
 
             Evaluation capillaryPressures[BlackoilPhases::MaxNumPhases];
-            for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < n; ++k) {
+                const int i = order.empty() ? k : order[k];
                 fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
+                const auto& params = materialLawManager_->materialLawParams(paramsCell_(cells[i]));
                 MaterialLaw::capillaryPressures(capillaryPressures, params, fluidState);
 
                 // copy the values calculated using opm-material to the target arrays
@@ -180,9 +320,10 @@ namespace Opm
             fluidState.setSaturationArray(s);
 
             double capillaryPressures[BlackoilPhases::MaxNumPhases] = { 0 };
-            for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < n; ++k) {
+                const int i = order.empty() ? k : order[k];
                 fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
+                const auto& params = materialLawManager_->materialLawParams(paramsCell_(cells[i]));
                 MaterialLaw::capillaryPressures(capillaryPressures, params, fluidState);
 
                 // copy the values calculated using opm-material to the target arrays
@@ -367,5 +508,6 @@ namespace Opm
                                                               double& swat)
     {
         swat = materialLawManager_->applySwatinit(cell, pcow, swat);
+        leaveBatchClass_(cell);
     }
 } // namespace Opm
@@ -72,6 +72,29 @@ namespace Opm
             init(Opm::phaseUsageFromDeck(deck), materialLawManager);
         }
 
+        /// Set up batch evaluation of relperm() and capPress().
+        /// Cells with the same saturation region and the same scaled
+        /// end points have identical saturation functions. They are
+        /// put in one class, the data points of a call are evaluated
+        /// class by class, and all points of a class use the material
+        /// law parameters of one cell. The results are identical to
+        /// the per-cell evaluation. Nothing is done if hysteresis is
+        /// enabled, since the parameters then depend on the saturation
+        /// history of each cell.
+        /// \param[in]  satnum  Saturation table index (SATNUM - 1) of each cell.
+        void initBatchEvaluation(const std::vector<int>& satnum);
+
+        /// Turn batch evaluation on (the default) or off. Has no effect
+        /// unless initBatchEvaluation() has been called.
+        void setBatchEvaluation(const bool enable);
+
+        /// \return  True if relperm() and capPress() evaluate in batches.
+        bool batchEvaluation() const;
+
+        /// \return  Number of saturation function classes, or zero if
+        ///          batch evaluation is not set up.
+        int numBatchClasses() const;
+
         /// \return   P, the number of phases.
         int numPhases() const;
 
@@ -170,8 +193,23 @@ namespace Opm
 
 
     private:
+        std::vector<int> evaluationOrder_(const int n, const int* cells) const;
+        int paramsCell_(const int cell) const;
+        void leaveBatchClass_(const int cell);
+
         std::shared_ptr<MaterialLawManager> materialLawManager_;
         PhaseUsage phaseUsage_;
+
+        // Batch evaluation. cell_class_ is empty if not set up, and -1
+        // for cells that use their own parameters. The cells of class c
+        // are class_members_[class_start_[c]], ..., in increasing order,
+        // and class_members_[class_rep_[c]] is the cell whose parameters
+        // are used for the class.
+        bool batch_enabled_;
+        std::vector<int> cell_class_;
+        std::vector<int> class_start_;
+        std::vector<int> class_members_;
+        std::vector<int> class_rep_;
     };
 
 
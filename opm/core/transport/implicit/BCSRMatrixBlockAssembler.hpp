@@ -0,0 +1,164 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media Project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_BCSRMATRIXBLOCKASSEMBLER_HPP_HEADER
+#define OPM_BCSRMATRIXBLOCKASSEMBLER_HPP_HEADER
+
+#include <opm/core/transport/implicit/JacobianSystem.hpp>
+
+#include <opm/core/linalg/sparse_sys.h>
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+
+namespace Opm {
+    namespace ImplicitTransportDefault {
+
+        template <>
+        class MatrixZero <struct BCSRMatrix> {
+        public:
+            static void
+            zero(struct BCSRMatrix& A) {
+                bcsrmatrix_zero(&A);
+            }
+        };
+
+        // Block assembler storing one column index per cell connection
+        // and one dense ndof-by-ndof block per non-zero.  Counterpart of
+        // MatrixBlockAssembler<CSRMatrix>, which expands every block
+        // into ndof*ndof scalar entries.
+        template <>
+        class MatrixBlockAssembler<struct BCSRMatrix> {
+        public:
+            template <class Block>
+            void
+            assembleBlock(::std::size_t ndof,
+                          ::std::size_t i   ,
+                          ::std::size_t j   ,
+                          const Block&  b   ) {
+
+                assert (ndof >  0);
+                assert (ndof == ndof_);
+
+                const ::std::size_t k =
+                    bcsrmatrix_elm_index(static_cast<int>(i),
+                                         static_cast<int>(j), &mat_);
+
+                // Incoming blocks are column major, BCSRMatrix blocks
+                // are row major.
+                double* a = &sa_[k * ndof * ndof];
+                for (::std::size_t row = 0; row < ndof; ++row) {
+                    for (::std::size_t col = 0; col < ndof; ++col) {
+                        a[row*ndof + col] += b[col*ndof + row];
+                    }
+                }
+            }
+
+            template <class Connections>
+            void
+            createBlockRow(::std::size_t      i  ,
+                           const Connections& conn,
+                           ::std::size_t      ndof) {
+
+                assert (ndof >  0);
+                assert (ndof == ndof_);
+                assert (i    == ia_.size() - 1);  (void) i;
+
+                const ::std::size_t start = ja_.size();
+
+                for (typename Connections::const_iterator
+                         c = conn.begin(), e = conn.end(); c != e; ++c) {
+                    ja_.push_back(static_cast<int>(*c));
+                }
+
+                ::std::sort(ja_.begin() + start, ja_.end());
+                ia_.push_back(static_cast<int>(ja_.size()));
+
+                sa_.insert(sa_.end(), conn.size() * ndof * ndof, double(0.0));
+
+                finalizeStructure();
+            }
+
+            void
+            finalizeStructure() {
+                construct();
+                setBCSRSize();
+            }
+
+            void
+            setSize(size_t ndof, size_t m, size_t n, size_t nnz = 0) {
+                (void) n;
+
+                assert ((0 < ndof) && (ndof <= BCSR_MAX_BLOCK_SIZE));
+
+                clear();
+
+                allocate(ndof, m, nnz);
+
+                ia_.push_back(0);
+                ndof_ = ndof;
+            }
+
+            struct BCSRMatrix&       matrix()       { return mat_; }
+            const struct BCSRMatrix& matrix() const { return mat_; }
+
+        private:
+            void
+            allocate(::std::size_t ndof, ::std::size_t m, ::std::size_t nnz) {
+                ia_.reserve(1 + m);
+                ja_.reserve(0 + nnz);
+                sa_.reserve(0 + (nnz * ndof * ndof));
+            }
+
+            void
+            clear() {
+                ia_.resize(0);
+                ja_.resize(0);
+                sa_.resize(0);
+            }
+
+            void
+            construct() {
+                mat_.ia = &ia_[0];
+                mat_.ja = &ja_[0];
+                mat_.sa = &sa_[0];
+            }
+
+            void
+            setBCSRSize() {
+                mat_.m   = ia_.size() - 1;
+                mat_.nnz = ja_.size()    ;
+                mat_.bs  = static_cast<int>(ndof_);
+            }
+
+            ::std::size_t         ndof_;
+
+            ::std::vector<int>    ia_;
+            ::std::vector<int>    ja_;
+            ::std::vector<double> sa_;
+
+            struct BCSRMatrix     mat_;
+        };
+    }
+}
+
+#endif  /* OPM_BCSRMATRIXBLOCKASSEMBLER_HPP_HEADER */
@@ -37,6 +37,7 @@
 #define OPM_CSRMATRIXUMFPACKSOLVER_HPP_HEADER
 
 #include <opm/core/linalg/call_umfpack.h>
+#include <opm/core/linalg/sparse_sys.h>
 #include <opm/common/ErrorMacros.hpp>
 
 namespace Opm
@@ -79,6 +80,39 @@ namespace Opm
             }
 
 
+            template <class Vector>
+            void
+            solve(const struct BCSRMatrix& A,
+                  const Vector&            b,
+                  Vector&                  x)
+            {
+#if HAVE_SUITESPARSE_UMFPACK_H
+                if (A.bs == 1) {
+                    // Scalar blocks share the CSR layout.
+                    struct CSRMatrix S;
+                    S.m   = A.m;
+                    S.nnz = A.nnz;
+                    S.ia  = A.ia;
+                    S.ja  = A.ja;
+                    S.sa  = A.sa;
+
+                    call_UMFPACK(&S, &b[0], &x[0]);
+                } else {
+                    struct CSRMatrix* S = bcsrmatrix_expand(&A);
+                    if (S == 0) {
+                        OPM_THROW(std::runtime_error, "Failed to expand block matrix.");
+                    }
+
+                    call_UMFPACK(S, &b[0], &x[0]);
+                    csrmatrix_delete(S);
+                }
+#else
+    OPM_THROW(std::runtime_error, "Cannot use implicit transport solver without UMFPACK. "
+          "Reconfigure opm-core with SuiteSparse/UMFPACK support and recompile.");
+#endif
+            }
+
+
         }; // class CSRMatrixUmfpackSolver
 
     } // namespace ImplicitTransportLinAlgSupport
@@ -31,7 +31,7 @@
 #include <opm/core/transport/implicit/ImplicitAssembly.hpp>
 #include <opm/core/transport/implicit/ImplicitTransport.hpp>
 #include <opm/core/transport/implicit/JacobianSystem.hpp>
-#include <opm/core/transport/implicit/CSRMatrixBlockAssembler.hpp>
+#include <opm/core/transport/implicit/BCSRMatrixBlockAssembler.hpp>
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
 #include <opm/core/props/IncompPropertiesInterface.hpp>
 #include <opm/core/grid.h>
@@ -85,7 +85,7 @@ namespace Opm
         typedef Opm::SimpleFluid2pWrappingProps TwophaseFluid;
         typedef Opm::SinglePointUpwindTwoPhase<TwophaseFluid> TransportModel;
         typedef ImplicitTransportDefault::NewtonVectorCollection< ::std::vector<double> >      NVecColl;
-        typedef ImplicitTransportDefault::JacobianSystem        < struct CSRMatrix, NVecColl > JacSys;
+        typedef ImplicitTransportDefault::JacobianSystem        < struct BCSRMatrix, NVecColl > JacSys;
         template <class Vector>
         class MaxNorm {
         public:
@@ -22,14 +22,159 @@
 #include <opm/core/transport/reorder/reordersequence.h>
 #include <opm/core/grid.h>
 #include <opm/core/utility/StopWatch.hpp>
+#include <opm/common/ErrorMacros.hpp>
 
+#include <algorithm>
+#include <exception>
 #include <vector>
 #include <cassert>
 #include <iostream>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-void Opm::ReorderSolverInterface::reorderAndTransport(const UnstructuredGrid& grid, const double* darcyflux)
+
+namespace
+{
+    // Signs of the interior face fluxes, which determine the upwind
+    // graph, and a hash of them for cheap comparison.
+    std::uint64_t fluxSigns(const UnstructuredGrid& grid,
+                            const double* darcyflux,
+                            std::vector<signed char>& signs)
+    {
+        const int nf = grid.number_of_faces;
+        signs.resize(nf);
+        std::uint64_t hash = 14695981039346656037ULL; // FNV-1a offset basis.
+        for (int f = 0; f < nf; ++f) {
+            const bool interior = (grid.face_cells[2*f] >= 0) && (grid.face_cells[2*f + 1] >= 0);
+            const double flux = darcyflux[f];
+            const signed char sign = interior ? ((flux > 0.0) - (flux < 0.0)) : 0;
+            signs[f] = sign;
+            hash = (hash ^ static_cast<unsigned char>(sign)) * 1099511628211ULL;
+        }
+        return hash;
+    }
+} // anonymous namespace
+
+
+Opm::ReorderSolverInterface::ReorderSolverInterface()
+    : fixed_sequence_(false),
+      reuse_sequence_(true),
+      sequence_grid_(0),
+      sign_hash_(0),
+      num_computations_(0),
+      num_reuses_(0),
+      parallel_sweep_(false),
+      levels_valid_(false),
+      num_sweep_levels_(0)
+{
+}
+
+
+void Opm::ReorderSolverInterface::setSequence(const std::vector<int>& sequence,
+                                              const std::vector<int>& components)
+{
+    if (components.empty() || components.front() != 0
+        || components.back() != int(sequence.size())) {
+        OPM_THROW(std::runtime_error, "Inconsistent reorder sequence and components.");
+    }
+    sequence_ = sequence;
+    components_ = components;
+    fixed_sequence_ = true;
+    levels_valid_ = false;
+}
+
+
+void Opm::ReorderSolverInterface::clearSequence()
+{
+    fixed_sequence_ = false;
+    sequence_grid_ = 0;
+    face_signs_.clear();
+}
+
+
+void Opm::ReorderSolverInterface::setSequenceReuse(const bool reuse)
+{
+    reuse_sequence_ = reuse;
+}
+
+
+int Opm::ReorderSolverInterface::numSequenceComputations() const
+{
+    return num_computations_;
+}
+
+
+int Opm::ReorderSolverInterface::numSequenceReuses() const
+{
+    return num_reuses_;
+}
+
+
+void Opm::ReorderSolverInterface::setParallelSweep(const bool parallel)
+{
+    parallel_sweep_ = parallel;
+}
+
+
+int Opm::ReorderSolverInterface::numSweepLevels() const
+{
+    return num_sweep_levels_;
+}
+
+
+bool Opm::ReorderSolverInterface::supportsParallelSweep() const
+{
+    return false;
+}
+
+
+int Opm::ReorderSolverInterface::maxSweepThreads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+
+int Opm::ReorderSolverInterface::sweepThread()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+
+// Returns true if the sequence may differ from that of the previous
+// call, i.e., unless a cached sequence was reused.
+bool Opm::ReorderSolverInterface::updateSequence(const UnstructuredGrid& grid, const double* darcyflux)
 {
+    if (fixed_sequence_) {
+        if (int(sequence_.size()) != grid.number_of_cells) {
+            OPM_THROW(std::runtime_error, "Supplied reorder sequence has " << sequence_.size()
+                      << " cells, grid has " << grid.number_of_cells << ".");
+        }
+        // The flux, and therefore the level structure, may have changed.
+        return true;
+    }
+
+    if (reuse_sequence_) {
+        const std::uint64_t hash = fluxSigns(grid, darcyflux, new_face_signs_);
+        if (sequence_grid_ == &grid && int(sequence_.size()) == grid.number_of_cells
+            && hash == sign_hash_ && new_face_signs_ == face_signs_) {
+            ++num_reuses_;
+            return false;
+        }
+        face_signs_.swap(new_face_signs_);
+        sign_hash_ = hash;
+        sequence_grid_ = &grid;
+    }
+
     // Compute reordered sequence of single-cell problems
     sequence_.resize(grid.number_of_cells);
     components_.resize(grid.number_of_cells + 1);
@@ -39,11 +184,100 @@ void Opm::ReorderSolverInterface::reorderAndTransport(const UnstructuredGrid& gr
     compute_sequence(&grid, darcyflux, &sequence_[0], &components_[0], &ncomponents);
     clock.stop();
     std::cout << "Topological sort took: " << clock.secsSinceStart() << " seconds." << std::endl;
+    ++num_computations_;
 
     // Make vector's size match actual used data.
     components_.resize(ncomponents + 1);
+    return true;
+}
+
+
+// Group the components into wavefront levels: a component's level
+// is one more than the highest level of its upwind components. The
+// components of a level may then be solved in any order, or
+// concurrently. If the sequence is not in upwind order (which may
+// happen for a sequence supplied through setSequence()), no levels
+// are stored and the sweep is serial.
+void Opm::ReorderSolverInterface::computeLevels(const UnstructuredGrid& grid, const double* darcyflux)
+{
+    const int ncomponents = components_.size() - 1;
+    std::vector<int> comp_of_cell(grid.number_of_cells);
+    for (int comp = 0; comp < ncomponents; ++comp) {
+        for (int i = components_[comp]; i < components_[comp + 1]; ++i) {
+            comp_of_cell[sequence_[i]] = comp;
+        }
+    }
+
+    std::vector<int> comp_level(ncomponents, 0);
+    int num_levels = 0;
+    for (int comp = 0; comp < ncomponents; ++comp) {
+        int level = 0;
+        for (int i = components_[comp]; i < components_[comp + 1]; ++i) {
+            const int cell = sequence_[i];
+            for (int hf = grid.cell_facepos[cell]; hf < grid.cell_facepos[cell + 1]; ++hf) {
+                const int f = grid.cell_faces[hf];
+                int other;
+                double influx;
+                if (cell == grid.face_cells[2*f]) {
+                    other  = grid.face_cells[2*f + 1];
+                    influx = -darcyflux[f];
+                } else {
+                    other  = grid.face_cells[2*f];
+                    influx = darcyflux[f];
+                }
+                if (other < 0 || influx <= 0.0) {
+                    continue;
+                }
+                const int other_comp = comp_of_cell[other];
+                if (other_comp > comp) {
+                    // Not in upwind order.
+                    level_start_.clear();
+                    level_components_.clear();
+                    levels_valid_ = true;
+                    return;
+                }
+                if (other_comp < comp) {
+                    level = std::max(level, comp_level[other_comp] + 1);
+                }
+            }
+        }
+        comp_level[comp] = level;
+        num_levels = std::max(num_levels, level + 1);
+    }
+
+    // Bucket the components by level, keeping the sequence order
+    // within each level.
+    level_start_.assign(num_levels + 1, 0);
+    for (int comp = 0; comp < ncomponents; ++comp) {
+        ++level_start_[comp_level[comp] + 1];
+    }
+    for (int level = 0; level < num_levels; ++level) {
+        level_start_[level + 1] += level_start_[level];
+    }
+    level_components_.resize(ncomponents);
+    std::vector<int> pos(level_start_.begin(), level_start_.end() - 1);
+    for (int comp = 0; comp < ncomponents; ++comp) {
+        level_components_[pos[comp_level[comp]]++] = comp;
+    }
+    levels_valid_ = true;
+}
+
 
+void Opm::ReorderSolverInterface::solveComponent(const int comp)
+{
+    const int comp_size = components_[comp + 1] - components_[comp];
+    if (comp_size == 1) {
+        solveSingleCell(sequence_[components_[comp]]);
+    } else {
+        solveMultiCell(comp_size, &sequence_[components_[comp]]);
+    }
+}
+
+
+void Opm::ReorderSolverInterface::serialSweep()
+{
     // Invoke appropriate solve method for each interdependent component.
+    const int ncomponents = components_.size() - 1;
     for (int comp = 0; comp < ncomponents; ++comp) {
 #if 0
 #ifdef MATLAB_MEX_FILE
@@ -55,16 +289,79 @@ void Opm::ReorderSolverInterface::reorderAndTransport(const UnstructuredGrid& gr
         }
 #endif
 #endif
-	const int comp_size = components_[comp + 1] - components_[comp];
-	if (comp_size == 1) {
-	    solveSingleCell(sequence_[components_[comp]]);
-	} else {
-	    solveMultiCell(comp_size, &sequence_[components_[comp]]);
-	}
+        solveComponent(comp);
     }
 }
 
 
+void Opm::ReorderSolverInterface::parallelSweep()
+{
+    const int num_levels = level_start_.size() - 1;
+    num_sweep_levels_ = num_levels;
+
+    // Exceptions may not leave a parallel region, so the first one
+    // is kept and rethrown after the sweep. Failures are flagged per
+    // level, so that a flag is never written after the barrier that
+    // precedes its reading.
+    std::exception_ptr error;
+    std::vector<char> level_failed(num_levels, 0);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (int level = 0; level < num_levels; ++level) {
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+        for (int i = level_start_[level]; i < level_start_[level + 1]; ++i) {
+            try {
+                solveComponent(level_components_[i]);
+            }
+            catch (...) {
+#ifdef _OPENMP
+#pragma omp critical(reorder_sweep_error)
+#endif
+                {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    level_failed[level] = 1;
+                }
+            }
+        }
+        // Implicit barrier above, so all threads see the same flag.
+        if (level_failed[level]) {
+            break;
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+
+void Opm::ReorderSolverInterface::reorderAndTransport(const UnstructuredGrid& grid, const double* darcyflux)
+{
+    // Compute (or reuse) reordered sequence of single-cell problems
+    if (updateSequence(grid, darcyflux)) {
+        levels_valid_ = false;
+    }
+
+    num_sweep_levels_ = 0;
+#ifdef _OPENMP
+    if (parallel_sweep_ && supportsParallelSweep() && maxSweepThreads() > 1) {
+        if (!levels_valid_) {
+            computeLevels(grid, darcyflux);
+        }
+        if (!level_start_.empty()) {
+            parallelSweep();
+            return;
+        }
+    }
+#endif
+    serialSweep();
+}
+
+
 const std::vector<int>& Opm::ReorderSolverInterface::sequence() const
 {
     return sequence_;
@@ -20,6 +20,7 @@
 #ifndef OPM_REORDERSOLVERINTERFACE_HEADER_INCLUDED
 #define OPM_REORDERSOLVERINTERFACE_HEADER_INCLUDED
 
+#include <cstdint>
 #include <vector>
 
 struct UnstructuredGrid;
@@ -35,10 +36,60 @@ namespace Opm
     /// class.) The reorderAndTransport() method is provided as an aid
     /// to implementing solve() in subclasses, together with the
     /// sequence() and components() methods for accessing the ordering.
+    ///
+    /// The ordering depends only on the signs of the interior face
+    /// fluxes. reorderAndTransport() therefore keeps the ordering of
+    /// the previous call and reuses it if the sign pattern is
+    /// unchanged, as is typical between nearby time steps or between
+    /// the forward and tracer solves of a flow diagnostics run.
+    ///
+    /// Components at the same depth of the upwind graph of components
+    /// do not depend on each other. With setParallelSweep(true), and
+    /// if the subclass supports it (see supportsParallelSweep()), the
+    /// components are grouped into such wavefront levels, and the
+    /// components of each level are solved concurrently by a thread
+    /// pool (OpenMP).
     class ReorderSolverInterface
     {
     public:
+        ReorderSolverInterface();
     virtual ~ReorderSolverInterface() {}
+
+        /// Use the given ordering in subsequent solves instead of
+        /// computing one from the fluxes, until clearSequence() is
+        /// called.
+        /// \param[in] sequence    Cell permutation, one entry per cell.
+        /// \param[in] components  Start of each strongly connected
+        ///                        component in sequence, followed by
+        ///                        sequence.size().  Components of more
+        ///                        than one cell are solved by
+        ///                        solveMultiCell().
+        void setSequence(const std::vector<int>& sequence,
+                         const std::vector<int>& components);
+
+        /// Discard any supplied or cached ordering. The next solve
+        /// will compute the ordering from its fluxes.
+        void clearSequence();
+
+        /// Enable or disable reuse of the previous ordering when the
+        /// flux sign pattern is unchanged (enabled by default).
+        void setSequenceReuse(const bool reuse);
+
+        /// Number of times the ordering has been computed from fluxes.
+        int numSequenceComputations() const;
+
+        /// Number of times a previously computed ordering was reused.
+        int numSequenceReuses() const;
+
+        /// Enable or disable level-scheduled parallel sweeps (disabled
+        /// by default). Has no effect unless compiled with OpenMP and
+        /// supportsParallelSweep() returns true.
+        void setParallelSweep(const bool parallel);
+
+        /// Number of wavefront levels in the last parallel sweep, or
+        /// zero if the last sweep was serial.
+        int numSweepLevels() const;
+
     private:
 	virtual void solveSingleCell(const int cell) = 0;
 	virtual void solveMultiCell(const int num_cells, const int* cells) = 0;
@@ -46,9 +97,45 @@ namespace Opm
 	void reorderAndTransport(const UnstructuredGrid& grid, const double* darcyflux);
         const std::vector<int>& sequence() const;
         const std::vector<int>& components() const;
+
+        /// Return true if solveSingleCell() and solveMultiCell() may
+        /// be called concurrently for different components. Such
+        /// calls are only made for components that do not depend on
+        /// each other, but any scratch data used by the methods must
+        /// be private to the calling thread (see sweepThread()).
+        /// The default implementation returns false.
+        virtual bool supportsParallelSweep() const;
+
+        /// Upper bound on the number of threads used by a sweep, for
+        /// sizing per-thread workspaces.
+        static int maxSweepThreads();
+
+        /// Index of the calling thread, in [0, maxSweepThreads()).
+        static int sweepThread();
     private:
+        bool updateSequence(const UnstructuredGrid& grid, const double* darcyflux);
+        void computeLevels(const UnstructuredGrid& grid, const double* darcyflux);
+        void solveComponent(const int comp);
+        void serialSweep();
+        void parallelSweep();
+
         std::vector<int> sequence_;
         std::vector<int> components_;
+        // Ordering cache.
+        bool fixed_sequence_;       // Supplied by setSequence().
+        bool reuse_sequence_;
+        const UnstructuredGrid* sequence_grid_;
+        std::uint64_t sign_hash_;
+        std::vector<signed char> face_signs_;
+        std::vector<signed char> new_face_signs_;
+        int num_computations_;
+        int num_reuses_;
+        // Level scheduling.
+        bool parallel_sweep_;
+        bool levels_valid_;
+        std::vector<int> level_start_;       // Start of each level in level_components_.
+        std::vector<int> level_components_;  // Components, grouped by level.
+        int num_sweep_levels_;
     };
 
 
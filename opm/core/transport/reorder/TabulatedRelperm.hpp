@@ -0,0 +1,174 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_TABULATEDRELPERM_HEADER_INCLUDED
+#define OPM_TABULATEDRELPERM_HEADER_INCLUDED
+
+#include <opm/core/utility/UniformTableLinear.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Two-phase relative permeabilities tabulated at uniformly spaced
+    /// water saturations, one table pair per saturation region.
+    ///
+    /// Used by the reordering transport solvers to replace one call to
+    /// the relperm() method of a property object per residual
+    /// evaluation by an inline table lookup. Each region is sampled
+    /// from the property object at the first cell in that region, so
+    /// all cells of a region must share relative permeability curves.
+    class TabulatedRelperm
+    {
+    public:
+        /// Construct an empty object, see build().
+        TabulatedRelperm()
+        {
+        }
+
+        /// Tabulate the relative permeabilities.
+        /// \param[in] props       Property object with a relperm() method
+        ///                        with the signature of
+        ///                        IncompPropertiesInterface::relperm().
+        /// \param[in] num_cells   Number of cells.
+        /// \param[in] region      Saturation region (0, 1, ...) of each
+        ///                        cell, or empty if all cells share the
+        ///                        curves of cell 0.
+        /// \param[in] num_points  Number of uniformly spaced water
+        ///                        saturations in [0, 1] to sample, at
+        ///                        least two.
+        template <class Props>
+        void build(const Props& props,
+                   const int num_cells,
+                   const std::vector<int>& region,
+                   const int num_points)
+        {
+            if (num_points < 2) {
+                OPM_THROW(std::runtime_error, "TabulatedRelperm needs at least two sample points, got "
+                          << num_points);
+            }
+            if (!region.empty() && int(region.size()) != num_cells) {
+                OPM_THROW(std::runtime_error, "TabulatedRelperm: region array has " << region.size()
+                          << " entries, but there are " << num_cells << " cells.");
+            }
+
+            // First cell of each region.
+            std::vector<int> rep_cell(1, 0);
+            if (!region.empty()) {
+                rep_cell.clear();
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    const int r = region[cell];
+                    if (r < 0) {
+                        OPM_THROW(std::runtime_error, "TabulatedRelperm: negative region " << r
+                                  << " in cell " << cell);
+                    }
+                    if (r >= int(rep_cell.size())) {
+                        rep_cell.resize(r + 1, -1);
+                    }
+                    if (rep_cell[r] == -1) {
+                        rep_cell[r] = cell;
+                    }
+                }
+            }
+
+            // Sample all regions in a single property evaluation.
+            const int num_regions = rep_cell.size();
+            const int n = num_regions*num_points;
+            std::vector<int> cells(n);
+            std::vector<double> sat(2*n), kr(2*n);
+            for (int r = 0; r < num_regions; ++r) {
+                // Regions without cells get the curves of cell 0.
+                const int cell = (rep_cell[r] == -1) ? 0 : rep_cell[r];
+                for (int i = 0; i < num_points; ++i) {
+                    const int k = r*num_points + i;
+                    const double s = double(i)/double(num_points - 1);
+                    cells[k] = cell;
+                    sat[2*k + 0] = s;
+                    sat[2*k + 1] = 1.0 - s;
+                }
+            }
+            props.relperm(n, &sat[0], &cells[0], &kr[0], 0);
+
+            krw_.clear();
+            kro_.clear();
+            std::vector<double> krw(num_points), kro(num_points);
+            for (int r = 0; r < num_regions; ++r) {
+                for (int i = 0; i < num_points; ++i) {
+                    const int k = r*num_points + i;
+                    krw[i] = kr[2*k + 0];
+                    kro[i] = kr[2*k + 1];
+                }
+                krw_.push_back(UniformTableLinear<double>(0.0, 1.0, krw));
+                kro_.push_back(UniformTableLinear<double>(0.0, 1.0, kro));
+            }
+            region_ = region;
+        }
+
+        /// Remove the tables.
+        void clear()
+        {
+            krw_.clear();
+            kro_.clear();
+            region_.clear();
+        }
+
+        /// True if no tables have been built.
+        bool empty() const
+        {
+            return krw_.empty();
+        }
+
+        /// Relative permeabilities at water saturation s in a cell.
+        /// \param[in]  s     Water saturation.
+        /// \param[in]  cell  Cell index.
+        /// \param[out] kr    Water and oil relative permeabilities.
+        void relperm(const double s, const int cell, double* kr) const
+        {
+            const int r = region_.empty() ? 0 : region_[cell];
+            kr[0] = krw_[r](s);
+            kr[1] = kro_[r](s);
+        }
+
+        /// Relative permeabilities and their derivatives with respect
+        /// to water saturation in a cell.
+        /// \param[in]  s      Water saturation.
+        /// \param[in]  cell   Cell index.
+        /// \param[out] kr     Water and oil relative permeabilities.
+        /// \param[out] dkrds  Their derivatives with respect to s.
+        void relperm(const double s, const int cell, double* kr, double* dkrds) const
+        {
+            const int r = region_.empty() ? 0 : region_[cell];
+            kr[0] = krw_[r](s);
+            kr[1] = kro_[r](s);
+            dkrds[0] = krw_[r].derivative(s);
+            dkrds[1] = kro_[r].derivative(s);
+        }
+
+    private:
+        std::vector<UniformTableLinear<double> > krw_;
+        std::vector<UniformTableLinear<double> > kro_;
+        std::vector<int> region_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_TABULATEDRELPERM_HEADER_INCLUDED
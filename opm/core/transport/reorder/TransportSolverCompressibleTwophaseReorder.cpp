@@ -123,6 +123,20 @@ namespace Opm
         computeSurfacevol(grid_.number_of_cells, props_.numPhases(), &A_[0], &saturation[0], &surfacevol[0]);
     }
 
+
+    void TransportSolverCompressibleTwophaseReorder::setRelpermTable(const int num_points,
+                                                                     const std::vector<int>& region)
+    {
+        relperm_table_.build(props_, grid_.number_of_cells, region, num_points);
+    }
+
+
+    void TransportSolverCompressibleTwophaseReorder::clearRelpermTable()
+    {
+        relperm_table_.clear();
+    }
+
+
     // Residual function r(s) for a single-cell implicit Euler transport
     //
     // [[ incompressible was: r(s) = s - s0 + dt/pv*( influx + outflux*f(s) ) ]]
@@ -190,6 +204,14 @@ namespace Opm
     };
 
 
+    // A cell solve only writes the saturation and fractional flow of
+    // its own cell, and solveMultiCell() keeps its work arrays local.
+    bool TransportSolverCompressibleTwophaseReorder::supportsParallelSweep() const
+    {
+        return true;
+    }
+
+
     void TransportSolverCompressibleTwophaseReorder::solveSingleCell(const int cell)
     {
         Residual res(*this, cell);
@@ -307,9 +329,13 @@ namespace Opm
 
     double TransportSolverCompressibleTwophaseReorder::fracFlow(double s, int cell) const
     {
-        double sat[2] = { s, 1.0 - s };
         double mob[2];
-        props_.relperm(1, sat, &cell, mob, 0);
+        if (relperm_table_.empty()) {
+            double sat[2] = { s, 1.0 - s };
+            props_.relperm(1, sat, &cell, mob, 0);
+        } else {
+            relperm_table_.relperm(s, cell, mob);
+        }
         mob[0] /= visc_[2*cell + 0];
         mob[1] /= visc_[2*cell + 1];
         return mob[0]/(mob[0] + mob[1]);
@@ -381,8 +407,12 @@ namespace Opm
 
     void TransportSolverCompressibleTwophaseReorder::mobility(double s, int cell, double* mob) const
     {
-        double sat[2] = { s, 1.0 - s };
-        props_.relperm(1, sat, &cell, mob, 0);
+        if (relperm_table_.empty()) {
+            double sat[2] = { s, 1.0 - s };
+            props_.relperm(1, sat, &cell, mob, 0);
+        } else {
+            relperm_table_.relperm(s, cell, mob);
+        }
         mob[0] /= visc_[2*cell + 0];
         mob[1] /= visc_[2*cell + 1];
     }
@@ -21,6 +21,7 @@
 #define OPM_TRANSPORTSOLVERCOMPRESSIBLETWOPHASEREORDER_HEADER_INCLUDED
 
 #include <opm/core/transport/reorder/ReorderSolverInterface.hpp>
+#include <opm/core/transport/reorder/TabulatedRelperm.hpp>
 #include <vector>
 
 struct UnstructuredGrid;
@@ -84,7 +85,23 @@ namespace Opm
                           std::vector<double>& saturation,
                           std::vector<double>& surfacevol);
 
+        /// Evaluate relative permeabilities in solve() and
+        /// solveGravity() by linear interpolation in tables sampled
+        /// from the property object, instead of calling it for every
+        /// residual evaluation.
+        /// \param[in] num_points  Number of uniformly spaced water
+        ///                        saturations sampled, e.g. 1001.
+        /// \param[in] region      Saturation region (0, 1, ...) of each
+        ///                        cell, sampled at its first cell. If
+        ///                        empty, all cells use the curves of cell 0.
+        void setRelpermTable(const int num_points,
+                             const std::vector<int>& region = std::vector<int>());
+
+        /// Go back to calling the property object, see setRelpermTable().
+        void clearRelpermTable();
+
     private:
+        virtual bool supportsParallelSweep() const;
         virtual void solveSingleCell(const int cell);
         virtual void solveMultiCell(const int num_cells, const int* cells);
         void solveSingleCellGravity(const std::vector<int>& cells,
@@ -112,6 +129,7 @@ namespace Opm
         double dt_;
         std::vector<double> saturation_;        // P (= num. phases) per cell
         std::vector<double> fractionalflow_;  // = m[0]/(m[0] + m[1]) per cell
+        TabulatedRelperm relperm_table_;      // Used instead of props_ if non-empty.
         // For gravity segregation.
         const double* gravity_;
         std::vector<double> trans_;
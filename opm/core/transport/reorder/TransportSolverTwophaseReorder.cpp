@@ -26,11 +26,15 @@
 #include <opm/core/utility/RootFinders.hpp>
 #include <opm/core/utility/miscUtilities.hpp>
 #include <opm/core/pressure/tpfa/trans_tpfa.h>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <iterator>
 #include <numeric>
+#include <utility>
 
 
 #define EXPERIMENT_GAUSS_SEIDEL
@@ -58,6 +62,10 @@ namespace Opm
           saturation_(grid.number_of_cells, -1.0),
           fractionalflow_(grid.number_of_cells, -1.0),
           reorder_iterations_(grid.number_of_cells, 0),
+          newton_min_size_(20),
+          newton_maxit_(25),
+          multicell_stats_(),
+          verbosity_(0),
           mob_(2*grid.number_of_cells, -1.0)
 #ifdef EXPERIMENT_GAUSS_SEIDEL
         , ia_upw_(grid.number_of_cells + 1, -1),
@@ -78,6 +86,11 @@ namespace Opm
             cells[i] = i;
         }
         props.satRange(props.numCells(), &cells[0], &smin_[0], &smax_[0]);
+        // The Newton systems are solved from within the parallel
+        // sweep, so their linear solver must not start threads.
+        ParameterGroup serial;
+        serial.insertParameter("linsolver_threads", "1");
+        newton_linsolver_ = LinearSolverKrylov(serial);
         if (gravity) {
             initGravity(gravity);
             initColumns();
@@ -116,8 +129,17 @@ namespace Opm
                                &ia_downw_[0], &ja_downw_[0]);
 #endif
         std::fill(reorder_iterations_.begin(),reorder_iterations_.end(),0);
+        multicell_stats_ = MultiCellStatistics();
         reorderAndTransport(grid_, darcyflux_);
         toBothSat(saturation_, state.saturation());
+
+        const MultiCellStatistics& st = multicell_stats_;
+        if (verbosity_ > 0 && st.num_components > 0) {
+            std::cout << st.num_components << " multicell blocks with max size "
+                      << st.max_size << " cells, " << st.num_newton << " solved in upto "
+                      << st.max_newton_iterations << " Newton iterations, others in upto "
+                      << st.max_gauss_seidel_iterations << " Gauss-Seidel iterations." << std::endl;
+        }
     }
 
 
@@ -127,6 +149,38 @@ namespace Opm
     }
 
 
+    const TransportSolverTwophaseReorder::MultiCellStatistics&
+    TransportSolverTwophaseReorder::multiCellStatistics() const
+    {
+        return multicell_stats_;
+    }
+
+
+    void TransportSolverTwophaseReorder::setNewtonMinComponentSize(const int min_size)
+    {
+        newton_min_size_ = min_size;
+    }
+
+
+    void TransportSolverTwophaseReorder::setVerbosity(const int verbosity)
+    {
+        verbosity_ = verbosity;
+    }
+
+
+    void TransportSolverTwophaseReorder::setRelpermTable(const int num_points,
+                                                         const std::vector<int>& region)
+    {
+        relperm_table_.build(props_, grid_.number_of_cells, region, num_points);
+    }
+
+
+    void TransportSolverTwophaseReorder::clearRelpermTable()
+    {
+        relperm_table_.clear();
+    }
+
+
     // Residual function r(s) for a single-cell implicit Euler transport
     //
     //     r(s) = s - s0 + dt/pv*( influx + outflux*f(s) )
@@ -186,6 +240,15 @@ namespace Opm
     };
 
 
+    // A cell solve only writes the saturation, fractional flow and
+    // iteration count of its own cell, and solveMultiCell() keeps its
+    // work arrays local.
+    bool TransportSolverTwophaseReorder::supportsParallelSweep() const
+    {
+        return true;
+    }
+
+
     void TransportSolverTwophaseReorder::solveSingleCell(const int cell)
     {
         Residual res(*this, cell);
@@ -241,6 +304,165 @@ namespace Opm
 
 
     void TransportSolverTwophaseReorder::solveMultiCell(const int num_cells, const int* cells)
+    {
+        int newton_iters = 0;
+        const bool try_newton = newton_min_size_ > 0 && num_cells >= newton_min_size_;
+        const bool newton_ok = try_newton && solveMultiCellNewton(num_cells, cells, newton_iters);
+        const int gs_iters = newton_ok ? 0 : solveMultiCellGaussSeidel(num_cells, cells);
+
+#ifdef _OPENMP
+#pragma omp critical(transport_twophase_reorder_stats)
+#endif
+        {
+            MultiCellStatistics& st = multicell_stats_;
+            ++st.num_components;
+            st.num_cells += num_cells;
+            st.max_size = std::max(st.max_size, num_cells);
+            if (try_newton) {
+                st.newton_iterations += newton_iters;
+                st.max_newton_iterations = std::max(st.max_newton_iterations, newton_iters);
+                if (newton_ok) {
+                    ++st.num_newton;
+                } else {
+                    ++st.num_newton_failures;
+                }
+            }
+            st.gauss_seidel_iterations += gs_iters;
+            st.max_gauss_seidel_iterations = std::max(st.max_gauss_seidel_iterations, gs_iters);
+        }
+    }
+
+
+    // Newton's method for the implicit Euler equations of all cells of
+    // a strongly connected component simultaneously,
+    //
+    //     r_i(s) = s_i - s0_i + dt/pv_i*( influx_i(s) + outflux_i*f(s_i) ),
+    //
+    // where influx_i depends on the saturations of the upwind cells
+    // within the component. The Jacobian has a row for each cell, with
+    // the diagonal and one entry for each upwind neighbour within the
+    // component. Returns false, leaving saturation_ and
+    // fractionalflow_ unchanged, if the iteration does not converge.
+    bool TransportSolverTwophaseReorder::solveMultiCellNewton(const int num_cells,
+                                                              const int* cells,
+                                                              int& iterations)
+    {
+        const int n = num_cells;
+        iterations = 0;
+
+        // Local index of each cell, found by binary search.
+        std::vector<std::pair<int, int> > local(n);
+        for (int i = 0; i < n; ++i) {
+            local[i] = std::make_pair(cells[i], i);
+        }
+        std::sort(local.begin(), local.end());
+
+        // Jacobian structure, diagonal first in each row, and the
+        // saturation independent parts of the residual.
+        std::vector<double> s0(n), dtpv(n), influx(n), outflux(n);
+        std::vector<int> ia(n + 1);
+        std::vector<int> ja;
+        std::vector<double> upwind_flux;   // Flux of each Jacobian entry, zero on diagonal.
+        ja.reserve(3*n);
+        upwind_flux.reserve(3*n);
+        ia[0] = 0;
+        for (int i = 0; i < n; ++i) {
+            const int cell = cells[i];
+            s0[i] = saturation_[cell];
+            dtpv[i] = dt_/porevolume_[cell];
+            const double src_flux = -source_[cell];
+            influx[i]  = (src_flux < 0.0) ? src_flux : 0.0;
+            outflux[i] = (src_flux < 0.0) ? 0.0 : src_flux;
+            ja.push_back(i);
+            upwind_flux.push_back(0.0);
+            for (int hf = grid_.cell_facepos[cell]; hf < grid_.cell_facepos[cell+1]; ++hf) {
+                const int f = grid_.cell_faces[hf];
+                double flux;
+                int other;
+                if (cell == grid_.face_cells[2*f]) {
+                    flux  = darcyflux_[f];
+                    other = grid_.face_cells[2*f+1];
+                } else {
+                    flux  =-darcyflux_[f];
+                    other = grid_.face_cells[2*f];
+                }
+                if (other == -1) {
+                    continue;
+                }
+                if (flux < 0.0) {
+                    std::vector<std::pair<int, int> >::const_iterator it
+                        = std::lower_bound(local.begin(), local.end(), std::make_pair(other, -1));
+                    if (it != local.end() && it->first == other) {
+                        ja.push_back(it->second);
+                        upwind_flux.push_back(flux);
+                    } else {
+                        influx[i] += flux*fractionalflow_[other];
+                    }
+                } else {
+                    outflux[i] += flux;
+                }
+            }
+            ia[i + 1] = ja.size();
+        }
+
+        const double max_dsat = 0.2;
+        std::vector<double> s(s0), f(n), dfds(n), r(n), sa(ja.size()), ds(n);
+        for (;;) {
+            fracFlowWithDerivative(n, cells, &s[0], &f[0], &dfds[0]);
+
+            // Residual and Jacobian.
+            double max_res = 0.0;
+            for (int i = 0; i < n; ++i) {
+                double in = influx[i];
+                for (int k = ia[i] + 1; k < ia[i + 1]; ++k) {
+                    in += upwind_flux[k]*f[ja[k]];
+                    sa[k] = dtpv[i]*upwind_flux[k]*dfds[ja[k]];
+                }
+                r[i] = s[i] - s0[i] + dtpv[i]*(in + outflux[i]*f[i]);
+                sa[ia[i]] = 1.0 + dtpv[i]*outflux[i]*dfds[i];
+                max_res = std::max(max_res, std::fabs(r[i]));
+            }
+            if (max_res < tol_) {
+                break;
+            }
+            if (iterations == newton_maxit_) {
+                return false;
+            }
+            ++iterations;
+
+            // Newton update, limiting the largest saturation change.
+            for (int i = 0; i < n; ++i) {
+                r[i] = -r[i];
+            }
+            std::fill(ds.begin(), ds.end(), 0.0);
+            LinearSolverInterface::LinearSolverReport rep
+                = newton_linsolver_.solve(n, ja.size(), &ia[0], &ja[0], &sa[0], &r[0], &ds[0]);
+            if (!rep.converged) {
+                return false;
+            }
+            double max_ds = 0.0;
+            for (int i = 0; i < n; ++i) {
+                max_ds = std::max(max_ds, std::fabs(ds[i]));
+            }
+            const double damping = (max_ds > max_dsat) ? max_dsat/max_ds : 1.0;
+            for (int i = 0; i < n; ++i) {
+                s[i] = std::min(std::max(s[i] + damping*ds[i], 0.0), 1.0);
+            }
+        }
+
+        for (int i = 0; i < n; ++i) {
+            const int cell = cells[i];
+            saturation_[cell] = s[i];
+            fractionalflow_[cell] = f[i];
+            reorder_iterations_[cell] += iterations;
+        }
+        return true;
+    }
+
+
+    // Nonlinear Gauss-Seidel over single-cell solves. Returns the
+    // number of iterations.
+    int TransportSolverTwophaseReorder::solveMultiCellGaussSeidel(const int num_cells, const int* cells)
     {
         // std::ofstream os("dump");
         // std::copy(cells, cells + num_cells, std::ostream_iterator<double>(os, "\n"));
@@ -414,8 +636,7 @@ namespace Opm
             OPM_THROW(std::runtime_error, "In solveMultiCell(), we did not converge after "
                   << num_iters << " iterations. Remaining update count = " << update_count);
         }
-        std::cout << "Solved " << num_cells << " cell multicell problem in "
-                  << num_iters << " iterations." << std::endl;
+        return num_iters;
 
 #else
         double max_s_change = 0.0;
@@ -450,22 +671,67 @@ namespace Opm
             OPM_THROW(std::runtime_error, "In solveMultiCell(), we did not converge after "
                   << num_iters << " iterations. Delta s = " << max_s_change);
         }
-        std::cout << "Solved " << num_cells << " cell multicell problem in "
-                  << num_iters << " iterations." << std::endl;
+        return num_iters;
 #endif // EXPERIMENT_GAUSS_SEIDEL
     }
 
     double TransportSolverTwophaseReorder::fracFlow(double s, int cell) const
     {
-        double sat[2] = { s, 1.0 - s };
         double mob[2];
-        props_.relperm(1, sat, &cell, mob, 0);
+        if (relperm_table_.empty()) {
+            double sat[2] = { s, 1.0 - s };
+            props_.relperm(1, sat, &cell, mob, 0);
+        } else {
+            relperm_table_.relperm(s, cell, mob);
+        }
         mob[0] /= visc_[0];
         mob[1] /= visc_[1];
         return mob[0]/(mob[0] + mob[1]);
     }
 
 
+    // Fractional flow and its derivative with respect to water
+    // saturation, for n cells in a single property evaluation.
+    void TransportSolverTwophaseReorder::fracFlowWithDerivative(const int n,
+                                                                const int* cells,
+                                                                const double* s,
+                                                                double* f,
+                                                                double* dfds) const
+    {
+        if (!relperm_table_.empty()) {
+            for (int i = 0; i < n; ++i) {
+                double kr[2], dkr[2];
+                relperm_table_.relperm(s[i], cells[i], kr, dkr);
+                const double m0  = kr[0]/visc_[0];
+                const double m1  = kr[1]/visc_[1];
+                const double dm0 = dkr[0]/visc_[0];
+                const double dm1 = dkr[1]/visc_[1];
+                const double mt  = m0 + m1;
+                f[i]    = m0/mt;
+                dfds[i] = (dm0*m1 - m0*dm1)/(mt*mt);
+            }
+            return;
+        }
+        std::vector<double> sat(2*n), kr(2*n), dkr(4*n);
+        for (int i = 0; i < n; ++i) {
+            sat[2*i + 0] = s[i];
+            sat[2*i + 1] = 1.0 - s[i];
+        }
+        props_.relperm(n, &sat[0], cells, &kr[0], &dkr[0]);
+        for (int i = 0; i < n; ++i) {
+            // dkr[4*i + p + 2*q] is the derivative of kr_p wrt. s_q, and s_1 = 1 - s_0.
+            const double* dk = &dkr[4*i];
+            const double m0  = kr[2*i + 0]/visc_[0];
+            const double m1  = kr[2*i + 1]/visc_[1];
+            const double dm0 = (dk[0] - dk[2])/visc_[0];
+            const double dm1 = (dk[1] - dk[3])/visc_[1];
+            const double mt  = m0 + m1;
+            f[i]    = m0/mt;
+            dfds[i] = (dm0*m1 - m0*dm1)/(mt*mt);
+        }
+    }
+
+
 
 
 
@@ -530,8 +796,12 @@ namespace Opm
 
     void TransportSolverTwophaseReorder::mobility(double s, int cell, double* mob) const
     {
-        double sat[2] = { s, 1.0 - s };
-        props_.relperm(1, sat, &cell, mob, 0);
+        if (relperm_table_.empty()) {
+            double sat[2] = { s, 1.0 - s };
+            props_.relperm(1, sat, &cell, mob, 0);
+        } else {
+            relperm_table_.relperm(s, cell, mob);
+        }
         mob[0] /= visc_[0];
         mob[1] /= visc_[1];
     }
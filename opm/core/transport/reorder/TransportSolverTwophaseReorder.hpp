@@ -22,6 +22,8 @@
 
 #include <opm/core/transport/reorder/ReorderSolverInterface.hpp>
 #include <opm/core/transport/TransportSolverTwophaseInterface.hpp>
+#include <opm/core/transport/reorder/TabulatedRelperm.hpp>
+#include <opm/core/linalg/LinearSolverKrylov.hpp>
 #include <vector>
 #include <map>
 #include <ostream>
@@ -33,6 +35,12 @@ namespace Opm
     class IncompPropertiesInterface;
 
     /// Implements a reordering transport solver for incompressible two-phase flow.
+    ///
+    /// Strongly connected components (loops) of the upwind graph with
+    /// at least a given number of cells are solved by Newton's method
+    /// on the whole component, using a sparse Jacobian, and smaller
+    /// components by nonlinear Gauss-Seidel over single-cell solves.
+    /// Gauss-Seidel is also used if Newton's method fails.
     class TransportSolverTwophaseReorder : public TransportSolverTwophaseInterface, ReorderSolverInterface
     {
     public:
@@ -80,11 +88,60 @@ namespace Opm
         //// \return vector of iteration per cell
         const std::vector<int>& getReorderIterations() const;
 
+        /// Statistics of the strongly connected components of more
+        /// than one cell solved in the last call to solve().
+        struct MultiCellStatistics
+        {
+            int num_components;              // Multi-cell components solved.
+            int num_cells;                   // Total cells in them.
+            int max_size;                    // Largest component.
+            int num_newton;                  // Components solved by Newton's method.
+            int newton_iterations;           // Total Newton iterations.
+            int max_newton_iterations;
+            int num_newton_failures;         // Newton failures, solved by Gauss-Seidel instead.
+            int gauss_seidel_iterations;     // Total Gauss-Seidel sweeps.
+            int max_gauss_seidel_iterations;
+        };
+
+        /// Return statistics of the multi-cell solves of the last call to solve().
+        const MultiCellStatistics& multiCellStatistics() const;
+
+        /// Set the smallest component size solved by Newton's method
+        /// (default 20). Zero disables Newton's method.
+        void setNewtonMinComponentSize(const int min_size);
+
+        /// Print the statistics of the multi-cell solves after each
+        /// call to solve() if verbosity > 0 (default 0).
+        void setVerbosity(const int verbosity);
+
+        /// Evaluate relative permeabilities in solve() and
+        /// solveGravity() by linear interpolation in tables sampled
+        /// from the property object, instead of calling it for every
+        /// residual evaluation.
+        /// \param[in] num_points  Number of uniformly spaced water
+        ///                        saturations sampled, e.g. 1001.
+        /// \param[in] region      Saturation region (0, 1, ...) of each
+        ///                        cell, sampled at its first cell. If
+        ///                        empty, all cells use the curves of cell 0.
+        void setRelpermTable(const int num_points,
+                             const std::vector<int>& region = std::vector<int>());
+
+        /// Go back to calling the property object, see setRelpermTable().
+        void clearRelpermTable();
+
+        /// Enable or disable level-scheduled parallel sweeps in solve().
+        /// Requires the relperm() method of the property object to be
+        /// safe to call concurrently.
+        using ReorderSolverInterface::setParallelSweep;
+
     private:
+        virtual bool supportsParallelSweep() const;
         void initGravity(const double* grav);
         void initColumns();
         virtual void solveSingleCell(const int cell);
         virtual void solveMultiCell(const int num_cells, const int* cells);
+        int solveMultiCellGaussSeidel(const int num_cells, const int* cells);
+        bool solveMultiCellNewton(const int num_cells, const int* cells, int& iterations);
 
         void solveSingleCellGravity(const std::vector<int>& cells,
                                     const int pos,
@@ -106,6 +163,13 @@ namespace Opm
         std::vector<double> saturation_;        // one per cell, only water saturation!
         std::vector<double> fractionalflow_;  // = m[0]/(m[0] + m[1]) per cell
         std::vector<int> reorder_iterations_;
+        TabulatedRelperm relperm_table_;    // Used instead of props_ if non-empty.
+        // For multi-cell components.
+        int newton_min_size_;
+        int newton_maxit_;
+        LinearSolverKrylov newton_linsolver_;  // Serial, shared by the threads of a parallel sweep.
+        MultiCellStatistics multicell_stats_;
+        int verbosity_;
         //std::vector<double> reorder_fval_;
         // For gravity segregation.
         std::vector<double> gravflux_;
@@ -121,6 +185,8 @@ namespace Opm
 
         struct Residual;
         double fracFlow(double s, int cell) const;
+        void fracFlowWithDerivative(const int n, const int* cells, const double* s,
+                                    double* f, double* dfds) const;
 
         struct GravityResidual;
         void mobility(double s, int cell, double* mob) const;
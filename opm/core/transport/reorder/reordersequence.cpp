@@ -30,7 +30,9 @@ struct SortByAbsFlux
 
 
 /* Construct adjacency matrix of upwind graph wrt flux.  Column
-   indices are not sorted. */
+   indices are not sorted.  The upwind cell across an interior face
+   is simply the other cell of the face, so a single pass over the
+   cell faces suffices. */
 // ---------------------------------------------------------------------
 static void
 make_upwind_graph(int           nc       ,
@@ -39,33 +41,15 @@ make_upwind_graph(int           nc       ,
                   const int    *face2cell,
                   const double *flux     ,
                   int          *ia       ,
-                  int          *ja       ,
-                  int          *work     )
+                  int          *ja       )
 // ---------------------------------------------------------------------
 {
     /* Using topology (conn, cptr), and direction, construct adjacency
        matrix of graph. */
 
-    int i, j, p, f, positive_sign, boundaryface;
+    int i, j, p, f, c1, c2, positive_sign;
     double theflux;
 
-    /* For each face, store upwind cell in work array */
-    for (i=0; i<nc; ++i)
-    {
-        for (j=faceptr[i]; j<faceptr[i+1]; ++j)
-        {
-            f  = cellfaces[j];
-            positive_sign = (i == face2cell[2*f]);
-            theflux = positive_sign ? flux[f] : -flux[f];
-
-            if ( theflux > 0  )
-            {
-                /* i is upwind cell for face f */
-                work[f] = i;
-            }
-        }
-    }
-
     /* Fill ia and ja */
     p = 0;
     ia[0] = p;
@@ -73,22 +57,23 @@ make_upwind_graph(int           nc       ,
     {
         for (j=faceptr[i]; j<faceptr[i+1]; ++j)
         {
-
             f  = cellfaces[j];
-            boundaryface = (face2cell[2*f+0] == -1) ||
-                           (face2cell[2*f+1] == -1);
+            c1 = face2cell[2*f+0];
+            c2 = face2cell[2*f+1];
 
-            if ( boundaryface )
+            if ( (c1 == -1) || (c2 == -1) )
             {
+                /* boundary face */
                 continue;
             }
 
-            positive_sign = (i == face2cell[2*f]);
+            positive_sign = (i == c1);
             theflux = positive_sign ? flux[f] : -flux[f];
 
             if ( theflux < 0)
             {
-                ja[p++] = work[f];
+                /* other cell is upwind cell for face f */
+                ja[p++] = positive_sign ? c2 : c1;
             }
         }
         ia[i+1] = p;
@@ -110,7 +95,7 @@ compute_reorder_sequence_graph(int           nc,
 // ---------------------------------------------------------------------
 {
     make_upwind_graph(nc, cellfaces, facepos, face2cell,
-                      flux, ia, ja, work);
+                      flux, ia, ja);
 
     tarjan (nc, ia, ja, sequence, components, ncomponents, work);
 
@@ -119,6 +104,23 @@ compute_reorder_sequence_graph(int           nc,
 }
 
 
+// ---------------------------------------------------------------------
+size_t
+compute_sequence_workspace_bytes(const struct UnstructuredGrid* grid,
+                                 int                            graph_supplied)
+// ---------------------------------------------------------------------
+{
+    const std::size_t nc = grid->number_of_cells;
+    const std::size_t nf = grid->number_of_faces;
+
+    std::size_t n = tarjan_workspace_size(nc);
+    if (!graph_supplied) {
+        n += (nc + 1) + nf;     // ia, ja
+    }
+    return n * sizeof(int);
+}
+
+
 // ---------------------------------------------------------------------
 void
 compute_sequence(const struct UnstructuredGrid* grid       ,
@@ -130,9 +132,8 @@ compute_sequence(const struct UnstructuredGrid* grid       ,
 {
     const std::size_t nc = grid->number_of_cells;
     const std::size_t nf = grid->number_of_faces;
-    const std::size_t sz = std::max(nf, 3 * nc);
 
-    std::vector<int> work(sz);
+    std::vector<int> work(tarjan_workspace_size(nc));
     std::vector<int> ia  (nc + 1);
     std::vector<int> ja  (nf);  // A bit too much.
 
@@ -160,10 +161,8 @@ compute_sequence_graph(const struct UnstructuredGrid* grid       ,
 // ---------------------------------------------------------------------
 {
     const std::size_t nc = grid->number_of_cells;
-    const std::size_t nf = grid->number_of_faces;
-    const std::size_t sz = std::max(nf, 3 * nc);
 
-    std::vector<int> work(sz);
+    std::vector<int> work(tarjan_workspace_size(nc));
 
     compute_reorder_sequence_graph(grid->number_of_cells,
                                    grid->cell_faces,
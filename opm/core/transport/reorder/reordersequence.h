@@ -11,6 +11,8 @@
  * down-stream cells.
  */
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
@@ -138,6 +140,26 @@ compute_sequence_graph(const struct UnstructuredGrid *grid       ,
                        int                           *ia         ,
                        int                           *ja         );
 
+
+/**
+ * Temporary memory allocated by compute_sequence() or
+ * compute_sequence_graph() for a particular grid, in addition to the
+ * caller's output arrays.  Allows checking the memory footprint of the
+ * ordering up front, before processing very large models.
+ *
+ * \param[in] grid           Grid structure.
+ *
+ * \param[in] graph_supplied Non-zero for compute_sequence_graph(),
+ *                           which stores the upwind graph in the
+ *                           caller's arrays, zero for
+ *                           compute_sequence().
+ *
+ * \return Number of bytes.
+ */
+size_t
+compute_sequence_workspace_bytes(const struct UnstructuredGrid *grid,
+                                 int                            graph_supplied);
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
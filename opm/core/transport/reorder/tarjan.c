@@ -23,6 +23,7 @@ SOFTWARE.
 #include "config.h"
 #include <assert.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef MATLAB_MEX_FILE
 #include "tarjan.h"
@@ -31,15 +32,20 @@ SOFTWARE.
 #endif
 
 
-static void
-clear_vector(size_t n, int *v)
-{
-    size_t i;
+/* Per-vertex scratch data is interleaved, WORK[3*v + TIME], ..., so
+   that visiting a vertex touches a single cache line rather than one
+   line in each of three separate arrays. */
+enum { TIME = 0, LINK = 1, STATUS = 2, NDATA = 3 };
+
 
-    for (i = 0; i < n; i++) { v[i] = 0; }
+/*--------------------------------------------------------------------*/
+size_t
+tarjan_workspace_size(size_t nv)
+/*--------------------------------------------------------------------*/
+{
+    return NDATA * nv;
 }
 
-static int min(int a, int b){ return a < b? a : b;}
 
 /*
   Compute the strong components of directed graph G(edges, vertices),
@@ -63,147 +69,172 @@ static int min(int a, int b){ return a < b? a : b;}
   ncomp - number of strong components.
 
   work  - block of memory of size 3*nv*sizeof(int).
+
+  The depth-first search uses explicit stacks (stored at the end of
+  VERT and COMP), so there is no recursion regardless of graph size.
  */
 
-/*--------------------------------------------------------------------*/
-void
-tarjan (int nv, const int *ia, const int *ja, int *vert, int *comp,
-        int *ncomp, int *work)
-/*--------------------------------------------------------------------*/
-{
-    /* Hint: end of VERT and COMP are used as stacks. */
+/*
+  The algorithm is written once, as a macro, and instantiated for int
+  and int64_t indices below so that the two versions cannot drift
+  apart.  IDX is the index type.
+ */
+#define TARJAN_DEFINE(NAME, IDX)                                        \
+void                                                                    \
+NAME (IDX nv, const IDX *ia, const IDX *ja, IDX *vert, IDX *comp,       \
+      IDX *ncomp, IDX *work)                                            \
+{                                                                       \
+    /* Hint: end of VERT and COMP are used as stacks. */                \
+                                                                        \
+    enum {DONE=-2, REMAINING=-1};                                       \
+    IDX  c, v, seed, child;                                             \
+    IDX  i;                                                             \
+    IDX *cdata;                                                         \
+                                                                        \
+    IDX *stack   = comp + nv;                                           \
+    IDX *bottom  = stack;                                               \
+    IDX *cstack  = vert + nv-1;                                         \
+    IDX *cbottom = cstack;                                              \
+                                                                        \
+    IDX  t       = 0;                                                   \
+    IDX  pos     = 0;                                                   \
+                                                                        \
+    (void) cbottom;             /* Used in assertions only. */          \
+                                                                        \
+    for (i = 0; i < NDATA*nv; ++i) { work[i] = 0; }                     \
+    for (i = 0; i < nv;       ++i) { vert[i] = 0; }                     \
+    for (i = 0; i < nv + 1;   ++i) { comp[i] = 0; }                     \
+                                                                        \
+    /* Init status all vertices */                                      \
+    for (i=0; i<nv; ++i)                                                \
+    {                                                                   \
+        work[NDATA*i + STATUS] = REMAINING;                             \
+    }                                                                   \
+                                                                        \
+    *ncomp  = 0;                                                        \
+    *comp++ = pos;                                                      \
+                                                                        \
+    seed = 0;                                                           \
+    while (seed < nv)                                                   \
+    {                                                                   \
+        if (work[NDATA*seed + STATUS] == DONE)                          \
+        {                                                               \
+            ++seed;                                                     \
+            continue;                                                   \
+        }                                                               \
+                                                                        \
+        /* push seed */                                                 \
+        *stack-- = seed;                                                \
+                                                                        \
+        t = 0;                                                          \
+                                                                        \
+        while ( stack != bottom )                                       \
+        {                                                               \
+            /* peek c */                                                \
+            c     = *(stack+1);                                         \
+            cdata = work + NDATA*c;                                     \
+                                                                        \
+            assert(cdata[STATUS] != DONE);                              \
+            assert(cdata[STATUS] >= -2);                                \
+                                                                        \
+            if (cdata[STATUS] == REMAINING)                             \
+            {                                                           \
+                /* number of descendants of c */                        \
+                cdata[STATUS] = ia[c+1]-ia[c];                          \
+                cdata[TIME]   = cdata[LINK] = t++;                      \
+                                                                        \
+                /* push c on strongcomp stack */                        \
+                *cstack-- = c;                                          \
+            }                                                           \
+                                                                        \
+            /* if all descendants are processed */                      \
+            if (cdata[STATUS] == 0)                                     \
+            {                                                           \
+                /* if c is root of strong component */                  \
+                if (cdata[LINK] == cdata[TIME])                         \
+                {                                                       \
+                    do                                                  \
+                    {                                                   \
+                        assert (cstack != cbottom);                     \
+                                                                        \
+                        /* pop strong component stack */                \
+                        v = *++cstack;                                  \
+                        work[NDATA*v + STATUS] = DONE;                  \
+                                                                        \
+                        /* store vertex in VERT */                      \
+                        vert[pos++]  = v;                               \
+                    }                                                   \
+                    while ( v != c );                                   \
+                                                                        \
+                    /* store end point of component */                  \
+                    *comp++ = pos;                                      \
+                    ++*ncomp;                                           \
+                }                                                       \
+                                                                        \
+                /* pop c */                                             \
+                ++stack;                                                \
+                                                                        \
+                if (stack != bottom)                                    \
+                {                                                       \
+                    IDX *pdata = work + NDATA*(*(stack+1));             \
+                    if (cdata[LINK] < pdata[LINK]) {                    \
+                        pdata[LINK] = cdata[LINK];                      \
+                    }                                                   \
+                }                                                       \
+            }                                                           \
+                                                                        \
+            /* if there are more descendants to consider */             \
+            else                                                        \
+            {                                                           \
+                IDX *chdata;                                            \
+                                                                        \
+                assert(cdata[STATUS] > 0);                              \
+                                                                        \
+                child  = ja[ia[c] + cdata[STATUS]-1];                   \
+                chdata = work + NDATA*child;                            \
+                /* decrement descendant count of c*/                    \
+                --cdata[STATUS];                                        \
+                                                                        \
+                if (chdata[STATUS] == REMAINING)                        \
+                {                                                       \
+                    /* push child */                                    \
+                    *stack-- = child;                                   \
+                }                                                       \
+                else if (chdata[STATUS] >= 0)                           \
+                {                                                       \
+                    if (chdata[TIME] < cdata[LINK]) {                   \
+                        cdata[LINK] = chdata[TIME];                     \
+                    }                                                   \
+                }                                                       \
+                else                                                    \
+                {                                                       \
+                    assert(chdata[STATUS] == DONE);                     \
+                }                                                       \
+            }                                                           \
+        }                                                               \
+        assert (cstack == cbottom);                                     \
+    }                                                                   \
+}
 
-    enum {DONE=-2, REMAINING=-1};
-    int  c, v, seed, child;
-    int  i;
 
-    int *stack  = comp + nv;
-    int *bottom = stack;
-    int *cstack = vert + nv-1;
+/*--------------------------------------------------------------------*/
+TARJAN_DEFINE(tarjan, int)
+/*--------------------------------------------------------------------*/
 
-#if !defined(NDEBUG)
-    int *cbottom = cstack;
-#endif
 
-    int  t      = 0;
-    int  pos    = 0;
+/*
+  64-bit index version of tarjan(), for graphs whose number of
+  vertices or edges exceeds the range of int.  Same algorithm and
+  storage scheme.
 
-    int *time   = work;
-    int *link   = time + nv;
-    int *status = link + nv; /* dual usage... */
+  work  - block of memory of size 3*nv*sizeof(int64_t).
+ */
 
-    clear_vector(3 * ((size_t) nv), work);
-    clear_vector(1 * ((size_t) nv), vert);
-    clear_vector(1 + ((size_t) nv), comp);
+/*--------------------------------------------------------------------*/
+TARJAN_DEFINE(tarjan_64, int64_t)
+/*--------------------------------------------------------------------*/
 
-    /* Init status all vertices */
-    for (i=0; i<nv; ++i)
-    {
-        status[i] = REMAINING;
-    }
-
-    *ncomp  = 0;
-    *comp++ = pos;
-
-    seed = 0;
-    while (seed < nv)
-    {
-        if (status[seed] == DONE)
-        {
-            ++seed;
-            continue;
-        }
-
-        /* push seed */
-        *stack-- = seed;
-
-        t = 0;
-
-        while ( stack != bottom )
-        {
-            /* peek c */
-            c = *(stack+1);
-
-            assert(status[c] != DONE);
-            assert(status[c] >= -2);
-
-            if (status[c] == REMAINING)
-            {
-                /* number of descendants of c */
-                status[c] = ia[c+1]-ia[c];
-                time[c]   = link[c] = t++;
-
-                /* push c on strongcomp stack */
-                *cstack-- = c;
-            }
-
-
-
-            /* if all descendants are processed */
-            if (status[c] == 0)
-            {
-
-                /* if c is root of strong component */
-                if (link[c] == time[c])
-                {
-                    do
-                    {
-                        assert (cstack != cbottom);
-
-                        /* pop strong component stack */
-                        v         = *++cstack;
-                        status[v] = DONE;
-
-                        /* store vertex in VERT */
-                        vert[pos++]  = v;
-                    }
-                    while ( v != c );
-
-                    /* store end point of component */
-                    *comp++ = pos;
-                    ++*ncomp;
-                }
-
-                /* pop c */
-                ++stack;
-
-                if (stack != bottom)
-                {
-                    link[*(stack+1)] = min(link[*(stack+1)], link[c]);
-                }
-            }
-
-
-
-            /* if there are more descendants to consider */
-            else
-            {
-                assert(status[c] > 0);
-
-                child = ja[ia[c] + status[c]-1];
-                /* decrement descendant count of c*/
-                --status[c];
-
-                if (status[child] == REMAINING)
-                {
-                    /* push child */
-                    *stack-- = child;
-
-                }
-                else if (status[child] >= 0)
-                {
-                    link[c] = min(link[c], time[child]);
-
-                }
-                else
-                {
-                    assert(status[child] == DONE);
-                }
-            }
-        }
-        assert (cstack == cbottom);
-    }
-}
+#undef TARJAN_DEFINE
 
 /* Local Variables:    */
 /* c-basic-offset:4    */
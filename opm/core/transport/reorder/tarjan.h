@@ -34,6 +34,9 @@ SOFTWARE.
 #ifndef TARJAN_H_INCLUDED
 #define TARJAN_H_INCLUDED
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
@@ -65,7 +68,8 @@ extern "C" {
  *
  * \param[out] work Pointer to a scratch array represented as a block
  *                  of memory capable of holding <CODE>3 * nv</CODE>
- *                  elements of type <CODE>int</CODE>.
+ *                  elements of type <CODE>int</CODE>.  See
+ *                  tarjan_workspace_size().
  */
 void
 tarjan(int        nv   ,
@@ -76,6 +80,35 @@ tarjan(int        nv   ,
        int       *ncomp,
        int       *work );
 
+
+/**
+ * Compute the strongly connected components of a directed graph whose
+ * number of vertices or edges does not fit in an <CODE>int</CODE>.
+ *
+ * Identical to tarjan() except that all indices and counts, and the
+ * scratch array, are of type <CODE>int64_t</CODE>.
+ */
+void
+tarjan_64(int64_t        nv   ,
+          const int64_t *ia   ,
+          const int64_t *ja   ,
+          int64_t       *vert ,
+          int64_t       *comp ,
+          int64_t       *ncomp,
+          int64_t       *work );
+
+
+/**
+ * Number of elements in the scratch array of tarjan() and
+ * tarjan_64().  Along with the arrays <CODE>vert</CODE> (@c nv
+ * elements) and <CODE>comp</CODE> (<CODE>nv + 1</CODE> elements),
+ * which double as the search stacks, this is all the memory used.
+ *
+ * \param[in] nv Number of graph vertices.
+ */
+size_t
+tarjan_workspace_size(size_t nv);
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -62,6 +62,10 @@ namespace Opm {
 	    /// @return the domain as a pair of doubles.
 	    std::pair<double, double> domain();
 
+	    /// @brief Get the number of samples.
+	    /// @return the number of y values.
+	    int numSamples() const;
+
 	    /// @brief Rescale the domain.
 	    /// @param new_domain the new domain as a pair of doubles.
 	    void rescaleDomain(std::pair<double, double> new_domain);
@@ -152,6 +156,14 @@ namespace Opm {
 	    return std::make_pair(xmin_, xmax_);
 	}
 
+	template<typename T>
+	inline int
+	UniformTableLinear<T>
+	::numSamples() const
+	{
+	    return y_values_.size();
+	}
+
 	template<typename T>
 	inline void
 	UniformTableLinear<T>
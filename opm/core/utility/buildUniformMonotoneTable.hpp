@@ -23,6 +23,10 @@
 #include <opm/core/utility/MonotCubicInterpolator.hpp>
 #include <opm/core/utility/UniformTableLinear.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace Opm {
 
     template <typename T>
@@ -43,6 +47,94 @@ namespace Opm {
         table = UniformTableLinear<T>(xmin, xmax, uniform_yv);
     }
 
+    /// The largest error of linear interpolation in the samples yv of
+    /// f, uniformly spaced on [xmin, xmax], measured at the quarter
+    /// points of each interval relative to the largest magnitude of f
+    /// at the samples.
+    template <class Function>
+    double uniformTableError(const Function& f,
+                             const double xmin,
+                             const double xmax,
+                             const std::vector<double>& yv)
+    {
+        const int intervals = yv.size() - 1;
+        double scale = 0.0;
+        for (const double y : yv) {
+            scale = std::max(scale, std::fabs(y));
+        }
+        scale = (scale > 0.0) ? scale : 1.0;
+        double error = 0.0;
+        for (int i = 0; i < intervals; ++i) {
+            for (int q = 1; q < 4; ++q) {
+                const double w = (i + 0.25*q)/double(intervals);
+                const double interp = (1.0 - 0.25*q)*yv[i] + 0.25*q*yv[i + 1];
+                error = std::max(error, std::fabs(f((1.0 - w)*xmin + w*xmax) - interp)/scale);
+            }
+        }
+        return error;
+    }
+
+    /// Sample the function f at the given number of uniformly spaced
+    /// points on [xmin, xmax].
+    /// \return  The relative error of the table, see uniformTableError().
+    template <class Function>
+    double sampleUniformTable(const Function& f,
+                              const double xmin,
+                              const double xmax,
+                              const int samples,
+                              UniformTableLinear<double>& table)
+    {
+        std::vector<double> yv(samples);
+        for (int i = 0; i < samples; ++i) {
+            const double w = double(i)/double(samples - 1);
+            yv[i] = f((1.0 - w)*xmin + w*xmax);
+        }
+        table = UniformTableLinear<double>(xmin, xmax, yv);
+        return uniformTableError(f, xmin, xmax, yv);
+    }
+
+    /// Sample the function f uniformly on [xmin, xmax], doubling the
+    /// number of intervals (starting from 16) until linear
+    /// interpolation in the samples is within tolerance of f, or the
+    /// table would get more than max_samples samples. The error is
+    /// measured as by uniformTableError(). Functions with jumps, such
+    /// as derivatives of piecewise linear functions, never get within
+    /// tolerance and end up with max_samples samples.
+    /// \return  The largest relative error found for the final table.
+    template <class Function>
+    double buildUniformTable(const Function& f,
+                             const double xmin,
+                             const double xmax,
+                             const double tolerance,
+                             const int max_samples,
+                             UniformTableLinear<double>& table)
+    {
+        int intervals = 16;
+        std::vector<double> yv(intervals + 1);
+        for (int i = 0; i <= intervals; ++i) {
+            const double w = double(i)/double(intervals);
+            yv[i] = f((1.0 - w)*xmin + w*xmax);
+        }
+        for (;;) {
+            const double error = uniformTableError(f, xmin, xmax, yv);
+            if (error <= tolerance || 2*intervals + 1 > max_samples) {
+                table = UniformTableLinear<double>(xmin, xmax, yv);
+                return error;
+            }
+            // Keep the samples we have, and add the midpoints.
+            std::vector<double> refined(2*intervals + 1);
+            for (int i = 0; i <= intervals; ++i) {
+                refined[2*i] = yv[i];
+            }
+            for (int i = 0; i < intervals; ++i) {
+                const double w = (i + 0.5)/double(intervals);
+                refined[2*i + 1] = f((1.0 - w)*xmin + w*xmax);
+            }
+            yv.swap(refined);
+            intervals *= 2;
+        }
+    }
+
 } // namespace Opm
 
 
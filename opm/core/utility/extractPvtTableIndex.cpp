@@ -44,4 +44,18 @@ void extractPvtTableIndex(std::vector<int> &pvtTableIdx,
     }
 }
 
+void extractSatTableIndex(std::vector<int> &satTableIdx,
+                          const Opm::EclipseState& eclState,
+                          size_t numCompressed,
+                          const int *compressedToCartesianCellIdx)
+{
+    const std::vector<int>& satnumData = eclState.get3DProperties().getIntGridProperty("SATNUM").getData();
+    satTableIdx.resize(numCompressed);
+    for (size_t cellIdx = 0; cellIdx < numCompressed; ++ cellIdx) {
+        size_t cartesianCellIdx = compressedToCartesianCellIdx ? compressedToCartesianCellIdx[cellIdx]:cellIdx;
+        assert(cartesianCellIdx < satnumData.size());
+        satTableIdx[cellIdx] = satnumData[cartesianCellIdx] - 1;
+    }
+}
+
 }
@@ -28,6 +28,13 @@ void extractPvtTableIndex(std::vector<int> &pvtTableIdx,
                           size_t numCompressed,
                           const int *compressedToCartesianCellIdx);
 
+/// Saturation table index (SATNUM - 1) of each compressed cell, in the
+/// same way as extractPvtTableIndex() for PVTNUM.
+void extractSatTableIndex(std::vector<int> &satTableIdx,
+                          const Opm::EclipseState& eclState,
+                          size_t numCompressed,
+                          const int *compressedToCartesianCellIdx);
+
 }
 
 #endif // OPM_EXTRACT_PVT_TABLE_INDEX_HPP
@@ -34,6 +34,7 @@
 #include <opm/core/grid/GridManager.hpp>
 #include <opm/core/grid.h>
 #include <cmath>
+#include <stdexcept>
 
 using namespace Opm;
 
@@ -90,6 +91,47 @@ BOOST_AUTO_TEST_CASE(cartesian_2d_b)
     }
 }
 
+
+BOOST_AUTO_TEST_CASE(cartesian_3d)
+{
+    const GridManager gm(4, 4, 4);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    BOOST_CHECK_THROW(AnisotropicEikonal2d ae2(grid), std::logic_error);
+    AnisotropicEikonal3d ae(grid);
+
+    // Unit metric in all cells, start in the corner cell.
+    std::vector<double> metric;
+    for (int cell = 0; cell < grid.number_of_cells; ++cell) {
+        const double unit[] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+        metric.insert(metric.end(), unit, unit + 9);
+    }
+    BOOST_REQUIRE_EQUAL(metric.size(), grid.number_of_cells*grid.dimensions*grid.dimensions);
+    const std::vector<int> start = { 0 };
+    std::vector<double> sol;
+    ae.solve(metric.data(), start, sol);
+    BOOST_REQUIRE_EQUAL(sol.size(), grid.number_of_cells);
+
+    // Exact along the axes, and symmetric in the coordinates.
+    for (int i = 0; i < 4; ++i) {
+        BOOST_CHECK_CLOSE(sol[i], double(i), 1e-8);
+        BOOST_CHECK_CLOSE(sol[4*i], double(i), 1e-8);
+        BOOST_CHECK_CLOSE(sol[16*i], double(i), 1e-8);
+    }
+    for (int k = 0; k < 4; ++k) {
+        for (int j = 0; j < 4; ++j) {
+            for (int i = 0; i < 4; ++i) {
+                const double val = sol[i + 4*j + 16*k];
+                BOOST_CHECK_CLOSE(val, sol[j + 4*k + 16*i], 1e-8);
+                BOOST_CHECK_CLOSE(val, sol[k + 4*i + 16*j], 1e-8);
+                // Not shorter than the straight line.
+                BOOST_CHECK(val >= std::sqrt(double(i*i + j*j + k*k)) - 1e-8);
+            }
+        }
+    }
+    // Exact along the diagonal, which is a line through neighbours.
+    BOOST_CHECK_CLOSE(sol[3 + 4*3 + 16*3], 3.0*std::sqrt(3.0), 1e-8);
+}
+
 #else // BOOST_HEAP_AVAILABLE is false
 
 BOOST_AUTO_TEST_CASE(dummy)
@@ -0,0 +1,167 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE BCSRMatrixTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/core/linalg/sparse_sys.h>
+#include <opm/core/transport/implicit/BCSRMatrixBlockAssembler.hpp>
+#include <opm/core/transport/implicit/CSRMatrixBlockAssembler.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace
+{
+    // Tridiagonal block pattern on 'm' block rows.
+    std::vector<int> neighbours(int i, int m)
+    {
+        std::vector<int> conn;
+        if (i > 0)     { conn.push_back(i - 1); }
+        conn.push_back(i);
+        if (i < m - 1) { conn.push_back(i + 1); }
+        return conn;
+    }
+
+    // Column major ndof-by-ndof block depending on (i,j).
+    std::vector<double> block(int ndof, int i, int j)
+    {
+        std::vector<double> b(ndof * ndof);
+        for (int k = 0; k < ndof * ndof; ++k) {
+            b[k] = (i == j ? 10.0 : -1.0) + 0.1*k + 0.01*(i + 2*j);
+        }
+        return b;
+    }
+
+    template <class Matrix>
+    void assemble(Opm::ImplicitTransportDefault::MatrixBlockAssembler<Matrix>& mba,
+                  int ndof, int m)
+    {
+        mba.setSize(ndof, m, m, 3 * m);
+        for (int i = 0; i < m; ++i) {
+            mba.createBlockRow(i, neighbours(i, m), ndof);
+        }
+        for (int i = 0; i < m; ++i) {
+            const std::vector<int> conn = neighbours(i, m);
+            for (std::size_t k = 0; k < conn.size(); ++k) {
+                mba.assembleBlock(ndof, i, conn[k], block(ndof, i, conn[k]));
+            }
+        }
+    }
+
+    std::vector<double> csrMatvec(const CSRMatrix& A, const std::vector<double>& x)
+    {
+        std::vector<double> y(A.m, 0.0);
+        for (std::size_t i = 0; i < A.m; ++i) {
+            for (int k = A.ia[i]; k < A.ia[i + 1]; ++k) {
+                y[i] += A.sa[k] * x[A.ja[k]];
+            }
+        }
+        return y;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BlockAssemblyMatchesScalar)
+{
+    using namespace Opm::ImplicitTransportDefault;
+
+    const int m = 7;
+    for (int ndof = 1; ndof <= BCSR_MAX_BLOCK_SIZE; ++ndof) {
+        MatrixBlockAssembler<BCSRMatrix> bmba;
+        MatrixBlockAssembler<CSRMatrix>  smba;
+        assemble(bmba, ndof, m);
+        assemble(smba, ndof, m);
+
+        const BCSRMatrix& B = bmba.matrix();
+        const CSRMatrix&  S = smba.matrix();
+
+        BOOST_CHECK_EQUAL(B.m, std::size_t(m));
+        BOOST_CHECK_EQUAL(B.bs, ndof);
+        BOOST_CHECK_EQUAL(B.nnz * ndof * ndof, S.nnz);
+
+        std::vector<double> x(m * ndof);
+        for (std::size_t k = 0; k < x.size(); ++k) {
+            x[k] = 1.0 + 0.5*k;
+        }
+
+        std::vector<double> yb(x.size());
+        bcsrmatrix_matvec(&B, &x[0], &yb[0]);
+        const std::vector<double> ys = csrMatvec(S, x);
+
+        for (std::size_t k = 0; k < x.size(); ++k) {
+            BOOST_CHECK_CLOSE(yb[k], ys[k], 1.0e-12);
+        }
+
+        CSRMatrix* E = bcsrmatrix_expand(&B);
+        BOOST_REQUIRE(E != 0);
+        BOOST_CHECK_EQUAL(E->m,   S.m);
+        BOOST_CHECK_EQUAL(E->nnz, S.nnz);
+        for (std::size_t k = 0; k <= S.m; ++k) {
+            BOOST_CHECK_EQUAL(E->ia[k], S.ia[k]);
+        }
+        for (std::size_t k = 0; k < S.nnz; ++k) {
+            BOOST_CHECK_EQUAL(E->ja[k], S.ja[k]);
+            BOOST_CHECK_EQUAL(E->sa[k], S.sa[k]);
+        }
+        csrmatrix_delete(E);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PushbackConstruction)
+{
+    // 2x2 block diagonal matrix with one off-diagonal block.
+    BCSRMatrix* A = bcsrmatrix_new_count_nnz(2, 2);
+    BOOST_REQUIRE(A != 0);
+
+    A->ia[1] = 2;
+    A->ia[2] = 1;
+    BOOST_CHECK_EQUAL(bcsrmatrix_new_elms_pushback(A), std::size_t(3));
+
+    A->ja[A->ia[1]++] = 1;
+    A->ja[A->ia[1]++] = 0;
+    A->ja[A->ia[2]++] = 1;
+    bcsrmatrix_sortrows(A);
+    bcsrmatrix_zero(A);
+
+    const double d[] = { 2.0, 1.0, 0.0, 3.0 };
+    const double o[] = { 1.0, 0.0, 0.0, 1.0 };
+    bcsrmatrix_assemble_block(0, 0, d, A);
+    bcsrmatrix_assemble_block(0, 1, o, A);
+    bcsrmatrix_assemble_block(1, 1, d, A);
+
+    BOOST_CHECK_EQUAL(bcsrmatrix_elm_index(0, 1, A), std::size_t(1));
+
+    const double x[] = { 1.0, 2.0, 3.0, 4.0 };
+    double y[4];
+    bcsrmatrix_matvec(A, x, y);
+
+    BOOST_CHECK_CLOSE(y[0],  7.0, 1.0e-12);
+    BOOST_CHECK_CLOSE(y[1], 10.0, 1.0e-12);
+    BOOST_CHECK_CLOSE(y[2], 10.0, 1.0e-12);
+    BOOST_CHECK_CLOSE(y[3], 12.0, 1.0e-12);
+
+    bcsrmatrix_delete(A);
+}
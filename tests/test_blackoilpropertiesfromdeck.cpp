@@ -0,0 +1,397 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+/* --- Boost.Test boilerplate --- */
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define NVERBOSE  // Suppress own messages when throw()ing
+
+#define BOOST_TEST_MODULE BlackoilPropertiesFromDeckTest
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+/* --- our own headers --- */
+
+#include <opm/core/grid.h>
+#include <opm/core/grid/GridManager.hpp>
+
+#include <opm/core/props/BlackoilPropertiesFromDeck.hpp>
+#include <opm/core/props/BlackoilPhases.hpp>
+
+#include <opm/parser/eclipse/Parser/Parser.hpp>
+#include <opm/parser/eclipse/Parser/ParseContext.hpp>
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <cmath>
+#include <vector>
+
+#define CHECK(value, expected, reltol) \
+{ \
+  if (std::fabs((expected)) < 1.e-14) \
+    BOOST_CHECK_SMALL((value), (reltol)); \
+  else \
+    BOOST_CHECK_CLOSE((value), (expected), (reltol)); \
+}
+
+namespace
+{
+    // Pressures from 100 to 200 bar, within all the PVT tables of
+    // equil_liveoil.DATA, and surface volumes giving both saturated
+    // and undersaturated oil.
+    struct PvtPoints
+    {
+        explicit PvtPoints(const int n)
+            : p(n), T(n, 273.15 + 20.0), z(3*n), cells(n)
+        {
+            for (int i = 0; i < n; ++i) {
+                p[i] = 1.0e7 + 1.0e7*i/(n - 1);
+                z[3*i + 0] = 1.0;
+                z[3*i + 1] = 1.0;
+                z[3*i + 2] = (i % 2 == 0) ? 10.0 : 200.0;
+                cells[i] = i;
+            }
+        }
+        std::vector<double> p;
+        std::vector<double> T;
+        std::vector<double> z;
+        std::vector<int> cells;
+    };
+
+    // Forwards everything but pvtProperties(), to test the default
+    // implementation of BlackoilPropertiesInterface.
+    class ForwardingProps : public Opm::BlackoilPropertiesInterface
+    {
+    public:
+        explicit ForwardingProps(Opm::BlackoilPropertiesInterface& props)
+            : props_(props)
+        {
+        }
+        int numDimensions() const { return props_.numDimensions(); }
+        int numCells() const { return props_.numCells(); }
+        const int* cellPvtRegionIndex() const { return props_.cellPvtRegionIndex(); }
+        const double* porosity() const { return props_.porosity(); }
+        const double* permeability() const { return props_.permeability(); }
+        int numPhases() const { return props_.numPhases(); }
+        Opm::PhaseUsage phaseUsage() const { return props_.phaseUsage(); }
+        void viscosity(const int n, const double* p, const double* T, const double* z,
+                       const int* cells, double* mu, double* dmudp) const
+        {
+            props_.viscosity(n, p, T, z, cells, mu, dmudp);
+        }
+        void matrix(const int n, const double* p, const double* T, const double* z,
+                    const int* cells, double* A, double* dAdp) const
+        {
+            props_.matrix(n, p, T, z, cells, A, dAdp);
+        }
+        void density(const int n, const double* A, const int* cells, double* rho) const
+        {
+            props_.density(n, A, cells, rho);
+        }
+        const double* surfaceDensity(int regionIdx = 0) const { return props_.surfaceDensity(regionIdx); }
+        void relperm(const int n, const double* s, const int* cells, double* kr, double* dkrds) const
+        {
+            props_.relperm(n, s, cells, kr, dkrds);
+        }
+        void capPress(const int n, const double* s, const int* cells, double* pc, double* dpcds) const
+        {
+            props_.capPress(n, s, cells, pc, dpcds);
+        }
+        void satRange(const int n, const int* cells, double* smin, double* smax) const
+        {
+            props_.satRange(n, cells, smin, smax);
+        }
+        void swatInitScaling(const int cell, const double pcow, double& swat)
+        {
+            props_.swatInitScaling(cell, pcow, swat);
+        }
+    private:
+        Opm::BlackoilPropertiesInterface& props_;
+    };
+
+    // Check pvtProperties() against matrix(), viscosity() and
+    // density(), with B and R taken from A (see matrix()), and check
+    // that asking for derivatives only gives the same derivatives.
+    void checkPvtProperties(const Opm::BlackoilPropertiesInterface& props, const PvtPoints& pts)
+    {
+        const int np = props.numPhases();
+        const int n = pts.p.size();
+        const Opm::PhaseUsage pu = props.phaseUsage();
+        const int o = pu.phase_pos[Opm::BlackoilPhases::Liquid];
+        const int g = pu.phase_pos[Opm::BlackoilPhases::Vapour];
+
+        std::vector<double> A(n*np*np), dAdp(n*np*np), mu(n*np), dmudp(n*np), rho(n*np);
+        props.matrix(n, &pts.p[0], &pts.T[0], &pts.z[0], &pts.cells[0], &A[0], &dAdp[0]);
+        props.viscosity(n, &pts.p[0], &pts.T[0], &pts.z[0], &pts.cells[0], &mu[0], &dmudp[0]);
+        props.density(n, &A[0], &pts.cells[0], &rho[0]);
+
+        std::vector<double> B(n*np), dBdp(n*np), R(n*np), dRdp(n*np);
+        std::vector<double> fA(n*np*np), fdAdp(n*np*np), fmu(n*np), fdmudp(n*np), frho(n*np);
+        Opm::BlackoilPropertiesInterface::PvtOutput out;
+        out.B = &B[0];
+        out.dBdp = &dBdp[0];
+        out.R = &R[0];
+        out.dRdp = &dRdp[0];
+        out.mu = &fmu[0];
+        out.dmudp = &fdmudp[0];
+        out.A = &fA[0];
+        out.dAdp = &fdAdp[0];
+        out.rho = &frho[0];
+        props.pvtProperties(n, &pts.p[0], &pts.T[0], &pts.z[0], &pts.cells[0], out);
+
+        std::vector<double> dBdp_only(n*np), dRdp_only(n*np);
+        Opm::BlackoilPropertiesInterface::PvtOutput out_derivatives;
+        out_derivatives.dBdp = &dBdp_only[0];
+        out_derivatives.dRdp = &dRdp_only[0];
+        props.pvtProperties(n, &pts.p[0], &pts.T[0], &pts.z[0], &pts.cells[0], out_derivatives);
+
+        const double reltol = 1.0e-10;
+        for (int i = 0; i < n*np*np; ++i) {
+            CHECK(fA[i], A[i], reltol);
+            CHECK(fdAdp[i], dAdp[i], reltol);
+        }
+        for (int i = 0; i < n; ++i) {
+            const double* m = &A[i*np*np];
+            const double* dm = &dAdp[i*np*np];
+            for (int phase = 0; phase < np; ++phase) {
+                const int k = i*np + phase;
+                CHECK(fmu[k], mu[k], reltol);
+                CHECK(fdmudp[k], dmudp[k], reltol);
+                CHECK(frho[k], rho[k], reltol);
+
+                // A_pp = 1/B_p, A_og = R_g/B_g and A_go = R_o/B_o.
+                CHECK(1.0/B[k], m[phase + phase*np], reltol);
+                CHECK(-dBdp[k]/(B[k]*B[k]), dm[phase + phase*np], reltol);
+                if (phase == o || phase == g) {
+                    const int other = (phase == o) ? g : o;
+                    CHECK(R[k]/B[k], m[other + phase*np], reltol);
+                }
+                CHECK(dBdp_only[k], dBdp[k], reltol);
+                CHECK(dRdp_only[k], dRdp[k], reltol);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE ()
+
+BOOST_AUTO_TEST_CASE (ViscositySingleCell)
+{
+    // Calls with a single data point in a cell other than the first
+    // must only write that point's values, and dmudp may be null.
+    Opm::GridManager gm(1, 1, 20, 1.0, 1.0, 5.0);
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseFile("equil_liveoil.DATA", parseContext);
+    Opm::EclipseState eclipseState(deck, parseContext);
+    Opm::BlackoilPropertiesFromDeck props(deck, eclipseState, grid, false);
+
+    const int np = 3;
+    const int n = grid.number_of_cells;
+    BOOST_REQUIRE(np == props.numPhases());
+    const PvtPoints pts(n);
+
+    std::vector<double> mu(n*np), dmudp(n*np);
+    props.viscosity(n, &pts.p[0], &pts.T[0], &pts.z[0], &pts.cells[0], &mu[0], &dmudp[0]);
+
+    const double guard = -1.0;
+    const double reltol = 1.0e-12;
+    for (int i = 0; i < n; ++i) {
+        // Room for the point between two guard blocks.
+        std::vector<double> mu1(3*np, guard), dmudp1(3*np, guard);
+        props.viscosity(1, &pts.p[i], &pts.T[i], &pts.z[np*i], &pts.cells[i],
+                        &mu1[np], &dmudp1[np]);
+        for (int phase = 0; phase < np; ++phase) {
+            BOOST_CHECK_EQUAL(mu1[phase], guard);
+            BOOST_CHECK_EQUAL(mu1[2*np + phase], guard);
+            BOOST_CHECK_EQUAL(dmudp1[phase], guard);
+            BOOST_CHECK_EQUAL(dmudp1[2*np + phase], guard);
+            CHECK(mu1[np + phase], mu[np*i + phase], reltol);
+            CHECK(dmudp1[np + phase], dmudp[np*i + phase], reltol);
+        }
+
+        std::vector<double> mu2(np, guard);
+        props.viscosity(1, &pts.p[i], &pts.T[i], &pts.z[np*i], &pts.cells[i], &mu2[0], 0);
+        for (int phase = 0; phase < np; ++phase) {
+            CHECK(mu2[phase], mu[np*i + phase], reltol);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (PvtPropertiesMatchSeparateCalls)
+{
+    Opm::GridManager gm(1, 1, 20, 1.0, 1.0, 5.0);
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseFile("equil_liveoil.DATA", parseContext);
+    Opm::EclipseState eclipseState(deck, parseContext);
+    Opm::BlackoilPropertiesFromDeck props(deck, eclipseState, grid, false);
+    const PvtPoints pts(grid.number_of_cells);
+
+    // The fused evaluation of BlackoilPropertiesFromDeck.
+    checkPvtProperties(props, pts);
+
+    // The default implementation of the interface.
+    ForwardingProps forwarding(props);
+    checkPvtProperties(forwarding, pts);
+}
+
+BOOST_AUTO_TEST_CASE (PvtTables)
+{
+    Opm::GridManager gm(1, 1, 20, 1.0, 1.0, 5.0);
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseFile("equil_liveoil.DATA", parseContext);
+    Opm::EclipseState eclipseState(deck, parseContext);
+    Opm::BlackoilPropertiesFromDeck props(deck, eclipseState, grid, false);
+    Opm::BlackoilPropertiesFromDeck tabulated(deck, eclipseState, grid, false);
+
+    const double tolerance = 1.0e-6;
+    const double error = tabulated.initPvtTables(1.0e7, 2.0e7, 273.15 + 20.0, tolerance);
+    BOOST_CHECK_LE(error, tolerance);
+    BOOST_CHECK_EQUAL(tabulated.pvtTableError(), error);
+    BOOST_CHECK_GE(tabulated.pvtTableDerivativeError(), 0.0);
+    BOOST_CHECK_EQUAL(props.pvtTableError(), 0.0);
+
+    // Half the points have saturated oil and use the tables, the
+    // others are evaluated by the PVT objects.
+    const int np = 3;
+    const int n = grid.number_of_cells;
+    const PvtPoints pts(n);
+    std::vector<double> B(n*np), R(n*np), mu(n*np), rho(n*np);
+    std::vector<double> tB(n*np), tR(n*np), tmu(n*np), trho(n*np);
+    Opm::BlackoilPropertiesInterface::PvtOutput out;
+    out.B = &B[0];
+    out.R = &R[0];
+    out.mu = &mu[0];
+    out.rho = &rho[0];
+    props.pvtProperties(n, &pts.p[0], &pts.T[0], &pts.z[0], &pts.cells[0], out);
+    out.B = &tB[0];
+    out.R = &tR[0];
+    out.mu = &tmu[0];
+    out.rho = &trho[0];
+    tabulated.pvtProperties(n, &pts.p[0], &pts.T[0], &pts.z[0], &pts.cells[0], out);
+
+    // The values vary little over the pressure range, so the error
+    // relative to their largest magnitude is close to the pointwise
+    // relative error. CHECK takes percent.
+    const double reltol = 10.0*100.0*tolerance;
+    for (int i = 0; i < n*np; ++i) {
+        CHECK(tB[i], B[i], reltol);
+        CHECK(tR[i], R[i], reltol);
+        CHECK(tmu[i], mu[i], reltol);
+        CHECK(trho[i], rho[i], reltol);
+    }
+
+    // The separate calls use the tables as well.
+    std::vector<double> tmu2(n*np);
+    tabulated.viscosity(n, &pts.p[0], &pts.T[0], &pts.z[0], &pts.cells[0], &tmu2[0], 0);
+    for (int i = 0; i < n*np; ++i) {
+        CHECK(tmu2[i], tmu[i], 1.0e-12);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (BatchedSaturationFunctions)
+{
+    // The end points of satfuncEPS_B.DATA vary with depth, so the
+    // cells fall in several classes, some with more than one cell.
+    Opm::GridManager gm(1, 1, 10, 1.0, 1.0, 5.0);
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::Deck deck = parser.parseFile("satfuncEPS_B.DATA", parseContext);
+    Opm::EclipseState eclipseState(deck, parseContext);
+
+    Opm::ParameterGroup param;
+    Opm::BlackoilPropertiesFromDeck unbatched(deck, eclipseState, grid, param, false);
+    param.insertParameter("satfunc_batch", "true");
+    Opm::BlackoilPropertiesFromDeck batched(deck, eclipseState, grid, param, false);
+
+    const int np = 3;
+    BOOST_REQUIRE(np == batched.numPhases());
+
+    // Eleven saturations per cell, with the cells of consecutive
+    // data points interleaved so that each class is visited in
+    // several runs.
+    const int nc = grid.number_of_cells;
+    const int ns = 11;
+    const int n = nc*ns;
+    std::vector<double> s(n*np);
+    std::vector<int> cells(n);
+    for (int i = 0; i < n; ++i) {
+        const int k = i / nc;
+        cells[i] = (i % 2 == 0) ? (i/2) % nc : nc - 1 - (i/2) % nc;
+        s[np*i + 0] = 0.1*k;
+        s[np*i + 2] = 0.5*(1.0 - s[np*i + 0])*(k % 3)/2.0;
+        s[np*i + 1] = 1.0 - s[np*i + 0] - s[np*i + 2];
+    }
+
+    std::vector<double> kr(n*np), dkrds(n*np*np), pc(n*np), dpcds(n*np*np);
+    batched.relperm(n, &s[0], &cells[0], &kr[0], &dkrds[0]);
+    batched.capPress(n, &s[0], &cells[0], &pc[0], &dpcds[0]);
+
+    std::vector<double> kr0(n*np), dkrds0(n*np*np), pc0(n*np), dpcds0(n*np*np);
+    unbatched.relperm(n, &s[0], &cells[0], &kr0[0], &dkrds0[0]);
+    unbatched.capPress(n, &s[0], &cells[0], &pc0[0], &dpcds0[0]);
+
+    const double reltol = 1.0e-12;
+    for (int i = 0; i < n*np; ++i) {
+        CHECK(kr[i], kr0[i], reltol);
+        CHECK(pc[i], pc0[i], reltol);
+    }
+    for (int i = 0; i < n*np*np; ++i) {
+        CHECK(dkrds[i], dkrds0[i], reltol);
+        CHECK(dpcds[i], dpcds0[i], reltol);
+    }
+
+    // Without derivatives.
+    std::vector<double> kr1(n*np), pc1(n*np);
+    batched.relperm(n, &s[0], &cells[0], &kr1[0], 0);
+    batched.capPress(n, &s[0], &cells[0], &pc1[0], 0);
+    for (int i = 0; i < n*np; ++i) {
+        CHECK(kr1[i], kr0[i], reltol);
+        CHECK(pc1[i], pc0[i], reltol);
+    }
+
+    // A cell rescaled by SWATINIT no longer shares its class.
+    double swat = 0.5;
+    double swat0 = 0.5;
+    batched.swatInitScaling(8, 1.0e4, swat);
+    unbatched.swatInitScaling(8, 1.0e4, swat0);
+    CHECK(swat, swat0, reltol);
+    batched.capPress(n, &s[0], &cells[0], &pc[0], &dpcds[0]);
+    unbatched.capPress(n, &s[0], &cells[0], &pc0[0], &dpcds0[0]);
+    for (int i = 0; i < n*np; ++i) {
+        CHECK(pc[i], pc0[i], reltol);
+    }
+    for (int i = 0; i < n*np*np; ++i) {
+        CHECK(dpcds[i], dpcds0[i], reltol);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,193 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE CompressedTracersTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/flowdiagnostics/CompressedTracers.hpp>
+#include <opm/core/flowdiagnostics/ColumnarFile.hpp>
+#include <opm/core/flowdiagnostics/FlowDiagnostics.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    // Tracers in the solver layout. Tracer t is nonzero in the cells
+    // t, t + 3, t + 6, ... only, so most values are zero.
+    std::vector<double> tracerField(const int num_cells, const int num_tracers, const double scale)
+    {
+        std::vector<double> tracer(num_cells*num_tracers, 0.0);
+        for (int cell = 0; cell < num_cells; ++cell) {
+            for (int t = 0; t < num_tracers; ++t) {
+                if ((cell - t) % 3 == 0) {
+                    tracer[cell*num_tracers + t] = scale*(0.25 + 0.5*std::fabs(std::sin(cell + 0.7*t)));
+                }
+            }
+        }
+        return tracer;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(StorageSchemes)
+{
+    const int nc = 1100;
+    const std::vector<double> batch1 = tracerField(nc, 3, 1.0);
+    const std::vector<double> batch2 = tracerField(nc, 2, 0.5);
+
+    const CompressedTracers::Storage storage[] = {
+        CompressedTracers::Double, CompressedTracers::Float, CompressedTracers::Sparse
+    };
+    for (int s = 0; s < 3; ++s) {
+        CompressedTracers tracers(nc, storage[s]);
+        tracers.append(batch1, 3);
+        tracers.append(batch2, 2);
+        BOOST_CHECK_EQUAL(tracers.numTracers(), 5);
+        BOOST_CHECK_THROW(tracers.append(batch2, 3), std::runtime_error);
+
+        // Single precision loses accuracy, but nothing else.
+        const double tol = (storage[s] == CompressedTracers::Double) ? 0.0 : 1e-7;
+        std::vector<double> block((700 - 123)*5);
+        tracers.expand(123, 700, &block[0]);
+        for (int cell = 123; cell < 700; ++cell) {
+            for (int t = 0; t < 5; ++t) {
+                const double expected = (t < 3) ? batch1[cell*3 + t] : batch2[cell*2 + t - 3];
+                BOOST_CHECK_SMALL(block[(cell - 123)*5 + t] - expected, tol);
+                BOOST_CHECK_SMALL(tracers.value(t, cell) - expected, tol);
+            }
+        }
+    }
+
+    // Sparse storage keeps about a third of the values, in single precision.
+    CompressedTracers dense(nc, CompressedTracers::Double);
+    CompressedTracers sparse(nc, CompressedTracers::Sparse);
+    dense.append(batch1, 3);
+    sparse.append(batch1, 3);
+    BOOST_CHECK_LT(sparse.memoryUsage(), dense.memoryUsage()/2);
+}
+
+
+BOOST_AUTO_TEST_CASE(WellPairs)
+{
+    const int nc = 1300;
+    const int ni = 3;
+    const int np = 4;
+    const std::vector<double> ftracer = tracerField(nc, ni, 1.0);
+    const std::vector<double> btracer = tracerField(nc, np, 1.0);
+    std::vector<double> porevol(nc);
+    for (int cell = 0; cell < nc; ++cell) {
+        porevol[cell] = 1.0 + 0.1*(cell % 7);
+    }
+
+    CompressedTracers f(nc, CompressedTracers::Sparse);
+    CompressedTracers b(nc, CompressedTracers::Float);
+    f.append(ftracer, ni);
+    b.append(btracer, np);
+    const WellPairVolumes vol = computeWellPairVolumes(porevol, f, b);
+    BOOST_REQUIRE_EQUAL(vol.injectors.size(), ni);
+    BOOST_REQUIRE_EQUAL(vol.producers.size(), np);
+    for (int i = 0; i < ni; ++i) {
+        BOOST_CHECK_EQUAL(vol.injectors[i], i);
+        for (int p = 0; p < np; ++p) {
+            double expected = 0.0;
+            for (int cell = 0; cell < nc; ++cell) {
+                expected += porevol[cell]*ftracer[cell*ni + i]*btracer[cell*np + p];
+            }
+            BOOST_CHECK_CLOSE(vol(i, p), expected, 1e-4);
+        }
+    }
+
+    const CompressedTracers wrong(nc - 1, CompressedTracers::Float);
+    BOOST_CHECK_THROW(computeWellPairVolumes(porevol, wrong, b), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(ColumnarRoundTrip)
+{
+    const int nc = 50;
+    const std::vector<double> batch = tracerField(nc, 2, 1.0);
+    CompressedTracers sparse(nc, CompressedTracers::Sparse);
+    sparse.append(batch, 2);
+    CompressedTracers dense(nc, CompressedTracers::Float);
+    dense.append(batch, 2);
+
+    const std::string filename = "test_compressedtracers.opmcol";
+    std::vector<double> tof(nc);
+    for (int cell = 0; cell < nc; ++cell) {
+        tof[cell] = 0.5*cell;
+    }
+    {
+        ColumnarWriter writer(filename);
+        writer.write("tof", tof);
+        writer.write("empty", std::vector<int>());
+        sparse.write(writer, "s");
+        dense.write(writer, "d");
+        writer.close();
+    }
+
+    ColumnarReader reader(filename);
+    const std::vector<std::string> names = reader.names();
+    BOOST_REQUIRE_EQUAL(names.size(), 8);
+    BOOST_CHECK_EQUAL(names[0], "tof");
+    BOOST_CHECK_EQUAL(names[2], "s0_cells");
+    BOOST_CHECK_EQUAL(names[7], "d1");
+    BOOST_CHECK(reader.has("s1_values"));
+    BOOST_CHECK(!reader.has("s2_values"));
+    BOOST_CHECK_EQUAL(reader.type("d0"), ColumnFloat32);
+    BOOST_CHECK_EQUAL(reader.size("empty"), 0);
+
+    const std::vector<double> tof_read = reader.readDouble("tof");
+    BOOST_CHECK(tof_read == tof);
+    BOOST_CHECK_THROW(reader.readFloat("tof"), std::runtime_error);
+    BOOST_CHECK_THROW(reader.readInt("nonexistent"), std::runtime_error);
+
+    for (int t = 0; t < 2; ++t) {
+        const std::string prefix = (t == 0) ? "0" : "1";
+        const std::vector<int> cells = reader.readInt("s" + prefix + "_cells");
+        const std::vector<float> values = reader.readFloat("s" + prefix + "_values");
+        const std::vector<float> column = reader.readFloat("d" + prefix);
+        BOOST_REQUIRE_EQUAL(cells.size(), values.size());
+        BOOST_REQUIRE_EQUAL(column.size(), nc);
+        std::vector<float> from_sparse(nc, 0.0f);
+        for (std::size_t k = 0; k < cells.size(); ++k) {
+            from_sparse[cells[k]] = values[k];
+        }
+        for (int cell = 0; cell < nc; ++cell) {
+            BOOST_CHECK_EQUAL(from_sparse[cell], column[cell]);
+            BOOST_CHECK_EQUAL(column[cell], float(batch[cell*2 + t]));
+        }
+    }
+    std::remove(filename.c_str());
+}
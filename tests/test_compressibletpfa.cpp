@@ -0,0 +1,179 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE CompressibleTpfaTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/pressure/CompressibleTpfa.hpp>
+#include <opm/core/props/BlackoilPropertiesBasic.hpp>
+#include <opm/core/props/rock/RockCompressibility.hpp>
+#include <opm/core/linalg/LinearSolverFactory.hpp>
+#include <opm/core/simulator/BlackoilState.hpp>
+#include <opm/core/simulator/WellState.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/grid.h>
+
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    struct Result
+    {
+        std::vector<std::vector<double> > pressure;  // After each step.
+        std::vector<CompressibleTpfa::NewtonStatistics> stats;
+    };
+
+    // Relax a linear initial pressure profile over a few time steps
+    // on a 10x1x1 grid without wells. The strong rock compressibility
+    // makes the equations nonlinear in the pressure.
+    Result relaxPressure(const CompressibleTpfa::NewtonOptions& newton)
+    {
+        const GridManager gm(10, 1, 1, 10.0, 10.0, 10.0);
+        const UnstructuredGrid& g = *gm.c_grid();
+        const int nc = g.number_of_cells;
+
+        ParameterGroup param;
+        param.insertParameter("num_phases", "2");
+        param.insertParameter("porosity", "0.2");
+        param.insertParameter("rock_compressibility_pref", "100.0");
+        param.insertParameter("rock_compressibility", "0.005");
+        param.insertParameter("linsolver_residual_tolerance", "1e-14");
+        param.insertParameter("linsolver_max_iterations", "1000");
+        const BlackoilPropertiesBasic props(param, 3, nc);
+        const RockCompressibility rock_comp(param);
+        LinearSolverFactory linsolver(param);
+
+        CompressibleTpfa psolver(g, props, &rock_comp, linsolver,
+                                 1.0e-9, 0.0, 30, 0, 0, newton);
+
+        BlackoilState state(nc, g.number_of_faces, 2);
+        for (int c = 0; c < nc; ++c) {
+            state.pressure()[c] = (100.0 + 20.0*c)*1.0e5;
+            state.saturation()[2*c]     = 1.0;
+            state.saturation()[2*c + 1] = 0.0;
+            state.surfacevol()[2*c]     = 1.0;
+            state.surfacevol()[2*c + 1] = 0.0;
+        }
+        WellState well_state;
+
+        Result res;
+        for (int step = 0; step < 4; ++step) {
+            psolver.solve(86400.0, state, well_state);
+            res.pressure.push_back(state.pressure());
+            res.stats.push_back(psolver.newtonStatistics());
+        }
+        return res;
+    }
+
+    void checkSamePressure(const Result& a, const Result& b)
+    {
+        BOOST_REQUIRE_EQUAL(a.pressure.size(), b.pressure.size());
+        for (std::size_t step = 0; step < a.pressure.size(); ++step) {
+            BOOST_REQUIRE_EQUAL(a.pressure[step].size(), b.pressure[step].size());
+            for (std::size_t c = 0; c < a.pressure[step].size(); ++c) {
+                BOOST_CHECK_CLOSE(a.pressure[step][c], b.pressure[step][c], 1.0e-8);
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(FullNewton)
+{
+    const Result newton = relaxPressure(CompressibleTpfa::NewtonOptions());
+
+    // The pressure relaxes towards its mean.
+    const std::vector<double>& p = newton.pressure.back();
+    BOOST_CHECK_GT(p.front(), 100.0e5);
+    BOOST_CHECK_LT(p.back(), 280.0e5);
+    for (std::size_t c = 1; c < p.size(); ++c) {
+        BOOST_CHECK_GT(p[c], p[c - 1]);
+    }
+
+    // Every iteration is followed by an assembly with a new Jacobian,
+    // as is the initial state.
+    for (const CompressibleTpfa::NewtonStatistics& st : newton.stats) {
+        BOOST_CHECK_GT(st.iterations, 1);
+        BOOST_CHECK_EQUAL(st.chord_iterations, 0);
+        BOOST_CHECK_EQUAL(st.jacobian_evaluations, st.iterations + 1);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(ChordIterations)
+{
+    const Result newton = relaxPressure(CompressibleTpfa::NewtonOptions());
+
+    CompressibleTpfa::NewtonOptions options;
+    options.chord_reduction = 0.5;
+    options.max_chord_iterations = 3;
+    const Result chord = relaxPressure(options);
+
+    checkSamePressure(chord, newton);
+
+    // Each assembly after the initial one either uses a new Jacobian
+    // or reuses the previous one.
+    int chord_iterations = 0;
+    for (std::size_t step = 0; step < chord.stats.size(); ++step) {
+        const CompressibleTpfa::NewtonStatistics& st = chord.stats[step];
+        BOOST_CHECK_EQUAL(st.jacobian_evaluations + st.chord_iterations, st.iterations + 1);
+        BOOST_CHECK_LE(st.jacobian_evaluations, newton.stats[step].jacobian_evaluations);
+        BOOST_CHECK_GE(st.iterations, newton.stats[step].iterations);
+        chord_iterations += st.chord_iterations;
+    }
+    BOOST_CHECK_GT(chord_iterations, 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(ExtrapolatedPressure)
+{
+    const Result newton = relaxPressure(CompressibleTpfa::NewtonOptions());
+
+    CompressibleTpfa::NewtonOptions options;
+    options.extrapolate_pressure = true;
+    const Result extrap = relaxPressure(options);
+
+    checkSamePressure(extrap, newton);
+
+    // Nothing to extrapolate from in the first step.
+    BOOST_CHECK_EQUAL(extrap.stats[0].iterations, newton.stats[0].iterations);
+    int iterations = 0;
+    int newton_iterations = 0;
+    for (std::size_t step = 0; step < extrap.stats.size(); ++step) {
+        const CompressibleTpfa::NewtonStatistics& st = extrap.stats[step];
+        BOOST_CHECK_EQUAL(st.chord_iterations, 0);
+        BOOST_CHECK_EQUAL(st.jacobian_evaluations, st.iterations + 1);
+        iterations += st.iterations;
+        newton_iterations += newton.stats[step].iterations;
+    }
+    BOOST_CHECK_LE(iterations, newton_iterations);
+}
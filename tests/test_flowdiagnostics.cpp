@@ -28,6 +28,11 @@
 #define BOOST_TEST_MODULE FlowDiagnosticsTests
 #include <boost/test/unit_test.hpp>
 #include <opm/core/flowdiagnostics/FlowDiagnostics.hpp>
+#include <opm/core/wells.h>
+
+#include <cmath>
+#include <memory>
+#include <tuple>
 
 const std::vector<double> pv(16, 18750.0);
 
@@ -196,3 +201,63 @@ BOOST_AUTO_TEST_CASE(Sweep)
     compareCollections(et.first, Ev);
     compareCollections(et.second, tD);
 }
+
+
+
+
+BOOST_AUTO_TEST_CASE(WellPairs)
+{
+    // Five injectors and seven producers, interleaved.
+    const int num_inj = 5;
+    const int num_prod = 7;
+    std::shared_ptr<Wells> wells(create_wells(2, num_inj + num_prod, num_inj + num_prod),
+                                 destroy_wells);
+    for (int w = 0; w < num_inj + num_prod; ++w) {
+        const double comp_frac[] = { 1.0, 0.0 };
+        const double WI = 1.0;
+        const WellType type = (w % 2 == 0 && w/2 < num_inj) ? INJECTOR : PRODUCER;
+        add_well(type, 0.0, 1, comp_frac, &w, &WI, 0, "W", 1, wells.get());
+    }
+
+    // Cells below 700 have a single nonzero tracer value per kind,
+    // the rest have all tracers nonzero.
+    const int nc = 1500;
+    std::vector<double> porevol(nc), ftracer(nc*num_inj, 0.0), btracer(nc*num_prod, 0.0);
+    for (int c = 0; c < nc; ++c) {
+        porevol[c] = 1.0 + 0.01*(c % 13);
+        if (c < 700) {
+            ftracer[c*num_inj + c % num_inj] = 1.0;
+            btracer[c*num_prod + c % num_prod] = 1.0;
+        } else {
+            for (int i = 0; i < num_inj; ++i) {
+                ftracer[c*num_inj + i] = 1.0 + std::sin(c + 3.0*i);
+            }
+            for (int p = 0; p < num_prod; ++p) {
+                btracer[c*num_prod + p] = 1.0 + std::cos(2.0*c + p);
+            }
+        }
+    }
+
+    const WellPairVolumes vol = computeWellPairVolumes(*wells, porevol, ftracer, btracer);
+    BOOST_REQUIRE_EQUAL(vol.injectors.size(), num_inj);
+    BOOST_REQUIRE_EQUAL(vol.producers.size(), num_prod);
+    const auto pairs = computeWellPairs(*wells, porevol, ftracer, btracer);
+    BOOST_REQUIRE_EQUAL(pairs.size(), num_inj*num_prod);
+    for (int i = 0; i < num_inj; ++i) {
+        BOOST_CHECK_EQUAL(vol.injectors[i], 2*i);
+        for (int p = 0; p < num_prod; ++p) {
+            double expected = 0.0;
+            for (int c = 0; c < nc; ++c) {
+                expected += porevol[c] * ftracer[c*num_inj + i] * btracer[c*num_prod + p];
+            }
+            BOOST_CHECK_CLOSE(vol(i, p), expected, 1e-10);
+            const auto& pair = pairs[i*num_prod + p];
+            BOOST_CHECK_EQUAL(std::get<0>(pair), vol.injectors[i]);
+            BOOST_CHECK_EQUAL(std::get<1>(pair), vol.producers[p]);
+            BOOST_CHECK_EQUAL(std::get<2>(pair), vol(i, p));
+        }
+    }
+
+    BOOST_CHECK_THROW(computeWellPairVolumes(*wells, porevol, wrong_length, btracer), std::runtime_error);
+    BOOST_CHECK_THROW(computeWellPairs(*wells, porevol, ftracer, wrong_length), std::runtime_error);
+}
@@ -31,8 +31,11 @@
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
 
 #include <dune/common/version.hh>
+#include <algorithm>
 #include <memory>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
 #include <string>
 
 struct MyMatrix
@@ -124,6 +127,108 @@ void run_test(const Opm::ParameterGroup& param)
 }
 
 
+// Copy of the matrix with all diagonal entries set to d.
+MyMatrix setDiagonal(const MyMatrix& mat, double d)
+{
+    MyMatrix res(mat);
+    for(std::size_t row=0; row<mat.rowStart.size()-1; ++row)
+        for(int i=mat.rowStart[row], end=mat.rowStart[row+1]; i!=end; ++i)
+            if(mat.colIndex[i]==int(row))
+                res.data[i]=d;
+    return res;
+}
+
+// Copy of the matrix without the entries (r, c) and (c, r): same
+// size, different sparsity pattern.
+MyMatrix dropCoupling(const MyMatrix& mat, int r, int c)
+{
+    MyMatrix res;
+    res.rowStart.push_back(0);
+    for(std::size_t row=0; row<mat.rowStart.size()-1; ++row)
+    {
+        for(int i=mat.rowStart[row], end=mat.rowStart[row+1]; i!=end; ++i)
+        {
+            const int col=mat.colIndex[i];
+            if((int(row)==r && col==c) || (int(row)==c && col==r))
+                continue;
+            res.colIndex.push_back(col);
+            res.data.push_back(mat.data[i]);
+        }
+        res.rowStart.push_back(res.data.size());
+    }
+    return res;
+}
+
+// Solve with the session, and compare with a solve by a new solver.
+void checkSessionSolve(Opm::LinearSolverInterface::Session& session,
+                       const Opm::ParameterGroup& param,
+                       const MyMatrix& mat, double tol)
+{
+    const int n=mat.rowStart.size()-1;
+    std::vector<double> exact, b;
+    createRandomVectors(n, exact, b, mat);
+    std::vector<double> x(n, 0.0), fresh(n, 0.0);
+    Opm::LinearSolverInterface::LinearSolverReport rep =
+        session.solve(n, mat.data.size(), &(mat.rowStart[0]),
+                      &(mat.colIndex[0]), &(mat.data[0]), &(b[0]), &(x[0]));
+    BOOST_CHECK(rep.converged);
+    Opm::LinearSolverFactory ls(param);
+    ls.solve(n, mat.data.size(), &(mat.rowStart[0]),
+             &(mat.colIndex[0]), &(mat.data[0]), &(b[0]), &(fresh[0]));
+    for(int i=0; i<n; ++i)
+        BOOST_CHECK_SMALL(x[i]-fresh[i], tol);
+}
+
+void checkSessionStatistics(const Opm::LinearSolverInterface::Session& session,
+                            int solves, int pattern_setups, int value_setups, int reuses)
+{
+    const Opm::LinearSolverInterface::SessionStatistics& stats=session.statistics();
+    BOOST_CHECK_EQUAL(stats.solves, solves);
+    BOOST_CHECK_EQUAL(stats.pattern_setups, pattern_setups);
+    BOOST_CHECK_EQUAL(stats.value_setups, value_setups);
+    BOOST_CHECK_EQUAL(stats.reuses, reuses);
+}
+
+// Solve a sequence of systems through one session: same matrix,
+// small and large value changes, then two pattern changes. The
+// diagonal 4.2 differs from 4 by less than the default refresh
+// tolerance (10% of the largest coefficient), 6 by more. If
+// 'exact_values' is set, the session must refresh its setup on any
+// change in the values.
+void run_session_test(const Opm::ParameterGroup& param, double tol,
+                      bool exact_values=false)
+{
+    auto lap = createLaplacian(4);
+    Opm::LinearSolverFactory ls(param);
+    std::shared_ptr<Opm::LinearSolverInterface::Session> session = ls.makeSession();
+
+    checkSessionSolve(*session, param, *lap, tol);
+    checkSessionStatistics(*session, 1, 1, 0, 0);
+
+    checkSessionSolve(*session, param, *lap, tol);
+    checkSessionStatistics(*session, 2, 1, 0, 1);
+
+    checkSessionSolve(*session, param, setDiagonal(*lap, 4.2), tol);
+    if(exact_values)
+        checkSessionStatistics(*session, 3, 1, 1, 1);
+    else
+        checkSessionStatistics(*session, 3, 1, 0, 2);
+
+    checkSessionSolve(*session, param, setDiagonal(*lap, 6.0), tol);
+    if(exact_values)
+        checkSessionStatistics(*session, 4, 1, 2, 1);
+    else
+        checkSessionStatistics(*session, 4, 1, 1, 2);
+
+    checkSessionSolve(*session, param, dropCoupling(*lap, 5, 6), tol);
+    checkSessionSolve(*session, param, *createLaplacian(3), tol);
+    if(exact_values)
+        checkSessionStatistics(*session, 6, 3, 2, 1);
+    else
+        checkSessionStatistics(*session, 6, 3, 1, 2);
+}
+
+
 BOOST_AUTO_TEST_CASE(DefaultTest)
 {
     Opm::ParameterGroup param;
@@ -132,6 +237,180 @@ BOOST_AUTO_TEST_CASE(DefaultTest)
     run_test(param);
 }
 
+BOOST_AUTO_TEST_CASE(KrylovBiCGStabILU0Test)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("krylov"));
+    param.insertParameter(std::string("linsolver_krylov"), std::string("1"));
+    param.insertParameter(std::string("linsolver_preconditioner"), std::string("2"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    run_test(param);
+}
+
+BOOST_AUTO_TEST_CASE(KrylovCGJacobiTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("krylov"));
+    param.insertParameter(std::string("linsolver_krylov"), std::string("0"));
+    param.insertParameter(std::string("linsolver_preconditioner"), std::string("1"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    run_test(param);
+}
+
+BOOST_AUTO_TEST_CASE(KrylovIgnoresInitialGuessTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("krylov"));
+    param.insertParameter(std::string("linsolver_krylov"), std::string("1"));
+    param.insertParameter(std::string("linsolver_preconditioner"), std::string("2"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+
+    int N=4;
+    auto mat = createLaplacian(N);
+    std::vector<double> x, b;
+    createRandomVectors(N*N, x, b, *mat);
+    std::vector<double> exact(x);
+    // Garbage, as left by malloc(), must not affect the solve.
+    std::fill(x.begin(), x.end(), std::numeric_limits<double>::quiet_NaN());
+    Opm::LinearSolverFactory ls(param);
+    Opm::LinearSolverInterface::LinearSolverReport rep =
+        ls.solve(N*N, mat->data.size(), &(mat->rowStart[0]),
+                 &(mat->colIndex[0]), &(mat->data[0]), &(b[0]),
+                 &(x[0]));
+    BOOST_CHECK(rep.converged);
+    for (int i = 0; i < N*N; ++i) {
+        BOOST_CHECK_SMALL(x[i] - exact[i], 1e-5);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(KrylovILU0MissingDiagonalTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("krylov"));
+    param.insertParameter(std::string("linsolver_krylov"), std::string("1"));
+    param.insertParameter(std::string("linsolver_preconditioner"), std::string("2"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+
+    // Drop the diagonal entry of row 0, which row 1 eliminates with.
+    int N=4;
+    auto lap = createLaplacian(N);
+    MyMatrix mat;
+    mat.rowStart.push_back(0);
+    for (int row = 0; row < N*N; ++row) {
+        for (int k = lap->rowStart[row]; k < lap->rowStart[row + 1]; ++k) {
+            if (row != 0 || lap->colIndex[k] != 0) {
+                mat.colIndex.push_back(lap->colIndex[k]);
+                mat.data.push_back(lap->data[k]);
+            }
+        }
+        mat.rowStart.push_back(mat.data.size());
+    }
+    std::vector<double> x(N*N, 0.0), b(N*N, 1.0);
+    Opm::LinearSolverFactory ls(param);
+    BOOST_CHECK_THROW(ls.solve(N*N, mat.data.size(), &(mat.rowStart[0]),
+                               &(mat.colIndex[0]), &(mat.data[0]), &(b[0]),
+                               &(x[0])),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(KrylovBiCGStabBreakdownTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("krylov"));
+    param.insertParameter(std::string("linsolver_krylov"), std::string("1"));
+    param.insertParameter(std::string("linsolver_preconditioner"), std::string("2"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    param.insertParameter(std::string("linsolver_threads"), std::string("4"));
+
+    // A 1D Laplacian driven from both ends.  With the ILU(0) blocks of
+    // four threads, the shadow residual becomes orthogonal to A*p after
+    // one iteration, so BiCGStab must restart instead of dividing by zero.
+    const int n = 10;
+    MyMatrix mat;
+    mat.rowStart.push_back(0);
+    for (int row = 0; row < n; ++row) {
+        for (int col = std::max(row - 1, 0); col <= std::min(row + 1, n - 1); ++col) {
+            mat.colIndex.push_back(col);
+            mat.data.push_back(col == row ? 2.0 : -1.0);
+        }
+        mat.rowStart.push_back(mat.data.size());
+    }
+    std::vector<double> x(n, 0.0), b(n, 0.0);
+    b[0] = -1.0;
+    b[n - 1] = 1.0;
+    Opm::LinearSolverFactory ls(param);
+    Opm::LinearSolverInterface::LinearSolverReport rep =
+        ls.solve(n, mat.data.size(), &(mat.rowStart[0]),
+                 &(mat.colIndex[0]), &(mat.data[0]), &(b[0]),
+                 &(x[0]));
+    BOOST_CHECK(rep.converged);
+    // The exact solution is linear, from -9/11 to 9/11.
+    for (int i = 0; i < n; ++i) {
+        BOOST_CHECK_SMALL(x[i] - (2.0*i - (n - 1))/(n + 1), 1e-6);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SessionTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("krylov"));
+    param.insertParameter(std::string("linsolver_krylov"), std::string("1"));
+    param.insertParameter(std::string("linsolver_preconditioner"), std::string("2"));
+    param.insertParameter(std::string("linsolver_residual_tolerance"), std::string("1e-12"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    run_session_test(param, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(SessionRefreshTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("krylov"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    Opm::LinearSolverFactory ls(param);
+    auto lap = createLaplacian(4);
+    const MyMatrix changed = setDiagonal(*lap, 4.2);
+
+    // Any change in the values refreshes the setup.
+    Opm::LinearSolverInterface::SessionPolicy exact;
+    exact.refresh_tolerance = 0.0;
+    auto session = ls.makeSession(exact);
+    checkSessionSolve(*session, param, *lap, 1e-8);
+    checkSessionSolve(*session, param, *lap, 1e-8);
+    checkSessionSolve(*session, param, changed, 1e-8);
+    checkSessionStatistics(*session, 3, 1, 1, 1);
+
+    // A change of 0.2 is above 4% of the largest coefficient 4.
+    Opm::LinearSolverInterface::SessionPolicy tight;
+    tight.refresh_tolerance = 0.04;
+    session = ls.makeSession(tight);
+    checkSessionSolve(*session, param, *lap, 1e-8);
+    checkSessionSolve(*session, param, changed, 1e-8);
+    checkSessionStatistics(*session, 2, 1, 1, 0);
+
+    // Refresh after at most two reuses in a row.
+    Opm::LinearSolverInterface::SessionPolicy limited;
+    limited.max_reuse = 2;
+    session = ls.makeSession(limited);
+    for(int i=0; i<4; ++i)
+        checkSessionSolve(*session, param, *lap, 1e-8);
+    checkSessionStatistics(*session, 4, 1, 1, 2);
+
+    // A reset forgets the pattern.
+    session->reset();
+    checkSessionSolve(*session, param, *lap, 1e-8);
+    checkSessionStatistics(*session, 5, 2, 1, 2);
+}
+
+#if HAVE_SUITESPARSE_UMFPACK_H
+BOOST_AUTO_TEST_CASE(UmfpackSessionTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("umfpack"));
+    // The factors are reused only for identical values.
+    run_session_test(param, 1e-12, true);
+}
+#endif
+
 #ifdef HAVE_DUNE_ISTL
 BOOST_AUTO_TEST_CASE(CGAMGTest)
 {
@@ -173,6 +452,27 @@ BOOST_AUTO_TEST_CASE(FastAMGTest)
     run_test(param);
 }
 
+BOOST_AUTO_TEST_CASE(MixedPrecisionCGAMGTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("istl"));
+    param.insertParameter(std::string("linsolver_type"), std::string("1"));
+    param.insertParameter(std::string("linsolver_mixed_precision"), std::string("true"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    param.insertParameter(std::string("linsolver_verbosity"), std::string("2"));
+    run_test(param);
+}
+
+BOOST_AUTO_TEST_CASE(MixedPrecisionBiCGILUTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("istl"));
+    param.insertParameter(std::string("linsolver_type"), std::string("2"));
+    param.insertParameter(std::string("linsolver_mixed_precision"), std::string("true"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    run_test(param);
+}
+
 BOOST_AUTO_TEST_CASE(KAMGTest)
 {
     Opm::ParameterGroup param;
@@ -181,6 +481,36 @@ BOOST_AUTO_TEST_CASE(KAMGTest)
     param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
     run_test(param);
 }
+BOOST_AUTO_TEST_CASE(CGILUSessionTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("istl"));
+    param.insertParameter(std::string("linsolver_type"), std::string("0"));
+    param.insertParameter(std::string("linsolver_residual_tolerance"), std::string("1e-12"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    run_session_test(param, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(CGAMGSessionTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("istl"));
+    param.insertParameter(std::string("linsolver_type"), std::string("1"));
+    param.insertParameter(std::string("linsolver_residual_tolerance"), std::string("1e-12"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    run_session_test(param, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(MixedPrecisionCGAMGSessionTest)
+{
+    Opm::ParameterGroup param;
+    param.insertParameter(std::string("linsolver"), std::string("istl"));
+    param.insertParameter(std::string("linsolver_type"), std::string("1"));
+    param.insertParameter(std::string("linsolver_mixed_precision"), std::string("true"));
+    param.insertParameter(std::string("linsolver_residual_tolerance"), std::string("1e-12"));
+    param.insertParameter(std::string("linsolver_max_iterations"), std::string("200"));
+    run_session_test(param, 1e-8);
+}
 #endif
 
 #if HAVE_PETSC
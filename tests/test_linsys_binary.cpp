@@ -0,0 +1,120 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE LinsysBinaryTest
+#include <boost/test/unit_test.hpp>
+
+#include <opm/core/linalg/linsys_binary.h>
+#include <opm/core/linalg/sparse_sys.h>
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    struct Tridiagonal
+    {
+        explicit Tridiagonal(int n)
+            : ia(1, 0), rhs(n)
+        {
+            for (int i = 0; i < n; ++i) {
+                for (int j = i - 1; j <= i + 1; ++j) {
+                    if ((0 <= j) && (j < n)) {
+                        ja.push_back(j);
+                        sa.push_back(i == j ? 2.0 : -1.0 + 1.0e-3*i);
+                    }
+                }
+                ia.push_back(static_cast<int>(ja.size()));
+                rhs[i] = 0.25 * i;
+            }
+
+            A.m   = n;
+            A.nnz = sa.size();
+            A.ia  = &ia[0];
+            A.ja  = &ja[0];
+            A.sa  = &sa[0];
+        }
+
+        std::vector<int>    ia;
+        std::vector<int>    ja;
+        std::vector<double> sa;
+        std::vector<double> rhs;
+        CSRMatrix           A;
+    };
+}
+
+BOOST_AUTO_TEST_CASE(RoundTrip)
+{
+    Tridiagonal sys(101);
+    const char* fn = "test_linsys_binary_roundtrip.linsys";
+
+    BOOST_REQUIRE_EQUAL(linsys_binary_write(&sys.A, sys.rhs.size(), &sys.rhs[0], 1, fn), 0);
+
+    LinsysBinary in;
+    BOOST_REQUIRE_EQUAL(linsys_binary_open(fn, 1, &in), 0);
+    BOOST_CHECK_EQUAL(in.flags, LINSYS_HAS_MATRIX | LINSYS_HAS_VECTOR | LINSYS_HAS_CHECKSUM);
+    BOOST_REQUIRE_EQUAL(in.A.m, sys.A.m);
+    BOOST_REQUIRE_EQUAL(in.A.nnz, sys.A.nnz);
+    BOOST_REQUIRE_EQUAL(in.n, sys.rhs.size());
+
+    for (std::size_t i = 0; i <= sys.A.m; ++i) {
+        BOOST_CHECK_EQUAL(in.A.ia[i], sys.ia[i]);
+    }
+    for (std::size_t k = 0; k < sys.A.nnz; ++k) {
+        BOOST_CHECK_EQUAL(in.A.ja[k], sys.ja[k]);
+        BOOST_CHECK_EQUAL(in.A.sa[k], sys.sa[k]);
+    }
+    for (std::size_t i = 0; i < in.n; ++i) {
+        BOOST_CHECK_EQUAL(in.v[i], sys.rhs[i]);
+    }
+
+    linsys_binary_close(&in);
+    std::remove(fn);
+}
+
+BOOST_AUTO_TEST_CASE(ChecksumDetectsCorruption)
+{
+    Tridiagonal sys(50);
+    const char* fn = "test_linsys_binary_corrupt.linsys";
+
+    BOOST_REQUIRE_EQUAL(linsys_binary_write(&sys.A, 0, 0, 1, fn), 0);
+
+    std::FILE* fp = std::fopen(fn, "r+b");
+    BOOST_REQUIRE(fp != 0);
+    std::fseek(fp, -3, SEEK_END);
+    std::fputc(0x5a, fp);
+    std::fclose(fp);
+
+    LinsysBinary in;
+    BOOST_CHECK(linsys_binary_open(fn, 1, &in) != 0);
+
+    // Structure is still valid, so opening without verification works.
+    BOOST_REQUIRE_EQUAL(linsys_binary_open(fn, 0, &in), 0);
+    BOOST_CHECK_EQUAL(in.flags & LINSYS_HAS_VECTOR, 0u);
+    linsys_binary_close(&in);
+
+    std::remove(fn);
+}
@@ -0,0 +1,140 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE TabulatedRelpermTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/transport/reorder/TabulatedRelperm.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    // Corey curves with exponent 1 + the region of the cell, and
+    // regions given by cell index modulo 3.
+    struct CoreyProps
+    {
+        mutable int num_calls;
+
+        CoreyProps() : num_calls(0) {}
+
+        static int region(const int cell)
+        {
+            return cell % 3;
+        }
+
+        static double kr(const double s, const int cell)
+        {
+            double k = 1.0;
+            for (int i = 0; i <= region(cell); ++i) {
+                k *= s;
+            }
+            return k;
+        }
+
+        void relperm(const int n, const double* s, const int* cells,
+                     double* kr_out, double* dkrds) const
+        {
+            BOOST_REQUIRE(dkrds == 0);
+            ++num_calls;
+            for (int i = 0; i < n; ++i) {
+                kr_out[2*i + 0] = kr(s[2*i + 0], cells[i]);
+                kr_out[2*i + 1] = kr(s[2*i + 1], cells[i]);
+            }
+        }
+    };
+}
+
+
+BOOST_AUTO_TEST_CASE(SingleRegion)
+{
+    const CoreyProps props;
+    TabulatedRelperm table;
+    BOOST_CHECK(table.empty());
+    table.build(props, 10, std::vector<int>(), 11);
+    BOOST_CHECK(!table.empty());
+    BOOST_CHECK_EQUAL(props.num_calls, 1);
+
+    // Cell 0 has linear curves, which are reproduced exactly in all cells.
+    const double s[] = { 0.0, 0.05, 0.37, 0.9, 1.0 };
+    for (int i = 0; i < 5; ++i) {
+        double kr[2], dkr[2];
+        table.relperm(s[i], 7, kr, dkr);
+        BOOST_CHECK_CLOSE(kr[0], s[i], 1e-10);
+        BOOST_CHECK_CLOSE(kr[1], 1.0 - s[i], 1e-10);
+        BOOST_CHECK_CLOSE(dkr[0], 1.0, 1e-10);
+        BOOST_CHECK_CLOSE(dkr[1], -1.0, 1e-10);
+    }
+
+    table.clear();
+    BOOST_CHECK(table.empty());
+}
+
+
+BOOST_AUTO_TEST_CASE(Regions)
+{
+    const int num_cells = 9;
+    std::vector<int> region(num_cells);
+    for (int cell = 0; cell < num_cells; ++cell) {
+        region[cell] = CoreyProps::region(cell);
+    }
+
+    const CoreyProps props;
+    TabulatedRelperm table;
+    const int num_points = 1001;
+    table.build(props, num_cells, region, num_points);
+    BOOST_CHECK_EQUAL(props.num_calls, 1);
+
+    // Linear interpolation error is bounded by h^2/8 max|kr''|.
+    const double h = 1.0/(num_points - 1);
+    const double tol = h*h/8.0*6.0;
+    for (int cell = 0; cell < num_cells; ++cell) {
+        for (int i = 0; i <= 20; ++i) {
+            const double s = 0.0493*i;
+            double kr[2];
+            table.relperm(s, cell, kr);
+            BOOST_CHECK_SMALL(kr[0] - CoreyProps::kr(s, cell), tol);
+            BOOST_CHECK_SMALL(kr[1] - CoreyProps::kr(1.0 - s, cell), tol);
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(InvalidInput)
+{
+    const CoreyProps props;
+    TabulatedRelperm table;
+    BOOST_CHECK_THROW(table.build(props, 4, std::vector<int>(), 1), std::runtime_error);
+    BOOST_CHECK_THROW(table.build(props, 4, std::vector<int>(3, 0), 11), std::runtime_error);
+    BOOST_CHECK_THROW(table.build(props, 2, std::vector<int>(2, -1), 11), std::runtime_error);
+    BOOST_CHECK(table.empty());
+}
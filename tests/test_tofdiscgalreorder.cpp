@@ -0,0 +1,150 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE TofDiscGalReorderTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/flowdiagnostics/TofDiscGalReorder.hpp>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/grid.h>
+#include <opm/core/utility/SparseTable.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    // Flow from the first to the last cell, in the positive direction
+    // along every axis, with more flow along x.
+    std::vector<double> diagonalFlux(const UnstructuredGrid& g)
+    {
+        std::vector<double> flux(g.number_of_faces, 0.0);
+        for (int f = 0; f < g.number_of_faces; ++f) {
+            const int c0 = g.face_cells[2*f];
+            const int c1 = g.face_cells[2*f + 1];
+            if (c0 >= 0 && c1 >= 0) {
+                flux[f] = (c1 - c0 == 1) ? 2.0 : 1.0;
+            }
+        }
+        return flux;
+    }
+
+    // Sources balancing the fluxes.
+    std::vector<double> balancingSource(const UnstructuredGrid& g, const std::vector<double>& flux)
+    {
+        std::vector<double> src(g.number_of_cells, 0.0);
+        for (int f = 0; f < g.number_of_faces; ++f) {
+            const int c0 = g.face_cells[2*f];
+            const int c1 = g.face_cells[2*f + 1];
+            if (c0 >= 0 && c1 >= 0) {
+                src[c0] += flux[f];
+                src[c1] -= flux[f];
+            }
+        }
+        return src;
+    }
+
+    ParameterGroup params(const int degree, const bool cache)
+    {
+        ParameterGroup param;
+        param.insertParameter("dg_degree", degree == 0 ? "0" : "1");
+        param.insertParameter("use_quadrature_cache", cache ? "true" : "false");
+        return param;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(QuadratureCacheAndParallelSweep)
+{
+    const GridManager gm(6, 5, 3);
+    const UnstructuredGrid& g = *gm.c_grid();
+    const int nc = g.number_of_cells;
+
+    const std::vector<double> flux = diagonalFlux(g);
+    const std::vector<double> src = balancingSource(g, flux);
+    std::vector<double> pv(nc);
+    for (int cell = 0; cell < nc; ++cell) {
+        pv[cell] = 1.0 + 0.1*(cell % 5);
+    }
+
+    SparseTable<int> heads;
+    const int head0[] = { 0 };
+    heads.appendRow(head0, head0 + 1);
+
+    for (int degree = 0; degree < 2; ++degree) {
+        TofDiscGalReorder plain(g, params(degree, false));
+        BOOST_CHECK(!plain.hasQuadratureCache());
+        std::vector<double> tof, tracer;
+        plain.solveTofTracer(&flux[0], &pv[0], &src[0], heads, tof, tracer);
+
+        TofDiscGalReorder cached(g, params(degree, true));
+        BOOST_CHECK(cached.hasQuadratureCache());
+        cached.setParallelSweep(true);
+        std::vector<double> ctof, ctracer;
+        cached.solveTofTracer(&flux[0], &pv[0], &src[0], heads, ctof, ctracer);
+
+        // Same integrals, summed in a different order.
+        BOOST_REQUIRE_EQUAL(ctof.size(), tof.size());
+        BOOST_REQUIRE_EQUAL(ctracer.size(), tracer.size());
+        for (std::size_t i = 0; i < tof.size(); ++i) {
+            BOOST_CHECK_SMALL(ctof[i] - tof[i], 1e-10*(1.0 + std::fabs(tof[i])));
+        }
+        for (std::size_t i = 0; i < tracer.size(); ++i) {
+            BOOST_CHECK_SMALL(ctracer[i] - tracer[i], 1e-10);
+        }
+
+        // The parallel sweep does not change the uncached result.
+        TofDiscGalReorder parallel(g, params(degree, false));
+        parallel.setParallelSweep(true);
+        std::vector<double> ptof, ptracer;
+        parallel.solveTofTracer(&flux[0], &pv[0], &src[0], heads, ptof, ptracer);
+        for (std::size_t i = 0; i < tof.size(); ++i) {
+            BOOST_CHECK_EQUAL(ptof[i], tof[i]);
+        }
+        for (std::size_t i = 0; i < tracer.size(); ++i) {
+            BOOST_CHECK_EQUAL(ptracer[i], tracer[i]);
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(QuadratureCacheMemoryLimit)
+{
+    const GridManager gm(4, 4, 4);
+    const UnstructuredGrid& g = *gm.c_grid();
+
+    ParameterGroup param = params(1, true);
+    param.insertParameter("quadrature_cache_max_mb", "0.001");
+    TofDiscGalReorder solver(g, param);
+    BOOST_CHECK(!solver.hasQuadratureCache());
+}
@@ -0,0 +1,324 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE TofReorderTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/flowdiagnostics/TofReorder.hpp>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/grid.h>
+#include <opm/core/utility/SparseTable.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace Opm;
+
+namespace
+{
+    // Unit flux from cell 0 to the last cell of a 1d chain of cells.
+    std::vector<double> chainFlux(const UnstructuredGrid& g)
+    {
+        std::vector<double> flux(g.number_of_faces, 0.0);
+        for (int f = 0; f < g.number_of_faces; ++f) {
+            const int c0 = g.face_cells[2*f];
+            const int c1 = g.face_cells[2*f + 1];
+            if (c0 >= 0 && c1 >= 0) {
+                flux[f] = (c0 < c1) ? 1.0 : -1.0;
+            }
+        }
+        return flux;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TofAndTracersInOneSweep)
+{
+    const GridManager gm(5, 1, 1);
+    const UnstructuredGrid& g = *gm.c_grid();
+    const int nc = g.number_of_cells;
+
+    const std::vector<double> flux = chainFlux(g);
+    const std::vector<double> pv(nc, 1.0);
+    std::vector<double> src(nc, 0.0);
+    src[0] = 1.0;
+    src[nc - 1] = -1.0;
+
+    // Tracer 0 starts in cell 0, tracer 1 has no head, tracer 2
+    // starts in cell 2.
+    SparseTable<int> heads;
+    const int head0[] = { 0 };
+    const int head2[] = { 2 };
+    heads.appendRow(head0, head0 + 1);
+    heads.appendRow(head0, head0);
+    heads.appendRow(head2, head2 + 1);
+
+    for (int multidim = 0; multidim < 2; ++multidim) {
+        TofReorder solver(g, multidim == 1);
+        std::vector<double> tof;
+        std::vector<double> tracer;
+        solver.solveTofTracer(&flux[0], &pv[0], &src[0], heads, tof, tracer);
+
+        BOOST_REQUIRE_EQUAL(tof.size(), std::size_t(nc));
+        BOOST_REQUIRE_EQUAL(tracer.size(), std::size_t(3*nc));
+        for (int c = 0; c < nc; ++c) {
+            BOOST_CHECK_CLOSE(tof[c], c + 1.0, 1e-10);
+            // Tracers are stored cell by cell.
+            BOOST_CHECK_CLOSE(tracer[3*c + 0], (c < 2) ? 1.0 : 0.0, 1e-10);
+            BOOST_CHECK_SMALL(tracer[3*c + 1], 1e-12);
+            BOOST_CHECK_CLOSE(tracer[3*c + 2], (c >= 2) ? 1.0 : 0.0, 1e-10);
+        }
+
+        // Time-of-flight alone gives the same result.
+        std::vector<double> tof_only;
+        solver.solveTof(&flux[0], &pv[0], &src[0], tof_only);
+        for (int c = 0; c < nc; ++c) {
+            BOOST_CHECK_CLOSE(tof_only[c], tof[c], 1e-10);
+        }
+    }
+}
+
+
+namespace
+{
+    // Divergence free flow in the xy-plane of an nx-by-ny-by-1 grid:
+    // unit flux in the x direction plus the rotational field of the
+    // stream function psi = a*sin(pi*x/nx)*sin(pi*y/ny).  For large
+    // 'a' some x-fluxes reverse, giving cyclic components.
+    std::vector<double> swirlFlux(const UnstructuredGrid& g, const int nx, const int ny, const double a)
+    {
+        const double pi = 3.14159265358979323846;
+        const int dim = g.dimensions;
+        std::vector<double> flux(g.number_of_faces, 0.0);
+        for (int f = 0; f < g.number_of_faces; ++f) {
+            if (g.face_cells[2*f] < 0 || g.face_cells[2*f + 1] < 0) {
+                continue;
+            }
+            const double* x = g.face_centroids + dim*f;
+            const double* n = g.face_normals + dim*f;
+            if (n[0] != 0.0) {
+                flux[f] = 1.0 + a*std::sin(pi*x[0]/nx)*(std::sin(pi*(x[1] + 0.5)/ny) - std::sin(pi*(x[1] - 0.5)/ny));
+            } else if (n[1] != 0.0) {
+                flux[f] = -a*std::sin(pi*x[1]/ny)*(std::sin(pi*(x[0] + 0.5)/nx) - std::sin(pi*(x[0] - 0.5)/nx));
+            }
+        }
+        return flux;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(ManyTracersIn2d)
+{
+    // One tracer per row, injected at the left end of the row.  More
+    // tracers than cell-local components fit on the stack.
+    const int nx = 7;
+    const int ny = 18;
+    const GridManager gm(nx, ny, 1);
+    const UnstructuredGrid& g = *gm.c_grid();
+    const int nc = g.number_of_cells;
+
+    const std::vector<double> pv(nc, 1.0);
+    std::vector<double> src(nc, 0.0);
+    SparseTable<int> heads;
+    for (int j = 0; j < ny; ++j) {
+        const int head = nx*j;
+        src[head] = 1.0;
+        src[head + nx - 1] = -1.0;
+        heads.appendRow(&head, &head + 1);
+    }
+
+    for (int cyclic = 0; cyclic < 2; ++cyclic) {
+        const std::vector<double> flux = swirlFlux(g, nx, ny, cyclic ? 12.0 : 3.0);
+        for (int multidim = 0; multidim < 2 - cyclic; ++multidim) {
+            TofReorder solver(g, multidim == 1);
+            std::vector<double> tof, tracer;
+            solver.solveTofTracer(&flux[0], &pv[0], &src[0], heads, tof, tracer);
+            BOOST_REQUIRE_EQUAL(tracer.size(), std::size_t(ny*nc));
+
+            // The flow is conservative and every inflow is tagged by
+            // exactly one tracer, so the tracers sum to one.  The
+            // Gauss-Seidel iterations of cyclic components stop at
+            // a tolerance of 1e-3.
+            const double tol = cyclic ? 1e-2 : 1e-10;
+            for (int c = 0; c < nc; ++c) {
+                BOOST_CHECK(tof[c] > 0.0);
+                double sum = 0.0;
+                for (int tr = 0; tr < ny; ++tr) {
+                    const double t = tracer[ny*c + tr];
+                    BOOST_CHECK(t > -tol && t < 1.0 + tol);
+                    sum += t;
+                }
+                BOOST_CHECK_SMALL(sum - 1.0, tol);
+            }
+            for (int j = 0; j < ny; ++j) {
+                BOOST_CHECK_EQUAL(tracer[ny*(nx*j) + j], 1.0);
+            }
+
+            // Time-of-flight alone gives the same result.
+            std::vector<double> tof_only;
+            solver.solveTof(&flux[0], &pv[0], &src[0], tof_only);
+            for (int c = 0; c < nc; ++c) {
+                BOOST_CHECK_SMALL(tof_only[c] - tof[c], cyclic ? 1e-2 : 1e-10);
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(SequenceReuse)
+{
+    const GridManager gm(5, 1, 1);
+    const UnstructuredGrid& g = *gm.c_grid();
+    const int nc = g.number_of_cells;
+
+    std::vector<double> flux = chainFlux(g);
+    const std::vector<double> pv(nc, 1.0);
+    std::vector<double> src(nc, 0.0);
+    src[0] = 1.0;
+    src[nc - 1] = -1.0;
+
+    TofReorder solver(g);
+    std::vector<double> tof;
+    solver.solveTof(&flux[0], &pv[0], &src[0], tof);
+    BOOST_CHECK_EQUAL(solver.numSequenceComputations(), 1);
+    BOOST_CHECK_EQUAL(solver.numSequenceReuses(), 0);
+
+    // Same signs, different magnitudes: the ordering is reused.
+    for (std::size_t f = 0; f < flux.size(); ++f) {
+        flux[f] *= 2.0;
+    }
+    src[0] *= 2.0;
+    src[nc - 1] *= 2.0;
+    solver.solveTof(&flux[0], &pv[0], &src[0], tof);
+    BOOST_CHECK_EQUAL(solver.numSequenceComputations(), 1);
+    BOOST_CHECK_EQUAL(solver.numSequenceReuses(), 1);
+    for (int c = 0; c < nc; ++c) {
+        BOOST_CHECK_CLOSE(tof[c], 0.5*(c + 1.0), 1e-10);
+    }
+
+    // Reversed flow: the ordering is recomputed.
+    for (std::size_t f = 0; f < flux.size(); ++f) {
+        flux[f] = -flux[f];
+    }
+    std::swap(src[0], src[nc - 1]);
+    solver.solveTof(&flux[0], &pv[0], &src[0], tof);
+    BOOST_CHECK_EQUAL(solver.numSequenceComputations(), 2);
+    for (int c = 0; c < nc; ++c) {
+        BOOST_CHECK_CLOSE(tof[c], 0.5*(nc - c), 1e-10);
+    }
+
+    // A supplied ordering is used instead of computing one.
+    std::vector<int> sequence(nc);
+    std::vector<int> components(nc + 1);
+    for (int c = 0; c < nc; ++c) {
+        sequence[c] = nc - 1 - c;
+        components[c] = c;
+    }
+    components[nc] = nc;
+    solver.setSequence(sequence, components);
+    solver.solveTof(&flux[0], &pv[0], &src[0], tof);
+    BOOST_CHECK_EQUAL(solver.numSequenceComputations(), 2);
+    for (int c = 0; c < nc; ++c) {
+        BOOST_CHECK_CLOSE(tof[c], 0.5*(nc - c), 1e-10);
+    }
+    solver.clearSequence();
+    solver.solveTof(&flux[0], &pv[0], &src[0], tof);
+    BOOST_CHECK_EQUAL(solver.numSequenceComputations(), 3);
+}
+
+
+BOOST_AUTO_TEST_CASE(ParallelSweep)
+{
+    // Diagonal flow, giving many independent cells per level.
+    const int nx = 12;
+    const int ny = 9;
+    const GridManager gm(nx, ny, 1);
+    const UnstructuredGrid& g = *gm.c_grid();
+    const int nc = g.number_of_cells;
+
+    std::vector<double> pv(nc);
+    for (int cell = 0; cell < nc; ++cell) {
+        pv[cell] = 1.0 + 0.1*(cell % 7);
+    }
+    std::vector<double> src(nc, 0.0);
+    src[0] = 1.0;
+    src[nc - 1] = -1.0;
+
+    SparseTable<int> heads;
+    const int head0[] = { 0 };
+    const int head1[] = { 5 };
+    heads.appendRow(head0, head0 + 1);
+    heads.appendRow(head1, head1 + 1);
+
+    for (int multidim = 0; multidim < 2; ++multidim) {
+        // With standard upwinding, let a 2x2 block circulate to get
+        // a multicell component.
+        std::vector<double> flux = chainFlux(g);
+        const bool cycle = (multidim == 0);
+        if (cycle) {
+            const int a = 1 + nx*1, c = 2 + nx*2, d = 1 + nx*2;
+            for (int f = 0; f < g.number_of_faces; ++f) {
+                const int c0 = g.face_cells[2*f];
+                const int c1 = g.face_cells[2*f + 1];
+                if ((c0 == d && c1 == c) || (c0 == a && c1 == d)) {
+                    flux[f] = -flux[f];
+                }
+            }
+        }
+
+        TofReorder serial(g, multidim == 1);
+        std::vector<double> tof, tracer;
+        serial.solveTofTracer(&flux[0], &pv[0], &src[0], heads, tof, tracer);
+        BOOST_CHECK_EQUAL(serial.numSweepLevels(), 0);
+
+        TofReorder parallel(g, multidim == 1);
+        parallel.setParallelSweep(true);
+        std::vector<double> ptof, ptracer;
+        parallel.solveTofTracer(&flux[0], &pv[0], &src[0], heads, ptof, ptracer);
+#ifdef _OPENMP
+        if (omp_get_max_threads() > 1) {
+            // One level per diagonal.
+            BOOST_CHECK_EQUAL(parallel.numSweepLevels(), nx + ny - 1);
+        }
+#endif
+        // Cell solves see the same upwind values in the same order,
+        // so the results are identical.
+        for (int cell = 0; cell < nc; ++cell) {
+            BOOST_CHECK_EQUAL(ptof[cell], tof[cell]);
+        }
+        for (std::size_t i = 0; i < tracer.size(); ++i) {
+            BOOST_CHECK_EQUAL(ptracer[i], tracer[i]);
+        }
+    }
+}
@@ -0,0 +1,220 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE TransTpfaTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/pressure/tpfa/trans_tpfa.h>
+#include <opm/core/pressure/tpfa/ifs_tpfa.h>
+#include <opm/core/pressure/flow_bc.h>
+#include <opm/core/linalg/sparse_sys.h>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/grid.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    // Symmetric positive definite, anisotropic permeability, varying by cell.
+    std::vector<double> makePerm(const UnstructuredGrid& g)
+    {
+        std::vector<double> perm(g.number_of_cells * 9, 0.0);
+        for (int c = 0; c < g.number_of_cells; ++c) {
+            double* K = &perm[9*c];
+            K[0] = 1.0 + 0.1*c;  K[4] = 2.0 + 0.05*c;  K[8] = 0.5;
+            K[1] = K[3] = 0.1;
+            K[2] = K[6] = 0.05;
+        }
+        return perm;
+    }
+
+    void perturb(std::vector<double>& perm, const std::vector<int>& cells)
+    {
+        for (std::size_t k = 0; k < cells.size(); ++k) {
+            double* K = &perm[9*cells[k]];
+            for (int i = 0; i < 9; ++i) {
+                K[i] *= 3.0 + k;
+            }
+        }
+    }
+
+    std::vector<int> changedFaces(const UnstructuredGrid& g, const std::vector<int>& cells)
+    {
+        std::vector<int> faces(g.cell_facepos[g.number_of_cells]);
+        const std::size_t nf = tpfa_cells_faces(const_cast<UnstructuredGrid*>(&g),
+                                                cells.size(), &cells[0], &faces[0]);
+        faces.resize(nf);
+        return faces;
+    }
+
+    void checkSystemsEqual(const ifs_tpfa_data* h1, const ifs_tpfa_data* h2)
+    {
+        BOOST_REQUIRE_EQUAL(h1->A->nnz, h2->A->nnz);
+        for (std::size_t i = 0; i < h1->A->nnz; ++i) {
+            BOOST_CHECK_CLOSE(h1->A->sa[i], h2->A->sa[i], 1e-10);
+        }
+        for (std::size_t i = 0; i < h1->A->m; ++i) {
+            BOOST_CHECK_SMALL(h1->b[i] - h2->b[i], 1e-10);
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(IncrementalTransmissibility)
+{
+    const GridManager gm(4, 3, 2, 1.0, 2.0, 0.5);
+    const UnstructuredGrid& g = *gm.c_grid();
+    UnstructuredGrid* gg = const_cast<UnstructuredGrid*>(&g);
+
+    std::vector<double> perm = makePerm(g);
+    std::vector<double> htrans(g.cell_facepos[g.number_of_cells]);
+    std::vector<double> trans(g.number_of_faces);
+    tpfa_htrans_compute(gg, &perm[0], &htrans[0]);
+    tpfa_trans_compute(gg, &htrans[0], &trans[0]);
+
+    std::vector<int> cells;
+    cells.push_back(5);
+    cells.push_back(6);
+    cells.push_back(23);
+    perturb(perm, cells);
+
+    const std::vector<int> faces = changedFaces(g, cells);
+    // Cells 5 and 6 share a face.
+    BOOST_CHECK_EQUAL(faces.size(), 17u);
+    for (std::size_t k = 1; k < faces.size(); ++k) {
+        BOOST_CHECK_LT(faces[k - 1], faces[k]);
+    }
+
+    tpfa_htrans_update(gg, &perm[0], cells.size(), &cells[0], &htrans[0]);
+    tpfa_trans_update(gg, &htrans[0], faces.size(), &faces[0], &trans[0]);
+
+    std::vector<double> htrans_full(htrans.size());
+    std::vector<double> trans_full(trans.size());
+    tpfa_htrans_compute(gg, &perm[0], &htrans_full[0]);
+    tpfa_trans_compute(gg, &htrans_full[0], &trans_full[0]);
+
+    for (std::size_t i = 0; i < htrans.size(); ++i) {
+        BOOST_CHECK_CLOSE(htrans[i], htrans_full[i], 1e-12);
+    }
+    for (std::size_t f = 0; f < trans.size(); ++f) {
+        BOOST_CHECK_CLOSE(trans[f], trans_full[f], 1e-12);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(IncrementalAssembly)
+{
+    const GridManager gm(4, 3, 2);
+    const UnstructuredGrid& g = *gm.c_grid();
+    UnstructuredGrid* gg = const_cast<UnstructuredGrid*>(&g);
+
+    std::vector<double> perm = makePerm(g);
+    std::vector<double> htrans(g.cell_facepos[g.number_of_cells]);
+    std::vector<double> trans(g.number_of_faces);
+    tpfa_htrans_compute(gg, &perm[0], &htrans[0]);
+    tpfa_trans_compute(gg, &htrans[0], &trans[0]);
+
+    std::vector<double> gpress(htrans.size());
+    for (std::size_t i = 0; i < gpress.size(); ++i) {
+        gpress[i] = std::sin(double(i));
+    }
+
+    // Boundary faces of the last cell (pressure condition on one of them)
+    // and of cell 0 (two pressure conditions on one face with an outside
+    // first neighbour, the others free).
+    const int last = g.number_of_cells - 1;
+    int bface = -1;
+    for (int i = g.cell_facepos[last]; i < g.cell_facepos[last + 1]; ++i) {
+        const int f = g.cell_faces[i];
+        if (g.face_cells[2*f + 0] < 0 || g.face_cells[2*f + 1] < 0) {
+            bface = f;
+        }
+    }
+    BOOST_REQUIRE(bface >= 0);
+    int bface0 = -1;
+    for (int i = g.cell_facepos[0]; i < g.cell_facepos[1]; ++i) {
+        const int f = g.cell_faces[i];
+        if (g.face_cells[2*f + 0] < 0) {
+            bface0 = f;
+        }
+    }
+    BOOST_REQUIRE(bface0 >= 0);
+
+    FlowBoundaryConditions* bc = flow_conditions_construct(1);
+    ifs_tpfa_data* h     = ifs_tpfa_construct(gg, NULL);
+    ifs_tpfa_data* hfull = ifs_tpfa_construct(gg, NULL);
+
+    for (int with_bc = 0; with_bc < 2; ++with_bc) {
+        flow_conditions_clear(bc);
+        if (with_bc) {
+            flow_conditions_append(BC_PRESSURE, bface, 100.0, bc);
+            flow_conditions_append(BC_PRESSURE, bface0, 50.0, bc);
+            flow_conditions_append(BC_PRESSURE, bface0, 70.0, bc);
+        }
+        ifs_tpfa_forces F;
+        F.src = NULL;
+        F.bc = with_bc ? bc : NULL;
+        F.W = NULL;
+        F.totmob = NULL;
+        F.wdp = NULL;
+
+        std::vector<double> p = perm;
+        std::vector<double> t = trans;
+        std::vector<double> ht = htrans;
+        BOOST_CHECK(ifs_tpfa_assemble(gg, &F, &t[0], &gpress[0], h));
+
+        std::vector<int> cells;
+        cells.push_back(0);
+        cells.push_back(1);
+        cells.push_back(last);
+        perturb(p, cells);
+
+        const std::vector<int> faces = changedFaces(g, cells);
+        std::vector<double> dtrans(faces.size());
+        for (std::size_t k = 0; k < faces.size(); ++k) {
+            dtrans[k] = -t[faces[k]];
+        }
+        tpfa_htrans_update(gg, &p[0], cells.size(), &cells[0], &ht[0]);
+        tpfa_trans_update(gg, &ht[0], faces.size(), &faces[0], &t[0]);
+        for (std::size_t k = 0; k < faces.size(); ++k) {
+            dtrans[k] += t[faces[k]];
+        }
+        ifs_tpfa_update_trans(gg, &F, faces.size(), &faces[0], &dtrans[0], h);
+
+        BOOST_CHECK(ifs_tpfa_assemble(gg, &F, &t[0], &gpress[0], hfull));
+        checkSystemsEqual(h, hfull);
+    }
+
+    ifs_tpfa_destroy(hfull);
+    ifs_tpfa_destroy(h);
+    flow_conditions_destroy(bc);
+}
@@ -0,0 +1,145 @@
+/*
+  Copyright 2016 SINTEF ICT, Applied Mathematics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE TransportSolverTwophaseReorderTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/transport/reorder/TransportSolverTwophaseReorder.hpp>
+#include <opm/core/props/IncompPropertiesBasic.hpp>
+#include <opm/core/simulator/TwophaseState.hpp>
+#include <opm/core/grid/GridManager.hpp>
+#include <opm/core/grid.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace Opm;
+
+namespace
+{
+    // Set the flux over the face between cells c0 and c1 to q, in
+    // the direction from c0 to c1.
+    void setFlux(const UnstructuredGrid& g, const int c0, const int c1,
+                 const double q, std::vector<double>& flux)
+    {
+        for (int f = 0; f < g.number_of_faces; ++f) {
+            if (g.face_cells[2*f] == c0 && g.face_cells[2*f + 1] == c1) {
+                flux[f] = q;
+                return;
+            }
+            if (g.face_cells[2*f] == c1 && g.face_cells[2*f + 1] == c0) {
+                flux[f] = -q;
+                return;
+            }
+        }
+        BOOST_FAIL("Cells " << c0 << " and " << c1 << " are not neighbours.");
+    }
+
+    // Solve a few time steps on a 2x2 grid whose upwind graph is the
+    // single cycle 0 -> 1 -> 3 -> 2 -> 0, with water injected in
+    // cell 0 and produced from cell 2.
+    std::vector<double> solveCycle(const int newton_min_size,
+                                   TransportSolverTwophaseReorder::MultiCellStatistics& stats)
+    {
+        const GridManager gm(2, 2, 1);
+        const UnstructuredGrid& g = *gm.c_grid();
+        const int nc = g.number_of_cells;
+
+        const std::vector<double> rho(2, 1000.0);
+        std::vector<double> mu(2);
+        mu[0] = 1.0e-3;
+        mu[1] = 5.0e-3;
+        const IncompPropertiesBasic props(2, SaturationPropsBasic::Quadratic,
+                                          rho, mu, 0.2, 1.0e-13, 3, nc);
+
+        TwophaseState state(nc, g.number_of_faces);
+        std::vector<double>& flux = state.faceflux();
+        setFlux(g, 0, 1, 1.5, flux);
+        setFlux(g, 1, 3, 1.5, flux);
+        setFlux(g, 3, 2, 1.5, flux);
+        setFlux(g, 2, 0, 1.0, flux);
+        for (int c = 0; c < nc; ++c) {
+            state.saturation()[2*c]     = 0.0;
+            state.saturation()[2*c + 1] = 1.0;
+        }
+
+        std::vector<double> src(nc, 0.0);
+        src[0] =  0.5;
+        src[2] = -0.5;
+        const std::vector<double> pv(nc, 1.0);
+
+        TransportSolverTwophaseReorder solver(g, props, 0, 1.0e-12, 50);
+        solver.setNewtonMinComponentSize(newton_min_size);
+        for (int step = 0; step < 3; ++step) {
+            solver.solve(&pv[0], &src[0], 0.5, state);
+        }
+        stats = solver.multiCellStatistics();
+
+        std::vector<double> sw(nc);
+        for (int c = 0; c < nc; ++c) {
+            sw[c] = state.saturation()[2*c];
+        }
+        return sw;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(NewtonAndGaussSeidelAgreeOnCycle)
+{
+    TransportSolverTwophaseReorder::MultiCellStatistics newton;
+    TransportSolverTwophaseReorder::MultiCellStatistics gs;
+    const std::vector<double> sw_newton = solveCycle(2, newton);
+    const std::vector<double> sw_gs = solveCycle(0, gs);
+
+    // The whole grid is one component.
+    BOOST_CHECK_EQUAL(newton.num_components, 1);
+    BOOST_CHECK_EQUAL(newton.num_cells, 4);
+    BOOST_CHECK_EQUAL(newton.max_size, 4);
+    BOOST_CHECK_EQUAL(gs.num_components, 1);
+    BOOST_CHECK_EQUAL(gs.num_cells, 4);
+
+    // Solved by Newton's method only if enabled for its size.
+    BOOST_CHECK_EQUAL(newton.num_newton, 1);
+    BOOST_CHECK_EQUAL(newton.num_newton_failures, 0);
+    BOOST_CHECK_GT(newton.newton_iterations, 0);
+    BOOST_CHECK_EQUAL(newton.max_newton_iterations, newton.newton_iterations);
+    BOOST_CHECK_EQUAL(newton.gauss_seidel_iterations, 0);
+
+    BOOST_CHECK_EQUAL(gs.num_newton, 0);
+    BOOST_CHECK_EQUAL(gs.newton_iterations, 0);
+    BOOST_CHECK_GT(gs.gauss_seidel_iterations, 0);
+    BOOST_CHECK_EQUAL(gs.max_gauss_seidel_iterations, gs.gauss_seidel_iterations);
+
+    BOOST_REQUIRE_EQUAL(sw_newton.size(), sw_gs.size());
+    for (std::size_t c = 0; c < sw_newton.size(); ++c) {
+        BOOST_CHECK_GT(sw_newton[c], 0.0);
+        BOOST_CHECK_LT(sw_newton[c], 1.0);
+        BOOST_CHECK_CLOSE(sw_newton[c], sw_gs[c], 1.0e-6);
+    }
+}
@@ -27,6 +27,9 @@
 #define BOOST_TEST_MODULE UniformTableLinearTests
 #include <boost/test/unit_test.hpp>
 #include <opm/core/utility/UniformTableLinear.hpp>
+#include <opm/core/utility/buildUniformMonotoneTable.hpp>
+
+#include <cmath>
 
 
 
@@ -71,3 +74,40 @@ BOOST_AUTO_TEST_CASE(table_operations)
     BOOST_CHECK_EQUAL(t1(-85.0), 0.0);
     BOOST_CHECK(std::fabs(t1.derivative(0.0)  + 2.0/30.0) < 1e-14);
 }
+
+
+BOOST_AUTO_TEST_CASE(table_from_tolerance)
+{
+    // A curve like a formation volume factor, with a kink.
+    auto f = [](const double x) { return (x < 3.0) ? 1.0 + 0.1*x : 1.3 + 0.02*(x - 3.0) + 0.01*(std::sin(x) - std::sin(3.0)); };
+    const double xmin = 1.0;
+    const double xmax = 10.0;
+
+    // Linear functions need no refinement.
+    Opm::UniformTableLinear<double> linear;
+    const double linear_error = Opm::buildUniformTable([](const double x) { return 2.0*x - 1.0; },
+                                                       xmin, xmax, 1e-12, 1000, linear);
+    BOOST_CHECK_SMALL(linear_error, 1e-14);
+    BOOST_CHECK_CLOSE(linear.derivative(4.2), 2.0, 1e-10);
+
+    const double tols[] = { 1e-3, 1e-4, 1e-6 };
+    for (const double tol : tols) {
+        Opm::UniformTableLinear<double> t;
+        const double error = Opm::buildUniformTable(f, xmin, xmax, tol, 1 << 20, t);
+        BOOST_CHECK_LE(error, tol);
+        // The reported error holds away from the check points too.
+        double scale = 0.0;
+        double worst = 0.0;
+        for (int i = 0; i <= 997; ++i) {
+            const double x = xmin + i*(xmax - xmin)/997.0;
+            scale = std::max(scale, std::fabs(f(x)));
+            worst = std::max(worst, std::fabs(t(x) - f(x)));
+        }
+        BOOST_CHECK_LE(worst/scale, 2.0*tol);
+    }
+
+    // With too few samples allowed, the achieved error is reported.
+    Opm::UniformTableLinear<double> coarse;
+    const double coarse_error = Opm::buildUniformTable(f, xmin, xmax, 1e-9, 40, coarse);
+    BOOST_CHECK_GT(coarse_error, 1e-9);
+}